@@ -1,4 +1,4 @@
-extern unsigned char xdata IAPSPDataBuf[127];
+#define IAPSPDataBuf    IAPDataBuf          /* SPROM data use shared IAPDataBuf[0:126] */
 
 void Erase_SPROM(void);
 void Erase_Verify_SPROM(unsigned int u16IAPDataSize);
@@ -0,0 +1,21 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Log-structured dataflash define                                                                        */
+/*  Two continuous APROM pages are reserved for the log, please confirm the address not over code size.   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     LOG_PAGE0_ADDR          0x1800
+#define     LOG_PAGE1_ADDR          0x1880
+#define     LOG_KEY_NUM             16          /* key value 0 ~ (LOG_KEY_NUM-1), max 61 keys */
+
+#define     LOG_PAGE_ERASED         0xFF
+#define     LOG_PAGE_RECEIVING      0x7F
+#define     LOG_PAGE_ACTIVE         0x3F
+#define     LOG_PAGE_OBSOLETE       0x00        /* programmed before the page erase */
+#define     LOG_RECORD_START        4           /* byte 0 page status, byte 1 page sequence, byte 2 inverted sequence */
+#define     LOG_RECORD_BLANK        0xFF
+
+extern unsigned int xdata u16LogEraseCount;
+extern unsigned int xdata u16LogProgramCount;
+
+void Init_DATAFLASH_LOG(void);
+unsigned char Write_DATAFLASH_LOG(unsigned char u8Key, unsigned char u8Data);
+unsigned char Read_DATAFLASH_LOG(unsigned char u8Key);
@@ -0,0 +1,22 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Power-fail-safe A/B dataflash record define                                                            */
+/*  Two continuous APROM pages are reserved for records, please confirm the address not over code size.   */
+/*  Slot : [sequence L][sequence H][data 0 ~ REC_DATA_SIZE-1][CRC16 H][CRC16 L], CRC programmed at last.   */
+/*  Link eeprom_record.c with crc.c, IAP_buffer.c and bod.c (bod_event_flag). Enable BOD interrupt and     */
+/*  set bod_event_flag in BOD_ISR (isr.c or application), see SampleCode/RegBased/IAP_Dataflash_Record.   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     REC_PAGE0_ADDR          0x1A00
+#define     REC_PAGE1_ADDR          0x1A80
+#define     REC_DATA_SIZE           12          /* record data bytes, max 124 */
+
+#define     REC_SLOT_SIZE           (REC_DATA_SIZE + 4)
+#define     REC_SLOT_NUM            (PAGE_SIZE / REC_SLOT_SIZE)
+#define     REC_SEQ_BLANK           0xFFFF
+
+#define     REC_ERR_BOD             0x02        /* brown-out detected, write not started */
+
+extern unsigned int xdata u16RecordSequence;
+
+unsigned char Init_DATAFLASH_RECORD(void);
+unsigned char Read_DATAFLASH_RECORD(unsigned char *pu8Data);
+unsigned char Write_DATAFLASH_RECORD(const unsigned char *pu8Data);
@@ -0,0 +1,38 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Flash wear telemetry define                                                                            */
+/*  Erase count of WEAR_TRACK_PAGE_NUM APROM pages, all LDROM pages and the wear area itself.              */
+/*  Two continuous APROM pages are reserved, please confirm the address not over code size.                */
+/*  Set FLASH_WEAR_ENABLE=1 in project C51 define and add flash_wear.c to hook library erase paths.        */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef FLASH_WEAR_ENABLE
+#define     FLASH_WEAR_ENABLE       0
+#endif
+
+#define     WEAR_PAGE0_ADDR         0x1C00
+#define     WEAR_PAGE1_ADDR         0x1C80
+#define     WEAR_TRACK_ADDR         0x1800      /* first tracked APROM page */
+#define     WEAR_TRACK_PAGE_NUM     8           /* tracked pages 0x1800 ~ 0x1BFF, max 20 pages */
+#define     WEAR_ENDURANCE          100000      /* page erase endurance cycles */
+
+#define     WEAR_SLOT_LDROM         WEAR_TRACK_PAGE_NUM             /* all LDROM page erase */
+#define     WEAR_SLOT_SELF          (WEAR_TRACK_PAGE_NUM + 1)       /* wear area page erase */
+#define     WEAR_SLOT_NUM           (WEAR_TRACK_PAGE_NUM + 2)
+
+#define     WEAR_PAGE_RECEIVING     0x7F
+#define     WEAR_PAGE_ACTIVE        0x3F
+#define     WEAR_BASE_START         2           /* byte 0 page status, byte 1 page sequence */
+#define     WEAR_TALLY_START        (WEAR_BASE_START + WEAR_SLOT_NUM * 4)
+#define     WEAR_TALLY_BLANK        0xFF
+
+#if FLASH_WEAR_ENABLE
+#define     FLASH_WEAR_RECORD       Flash_Wear_Record()
+#else
+#define     FLASH_WEAR_RECORD
+#endif
+
+extern unsigned long xdata WearCount[WEAR_SLOT_NUM];
+
+void Init_FLASH_WEAR(void);
+void Flash_Wear_Record(void);
+unsigned long Flash_Wear_Get_Count(unsigned char u8Slot);
+unsigned long Flash_Wear_Get_Remaining(unsigned char u8Slot);
@@ -0,0 +1,16 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Streaming LZ decoder for compressed ISP update, 256 bytes XRAM window                                  */
+/*  Stream is groups of one flag byte and 8 tokens, flag bit 0 first. Bit 1 token is one literal byte.    */
+/*  Bit 0 token is two bytes: distance - 1 (0 ~ 255) and length - LZ_MIN_MATCH (0 ~ 255), copied from      */
+/*  the output already decoded. Tokens after the last output byte are ignored.                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     LZ_MIN_MATCH            3
+#define     LZ_WINDOW_SIZE          256
+
+#define     LZ_STATE_FLAG           0
+#define     LZ_STATE_TOKEN          1
+#define     LZ_STATE_LENGTH         2
+
+void LZ_Decode_Init(void);
+void LZ_Decode_Input(unsigned char xdata *pu8Src, unsigned char u8Len);
+unsigned char LZ_Decode_Byte(unsigned char *pu8Out);
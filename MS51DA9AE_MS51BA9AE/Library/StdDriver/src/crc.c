@@ -0,0 +1,196 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_8K.h"
+
+unsigned int code CRC16Table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+unsigned long code CRC32Table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * @brief       CRC-16/CCITT one byte
+ * @param       u16CRC CRC value of previous data, CRC16_INIT for the first byte
+ * @param       u8Data new data byte
+ * @return      updated CRC value
+ * @details     Two nibble table look up, table 32 bytes in code.
+ * @example     u16CRC = CRC16_Update(u16CRC, u8Data);
+ */
+unsigned int CRC16_Update(unsigned int u16CRC, unsigned char u8Data)
+{
+    u16CRC = (u16CRC << 4) ^ CRC16Table[(HIBYTE(u16CRC) >> 4) ^ (u8Data >> 4)];
+    u16CRC = (u16CRC << 4) ^ CRC16Table[(HIBYTE(u16CRC) >> 4) ^ (u8Data & 0x0F)];
+    return u16CRC;
+}
+
+/**
+ * @brief       CRC-16/CCITT of a buffer
+ * @param       u16CRC CRC value of previous data, CRC16_INIT for a new calculation
+ * @param       pu8Data data pointer, xdata / code / data
+ * @param       u16Size data bytes
+ * @return      updated CRC value
+ * @example     u16CRC = CRC16_Buffer(CRC16_INIT, IAPDataBuf, 128);
+ */
+unsigned int CRC16_Buffer(unsigned int u16CRC, const unsigned char *pu8Data, unsigned int u16Size)
+{
+    while (u16Size--)
+    {
+        u16CRC = CRC16_Update(u16CRC, *pu8Data++);
+    }
+
+    return u16CRC;
+}
+
+/**
+ * @brief       CRC-16/CCITT of APROM area
+ * @param       u16CRC CRC value of previous data, CRC16_INIT for a new calculation
+ * @param       u16Addr APROM start address
+ * @param       u16Size data bytes
+ * @return      updated CRC value
+ * @details     Read APROM by MOVC, no IAP trigger needed. Must run in APROM.
+ * @example     u16CRC = CRC16_APROM(CRC16_INIT, 0x0000, 0x4000);
+ */
+unsigned int CRC16_APROM(unsigned int u16CRC, unsigned int u16Addr, unsigned int u16Size)
+{
+    unsigned char code *pCode;
+
+    pCode = (unsigned char code *)u16Addr;
+
+    while (u16Size--)
+    {
+        u16CRC = CRC16_Update(u16CRC, *pCode++);
+    }
+
+    return u16CRC;
+}
+
+/**
+ * @brief       CRC-16/CCITT of LDROM area
+ * @param       u16CRC CRC value of previous data, CRC16_INIT for a new calculation
+ * @param       u16Addr LDROM start address
+ * @param       u16Size data bytes
+ * @return      updated CRC value
+ * @details     LDROM is not visible by MOVC from APROM, read by IAP byte read command.
+ * @example     u16CRC = CRC16_LDROM(CRC16_INIT, 0x0000, 0x1000);
+ */
+unsigned int CRC16_LDROM(unsigned int u16CRC, unsigned int u16Addr, unsigned int u16Size)
+{
+    set_CHPCON_IAPEN;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+    IAPCN = BYTE_READ_LDROM;
+
+    while (u16Size--)
+    {
+        set_IAPTRG_IAPGO;
+        u16CRC = CRC16_Update(u16CRC, IAPFD);
+        IAPAL++;
+        if (IAPAL == 0)
+        {
+            IAPAH++;
+        }
+    }
+
+    clr_CHPCON_IAPEN;
+
+    return u16CRC;
+}
+
+/**
+ * @brief       CRC-32 one byte
+ * @param       u32CRC CRC value of previous data, CRC32_INIT for the first byte
+ * @param       u8Data new data byte
+ * @return      updated CRC value, final result need XOR CRC32_XOROUT
+ * @details     Two nibble table look up, table 64 bytes in code.
+ * @example     u32CRC = CRC32_Update(u32CRC, u8Data);
+ */
+unsigned long CRC32_Update(unsigned long u32CRC, unsigned char u8Data)
+{
+    u32CRC = (u32CRC >> 4) ^ CRC32Table[((unsigned char)u32CRC ^ u8Data) & 0x0F];
+    u32CRC = (u32CRC >> 4) ^ CRC32Table[((unsigned char)u32CRC ^ (u8Data >> 4)) & 0x0F];
+    return u32CRC;
+}
+
+/**
+ * @brief       CRC-32 of a buffer
+ * @param       u32CRC CRC value of previous data, CRC32_INIT for a new calculation
+ * @param       pu8Data data pointer, xdata / code / data
+ * @param       u16Size data bytes
+ * @return      updated CRC value, final result need XOR CRC32_XOROUT
+ * @example     u32CRC = CRC32_Buffer(CRC32_INIT, IAPDataBuf, 128) ^ CRC32_XOROUT;
+ */
+unsigned long CRC32_Buffer(unsigned long u32CRC, const unsigned char *pu8Data, unsigned int u16Size)
+{
+    while (u16Size--)
+    {
+        u32CRC = CRC32_Update(u32CRC, *pu8Data++);
+    }
+
+    return u32CRC;
+}
+
+/**
+ * @brief       CRC-32 of APROM area
+ * @param       u32CRC CRC value of previous data, CRC32_INIT for a new calculation
+ * @param       u16Addr APROM start address
+ * @param       u16Size data bytes
+ * @return      updated CRC value, final result need XOR CRC32_XOROUT
+ * @details     Read APROM by MOVC, no IAP trigger needed. Must run in APROM.
+ * @example     u32CRC = CRC32_APROM(CRC32_INIT, 0x0000, 0x4000) ^ CRC32_XOROUT;
+ */
+unsigned long CRC32_APROM(unsigned long u32CRC, unsigned int u16Addr, unsigned int u16Size)
+{
+    unsigned char code *pCode;
+
+    pCode = (unsigned char code *)u16Addr;
+
+    while (u16Size--)
+    {
+        u32CRC = CRC32_Update(u32CRC, *pCode++);
+    }
+
+    return u32CRC;
+}
+
+/**
+ * @brief       CRC-32 of LDROM area
+ * @param       u32CRC CRC value of previous data, CRC32_INIT for a new calculation
+ * @param       u16Addr LDROM start address
+ * @param       u16Size data bytes
+ * @return      updated CRC value, final result need XOR CRC32_XOROUT
+ * @details     LDROM is not visible by MOVC from APROM, read by IAP byte read command.
+ * @example     u32CRC = CRC32_LDROM(CRC32_INIT, 0x0000, 0x1000) ^ CRC32_XOROUT;
+ */
+unsigned long CRC32_LDROM(unsigned long u32CRC, unsigned int u16Addr, unsigned int u16Size)
+{
+    set_CHPCON_IAPEN;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+    IAPCN = BYTE_READ_LDROM;
+
+    while (u16Size--)
+    {
+        set_IAPTRG_IAPGO;
+        u32CRC = CRC32_Update(u32CRC, IAPFD);
+        IAPAL++;
+        if (IAPAL == 0)
+        {
+            IAPAH++;
+        }
+    }
+
+    clr_CHPCON_IAPEN;
+
+    return u32CRC;
+}
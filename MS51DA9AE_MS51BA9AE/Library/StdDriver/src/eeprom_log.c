@@ -0,0 +1,354 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_8K.h"
+
+#if (LOG_KEY_NUM > 61)
+#error "LOG_KEY_NUM must leave at least one free record after page transfer"
+#endif
+
+unsigned int xdata u16LogEraseCount;
+unsigned int xdata u16LogProgramCount;
+
+unsigned int xdata u16LogActivePage;
+unsigned char xdata u8LogWriteOffset;
+unsigned char xdata u8LogSequence;
+unsigned char xdata LogIndex[LOG_KEY_NUM];          /* offset of newest record of each key, 0 means not stored */
+
+/* Key byte in flash is a 4 of 8 bit code, a torn key program leaves more 1 bits and never reads as another key */
+unsigned char code LogKeyCode[61] =
+{
+    0x0F, 0x17, 0x1B, 0x1D, 0x1E, 0x27, 0x2B, 0x2D, 0x2E, 0x33, 0x35, 0x36, 0x39, 0x3A, 0x3C, 0x47,
+    0x4B, 0x4D, 0x4E, 0x53, 0x55, 0x56, 0x59, 0x5A, 0x5C, 0x63, 0x65, 0x66, 0x69, 0x6A, 0x6C, 0x71,
+    0x72, 0x74, 0x78, 0x87, 0x8B, 0x8D, 0x8E, 0x93, 0x95, 0x96, 0x99, 0x9A, 0x9C, 0xA3, 0xA5, 0xA6,
+    0xA9, 0xAA, 0xAC, 0xB1, 0xB2, 0xB4, 0xB8, 0xC3, 0xC5, 0xC6, 0xC9, 0xCA, 0xCC
+};
+
+/**
+ * @brief       Program one byte of the log area
+ * @param       u16Addr APROM address
+ * @param       u8Data value to be programmed
+ * @return      PASS / FAIL
+ * @details     Caller must enable IAP and APROM update before call.
+ */
+unsigned char Log_Program_Byte(unsigned int u16Addr, unsigned char u8Data)
+{
+  IAPCN = BYTE_PROGRAM_APROM;
+  IAPAL = LOBYTE(u16Addr);
+  IAPAH = HIBYTE(u16Addr);
+  IAPFD = u8Data;
+  set_IAPTRG_IAPGO;
+  u16LogProgramCount++;
+
+  if (*(unsigned char code *)u16Addr != u8Data)
+    return FAIL;
+
+  return PASS;
+}
+
+/**
+ * @brief       Erase one page of the log area if it is not blank
+ * @param       u16Addr page start address
+ * @return      none
+ * @details     Caller must enable IAP and APROM update before call.
+ */
+void Log_Erase_Page(unsigned int u16Addr)
+{
+  unsigned char i;
+  unsigned char code *pCode;
+
+  pCode = (unsigned char code *)u16Addr;
+
+  for (i = 0; i < PAGE_SIZE; i++)
+  {
+    if (pCode[i] != 0xFF)
+      break;
+  }
+
+  if (i == PAGE_SIZE)
+    return;
+
+  IAPCN = PAGE_ERASE_APROM;
+  IAPAL = LOBYTE(u16Addr);
+  IAPAH = HIBYTE(u16Addr);
+  IAPFD = 0xFF;
+  set_IAPTRG_IAPGO;
+  u16LogEraseCount++;
+  FLASH_WEAR_RECORD;
+}
+
+/**
+ * @brief       Mark a log page obsolete and erase it
+ * @param       u16Addr page start address
+ * @return      none
+ * @details     Caller must enable IAP and APROM update before call.
+ *              A torn erase sets random bits, from ACTIVE it often stays ACTIVE with a random sequence.
+ *              From OBSOLETE the header must land on ACTIVE and on a matching inverted sequence.
+ */
+void Log_Retire_Page(unsigned int u16Addr)
+{
+  if (*(unsigned char code *)u16Addr != LOG_PAGE_ERASED)
+    Log_Program_Byte(u16Addr, LOG_PAGE_OBSOLETE);
+
+  Log_Erase_Page(u16Addr);
+}
+
+/**
+ * @brief       Copy the newest record of each key into the other page
+ * @param       none
+ * @return      PASS / FAIL
+ * @details     The new page is marked RECEIVING while copying and ACTIVE after all records copied,
+ *              the old page is marked OBSOLETE and erased at last.
+ *              Power lost in any step is recovered by Init_DATAFLASH_LOG.
+ */
+unsigned char Log_Page_Transfer(void)
+{
+  unsigned int u16NewPage;
+  unsigned char u8Key, u8Offset, u8Data;
+
+  if (u16LogActivePage == LOG_PAGE0_ADDR)
+    u16NewPage = LOG_PAGE1_ADDR;
+  else
+    u16NewPage = LOG_PAGE0_ADDR;
+
+  Log_Erase_Page(u16NewPage);
+
+  if (Log_Program_Byte(u16NewPage, LOG_PAGE_RECEIVING) != PASS)
+    return FAIL;
+  if (Log_Program_Byte(u16NewPage + 1, u8LogSequence + 1) != PASS)
+    return FAIL;
+  if (Log_Program_Byte(u16NewPage + 2, (unsigned char)~(u8LogSequence + 1)) != PASS)
+    return FAIL;
+
+  u8Offset = LOG_RECORD_START;
+
+  for (u8Key = 0; u8Key < LOG_KEY_NUM; u8Key++)
+  {
+    if (LogIndex[u8Key] == 0)
+      continue;
+
+    u8Data = *(unsigned char code *)(u16LogActivePage + LogIndex[u8Key] + 1);
+
+    if (Log_Program_Byte(u16NewPage + u8Offset + 1, u8Data) != PASS)
+      return FAIL;
+    if (Log_Program_Byte(u16NewPage + u8Offset, LogKeyCode[u8Key]) != PASS)
+      return FAIL;
+
+    u8Offset += 2;
+  }
+
+  if (Log_Program_Byte(u16NewPage, LOG_PAGE_ACTIVE) != PASS)
+    return FAIL;
+
+  /* LogIndex keeps old page offsets until the new page is ACTIVE, a FAIL above leaves the old page readable */
+  u8LogWriteOffset = u8Offset;
+  u8Offset = LOG_RECORD_START;
+
+  for (u8Key = 0; u8Key < LOG_KEY_NUM; u8Key++)
+  {
+    if (LogIndex[u8Key] == 0)
+      continue;
+
+    LogIndex[u8Key] = u8Offset;
+    u8Offset += 2;
+  }
+
+  Log_Retire_Page(u16LogActivePage);
+
+  u16LogActivePage = u16NewPage;
+  u8LogSequence++;
+
+  return PASS;
+}
+
+/**
+ * @brief       Mount the log area and build RAM index
+ * @param       none
+ * @return      none
+ * @details     Select the active page by page status and sequence, finish any interrupted page transfer,
+ *              then scan records once to find the newest record of each key and the next free record.
+ *              Must be called once before Write_DATAFLASH_LOG / Read_DATAFLASH_LOG.
+ * @example     Init_DATAFLASH_LOG();
+ */
+void Init_DATAFLASH_LOG(void)
+{
+  unsigned char u8Status0, u8Status1, u8Seq0, u8Seq1;
+  unsigned char u8Offset, u8Key, u8Code;
+  unsigned int u16OldPage;
+  unsigned char code *pCode;
+
+  u8Status0 = *(unsigned char code *)LOG_PAGE0_ADDR;
+  u8Status1 = *(unsigned char code *)LOG_PAGE1_ADDR;
+  u8Seq0 = *(unsigned char code *)(LOG_PAGE0_ADDR + 1);
+  u8Seq1 = *(unsigned char code *)(LOG_PAGE1_ADDR + 1);
+
+  /* A torn erase can leave any status, the page header is valid only with the inverted sequence */
+  if (*(unsigned char code *)(LOG_PAGE0_ADDR + 2) != (unsigned char)~u8Seq0)
+    u8Status0 = LOG_PAGE_OBSOLETE;
+  if (*(unsigned char code *)(LOG_PAGE1_ADDR + 2) != (unsigned char)~u8Seq1)
+    u8Status1 = LOG_PAGE_OBSOLETE;
+
+  u16OldPage = 0;
+
+  set_CHPCON_IAPEN;
+  set_IAPUEN_APUEN;
+
+  if ((u8Status0 == LOG_PAGE_ACTIVE) && (u8Status1 == LOG_PAGE_ACTIVE))
+  {
+    /* Power lost before old page erased, the page with next sequence is newer */
+    if ((unsigned char)(u8Seq1 - u8Seq0) == 1)
+    {
+      u16LogActivePage = LOG_PAGE1_ADDR;
+      u16OldPage = LOG_PAGE0_ADDR;
+    }
+    else
+    {
+      u16LogActivePage = LOG_PAGE0_ADDR;
+      u16OldPage = LOG_PAGE1_ADDR;
+    }
+  }
+  else if (u8Status0 == LOG_PAGE_ACTIVE)
+  {
+    u16LogActivePage = LOG_PAGE0_ADDR;
+  }
+  else if (u8Status1 == LOG_PAGE_ACTIVE)
+  {
+    u16LogActivePage = LOG_PAGE1_ADDR;
+  }
+  else if (u8Status0 == LOG_PAGE_RECEIVING)
+  {
+    /* Power lost while marking the new page ACTIVE, all records already copied */
+    u16LogActivePage = LOG_PAGE0_ADDR;
+    Log_Program_Byte(LOG_PAGE0_ADDR, LOG_PAGE_ACTIVE);
+    u16OldPage = LOG_PAGE1_ADDR;
+  }
+  else if (u8Status1 == LOG_PAGE_RECEIVING)
+  {
+    u16LogActivePage = LOG_PAGE1_ADDR;
+    Log_Program_Byte(LOG_PAGE1_ADDR, LOG_PAGE_ACTIVE);
+    u16OldPage = LOG_PAGE0_ADDR;
+  }
+  else
+  {
+    /* No valid page, format log area */
+    u16LogActivePage = LOG_PAGE0_ADDR;
+    Log_Erase_Page(LOG_PAGE0_ADDR);
+    Log_Erase_Page(LOG_PAGE1_ADDR);
+    Log_Program_Byte(LOG_PAGE0_ADDR, LOG_PAGE_ACTIVE);
+    Log_Program_Byte(LOG_PAGE0_ADDR + 1, 0);
+    Log_Program_Byte(LOG_PAGE0_ADDR + 2, 0xFF);
+  }
+
+  if (u16OldPage != 0)
+  {
+    Log_Retire_Page(u16OldPage);
+  }
+
+  clr_IAPUEN_APUEN;
+  clr_CHPCON_IAPEN;
+
+  u8LogSequence = *(unsigned char code *)(u16LogActivePage + 1);
+
+  for (u8Key = 0; u8Key < LOG_KEY_NUM; u8Key++)
+  {
+    LogIndex[u8Key] = 0;
+  }
+
+  /* Single scan over the whole page, a record with data but blank or torn key is skipped.
+     A blank record may be followed by newer ones when its write failed, next free record is after the last used one. */
+  pCode = (unsigned char code *)u16LogActivePage;
+  u8LogWriteOffset = LOG_RECORD_START;
+
+  for (u8Offset = LOG_RECORD_START; u8Offset < PAGE_SIZE; u8Offset += 2)
+  {
+    u8Code = pCode[u8Offset];
+
+    if ((u8Code == LOG_RECORD_BLANK) && (pCode[u8Offset + 1] == 0xFF))
+      continue;
+
+    for (u8Key = 0; u8Key < LOG_KEY_NUM; u8Key++)
+    {
+      if (LogKeyCode[u8Key] == u8Code)
+        break;
+    }
+
+    if (u8Key < LOG_KEY_NUM)
+      LogIndex[u8Key] = u8Offset;
+
+    u8LogWriteOffset = u8Offset + 2;
+  }
+}
+
+/**
+ * @brief       Read the newest value of a key
+ * @param       u8Key key value 0 ~ (LOG_KEY_NUM-1)
+ * @return      stored value, 0xFF if the key never written
+ * @details     Read from APROM by RAM index, no search in flash.
+ * @example     u8Value = Read_DATAFLASH_LOG(3);
+ */
+unsigned char Read_DATAFLASH_LOG(unsigned char u8Key)
+{
+  if ((u8Key >= LOG_KEY_NUM) || (LogIndex[u8Key] == 0))
+    return 0xFF;
+
+  return *(unsigned char code *)(u16LogActivePage + LogIndex[u8Key] + 1);
+}
+
+/**
+ * @brief       Append a new value of a key to the log
+ * @param       u8Key key value 0 ~ (LOG_KEY_NUM-1)
+ * @param       u8Data value to be stored
+ * @return      PASS / FAIL
+ * @details     Program data byte then key byte into the next free record, no page erase.
+ *              When the active page is full, newest records are copied into the other page first.
+ * @example     Write_DATAFLASH_LOG(3, 0x55);
+ */
+unsigned char Write_DATAFLASH_LOG(unsigned char u8Key, unsigned char u8Data)
+{
+  unsigned char u8Result;
+
+  if (u8Key >= LOG_KEY_NUM)
+    return FAIL;
+
+  /* Same value stored, nothing need program */
+  if (Read_DATAFLASH_LOG(u8Key) == u8Data)
+    return PASS;
+
+  set_CHPCON_IAPEN;
+  set_IAPUEN_APUEN;
+
+  u8Result = PASS;
+
+  if (u8LogWriteOffset >= PAGE_SIZE)
+  {
+    u8Result = Log_Page_Transfer();
+  }
+
+  if (u8Result == PASS)
+  {
+    u8Result = Log_Program_Byte(u16LogActivePage + u8LogWriteOffset + 1, u8Data);
+  }
+
+  if (u8Result == PASS)
+  {
+    u8Result = Log_Program_Byte(u16LogActivePage + u8LogWriteOffset, LogKeyCode[u8Key]);
+  }
+
+  if (u8Result == PASS)
+  {
+    LogIndex[u8Key] = u8LogWriteOffset;
+  }
+
+  /* Failed record slot is skipped, the next write use a new record. A failed page transfer is tried again. */
+  if (u8LogWriteOffset < PAGE_SIZE)
+    u8LogWriteOffset += 2;
+
+  clr_IAPUEN_APUEN;
+  clr_CHPCON_IAPEN;
+
+  return u8Result;
+}
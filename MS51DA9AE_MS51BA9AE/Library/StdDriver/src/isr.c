@@ -26,9 +26,13 @@ void INT0_ISR(void) interrupt 0          // Vector @  0x03
 void Timer0_ISR(void) interrupt 1        // Vector @  0x0B
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_TIMER == 0)
+    Modbus_Timer_ISR();
+#else
   
     clr_TCON_TF0;
 
+#endif
     _pop_(SFRS);
 }
 //-----------------------------------------------------------------------------------------------------------
@@ -44,19 +48,29 @@ void INT1_ISR(void) interrupt 2          // Vector @  0x13
 void Timer1_ISR(void) interrupt 3        // Vector @  0x1B
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_TIMER == 1)
+    Modbus_Timer_ISR();
+#else
   
     clr_TCON_TF1;
 
+#endif
     _pop_(SFRS);
 }
 //-----------------------------------------------------------------------------------------------------------
 void UART0_ISR(void) interrupt 4         // Vector @  0x23
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_UART == UART0)
+    Modbus_UART_ISR();
+#elif UART_RING_ENABLE
+    UART0_Ring_ISR();
+#else
   
     clr_SCON_RI;
     clr_SCON_TI;
 
+#endif
     _pop_(SFRS);
 }
 //-----------------------------------------------------------------------------------------------------------
@@ -92,6 +106,7 @@ void BOD_ISR(void) interrupt 8           // Vector @  0x43
     _push_(SFRS);
   
     clr_BODCON0_BOF;
+    bod_event_flag = 1;
 
     _pop_(SFRS);
 }
@@ -146,10 +161,16 @@ void PWM_Brake_ISR(void) interrupt 14    // Vector @  0x73
 void UART1_ISR(void) interrupt 15    			// Vector @  0x7B
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_UART == UART1)
+    Modbus_UART_ISR();
+#elif UART_RING_ENABLE
+    UART1_Ring_ISR();
+#else
   
     clr_SCON_1_RI_1;
     clr_SCON_1_TI_1;
 
+#endif
     _pop_(SFRS);
 }
 //-----------------------------------------------------------------------------------------------------------
@@ -0,0 +1,379 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_8K.h"
+
+#define MODBUS_IDLE             0
+#define MODBUS_TX               1
+
+/* CRC-16 of byte index, polynomial 0xA001 reflected */
+unsigned int code au16ModbusCRC[256] =
+{
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+static unsigned char code au8Bit[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+unsigned char xdata au8ModbusFrame[MODBUS_FRAME_MAX];
+unsigned int xdata u16ModbusFrame;          /* frames to this slave, broadcast included */
+unsigned int xdata u16ModbusCRCError;       /* frames with CRC error or shorter than 4 bytes */
+unsigned int xdata u16ModbusOverrun;        /* frames over MODBUS_FRAME_MAX */
+unsigned int xdata u16ModbusException;      /* exception replies */
+
+static MODBUS_MAP code *pModbusMap;
+static unsigned int xdata u16ModbusLen, u16ModbusCRCValue, u16ModbusTxIndex;
+static unsigned char xdata u8ModbusAddress, u8ModbusState, u8ModbusOver, u8ModbusWritten;
+
+/**
+ * @brief       Map entry holding the whole request range
+ * @return      entry, 0 when no entry of u8Type has u16Start to u16Start + u16Count - 1
+ */
+static MODBUS_MAP code *Modbus_Find(unsigned char u8Type, unsigned int u16Start, unsigned int u16Count)
+{
+    MODBUS_MAP code *pEntry;
+
+    for (pEntry = pModbusMap; pEntry->u16Count; pEntry++)
+    {
+        if ((pEntry->u8Type == u8Type) && (u16Start >= pEntry->u16Address) &&
+            ((unsigned long)u16Start + u16Count <= (unsigned long)pEntry->u16Address + pEntry->u16Count))
+            return pEntry;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Copy bits between packed arrays, source from bit u16SrcBit, destination from bit u16DstBit
+ * @details     Byte wise: each step fills the destination byte up to its end or the last bit, the source
+ *              bits are shifted in from one or two bytes and merged by mask. FC01 / FC02 replies are one step
+ *              per byte, a source byte past the last copied bit is not read.
+ */
+static void Modbus_Bit_Copy(unsigned char xdata *pu8Dst, unsigned int u16DstBit,
+                            unsigned char xdata *pu8Src, unsigned int u16SrcBit, unsigned int u16Count)
+{
+    unsigned char u8DstShift, u8SrcShift, u8Bits, u8Value, u8Mask;
+
+    pu8Dst += u16DstBit >> 3;
+    pu8Src += u16SrcBit >> 3;
+    u8DstShift = u16DstBit & 7;
+    u8SrcShift = u16SrcBit & 7;
+
+    while (u16Count)
+    {
+        u8Bits = 8 - u8DstShift;
+        if (u8Bits > u16Count)
+            u8Bits = (unsigned char)u16Count;
+
+        u8Value = *pu8Src >> u8SrcShift;
+        if (u8SrcShift + u8Bits > 8)
+            u8Value |= pu8Src[1] << (8 - u8SrcShift);
+
+        u8Mask = (unsigned char)((0xFF >> (8 - u8Bits)) << u8DstShift);
+        *pu8Dst = (*pu8Dst & ~u8Mask) | ((u8Value << u8DstShift) & u8Mask);
+
+        u8SrcShift += u8Bits;
+        if (u8SrcShift >= 8)
+        {
+            u8SrcShift -= 8;
+            pu8Src++;
+        }
+
+        u8DstShift += u8Bits;
+        if (u8DstShift == 8)
+        {
+            u8DstShift = 0;
+            pu8Dst++;
+        }
+
+        u16Count -= u8Bits;
+    }
+}
+
+/**
+ * @brief       Serve request PDU in au8ModbusFrame, reply PDU is built in place
+ * @param       u16Len frame length without CRC
+ * @return      reply length without CRC
+ * @details     Quantity and length are checked before address, exception 03 before 02 as the Modbus
+ *              application protocol state diagrams.
+ */
+static unsigned int Modbus_Execute(unsigned int u16Len)
+{
+    unsigned char xdata *pu8Frame = au8ModbusFrame;
+    unsigned int xdata *pu16Reg;
+    unsigned int u16Start, u16Count, u16Index;
+    unsigned char u8Type, u8Exception = MODBUS_EX_VALUE;
+    MODBUS_MAP code *pEntry;
+
+    u16Start = ((unsigned int)pu8Frame[2] << 8) | pu8Frame[3];
+    u16Count = ((unsigned int)pu8Frame[4] << 8) | pu8Frame[5];
+
+    switch (pu8Frame[1])
+    {
+        case 0x01:      /* Read Coils */
+        case 0x02:      /* Read Discrete Inputs */
+            if ((u16Len != 6) || (u16Count == 0) || (u16Count > 2000))
+                break;
+            u8Type = (pu8Frame[1] == 0x01) ? MODBUS_COIL : MODBUS_DISCRETE;
+            pEntry = Modbus_Find(u8Type, u16Start, u16Count);
+            if (pEntry == 0)
+            {
+                u8Exception = MODBUS_EX_ADDRESS;
+                break;
+            }
+            pu8Frame[2] = (unsigned char)((u16Count + 7) >> 3);
+            pu8Frame[2 + pu8Frame[2]] = 0;      /* unused high bits of last byte are 0 */
+            Modbus_Bit_Copy(&pu8Frame[3], 0, (unsigned char xdata *)pEntry->pvData, u16Start - pEntry->u16Address, u16Count);
+            return 3 + pu8Frame[2];
+
+        case 0x03:      /* Read Holding Registers */
+        case 0x04:      /* Read Input Registers */
+            if ((u16Len != 6) || (u16Count == 0) || (u16Count > 125))
+                break;
+            u8Type = (pu8Frame[1] == 0x03) ? MODBUS_HOLDING_REG : MODBUS_INPUT_REG;
+            pEntry = Modbus_Find(u8Type, u16Start, u16Count);
+            if (pEntry == 0)
+            {
+                u8Exception = MODBUS_EX_ADDRESS;
+                break;
+            }
+            pu16Reg = (unsigned int xdata *)pEntry->pvData + (u16Start - pEntry->u16Address);
+            pu8Frame[2] = (unsigned char)(u16Count << 1);
+            for (u16Index = 0; u16Index < u16Count; u16Index++)
+            {
+                pu8Frame[3 + (u16Index << 1)] = HIBYTE(pu16Reg[u16Index]);
+                pu8Frame[4 + (u16Index << 1)] = LOBYTE(pu16Reg[u16Index]);
+            }
+            return 3 + pu8Frame[2];
+
+        case 0x05:      /* Write Single Coil, value FF00 or 0000, reply is echo */
+            if ((u16Len != 6) || ((u16Count != 0xFF00) && (u16Count != 0x0000)))
+                break;
+            pEntry = Modbus_Find(MODBUS_COIL, u16Start, 1);
+            if (pEntry == 0)
+            {
+                u8Exception = MODBUS_EX_ADDRESS;
+                break;
+            }
+            u16Start -= pEntry->u16Address;
+            if (u16Count)
+                ((unsigned char xdata *)pEntry->pvData)[u16Start >> 3] |= au8Bit[u16Start & 7];
+            else
+                ((unsigned char xdata *)pEntry->pvData)[u16Start >> 3] &= ~au8Bit[u16Start & 7];
+            u8ModbusWritten = 0x05;
+            return 6;
+
+        case 0x06:      /* Write Single Register, reply is echo */
+            if (u16Len != 6)
+                break;
+            pEntry = Modbus_Find(MODBUS_HOLDING_REG, u16Start, 1);
+            if (pEntry == 0)
+            {
+                u8Exception = MODBUS_EX_ADDRESS;
+                break;
+            }
+            ((unsigned int xdata *)pEntry->pvData)[u16Start - pEntry->u16Address] = u16Count;
+            u8ModbusWritten = 0x06;
+            return 6;
+
+        case 0x0F:      /* Write Multiple Coils, reply is address and quantity */
+            if ((u16Len < 7) || (u16Count == 0) || (u16Count > 1968) ||
+                (pu8Frame[6] != ((u16Count + 7) >> 3)) || (u16Len != 7 + (unsigned int)pu8Frame[6]))
+                break;
+            pEntry = Modbus_Find(MODBUS_COIL, u16Start, u16Count);
+            if (pEntry == 0)
+            {
+                u8Exception = MODBUS_EX_ADDRESS;
+                break;
+            }
+            Modbus_Bit_Copy((unsigned char xdata *)pEntry->pvData, u16Start - pEntry->u16Address, &pu8Frame[7], 0, u16Count);
+            u8ModbusWritten = 0x0F;
+            return 6;
+
+        case 0x10:      /* Write Multiple Registers, reply is address and quantity */
+            if ((u16Len < 7) || (u16Count == 0) || (u16Count > 123) ||
+                (pu8Frame[6] != (u16Count << 1)) || (u16Len != 7 + (unsigned int)pu8Frame[6]))
+                break;
+            pEntry = Modbus_Find(MODBUS_HOLDING_REG, u16Start, u16Count);
+            if (pEntry == 0)
+            {
+                u8Exception = MODBUS_EX_ADDRESS;
+                break;
+            }
+            pu16Reg = (unsigned int xdata *)pEntry->pvData + (u16Start - pEntry->u16Address);
+            for (u16Index = 0; u16Index < u16Count; u16Index++)
+                pu16Reg[u16Index] = ((unsigned int)pu8Frame[7 + (u16Index << 1)] << 8) | pu8Frame[8 + (u16Index << 1)];
+            u8ModbusWritten = 0x10;
+            return 6;
+
+        default:
+            u8Exception = MODBUS_EX_FUNCTION;
+            break;
+    }
+
+    pu8Frame[1] |= 0x80;
+    pu8Frame[2] = u8Exception;
+    u16ModbusException++;
+    return 3;
+}
+
+/**
+ * @brief       Slave address and map, receive state cleared
+ * @param       u8Address 1 to 247
+ * @param       pMap table ends with u16Count 0
+ * @return      none
+ */
+void Modbus_Init(unsigned char u8Address, MODBUS_MAP code *pMap)
+{
+    u8ModbusAddress = u8Address;
+    pModbusMap = pMap;
+    u8ModbusState = MODBUS_IDLE;
+    u8ModbusOver = 0;
+    u8ModbusWritten = 0;
+    u16ModbusLen = 0;
+    u16ModbusCRCValue = 0xFFFF;
+}
+
+/**
+ * @brief       One received byte, called by UART interrupt after the frame timer is restarted
+ * @details     CRC is updated here so frame end only tests the CRC value. Bytes while replying are the
+ *              RS-485 echo and are dropped.
+ */
+void Modbus_RX_Byte(unsigned char u8Data)
+{
+    if (u8ModbusState == MODBUS_TX)
+        return;
+
+    if (u16ModbusLen < MODBUS_FRAME_MAX)
+    {
+        au8ModbusFrame[u16ModbusLen++] = u8Data;
+        u16ModbusCRCValue = MODBUS_CRC(u16ModbusCRCValue, u8Data);
+    }
+    else
+    {
+        u8ModbusOver = 1;
+    }
+}
+
+/**
+ * @brief       3.5 character silence, called by frame timer interrupt
+ * @return      1 when a reply is ready for Modbus_TX_Next, 0 for no reply
+ * @details     CRC over address to CRC high byte is 0 for a good frame. Broadcast address 0 is served
+ *              without reply.
+ */
+unsigned char Modbus_Frame_End(void)
+{
+    if ((u8ModbusState == MODBUS_TX) || (u16ModbusLen == 0))
+        return 0;
+
+    if (u8ModbusOver)
+    {
+        u16ModbusOverrun++;
+    }
+    else if ((u16ModbusLen < 4) || (u16ModbusCRCValue != 0))
+    {
+        u16ModbusCRCError++;
+    }
+    else if ((au8ModbusFrame[0] == u8ModbusAddress) || (au8ModbusFrame[0] == 0))
+    {
+        u16ModbusFrame++;
+        u16ModbusLen = Modbus_Execute(u16ModbusLen - 2);
+        if (au8ModbusFrame[0] != 0)
+        {
+            u16ModbusTxIndex = 0;
+            u16ModbusCRCValue = 0xFFFF;
+            u8ModbusState = MODBUS_TX;
+            return 1;
+        }
+    }
+
+    u16ModbusLen = 0;
+    u16ModbusCRCValue = 0xFFFF;
+    u8ModbusOver = 0;
+
+    return 0;
+}
+
+/**
+ * @brief       Next reply byte, CRC low and high byte are added after the PDU
+ * @param       pu8Data byte to send
+ * @return      1 with byte, 0 when the reply is done and receive starts again
+ */
+unsigned char Modbus_TX_Next(unsigned char *pu8Data)
+{
+    if (u8ModbusState != MODBUS_TX)
+        return 0;
+
+    if (u16ModbusTxIndex < u16ModbusLen)
+    {
+        *pu8Data = au8ModbusFrame[u16ModbusTxIndex++];
+        u16ModbusCRCValue = MODBUS_CRC(u16ModbusCRCValue, *pu8Data);
+        return 1;
+    }
+
+    if (u16ModbusTxIndex == u16ModbusLen)
+    {
+        *pu8Data = LOBYTE(u16ModbusCRCValue);
+        u16ModbusTxIndex++;
+        return 1;
+    }
+
+    if (u16ModbusTxIndex == u16ModbusLen + 1)
+    {
+        *pu8Data = HIBYTE(u16ModbusCRCValue);
+        u16ModbusTxIndex++;
+        return 1;
+    }
+
+    u8ModbusState = MODBUS_IDLE;
+    u16ModbusLen = 0;
+    u16ModbusCRCValue = 0xFFFF;
+    return 0;
+}
+
+/**
+ * @brief       Function code of the last write request, cleared by read
+ * @return      0x05, 0x06, 0x0F, 0x10 or 0 for no write
+ * @details     Called with interrupt disabled by Modbus_Poll.
+ */
+unsigned char Modbus_Written(void)
+{
+    unsigned char u8Function = u8ModbusWritten;
+
+    u8ModbusWritten = 0;
+    return u8Function;
+}
@@ -0,0 +1,247 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+
+//***********************************************************************************************************
+//  File Function: MS51 SPI ISP subroutine
+//***********************************************************************************************************
+#include "MS51_8K.H"
+#include "ISP_SPI.h"
+bit BIT_TMP;
+
+  xdata volatile uint8_t rx_buf[64]; 
+  xdata volatile uint8_t tx_buf[64];
+  data volatile uint8_t bufhead;              /* 0~63 command received, 64~127 reply sent */
+  data volatile uint16_t flash_address; 
+  data volatile uint16_t AP_size;
+  data volatile uint8_t g_timer1Counter;
+  data volatile uint8_t count; 
+  data volatile uint16_t g_timer0Counter;
+  data volatile uint16_t g_checksum;          /* sum of last received packet, by ISR */
+  data volatile uint16_t g_rxsum;             /* sum of bytes received so far */
+  data volatile uint16_t g_totalchecksum;
+  data volatile uint8_t g_blankpage;          /* pages not erased by blank check */
+  bit volatile bSPIDataReady;
+  bit volatile g_lzflag;
+  bit volatile g_timer0Over;
+  bit volatile g_timer1Over;
+  bit volatile g_progarmflag;
+
+unsigned char PID_highB,PID_lowB,DID_highB,DID_lowB,CONF0,CONF1,CONF2,CONF4;
+unsigned char recv_CONF0,recv_CONF1,recv_CONF2,recv_CONF4;
+
+
+void READ_ID(void)
+{
+    set_CHPCON_IAPEN;
+    IAPCN = READ_DID;
+    IAPAH = 0x00;
+    IAPAL = 0x00;
+    trig_IAPGO;
+    DID_lowB = IAPFD;
+    IAPAL = 0x01;
+    trig_IAPGO;
+    DID_highB = IAPFD;
+    IAPAL = 0x02;
+    trig_IAPGO;
+    PID_lowB = IAPFD;
+    IAPAL = 0x03;
+    trig_IAPGO;
+    PID_highB = IAPFD;
+}
+void READ_CONFIG(void)
+{
+    IAPCN = BYTE_READ_CONFIG;
+    IAPAL = 0x00;
+    IAPAH = 0x00;
+    trig_IAPGO;
+    CONF0 = IAPFD;
+    IAPAL = 0x01;
+    trig_IAPGO;
+    CONF1 = IAPFD;
+    IAPAL = 0x02;
+    trig_IAPGO;
+    CONF2 = IAPFD;
+    IAPAL = 0x04;
+    trig_IAPGO;
+    CONF4 = IAPFD;
+    clr_CHPCON_IAPEN;
+}
+
+void TM0_ini(void)
+{    
+  TH0=TL0=0;    //interrupt timer 140us
+  set_TCON_TR0;      //Start timer0
+  set_IPH_PSH;       // Serial port 0 interrupt level2
+  set_IE_ET0;
+}
+
+
+/* Blank check of one page by IAP read, MOVC in LDROM reads LDROM. TRUE when all bytes are 0xFF */
+bit Page_Blank_Check(uint16_t u16Addr)
+{
+    uint8_t i;
+
+    IAPCN = BYTE_READ_AP;
+    IAPAH = HIBYTE(u16Addr);
+
+    for (i = 0; i < PAGE_SIZE; i++)
+    {
+        IAPAL = LOBYTE(u16Addr) + i;            //page aligned, low byte not carry
+        set_IAPTRG_IAPGO;
+        if (IAPFD != 0xFF)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+void Package_checksum(void)
+{
+  /* g_checksum is summed by receive ISR, only low 16 bits are replied */
+  tx_buf[0]=g_checksum&0xff;
+  tx_buf[1]=(g_checksum>>8)&0xff;
+  tx_buf[4]=rx_buf[4]+1;
+  tx_buf[5]=rx_buf[5];
+  if(tx_buf[4]==0x00)
+  tx_buf[5]++;
+  
+}
+
+/* Decompress payload from u8Start to end of packet into APROM, TRUE when AP_size reached */
+bit Program_Compressed(uint8_t u8Start)
+{
+    uint8_t u8Data;
+
+    LZ_Decode_Input((uint8_t xdata *)&rx_buf[u8Start], 64 - u8Start);
+
+    while (LZ_Decode_Byte(&u8Data) == PASS)
+    {
+        IAPCN = BYTE_PROGRAM_AP;
+        IAPAL = flash_address & 0xff;
+        IAPAH = (flash_address >> 8) & 0xff;
+        IAPFD = u8Data;
+        set_IAPTRG_IAPGO_WDCLR;
+
+        IAPCN = BYTE_READ_AP;                   //program byte verify
+        set_IAPTRG_IAPGO;
+        if (IAPFD != u8Data)
+            while (1);
+
+        g_totalchecksum = g_totalchecksum + u8Data;
+        flash_address++;
+
+        if (flash_address == AP_size)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+void Timer0_ISR (void) interrupt 1
+{
+if(g_timer0Counter)
+  {
+  g_timer0Counter--;
+    if(!g_timer0Counter)
+    {
+    g_timer0Over=1;
+    }
+  }
+  
+  if(g_timer1Counter)
+  {
+  g_timer1Counter--;
+    if(!g_timer1Counter)
+    {
+    g_timer1Over=1;
+    }
+  }
+}
+
+void Init_SPI(void)
+{
+    P05_QUASI_MODE;                            //P05 (SS) Quasi mode
+    P10_QUASI_MODE;                            //P10 (SPCLK) Quasi mode
+    P00_QUASI_MODE;                            //P00 (MOSI) Quasi mode
+    P01_QUASI_MODE;                            //P01 (MISO) Quasi mode
+    P03_PUSHPULL_MODE;                         //P03 (READY) Push-pull mode
+    ISP_READY_PIN = 0;
+
+    clr_SPCR_MSTR;                             // SPI in Slave mode
+    clr_SPCR_LSBFE;                            // MSB first
+    clr_SPCR_CPOL;                             // The SPI clock is low in idle mode
+    set_SPCR_CPHA;                             // The data is sample on the second edge of SPI clock
+
+    ENABLE_SPI0_INTERRUPT;                     // Enable SPI interrupt
+    set_SPCR_SPIEN;                            // Enable SPI function
+    clr_SPSR_SPIF;
+    SPDR = 0xFF;
+
+    bufhead = 0;
+    g_rxsum = 0;
+    ISP_READY_PIN = 1;                         // ready for first command
+    EA=1;
+}
+
+/* Reply is in tx_buf, preload first byte and tell master by READY high */
+void SPI_Reply_Ready(void)
+{
+    SPDR = tx_buf[0];
+    g_timer1Over = 0;
+    g_timer1Counter = SPI_FRAME_TIMEOUT;
+    ISP_READY_PIN = 1;
+}
+
+/*
+  One frame is 128 bytes with SS low: 64 command bytes, master waits READY high, then clocks 64 reply bytes.
+  READY is pulled low at the first command byte, so the high of the last reply is gone long before the 64th
+  byte and the next high means this command is done and its reply is in SPDR / tx_buf. See ISP_SPI.h for
+  the gap the master leaves between bytes.
+*/
+void SPI_ISR(void) interrupt 9
+{
+    uint8_t u8data;
+
+    clr_SPSR_SPIF;
+    u8data = SPDR;
+
+    if (bufhead < 64)
+    {
+        g_rxsum += u8data;
+        rx_buf[bufhead++] = u8data;
+
+        if (bufhead == 1)
+        {
+            ISP_READY_PIN = 0;                 // busy until reply of this command is loaded
+            g_timer1Over = 0;
+            g_timer1Counter = SPI_FRAME_TIMEOUT;
+        }
+        else if (bufhead == 64)
+        {
+            g_checksum = g_rxsum;
+            g_rxsum = 0;
+            g_timer1Counter = 0;
+            bSPIDataReady = TRUE;
+        }
+    }
+    else
+    {
+        bufhead++;
+
+        if (bufhead == 128)
+        {
+            bufhead = 0;
+            g_timer1Counter = 0;
+        }
+        else
+        {
+            SPDR = tx_buf[bufhead - 64];
+        }
+    }
+}
@@ -14,6 +14,10 @@
 
 //#define  isp_with_wdt
 unsigned int xdata start_address,u16_addr;
+unsigned int xdata u16_crc;
+unsigned char xdata u8_page, u8_mode;
+unsigned int xdata u16_packno;
+unsigned long xdata u32_baud;
 /************************************************************************************************************
 *    Main function 
 ************************************************************************************************************/
@@ -25,8 +29,17 @@ void main (void)
 #ifdef  isp_with_wdt
   TA=0x55;TA=0xAA;WDCON=0x07;
 #endif
+#if ISP_BAUDRATE_ENABLE
+//uart initial for ISP programmer GUI, baud rate detected from CMD_CONNECT
+  g_baudDivisor = Autobaud_Detect();            //baud rate of host CMD_CONNECT sync byte
+  if(g_baudDivisor == 0)
+    goto _APROM;
+  UART0_ini_115200_24MHz();
+  Timer3_Set_Divisor(g_baudDivisor);
+#else
 //uart initial for ISP programmer GUI, always use 115200 baudrate
   UART0_ini_115200_24MHz();
+#endif
   TM0_ini();
 
   g_timer0Over=0;
@@ -37,9 +50,27 @@ while(1)
 {
         if(bUartDataReady == TRUE)
         {
-          EA=0; //DISABLE ALL INTERRUPT
+#if ISP_BAUDRATE_ENABLE
+          if(g_baudTrial)                         //packet received in new baud rate
+          {
+            g_baudTrial=0;
+            g_timer0Counter=0;
+          }
+#endif
           if(g_programflag==1)
           {
+#if ISP_COMPRESSED_ENABLE
+            if(g_lzflag)
+            {
+              if(Program_Compressed(8))
+              {
+                g_programflag=0;
+                if(!g_deltaflag)                //delta update stays in ISP for next page range
+                  g_timer0Over=1;
+              }
+              goto END_2;
+            }
+#endif
             for(count=8;count<64;count++)
             {
               IAPCN = BYTE_PROGRAM_AP;          //program byte
@@ -53,6 +84,8 @@ while(1)
 #endif
           
               IAPCN = BYTE_READ_AP;              //program byte verify
+              set_IAPTRG_IAPGO;
+
               if(IAPFD!=uart_rcvbuf[count])
               while(1);                          
               if (CHPCON==0x43)                  //if error flag set, program error stop ISP
@@ -64,7 +97,8 @@ while(1)
               if(flash_address==AP_size)
               {
                  g_programflag=0;
-                 g_timer0Over =1;
+                 if(!g_deltaflag)
+                   g_timer0Over =1;
                  goto END_2;
               }
             } 
@@ -91,10 +125,39 @@ END_2:
             {
               Package_checksum();
               uart_txbuf[8]=FW_VERSION;
+              uart_txbuf[9]=ISP_FEATURE;
               Send_64byte_To_UART0();
               break;
             }
             
+#if ISP_BAUDRATE_ENABLE
+            case CMD_SET_BAUDRATE:
+            {
+              u32_baud = uart_rcvbuf[8];
+              u32_baud |= ((uint32_t)uart_rcvbuf[9]<<8);
+              u32_baud |= ((uint32_t)uart_rcvbuf[10]<<16);
+              u32_baud |= ((uint32_t)uart_rcvbuf[11]<<24);
+              u32_baud = Baud_Negotiate(u32_baud);
+              Package_checksum();
+              uart_txbuf[8]=u32_baud&0xff;
+              uart_txbuf[9]=(u32_baud>>8)&0xff;
+              uart_txbuf[10]=(u32_baud>>16)&0xff;
+              uart_txbuf[11]=(u32_baud>>24)&0xff;
+              Send_64byte_To_UART0();
+              if(u32_baud)                            //reply in old baud rate, then switch
+              {
+                while(bUartTxBusy);
+                g_baudPrevious=g_baudDivisor;
+                g_baudDivisor=Baud_Divisor(u32_baud);
+                Timer3_Set_Divisor(g_baudDivisor);
+                g_baudTrial=1;
+                g_timer0Counter=Baud_Trial_Counter;
+                g_timer0Over=0;
+              }
+              break;
+            }
+#endif
+
             case CMD_RUN_APROM:
             {
               goto _APROM;
@@ -118,19 +181,29 @@ END_2:
             {
 //              set_CHPCON_IAPEN;
               set_IAPUEN_APUEN;
-              IAPFD = 0xFF;             //Erase must set IAPFD = 0xFF
-              IAPCN = PAGE_ERASE_AP;
+              g_blankpage=0;
               for(flash_address=0x0000;flash_address<APROM_SIZE/PAGE_SIZE;flash_address++)
-              {        
-                IAPAL = LOBYTE(flash_address*PAGE_SIZE);
-                IAPAH = HIBYTE(flash_address*PAGE_SIZE);
+              {
+                if(Page_Blank_Check(flash_address*PAGE_SIZE))  //blank page need not erase
+                {
+                  g_blankpage++;
+                }
+                else
+                {
+                  IAPFD = 0xFF;             //Erase must set IAPFD = 0xFF
+                  IAPCN = PAGE_ERASE_AP;
+                  IAPAL = LOBYTE(flash_address*PAGE_SIZE);
+                  IAPAH = HIBYTE(flash_address*PAGE_SIZE);
 #ifdef isp_with_wdt
-              set_IAPTRG_IAPGO_WDCLR;
+                  set_IAPTRG_IAPGO_WDCLR;
 #else
-              set_IAPTRG_IAPGO;
+                  set_IAPTRG_IAPGO;
 #endif
+                }
               }
               Package_checksum();
+              uart_txbuf[10]=g_blankpage;
+              uart_txbuf[11]=0;
               Send_64byte_To_UART0();
               break;
             }
@@ -212,12 +285,84 @@ END_2:
               break;
             }
 
+#if ISP_PAGE_CRC_ENABLE
+            case CMD_READ_PAGE_CRC:
+            {
+              start_address = uart_rcvbuf[8];
+              start_address |= ((uart_rcvbuf[9]<<8)&0xFF00);
+              start_address &= ~(PAGE_SIZE-1);
+              u8_page = uart_rcvbuf[10];
+              if(u8_page > PAGE_CRC_MAX)
+                u8_page = PAGE_CRC_MAX;
+              if(start_address >= APROM_SIZE)
+                u8_page = 0;
+              else if(u8_page > (APROM_SIZE - start_address)/PAGE_SIZE)   //pages not over APROM
+                u8_page = (APROM_SIZE - start_address)/PAGE_SIZE;
+              READ_CONFIG();
+              if(!(CONF0&CONFIG0_LOCK))                   //locked chip replies no CRC
+                u8_page = 0;
+              Package_checksum();
+              uart_txbuf[2]=u8_page;                      //number of CRC replied
+              for(count=0;count<u8_page;count++)
+              {
+                u16_crc = Page_CRC16(start_address);
+                uart_txbuf[8+count*2]=u16_crc&0xff;
+                uart_txbuf[9+count*2]=(u16_crc>>8)&0xff;
+                start_address += PAGE_SIZE;
+#ifdef isp_with_wdt
+                set_WDCON_WDCLR;
+#endif
+              }
+              Send_64byte_To_UART0();
+              break;
+            }
+#endif
+
+#if ISP_READ_APROM_ENABLE
+            case CMD_READ_APROM:
+            {
+              start_address = uart_rcvbuf[8];
+              start_address |= ((uart_rcvbuf[9]<<8)&0xFF00);
+              u16_addr = uart_rcvbuf[12];
+              u16_addr |= ((uart_rcvbuf[13]<<8)&0xFF00);
+              if(start_address > APROM_SIZE)
+                start_address = APROM_SIZE;
+              if(u16_addr > APROM_SIZE - start_address)   //read end address, not over APROM
+                u16_addr = APROM_SIZE;
+              else
+                u16_addr += start_address;
+              READ_CONFIG();
+              if(!(CONF0&CONFIG0_LOCK))                   //locked chip replies no data
+                u16_addr = start_address;
+              u8_mode = uart_rcvbuf[10];
+              u16_packno = uart_rcvbuf[4];
+              u16_packno |= ((uart_rcvbuf[5]<<8)&0xFF00);
+              do                                          //continuous mode fills next packet while last one is sent
+              {
+                Package_checksum();
+                u16_packno++;
+                uart_txbuf[4]=u16_packno&0xff;
+                uart_txbuf[5]=(u16_packno>>8)&0xff;
+                start_address += Read_APROM_Packet(start_address, u16_addr);
+                Send_64byte_To_UART0();
+#ifdef isp_with_wdt
+                set_WDCON_WDCLR;
+#endif
+              } while((u8_mode&READ_APROM_CONTINUOUS) && (start_address<u16_addr));
+              break;
+            }
+#endif
+
+#if ISP_PAGE_CRC_ENABLE
+            case CMD_UPDATE_APROM_PAGE:
+#endif
+#if ISP_COMPRESSED_ENABLE
+            case CMD_UPDATE_APROM_COMPRESSED:
+#endif
             case CMD_UPDATE_APROM:
             {
 //              g_timer0Counter=Timer0Out_Counter;
               set_IAPUEN_APUEN;
-              IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
-              IAPCN = PAGE_ERASE_AP;
               
               start_address = 0;
               start_address = uart_rcvbuf[8];
@@ -225,26 +370,58 @@ END_2:
               AP_size = 0;
               AP_size = uart_rcvbuf[12];
               AP_size |= ((uart_rcvbuf[13]<<8)&0xFF00);
+              if(start_address > APROM_SIZE)              //range not over APROM, no erase or program after it
+                start_address = APROM_SIZE;
+              if(AP_size > APROM_SIZE - start_address)
+                AP_size = APROM_SIZE - start_address;
 
               u16_addr = start_address + AP_size;
-              flash_address = (start_address&0xFF00);
+              flash_address = (start_address&~(PAGE_SIZE-1));  //erase from page of start address
  
+              g_blankpage=0;
               while(flash_address< u16_addr)
               {
-                IAPAL = LOBYTE(flash_address);
-                IAPAH = HIBYTE(flash_address);
+                if(Page_Blank_Check(flash_address))  //blank page need not erase
+                {
+                  g_blankpage++;
+                }
+                else
+                {
+                  IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
+                  IAPCN = PAGE_ERASE_AP;
+                  IAPAL = LOBYTE(flash_address);
+                  IAPAH = HIBYTE(flash_address);
 #ifdef isp_with_wdt
-                set_IAPTRG_IAPGO_WDCLR;
+                  set_IAPTRG_IAPGO_WDCLR;
 #else
-                set_IAPTRG_IAPGO;
+                  set_IAPTRG_IAPGO;
 #endif
+                }
                 flash_address += PAGE_SIZE;
               }
               
               g_totalchecksum = 0;
               flash_address = start_address;
               g_programflag = 1;
+              AP_size = u16_addr;                         //program end address
+              g_deltaflag = (uart_rcvbuf[0]==CMD_UPDATE_APROM_PAGE);
 
+              g_lzflag=0;
+              if(flash_address==AP_size)                  //nothing to program
+              {
+                g_programflag=0;
+                goto END_1;
+              }
+#if ISP_COMPRESSED_ENABLE
+              if(uart_rcvbuf[0]==CMD_UPDATE_APROM_COMPRESSED)
+              {
+                g_lzflag=1;
+                LZ_Decode_Init();
+                if(Program_Compressed(16))
+                  g_programflag=0;
+                goto END_1;
+              }
+#endif
               for(count=16;count<64;count++)
               {
                 IAPCN = BYTE_PROGRAM_AP;
@@ -277,33 +454,49 @@ END_1:
               Package_checksum();
               uart_txbuf[8]=g_totalchecksum&0xff;
               uart_txbuf[9]=(g_totalchecksum>>8)&0xff;
+              uart_txbuf[10]=g_blankpage;
+              uart_txbuf[11]=0;
               Send_64byte_To_UART0();  
               break;
             }
           }  
-          bUartDataReady = FALSE;
-          bufhead = 0;
-
-          EA=1;
+          UART0_Rx_Release();                   //uart_rcvbuf done, next packet may be handed over
       }
       /*For connect timer out   */
       if(g_timer0Over==1)
       {
-        _nop_();
-        goto _APROM;
+#if ISP_BAUDRATE_ENABLE
+        if(g_baudTrial)                         //no packet in new baud rate, back to old one
+        {
+          g_baudDivisor=g_baudPrevious;
+          Timer3_Set_Divisor(g_baudDivisor);
+          g_baudTrial=0;
+          g_timer0Over=0;
+        }
+        else
+#endif
+        {
+          _nop_();
+          goto _APROM;
+        }
       }
       
       /*for uart time out or buffer error  */
-       if(g_timer1Over==1)
+      if(g_timer1Over==1)
       {
-       if((bufhead<64)&&(bufhead>0)||(bufhead>64))
-         {
-             bufhead=0;
-         }
-      }  
+        EA=0;                                   //Serial_ISR may store byte 0 of next packet
+        if((bufhead<64)&&(bufhead>0)||(bufhead>64))
+        {
+          bufhead=0;
+          g_rxsum=0;
+        }
+        g_timer1Over=0;
+        EA=1;
+      }
 }   
 
 _APROM:
+    while(bUartTxBusy);                                    //last reply sent out before reset
     MODIFY_HIRC_16();
     clr_CHPCON_IAPEN;
     TA = 0xAA; TA = 0x55; CHPCON = 0x80;                   //software reset enable boot from APROM
@@ -0,0 +1,66 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 Modbus RTU slave address 1 on UART0 9600 bps 8N1, project define MODBUS_ENABLE=1
+//  Coil 0-15, discrete input 0-7 (copy of coil 0-7), input register 0-3 (frame, CRC error, overrun,
+//  exception counter), holding register 0-7.
+//***********************************************************************************************************
+#include "MS51_8K.h"
+
+unsigned char xdata au8Coil[2];
+unsigned char xdata au8Discrete[1];
+unsigned int xdata au16InputReg[4];
+unsigned int xdata au16HoldingReg[8];
+
+MODBUS_MAP code ModbusMap[] =
+{
+    {MODBUS_COIL,        0, 16, au8Coil},
+    {MODBUS_DISCRETE,    0, 8,  au8Discrete},
+    {MODBUS_INPUT_REG,   0, 4,  au16InputReg},
+    {MODBUS_HOLDING_REG, 0, 8,  au16HoldingReg},
+    {0, 0, 0, 0}
+};
+
+/* Frame gap timer of Modbus, MODBUS_TIMER 0 */
+void Timer0_ISR(void) interrupt 1
+{
+    _push_(SFRS);
+    Modbus_Timer_ISR();
+    _pop_(SFRS);
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned char u8Function;
+    bit bEA;
+
+    MODIFY_HIRC(HIRC_24);
+    P06_QUASI_MODE;
+    P07_INPUT_MODE;
+    Modbus_Open(24000000, 9600, 1, ModbusMap);
+    ENABLE_GLOBAL_INTERRUPT;
+
+/* Requests are served in interrupt, main loop follows written data and counters */
+    while (1)
+    {
+        u8Function = Modbus_Poll();
+        if ((u8Function == 0x05) || (u8Function == 0x0F))
+            au8Discrete[0] = au8Coil[0];
+
+        bEA = EA;
+        EA = 0;
+        au16InputReg[0] = u16ModbusFrame;
+        au16InputReg[1] = u16ModbusCRCError;
+        au16InputReg[2] = u16ModbusOverrun;
+        au16InputReg[3] = u16ModbusException;
+        EA = bEA;
+    }
+}
@@ -0,0 +1,107 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 printf through UART0 TX ring, compare CPU time of one printf with library putchar
+//  Project define UART_RING_ENABLE=1, UART0_TX_RING_SIZE=64, PUTCHAR_OVERFLOW=PUTCHAR_BLOCK
+//***********************************************************************************************************
+#include "MS51_8K.h"
+
+/**
+ * @brief       Restart Timer0 from 0, Fsys/12 mode 1
+ * @param       None
+ * @return      None
+ */
+void Timer0_Start(void)
+{
+    clr_TCON_TR0;
+    TH0 = 0;
+    TL0 = 0;
+    set_TCON_TR0;
+}
+
+/**
+ * @brief       Stop Timer0
+ * @param       None
+ * @return      Timer0 ticks, 0.5us per tick at 24MHz
+ */
+unsigned int Timer0_Stop(void)
+{
+    clr_TCON_TR0;
+    return ((unsigned int)TH0 << 8) | TL0;
+}
+
+/**
+ * @brief       Send string the same way as Keil library putchar
+ * @param       pcStr string end with 0
+ * @return      None
+ * @details     Wait TI before every character, '\n' is sent as CR LF. UART0 interrupt must be disabled.
+ */
+void Blocking_Puts(char *pcStr)
+{
+    while (*pcStr)
+    {
+        if (*pcStr == '\n')
+        {
+            while (!TI);
+            TI = 0;
+            SBUF = 0x0D;
+        }
+
+        while (!TI);
+        TI = 0;
+        SBUF = *pcStr++;
+    }
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned int u16Format, u16Block, u16Ring;
+    unsigned int u16Value = 1234;
+    unsigned char u8State = 0x5A;
+    char xdata acLine[48];
+
+    MODIFY_HIRC(HIRC_24);
+    P06_QUASI_MODE;
+    P07_INPUT_MODE;
+    UART_Open(24000000, UART0_Timer3, 115200);
+    TIMER0_FSYS_DIV12;
+    ENABLE_TIMER0_MODE1;
+
+/* Format only */
+    Timer0_Start();
+    sprintf(acLine, "\nADC %u, state 0x%bX", u16Value, u8State);
+    u16Format = Timer0_Stop();
+
+/* Before: UART0 interrupt disabled, TI polled for every character like library putchar */
+    SFRS = 0;
+    TI = 1;
+    Timer0_Start();
+    sprintf(acLine, "\nADC %u, state 0x%bX", u16Value, u8State);
+    Blocking_Puts(acLine);
+    u16Block = Timer0_Stop();
+
+    while (!TI);
+
+/* After: printf queues to TX ring and returns, TI interrupt sends */
+    UART_Ring_Open(UART0);
+    ENABLE_GLOBAL_INTERRUPT;
+    Timer0_Start();
+    printf("\nADC %u, state 0x%bX", u16Value, u8State);
+    u16Ring = Timer0_Stop();
+
+    printf("\n\nOne printf of %bu characters, Timer0 0.5us tick", (unsigned char)(strlen(acLine) + 1));
+    printf("\nformat only      %u", u16Format);
+    printf("\nlibrary putchar  %u", u16Block);
+    printf("\nring putchar     %u", u16Ring);
+    printf("\nTX ring max %bu, dropped %u\n", u8UART0TxHighWater, u16PutcharDrop);
+
+    while (1);
+}
@@ -0,0 +1,62 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 UART0 interrupt ring buffer echo demo, project define UART_RING_ENABLE=1
+//***********************************************************************************************************
+#include "MS51_8K.h"
+
+/**
+ * @brief       Queue string to UART0 TX ring
+ * @param       pcStr string end with 0
+ * @return      None
+ * @details     Wait only while TX ring is full.
+ */
+void UART0_Ring_Puts(char *pcStr)
+{
+    while (*pcStr)
+    {
+        if (UART_Ring_Write(UART0, *pcStr))
+            pcStr++;
+    }
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned char u8Data;
+    char xdata acLine[48];
+
+    MODIFY_HIRC(HIRC_24);
+    P06_QUASI_MODE;
+    P07_INPUT_MODE;
+    UART_Open(24000000, UART0_Timer3, 115200);
+    UART_Ring_Open(UART0);
+    ENABLE_GLOBAL_INTERRUPT;
+
+    UART0_Ring_Puts("\r\nUART0 ring echo, '?' prints ring counters\r\n");
+
+/* Bytes received while main loop is busy wait in RX ring, echo is queued to TX ring */
+    while (1)
+    {
+        while (UART_Ring_Read(UART0, &u8Data))
+        {
+            if (u8Data == '?')
+            {
+                sprintf(acLine, "\r\nRX max %bu, TX max %bu, overrun %u\r\n",
+                        u8UART0RxHighWater, u8UART0TxHighWater, u16UART0RxOverrun);
+                UART0_Ring_Puts(acLine);
+            }
+            else
+            {
+                while (!UART_Ring_Write(UART0, u8Data));
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 tokenized log from interrupt and main loop, sent by UART0 TX ring
+//  Project define TLOG_ENABLE=1, TLOG_ASM_ENABLE=1, UART_RING_ENABLE=1, tlog_fast.A51 writes TLOG2 / TLOG3
+//  TLOG2 is used only in Timer0_ISR, TLOG0 / TLOG3 only in main loop, TLog_n are not reentrant
+//  Host : tlog_host table uart0_tlog.tbl UART0_TLOG.c
+//         tlog_host decode uart0_tlog.tbl /dev/ttyUSB0
+//***********************************************************************************************************
+#define TLOG_FILE_ID    1
+#include "MS51_8K.h"
+
+#define TH0_INIT        0x10
+#define TL0_INIT        0x00
+
+unsigned int data u16Tick;
+
+/************************************************************************************************************
+*    TIMER 0 interrupt subroutine, log costs ID and argument store only
+************************************************************************************************************/
+void Timer0_ISR(void) interrupt 1
+{
+    _push_(SFRS);
+
+    TH0 = TH0_INIT;
+    TL0 = TL0_INIT;
+    TF0 = 0;
+    u16Tick++;
+
+    if ((u16Tick & 0x1F) == 0)
+        TLOG2("\ntimer0 tick %u, SP 0x%bX", u16Tick, SP);
+
+    _pop_(SFRS);
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned char u8Data;
+    unsigned int u16Loop = 0;
+
+    MODIFY_HIRC(HIRC_24);
+    P06_QUASI_MODE;
+    P07_INPUT_MODE;
+    UART_Open(24000000, UART0_Timer3, 115200);
+    UART_Ring_Open(UART0);
+    TLog_Open();
+    TLOG0("\nUART0 tokenized log start");
+
+    ENABLE_TIMER0_MODE1;
+    TIMER0_FSYS_DIV12;
+    TH0 = TH0_INIT;
+    TL0 = TL0_INIT;
+    ENABLE_TIMER0_INTERRUPT;
+    ENABLE_GLOBAL_INTERRUPT;
+    set_TCON_TR0;
+
+/* Log output is moved to UART0 TX ring in idle time, received byte is logged with loop count */
+    while (1)
+    {
+        u16Loop++;
+
+        if (UART_Ring_Read(UART0, &u8Data))
+            TLOG3("\nRX '%c' 0x%bX at loop %u", u8Data, u8Data, u16Loop);
+
+        TLog_Flush();
+    }
+}
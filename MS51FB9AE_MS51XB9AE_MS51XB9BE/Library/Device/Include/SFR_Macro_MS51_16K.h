@@ -17,17 +17,27 @@
 #include "Function_define_MS51_16K.h"
 #include "bod.h"
 #include "common.h"
+#include "crc.h"
 #include "Delay.h"
 #include "eeprom.h"
+#include "eeprom_log.h"
+#include "eeprom_record.h"
+#include "flash_wear.h"
 #include "i2c.h"
 #include "IAP.h"
 #include "IAP_SPROM.h"
 #include "isr.h"
+#include "lz_decode.h"
+#include "memcpy_code.h"
+#include "modbus.h"
 #include "eeprom_sprom.h"
 #include "pwm.h"
 #include "spi.h"
 #include "sys.h"
+#include "tlog.h"
 #include "uart.h"
+#include "uart_putchar.h"
+#include "uart_ring.h"
 #include "watchdog.h"
 #include "wkt.h"
 
@@ -292,7 +302,7 @@
 
 /**** IAPTRG    A4H  ****  TA protect register ****/
 #define set_IAPTRG_IAPGO         BIT_TMP=EA;EA=0;TA=0xAA;TA=0x55;IAPTRG|=0x01;EA=BIT_TMP
-#define set_IAPTRG_IAPGO_WDCLR   BIT_TMP=EA;EA=0;set_WDCON_WDCLR;TA=0xAA;TA=0x55;IAPTRG|=0x01;EA=BIT_TMP
+#define set_IAPTRG_IAPGO_WDCLR   set_WDCON_WDCLR;BIT_TMP=EA;EA=0;TA=0xAA;TA=0x55;IAPTRG|=0x01;EA=BIT_TMP
 #define clr_IAPTRG_IAPGO         BIT_TMP=EA;EA=0;TA=0xAA;TA=0x55;IAPTRG&=0xFE;EA=BIT_TMP
 
 /**** IAPUEN    A5H **** TA protect register ****/ 
@@ -16,6 +16,8 @@
 #define   LPBOD_Mode_3       0x06
 
 
+extern bit bod_event_flag;
+
 void BOD_Open(unsigned char u8bodstatus, unsigned char u8bodlevel, unsigned char u8bodresetstatus);
 void BOD_LowPower(unsigned char u8LPBDD);
 void BOD_Interrupt (unsigned char u8bodINTstatus);
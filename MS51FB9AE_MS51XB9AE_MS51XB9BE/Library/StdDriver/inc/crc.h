@@ -0,0 +1,16 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  CRC-16/CCITT (poly 0x1021, MSB first) and CRC-32 (poly 0xEDB88320, LSB first), 16 entries nibble table */
+/*  CRC-16 result = CRC16_xxx(CRC16_INIT,...), CRC-32 result = CRC32_xxx(CRC32_INIT,...) ^ CRC32_XOROUT    */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     CRC16_INIT              0xFFFF
+#define     CRC32_INIT              0xFFFFFFFF
+#define     CRC32_XOROUT            0xFFFFFFFF
+
+unsigned int CRC16_Update(unsigned int u16CRC, unsigned char u8Data);
+unsigned int CRC16_Buffer(unsigned int u16CRC, const unsigned char *pu8Data, unsigned int u16Size);
+unsigned int CRC16_APROM(unsigned int u16CRC, unsigned int u16Addr, unsigned int u16Size);
+unsigned int CRC16_LDROM(unsigned int u16CRC, unsigned int u16Addr, unsigned int u16Size);
+unsigned long CRC32_Update(unsigned long u32CRC, unsigned char u8Data);
+unsigned long CRC32_Buffer(unsigned long u32CRC, const unsigned char *pu8Data, unsigned int u16Size);
+unsigned long CRC32_APROM(unsigned long u32CRC, unsigned int u16Addr, unsigned int u16Size);
+unsigned long CRC32_LDROM(unsigned long u32CRC, unsigned int u16Addr, unsigned int u16Size);
@@ -0,0 +1,12 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Block copy from code space (APROM / SPROM) by MOVC, source and destination pointers kept in the two    */
+/*  data pointers selected by AUXR1.DPS. Implemented in memcpy_code.A51.                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     PTR_TYPE_IDATA          0x00        /* Keil C51 generic pointer memory type byte */
+#define     PTR_TYPE_XDATA          0x01
+#define     PTR_TYPE_PDATA          0xFE
+#define     PTR_TYPE_CODE           0xFF
+#define     GENERIC_PTR_TYPE(p)     (*(unsigned char *)&(p))
+
+void memcpy_code_to_xdata(unsigned char xdata *pu8Dst, unsigned char code *pu8Src, unsigned int u16Size);
+void memcpy_code_to_idata(unsigned char idata *pu8Dst, unsigned char code *pu8Src, unsigned char u8Size);
@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Tokenized log define                                                                                   */
+/*  TLOGn("format", a, ...) stores a 16 bit message ID and n 16 bit arguments in an xdata ring, the format */
+/*  string is not compiled. Message ID = TLOG_FILE_ID << 11 | __LINE__, one TLOGn per source line.         */
+/*  Tool/TLog_Host/tlog_host builds the ID table from the sources and decodes the UART stream on the host. */
+/*  Set TLOG_ENABLE=1 in project C51 define and add tlog.c, TLOGn is removed when TLOG_ENABLE is 0.        */
+/*  TLog_0 ~ TLog_3 are not reentrant, Keil keeps their arguments and locals in fixed overlay memory. Use  */
+/*  each TLOGn in one context only, e.g. TLOG2 in one ISR, TLOG0 / TLOG1 / TLOG3 in main loop. The ring    */
+/*  is shared by all contexts, records are written with EA = 0.                                            */
+/*  TLOG_ASM_ENABLE=1 with tlog_fast.A51 in the project writes TLOG1 ~ TLOG3 records that do not wrap the  */
+/*  ring in assembly, see the clock counts there.                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef TLOG_ENABLE
+#define     TLOG_ENABLE             0
+#endif
+
+#ifndef TLOG_ASM_ENABLE
+#define     TLOG_ASM_ENABLE         0       /* 1: add tlog_fast.A51, same TLOG_RING_SIZE in A51 define */
+#endif
+
+#ifndef TLOG_RING_SIZE
+#define     TLOG_RING_SIZE          128     /* power of 2 from 16 to 128 */
+#endif
+#ifndef TLOG_UART_PORT
+#define     TLOG_UART_PORT          UART0   /* TLog_Flush output, needs UART_RING_ENABLE=1 */
+#endif
+#ifndef TLOG_FILE_ID
+#define     TLOG_FILE_ID            0       /* 0 to 31, define before include MCU header in each logging file */
+#endif
+
+#define     TLOG_ID                 ((unsigned int)(TLOG_FILE_ID) << 11 | __LINE__)
+
+#if TLOG_ENABLE
+#define     TLOG0(fmt)              TLog_0(TLOG_ID)
+#define     TLOG1(fmt, a)           TLog_1(TLOG_ID, (unsigned int)(a))
+#define     TLOG2(fmt, a, b)        TLog_2(TLOG_ID, (unsigned int)(a), (unsigned int)(b))
+#define     TLOG3(fmt, a, b, c)     TLog_3(TLOG_ID, (unsigned int)(a), (unsigned int)(b), (unsigned int)(c))
+#else
+#define     TLOG0(fmt)
+#define     TLOG1(fmt, a)
+#define     TLOG2(fmt, a, b)
+#define     TLOG3(fmt, a, b, c)
+#endif
+
+extern unsigned int xdata u16TLogDrop;                               /* records lost with ring full */
+
+void TLog_Open(void);
+void TLog_0(unsigned int u16Id);
+void TLog_1(unsigned int u16Id, unsigned int u16A);
+void TLog_2(unsigned int u16Id, unsigned int u16A, unsigned int u16B);
+void TLog_3(unsigned int u16Id, unsigned int u16A, unsigned int u16B, unsigned int u16C);
+unsigned char TLog_Read(unsigned char *pu8Data);
+void TLog_Flush(void);
@@ -0,0 +1,35 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  UART0 / UART1 interrupt ring buffer define                                                             */
+/*  RX and TX rings in xdata, each size power of 2 from 2 to 128 bytes.                                    */
+/*  Set UART_RING_ENABLE=1 in project C51 define and add uart_ring.c, then vector 4 / 15 of uart.c or      */
+/*  isr.c call UART0_Ring_ISR / UART1_Ring_ISR. TI is owned by the ring, do not use ENABLE_UARTx_PRINTF.   */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef UART_RING_ENABLE
+#define     UART_RING_ENABLE        0
+#endif
+
+#ifndef UART0_RX_RING_SIZE
+#define     UART0_RX_RING_SIZE      32
+#endif
+#ifndef UART0_TX_RING_SIZE
+#define     UART0_TX_RING_SIZE      32
+#endif
+#ifndef UART1_RX_RING_SIZE
+#define     UART1_RX_RING_SIZE      32
+#endif
+#ifndef UART1_TX_RING_SIZE
+#define     UART1_TX_RING_SIZE      32
+#endif
+
+extern unsigned int xdata u16UART0RxOverrun, u16UART1RxOverrun;     /* received bytes lost with RX ring full */
+extern unsigned char xdata u8UART0RxHighWater, u8UART0TxHighWater;   /* max bytes ever queued in ring */
+extern unsigned char xdata u8UART1RxHighWater, u8UART1TxHighWater;
+
+void UART_Ring_Open(unsigned char u8UARTPort);
+unsigned char UART_Ring_Write(unsigned char u8UARTPort, unsigned char u8Data);
+void UART_Ring_TX_Poll(unsigned char u8UARTPort);
+unsigned char UART_Ring_Read(unsigned char u8UARTPort, unsigned char *pu8Data);
+unsigned char UART_Ring_Available(unsigned char u8UARTPort);
+unsigned char UART_Ring_TX_Free(unsigned char u8UARTPort);
+void UART0_Ring_ISR(void);
+void UART1_Ring_ISR(void);
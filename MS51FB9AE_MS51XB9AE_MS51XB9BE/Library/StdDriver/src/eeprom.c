@@ -7,14 +7,13 @@
 
 #include "MS51_16K.H"
 
-
-volatile unsigned char xdata page_buffer[128];
 /**
  * @brief       Write Dataflash as EEPROM, 
  * @param       u16EPAddr the 16bit EEPROM start address. Any of APROM address can be defined as start address (0x3800)
  * @param       u8EPData the 8bit value need storage in (0x3800)
  * @return      none
  * @details     Storage dataflash page data into XRAM 380H-400H, modify data in XRAM, Erase dataflash page, writer updated XRAM data into dataflash
+ *              If only bits from 1 to 0 need change, the byte is programmed directly without page erase.
  */
 void Write_DATAFLASH_BYTE(unsigned int u16EPAddr,unsigned char u8EPData)
 {
@@ -22,16 +21,33 @@ void Write_DATAFLASH_BYTE(unsigned int u16EPAddr,unsigned char u8EPData)
   unsigned int u16_addrl_r;
   unsigned int RAMtmp;
   
-//Check page start address
-  u16_addrl_r=(u16EPAddr/128)*128;
-//Save APROM data to XRAM0
-  for(looptmp=0;looptmp<0x80;looptmp++)
+//Only bits 1 to 0 changed, program the byte without page erase
+  RAMtmp = *(unsigned char code *)u16EPAddr;
+  if((RAMtmp&u8EPData)==u8EPData)
   {
-    RAMtmp = Read_APROM_BYTE((unsigned int code *)(u16_addrl_r+looptmp));
-    page_buffer[looptmp]=RAMtmp;
+    if(RAMtmp!=u8EPData)
+    {
+      set_CHPCON_IAPEN;
+      set_IAPUEN_APUEN;
+      IAPCN = BYTE_PROGRAM_APROM;
+      IAPAL = u16EPAddr&0xff;
+      IAPAH = (u16EPAddr>>8)&0xff;
+      IAPFD = u8EPData;
+      set_IAPTRG_IAPGO;
+      u16IAPProgramCount++;
+      clr_IAPUEN_APUEN;
+      clr_CHPCON_IAPEN;
+    }
+    if(*(unsigned char code *)u16EPAddr==u8EPData)
+      return;
   }
+
+//Check page start address
+  u16_addrl_r=(u16EPAddr/128)*128;
+//Save APROM data to shared IAPDataBuf
+  memcpy_code_to_xdata(IAPDataBuf, (unsigned char code *)u16_addrl_r, PAGE_SIZE);
 // Modify customer data in XRAM
-  page_buffer[u16EPAddr&0x7f] = u8EPData;
+  IAPDataBuf[u16EPAddr&0x7f] = u8EPData;
   
 //Erase APROM DATAFLASH page
     IAPAL = u16_addrl_r&0xff;
@@ -41,6 +57,8 @@ void Write_DATAFLASH_BYTE(unsigned int u16EPAddr,unsigned char u8EPData)
     set_IAPUEN_APUEN;
     IAPCN = 0x22;     
      set_IAPTRG_IAPGO; 
+    u16IAPEraseCount++;
+    FLASH_WEAR_RECORD;
     
 //Save changed RAM data to APROM DATAFLASH
     set_CHPCON_IAPEN; 
@@ -50,8 +68,9 @@ void Write_DATAFLASH_BYTE(unsigned int u16EPAddr,unsigned char u8EPData)
     {
       IAPAL = (u16_addrl_r&0xff)+looptmp;
       IAPAH = (u16_addrl_r>>8)&0xff;
-      IAPFD = page_buffer[looptmp];
+      IAPFD = IAPDataBuf[looptmp];
       set_IAPTRG_IAPGO;      
+      u16IAPProgramCount++;
     }
     clr_IAPUEN_APUEN;
     clr_CHPCON_IAPEN;
@@ -80,17 +99,31 @@ void Write_DATAFLASH_ARRAY(unsigned int u16_addr,unsigned char *pDat,unsigned in
 //-------------------------------------------------------------------------
 void Read_DATAFLASH_ARRAY(unsigned int u16_addr,unsigned char *pDat,unsigned int num)
 {
-  unsigned int i;
-  for(i=0;i<num;i++)
-    pDat[i] = *(unsigned char code *)(u16_addr+i);
+  unsigned char code *pCode;
+
+  pCode=(unsigned char code *)u16_addr;
+
+  /* xdata and idata buffer copied by memcpy_code.A51, other memory type by generic pointer */
+  if(GENERIC_PTR_TYPE(pDat)==PTR_TYPE_XDATA)
+  {
+    memcpy_code_to_xdata((unsigned char xdata *)pDat, pCode, num);
+  }
+  else if((GENERIC_PTR_TYPE(pDat)==PTR_TYPE_IDATA)&&(num<0x100))
+  {
+    memcpy_code_to_idata((unsigned char idata *)pDat, pCode, num);
+  }
+  else
+  {
+    while(num--)
+      *pDat++=*pCode++;
+  }
 }
 
 //-----------------------------------------------------------------------------------------------------------
 unsigned char WriteDataToOnePage(unsigned int u16_addr,const unsigned char *pDat,unsigned char num)
 {
-  unsigned char i,offset;
+  unsigned char i,offset,u8Data;
   unsigned char code *pCode;
-  unsigned char xdata xd_tmp[128];
 
   set_CHPCON_IAPEN; 
   set_IAPUEN_APUEN;
@@ -98,10 +131,11 @@ unsigned char WriteDataToOnePage(unsigned int u16_addr,const unsigned char *pDat
   offset=u16_addr&0x007F;
   i = PAGE_SIZE - offset;
   if(num>i)num=i;
-  pCode = (unsigned char code *)u16_addr;
+  pCode=(unsigned char code *)u16_addr;
+  /* Flash bit can be programmed from 1 to 0 without erase, erase page only when any bit need 0 to 1 */
   for(i=0;i<num;i++)
   {
-    if(pCode[i]!=0xFF)break;
+    if((pCode[i]&pDat[i])!=pDat[i])break;
   }
   if(i==num)
   {
@@ -110,8 +144,12 @@ unsigned char WriteDataToOnePage(unsigned int u16_addr,const unsigned char *pDat
     IAPAH = u16_addr>>8;
     for(i=0;i<num;i++)
     {
-      IAPFD = pDat[i];
-      set_IAPTRG_IAPGO;
+      if(pCode[i]!=pDat[i])                     /* same value no need program */
+      {
+        IAPFD = pDat[i];
+        set_IAPTRG_IAPGO;
+        u16IAPProgramCount++;
+      }
       IAPAL++;
     }
     for(i=0;i<num;i++)
@@ -124,13 +162,11 @@ unsigned char WriteDataToOnePage(unsigned int u16_addr,const unsigned char *pDat
   {
     WriteDataToPage20:
     pCode = (unsigned char code *)(u16_addr&0xff80);
+    /* Only bytes not changed are saved in shared IAPDataBuf, new bytes are merged from pDat in program loop */
     for(i=0;i<128;i++)
     {
-      xd_tmp[i] = pCode[i];
-    }
-    for(i=0;i<num;i++)
-    {
-      xd_tmp[offset+i] = pDat[i];
+      if((i<offset)||(i>=offset+num))
+        IAPDataBuf[i] = pCode[i];
     }
     do
     {
@@ -139,16 +175,30 @@ unsigned char WriteDataToOnePage(unsigned int u16_addr,const unsigned char *pDat
       IAPCN = PAGE_ERASE_APROM;
       IAPFD = 0xFF;  
       set_IAPTRG_IAPGO; 
+      u16IAPEraseCount++;
+      FLASH_WEAR_RECORD;
       IAPCN =BYTE_PROGRAM_APROM;
       for(i=0;i<128;i++)
       {
-        IAPFD = xd_tmp[i];
-        set_IAPTRG_IAPGO;
+        if((i<offset)||(i>=offset+num))
+          u8Data = IAPDataBuf[i];
+        else
+          u8Data = pDat[i-offset];
+        if(u8Data!=0xFF)                       /* erased byte no need program */
+        {
+          IAPFD = u8Data;
+          set_IAPTRG_IAPGO;
+          u16IAPProgramCount++;
+        }
         IAPAL++;
       }
       for(i=0;i<128;i++)
       {
-        if(pCode[i]!=xd_tmp[i])break;
+        if((i<offset)||(i>=offset+num))
+          u8Data = IAPDataBuf[i];
+        else
+          u8Data = pDat[i-offset];
+        if(pCode[i]!=u8Data)break;
       }
     }while(i!=128);
     
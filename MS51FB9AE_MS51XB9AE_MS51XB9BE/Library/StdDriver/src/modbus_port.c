@@ -0,0 +1,162 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_16K.h"
+
+#if (MODBUS_UART != UART0) && (MODBUS_UART != UART1)
+#error "MODBUS_UART must be UART0 or UART1"
+#endif
+
+#if MODBUS_TIMER == 0
+#define MODBUS_TIMER_STOP       clr_TCON_TR0; clr_TCON_TF0
+#define MODBUS_TIMER_START      TL0 = u8ModbusReloadL; TH0 = u8ModbusReloadH; set_TCON_TR0
+#elif MODBUS_TIMER == 1
+#define MODBUS_TIMER_STOP       clr_TCON_TR1; clr_TCON_TF1
+#define MODBUS_TIMER_START      TL1 = u8ModbusReloadL; TH1 = u8ModbusReloadH; set_TCON_TR1
+#else
+#error "MODBUS_TIMER must be 0 or 1"
+#endif
+
+#if MODBUS_UART == UART0
+#define MODBUS_RI               RI
+#define MODBUS_TI               TI
+#define MODBUS_SBUF             SBUF
+#else
+#define MODBUS_RI               RI_1
+#define MODBUS_TI               TI_1
+#define MODBUS_SBUF             SBUF_1
+#endif
+
+static unsigned char data u8ModbusReloadH, u8ModbusReloadL;
+
+/**
+ * @brief       Modbus RTU slave open, 8 data bit no parity 1 stop bit
+ * @param       u32SysClock Fsys, e.g. 24000000
+ * @param       u32Baudrate e.g. 9600, baud rate clock is Timer3
+ * @param       u8Address slave address 1 to 247
+ * @param       pMap address map, table ends with u16Count 0
+ * @return      none
+ * @details     Frame gap T3.5 is 3.5 characters of 11 bit, 1750 us above 19200 bps, counted by Timer0 or
+ *              Timer1 at Fsys / 12 and restarted by each received byte. Call ENABLE_GLOBAL_INTERRUPT after.
+ * @example     Modbus_Open(24000000, 9600, 1, ModbusMap);
+ */
+void Modbus_Open(unsigned long u32SysClock, unsigned long u32Baudrate, unsigned char u8Address, MODBUS_MAP code *pMap)
+{
+    unsigned long u32Tick;
+
+    Modbus_Init(u8Address, pMap);
+
+    if (u32Baudrate > 19200)
+        u32Tick = u32SysClock / 12 * 7 / 4000;
+    else
+        u32Tick = u32SysClock / 12 * 77 / 2 / u32Baudrate;
+    if (u32Tick > 65535)
+        u32Tick = 65535;
+    u8ModbusReloadH = HIBYTE(65536 - u32Tick);
+    u8ModbusReloadL = LOBYTE(65536 - u32Tick);
+
+#ifdef MODBUS_DE_PIN
+    MODBUS_DE_PIN = 0;
+#endif
+
+#if MODBUS_TIMER == 0
+    TIMER0_FSYS_DIV12;
+    ENABLE_TIMER0_MODE1;
+    MODBUS_TIMER_STOP;
+    ENABLE_TIMER0_INTERRUPT;
+#else
+    TIMER1_FSYS_DIV12;
+    ENABLE_TIMER1_MODE1;
+    MODBUS_TIMER_STOP;
+    ENABLE_TIMER1_INTERRUPT;
+#endif
+
+#if MODBUS_UART == UART0
+    UART_Open(u32SysClock, UART0_Timer3, u32Baudrate);
+    clr_SCON_RI;
+    clr_SCON_TI;
+    ENABLE_UART0_INTERRUPT;
+#else
+    UART_Open(u32SysClock, UART1_Timer3, u32Baudrate);
+    clr_SCON_1_RI_1;
+    clr_SCON_1_TI_1;
+    ENABLE_UART1_INTERRUPT;
+#endif
+}
+
+/**
+ * @brief       Function code of the last served write request
+ * @return      0x05, 0x06, 0x0F, 0x10, or 0 when map data is not written since last call
+ * @example     if (Modbus_Poll() == 0x06) Apply_Setting();
+ */
+unsigned char Modbus_Poll(void)
+{
+    unsigned char u8Function;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+    u8Function = Modbus_Written();
+    EA = bEA;
+
+    return u8Function;
+}
+
+/**
+ * @brief       UART interrupt service of Modbus port
+ * @details     Caller saves SFRS. Each received byte restarts T3.5. TI of the last reply byte releases
+ *              the RS-485 driver, TI is set at the stop bit so the bus is left in its idle bias.
+ */
+void Modbus_UART_ISR(void)
+{
+    unsigned char u8Data;
+
+    SFRS = 0;
+
+    if (MODBUS_RI)
+    {
+        MODBUS_RI = 0;
+        u8Data = MODBUS_SBUF;
+        MODBUS_TIMER_STOP;
+        MODBUS_TIMER_START;
+        Modbus_RX_Byte(u8Data);
+    }
+
+    if (MODBUS_TI)
+    {
+        MODBUS_TI = 0;
+        if (Modbus_TX_Next(&u8Data))
+        {
+            MODBUS_SBUF = u8Data;
+        }
+        else
+        {
+#ifdef MODBUS_DE_PIN
+            MODBUS_DE_PIN = 0;
+#endif
+        }
+    }
+}
+
+/**
+ * @brief       Frame timer interrupt service, T3.5 silence is frame end
+ * @details     Caller saves SFRS. The request is served here and TI is set by software, the UART interrupt
+ *              that follows sends the first reply byte, so the reply starts right after the request is served.
+ */
+void Modbus_Timer_ISR(void)
+{
+    SFRS = 0;
+    MODBUS_TIMER_STOP;
+
+    if (Modbus_Frame_End())
+    {
+#ifdef MODBUS_DE_PIN
+        MODBUS_DE_PIN = 1;
+#endif
+        MODBUS_TI = 1;
+    }
+}
@@ -0,0 +1,268 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_16K.h"
+
+#if (TLOG_RING_SIZE & (TLOG_RING_SIZE - 1)) || (TLOG_RING_SIZE < 16) || (TLOG_RING_SIZE > 128)
+#error "TLOG_RING_SIZE must be power of 2 from 16 to 128"
+#endif
+
+#define TLOG_MASK               (TLOG_RING_SIZE - 1)
+#define TLOG_COUNT              ((unsigned char)(u8TLogHead - u8TLogTail))
+#define TLOG_FREE(n)            (!bTLogLost && (TLOG_COUNT <= TLOG_RING_SIZE - (n)))     /* fast check, else TLog_Room */
+
+/* Record = ID high, ID low, then each argument high, low. ID 0 is the marker record with u16TLogDrop. */
+/* Records are 2 byte multiple and the ring size is even, so one word never wraps around the ring end.  */
+#if TLOG_ASM_ENABLE
+/* tlog_fast.A51 owns TLogRing and TLog_1 ~ TLog_3, a record it can not write at once is passed to these */
+#define TLog_1                  TLog_Slow_1
+#define TLog_2                  TLog_Slow_2
+#define TLog_3                  TLog_Slow_3
+extern unsigned char xdata TLogRing[TLOG_RING_SIZE];
+#else
+unsigned char xdata TLogRing[TLOG_RING_SIZE];
+#endif
+unsigned char data u8TLogHead, u8TLogTail;
+bit bTLogLost;                                      /* marker record pending after drop */
+
+unsigned int xdata u16TLogDrop;
+
+/**
+ * @brief       Put one word to ring, caller checks free space and disables interrupt
+ * @param       u16Data word
+ * @return      none
+ */
+static void TLog_Put_Word(unsigned int u16Data)
+{
+    unsigned char xdata *pu8Put;
+
+    pu8Put = &TLogRing[u8TLogHead & TLOG_MASK];
+    *pu8Put++ = HIBYTE(u16Data);
+    *pu8Put = LOBYTE(u16Data);
+    u8TLogHead += 2;
+}
+
+/**
+ * @brief       Check ring space of record and put pending marker
+ * @param       u8Size record bytes
+ * @return      1 record fits, 0 record is dropped and counted
+ * @details     Caller disables interrupt. The marker tells the host how many records are lost up to here.
+ */
+static unsigned char TLog_Room(unsigned char u8Size)
+{
+    if (bTLogLost && (TLOG_COUNT <= TLOG_RING_SIZE - 4))
+    {
+        TLog_Put_Word(0);
+        TLog_Put_Word(u16TLogDrop);
+        bTLogLost = 0;
+    }
+
+    if (TLOG_COUNT <= TLOG_RING_SIZE - u8Size)
+        return 1;
+
+    u16TLogDrop++;
+    bTLogLost = 1;
+    return 0;
+}
+
+/**
+ * @brief       Empty log ring and put start marker
+ * @param       none
+ * @return      none
+ * @details     Marker with 0 lost records tells the host the device is reset.
+ */
+void TLog_Open(void)
+{
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+    u8TLogHead = 0;
+    u8TLogTail = 0;
+    u16TLogDrop = 0;
+    bTLogLost = 0;
+    TLog_Put_Word(0);
+    TLog_Put_Word(0);
+    EA = bEA;
+}
+
+/**
+ * @brief       Log record without argument, use TLOG0
+ * @param       u16Id message ID
+ * @return      none
+ * @details     Not reentrant, same for TLog_1 ~ TLog_3. Call from one context only: an interrupt between
+ *              the argument passing and EA = 0 overwrites the arguments of the interrupted call.
+ */
+void TLog_0(unsigned int u16Id)
+{
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+
+    if (TLOG_FREE(2) || TLog_Room(2))
+        TLog_Put_Word(u16Id);
+
+    EA = bEA;
+}
+
+/**
+ * @brief       Log record with one argument, use TLOG1
+ * @param       u16Id message ID
+ * @param       u16A argument
+ * @return      none
+ * @details     Not wrapped record is written by one pointer, same for TLog_2 and TLog_3. With
+ *              TLOG_ASM_ENABLE this is TLog_Slow_1 for the records tlog_fast.A51 does not write.
+ */
+void TLog_1(unsigned int u16Id, unsigned int u16A)
+{
+    unsigned char xdata *pu8Put;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+
+    if (TLOG_FREE(4) || TLog_Room(4))
+    {
+        if ((u8TLogHead & TLOG_MASK) <= TLOG_RING_SIZE - 4)
+        {
+            pu8Put = &TLogRing[u8TLogHead & TLOG_MASK];
+            *pu8Put++ = HIBYTE(u16Id);
+            *pu8Put++ = LOBYTE(u16Id);
+            *pu8Put++ = HIBYTE(u16A);
+            *pu8Put = LOBYTE(u16A);
+            u8TLogHead += 4;
+        }
+        else
+        {
+            TLog_Put_Word(u16Id);
+            TLog_Put_Word(u16A);
+        }
+    }
+
+    EA = bEA;
+}
+
+/**
+ * @brief       Log record with two arguments, use TLOG2
+ * @param       u16Id message ID
+ * @param       u16A first argument
+ * @param       u16B second argument
+ * @return      none
+ */
+void TLog_2(unsigned int u16Id, unsigned int u16A, unsigned int u16B)
+{
+    unsigned char xdata *pu8Put;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+
+    if (TLOG_FREE(6) || TLog_Room(6))
+    {
+        if ((u8TLogHead & TLOG_MASK) <= TLOG_RING_SIZE - 6)
+        {
+            pu8Put = &TLogRing[u8TLogHead & TLOG_MASK];
+            *pu8Put++ = HIBYTE(u16Id);
+            *pu8Put++ = LOBYTE(u16Id);
+            *pu8Put++ = HIBYTE(u16A);
+            *pu8Put++ = LOBYTE(u16A);
+            *pu8Put++ = HIBYTE(u16B);
+            *pu8Put = LOBYTE(u16B);
+            u8TLogHead += 6;
+        }
+        else
+        {
+            TLog_Put_Word(u16Id);
+            TLog_Put_Word(u16A);
+            TLog_Put_Word(u16B);
+        }
+    }
+
+    EA = bEA;
+}
+
+/**
+ * @brief       Log record with three arguments, use TLOG3
+ * @param       u16Id message ID
+ * @param       u16A first argument
+ * @param       u16B second argument
+ * @param       u16C third argument
+ * @return      none
+ */
+void TLog_3(unsigned int u16Id, unsigned int u16A, unsigned int u16B, unsigned int u16C)
+{
+    unsigned char xdata *pu8Put;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+
+    if (TLOG_FREE(8) || TLog_Room(8))
+    {
+        if ((u8TLogHead & TLOG_MASK) <= TLOG_RING_SIZE - 8)
+        {
+            pu8Put = &TLogRing[u8TLogHead & TLOG_MASK];
+            *pu8Put++ = HIBYTE(u16Id);
+            *pu8Put++ = LOBYTE(u16Id);
+            *pu8Put++ = HIBYTE(u16A);
+            *pu8Put++ = LOBYTE(u16A);
+            *pu8Put++ = HIBYTE(u16B);
+            *pu8Put++ = LOBYTE(u16B);
+            *pu8Put++ = HIBYTE(u16C);
+            *pu8Put = LOBYTE(u16C);
+            u8TLogHead += 8;
+        }
+        else
+        {
+            TLog_Put_Word(u16Id);
+            TLog_Put_Word(u16A);
+            TLog_Put_Word(u16B);
+            TLog_Put_Word(u16C);
+        }
+    }
+
+    EA = bEA;
+}
+
+/**
+ * @brief       Get one log byte for output
+ * @param       pu8Data log byte
+ * @return      1 byte read, 0 log ring empty
+ * @details     Tail is only written here, call from main loop only.
+ */
+unsigned char TLog_Read(unsigned char *pu8Data)
+{
+    if (u8TLogHead == u8TLogTail)
+        return 0;
+
+    *pu8Data = TLogRing[u8TLogTail & TLOG_MASK];
+    u8TLogTail++;
+    return 1;
+}
+
+#if UART_RING_ENABLE
+/**
+ * @brief       Move log bytes to TLOG_UART_PORT TX ring, not wait
+ * @param       none
+ * @return      none
+ * @details     Call from main loop, stops when log ring is empty or UART TX ring is full.
+ */
+void TLog_Flush(void)
+{
+    unsigned char u8Free;
+
+    u8Free = UART_Ring_TX_Free(TLOG_UART_PORT);
+
+    while (u8Free && (u8TLogHead != u8TLogTail))
+    {
+        UART_Ring_Write(TLOG_UART_PORT, TLogRing[u8TLogTail & TLOG_MASK]);
+        u8TLogTail++;
+        u8Free--;
+    }
+}
+#endif
@@ -14,6 +14,11 @@ unsigned char uart0_receive_data, uart1_receive_data;
 void Serial_ISR(void) interrupt 4
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_UART == UART0)
+    Modbus_UART_ISR();
+#elif UART_RING_ENABLE
+    UART0_Ring_ISR();
+#else
   
     if (RI)
     {
@@ -30,6 +35,7 @@ void Serial_ISR(void) interrupt 4
         }
     }
 
+#endif
     _pop_(SFRS);
 }	
 
@@ -38,6 +44,11 @@ void Serial_ISR(void) interrupt 4
 void SerialPort1_ISR(void) interrupt 15
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_UART == UART1)
+    Modbus_UART_ISR();
+#elif UART_RING_ENABLE
+    UART1_Ring_ISR();
+#else
   
     if (RI_1)
     {
@@ -54,6 +65,7 @@ void SerialPort1_ISR(void) interrupt 15
         }
     }
 
+#endif
     _pop_(SFRS);
 }
 
@@ -20,9 +20,12 @@ bit BIT_TMP;
   data volatile uint8_t g_timer1Counter;
   data volatile uint8_t count; 
   data volatile uint16_t g_timer0Counter;
-  data volatile uint32_t g_checksum;
-  data volatile uint32_t g_totalchecksum;
+  data volatile uint16_t g_checksum;          /* sum of last received packet, by ISR */
+  data volatile uint16_t g_rxsum;             /* sum of bytes received so far */
+  data volatile uint16_t g_totalchecksum;
+  data volatile uint8_t g_blankpage;          /* pages not erased by blank check */
   bit volatile bI2CDataReady;
+  bit volatile g_lzflag;
   bit volatile bISPDataReady;//for ack
   volatile uint8_t g_u8SlvDataLen;
   bit volatile g_timer0Over;
@@ -80,13 +83,28 @@ void TM0_ini(void)
 }
 
 
+/* Blank check of one page by IAP read, MOVC in LDROM reads LDROM. TRUE when all bytes are 0xFF */
+bit Page_Blank_Check(uint16_t u16Addr)
+{
+    uint8_t i;
+
+    IAPCN = BYTE_READ_AP;
+    IAPAH = HIBYTE(u16Addr);
+
+    for (i = 0; i < PAGE_SIZE; i++)
+    {
+        IAPAL = LOBYTE(u16Addr) + i;            //page aligned, low byte not carry
+        set_IAPTRG_IAPGO;
+        if (IAPFD != 0xFF)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 void Package_checksum(void)
 {
-  g_checksum=0;
-   for(count=0;count<64;count++)
-  {
-    g_checksum =g_checksum+ rx_buf[count];    
-  }
+  /* g_checksum is summed by receive ISR, only low 16 bits are replied */
   tx_buf[0]=g_checksum&0xff;
   tx_buf[1]=(g_checksum>>8)&0xff;
   tx_buf[4]=rx_buf[4]+1;
@@ -96,6 +114,36 @@ void Package_checksum(void)
   
 }
 
+/* Decompress payload from u8Start to end of packet into APROM, TRUE when AP_size reached */
+bit Program_Compressed(uint8_t u8Start)
+{
+    uint8_t u8Data;
+
+    LZ_Decode_Input((uint8_t xdata *)&rx_buf[u8Start], 64 - u8Start);
+
+    while (LZ_Decode_Byte(&u8Data) == PASS)
+    {
+        IAPCN = BYTE_PROGRAM_AP;
+        IAPAL = flash_address & 0xff;
+        IAPAH = (flash_address >> 8) & 0xff;
+        IAPFD = u8Data;
+        set_IAPTRG_IAPGO_WDCLR;
+
+        IAPCN = BYTE_READ_AP;                   //program byte verify
+        set_IAPTRG_IAPGO;
+        if (IAPFD != u8Data)
+            while (1);
+
+        g_totalchecksum = g_totalchecksum + u8Data;
+        flash_address++;
+
+        if (flash_address == AP_size)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 
 void Timer0_ISR (void) interrupt 1
 {
@@ -140,6 +188,7 @@ void I2C_ISR(void) interrupt 6
 
     if (I2STAT == 0x60) {                    /* Own SLA+W has been receive; ACK has been return */
         bI2CDataReady = 0;
+        g_rxsum = 0;
         bISPDataReady = 0;
         g_u8SlvDataLen = 0;
         //I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI_AA);
@@ -147,10 +196,15 @@ void I2C_ISR(void) interrupt 6
     } else if (I2STAT == 0x80)                 /* Previously address with own SLA address
                                                    Data has been received; ACK has been returned*/
     {
+        g_rxsum += I2DAT;
         rx_buf[g_u8SlvDataLen] = I2DAT;
         g_u8SlvDataLen++;
         g_u8SlvDataLen &= 0x3F;
         bI2CDataReady = (g_u8SlvDataLen == 0);
+        if (bI2CDataReady) {
+            g_checksum = g_rxsum;
+            g_rxsum = 0;
+        }
 
         if (g_u8SlvDataLen == 0x3F) {
             //I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI);
@@ -202,9 +256,12 @@ void I2C_ISR(void) interrupt 6
     } else if (I2STAT == 0x88)                 /* Previously addressed with own SLA address; NOT ACK has
                                                    been returned */
     {
+        g_rxsum += I2DAT;
         rx_buf[g_u8SlvDataLen] = I2DAT;
         g_u8SlvDataLen++;
         bI2CDataReady = (g_u8SlvDataLen == 64);
+        g_checksum = g_rxsum;
+        g_rxsum = 0;
         g_u8SlvDataLen = 0;
       //  I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI_AA);
       AA=1;
@@ -212,6 +269,7 @@ void I2C_ISR(void) interrupt 6
                                                    addressed as Slave/Receiver*/
     {
         g_u8SlvDataLen = 0;
+        g_rxsum = 0;
         //I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI_AA);
       AA=1;
     } else {
@@ -40,6 +40,14 @@ while(1)
           EA=0; /*Disable all interrupt */
           if(g_progarmflag==1)
           {
+            if(g_lzflag)
+            {
+              if(Program_Compressed(8))
+              {
+                g_progarmflag=0;
+              }
+              goto END_2;
+            }
             for(count=8;count<64;count++)
             {
               IAPCN = BYTE_PROGRAM_AP;          //program byte
@@ -93,6 +101,7 @@ END_2:
             {
               Package_checksum();
               tx_buf[8]=FW_VERSION;  
+              tx_buf[9]=ISP_FEATURE;
 
               bISPDataReady = 1;
             break;
@@ -121,21 +130,31 @@ END_2:
             {
 //              set_CHPCON_IAPEN;
               set_IAPUEN_APUEN;
-              IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
-              IAPCN = PAGE_ERASE_AP;
               
+              g_blankpage=0;
               for(flash_address=0x0000;flash_address<APROM_SIZE/PAGE_SIZE;flash_address++)
-              {        
-                IAPAL = LOBYTE(flash_address*PAGE_SIZE);
-                IAPAH = HIBYTE(flash_address*PAGE_SIZE);
+              {
+                if(Page_Blank_Check(flash_address*PAGE_SIZE))  //blank page need not erase
+                {
+                  g_blankpage++;
+                }
+                else
+                {
+                  IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
+                  IAPCN = PAGE_ERASE_AP;
+                  IAPAL = LOBYTE(flash_address*PAGE_SIZE);
+                  IAPAH = HIBYTE(flash_address*PAGE_SIZE);
 #ifdef isp_with_wdt
-              set_IAPTRG_IAPGO_WDCLR;
+                  set_IAPTRG_IAPGO_WDCLR;
 #else
-              trig_IAPGO;
+                  trig_IAPGO;
 #endif
+                }
               }
 
               Package_checksum();
+              tx_buf[10]=g_blankpage;
+              tx_buf[11]=0;
               bISPDataReady = 1; 
               break;
             }
@@ -216,22 +235,31 @@ END_2:
               break;
             }
             
+            case CMD_UPDATE_APROM_COMPRESSED:
             case CMD_UPDATE_APROM:
             {
               set_CHPCON_IAPEN;
               set_IAPUEN_APUEN;
-              IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
-              IAPCN = PAGE_ERASE_AP;
 
+              g_blankpage=0;
               for(flash_address=0x0000;flash_address<APROM_SIZE/PAGE_SIZE;flash_address++)
-              {        
-                IAPAL = LOBYTE(flash_address*PAGE_SIZE);
-                IAPAH = HIBYTE(flash_address*PAGE_SIZE);
+              {
+                if(Page_Blank_Check(flash_address*PAGE_SIZE))  //blank page need not erase
+                {
+                  g_blankpage++;
+                }
+                else
+                {
+                  IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
+                  IAPCN = PAGE_ERASE_AP;
+                  IAPAL = LOBYTE(flash_address*PAGE_SIZE);
+                  IAPAH = HIBYTE(flash_address*PAGE_SIZE);
 #ifdef isp_with_wdt
-              set_IAPTRG_IAPGO_WDCLR;
+                  set_IAPTRG_IAPGO_WDCLR;
 #else
-              trig_IAPGO;
+                  trig_IAPGO;
 #endif
+                }
               }
 
               g_totalchecksum=0;
@@ -241,6 +269,15 @@ END_2:
               AP_size|=(rx_buf[13]<<8);  
               g_progarmflag=1;
 
+              g_lzflag=0;
+              if(rx_buf[0]==CMD_UPDATE_APROM_COMPRESSED)
+              {
+                g_lzflag=1;
+                LZ_Decode_Init();
+                if(Program_Compressed(16))
+                  g_progarmflag=0;
+                goto END_1;
+              }
               for(count=16;count<64;count++)
               {
                 IAPCN = BYTE_PROGRAM_AP;
@@ -274,6 +311,8 @@ END_1:
               Package_checksum();
               tx_buf[8]=g_totalchecksum&0xff;
               tx_buf[9]=(g_totalchecksum>>8)&0xff;
+              tx_buf[10]=g_blankpage;
+              tx_buf[11]=0;
 
               bISPDataReady = 1;
               break;
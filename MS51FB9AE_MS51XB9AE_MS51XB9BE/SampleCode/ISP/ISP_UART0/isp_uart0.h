@@ -7,12 +7,37 @@
 #define CMD_SYNC_PACKNO      0xA4
 #define CMD_GET_FWVER        0xA6
 #define FW_VERSION           0x28
+/* Features of the LDROM image, set 0 in C51 define to leave one out when the code size of the map file is over LDROM size of CONFIG1 */
+#ifndef ISP_BAUDRATE_ENABLE
+#define ISP_BAUDRATE_ENABLE   1               /* autobaud of CMD_CONNECT and CMD_SET_BAUDRATE, 0 is fixed 115200 */
+#endif
+#ifndef ISP_COMPRESSED_ENABLE
+#define ISP_COMPRESSED_ENABLE 1               /* CMD_UPDATE_APROM_COMPRESSED, 0 also remove lz_decode.c from the project */
+#endif
+#ifndef ISP_PAGE_CRC_ENABLE
+#define ISP_PAGE_CRC_ENABLE   1               /* CMD_READ_PAGE_CRC and CMD_UPDATE_APROM_PAGE */
+#endif
+#ifndef ISP_BLANK_SKIP_ENABLE
+#define ISP_BLANK_SKIP_ENABLE 1               /* erase skips blank page, 0 erases every page */
+#endif
+#ifndef ISP_READ_APROM_ENABLE
+#define ISP_READ_APROM_ENABLE 1               /* CMD_READ_APROM */
+#endif
+/* bit0 pipelined APROM data packet, bit1 CMD_SET_BAUDRATE, bit2 CMD_UPDATE_APROM_COMPRESSED, bit3 page CRC delta update, bit4 erase skip blank page, bit5 CMD_READ_APROM, returned in byte 9 of CMD_GET_FWVER */
+#define ISP_FEATURE          (0x01 | (ISP_BAUDRATE_ENABLE<<1) | (ISP_COMPRESSED_ENABLE<<2) | (ISP_PAGE_CRC_ENABLE<<3) \
+                              | (ISP_BLANK_SKIP_ENABLE<<4) | (ISP_READ_APROM_ENABLE<<5))
 #define CMD_RUN_APROM        0xAB
 #define CMD_GET_DEVICEID     0xB1
 #define CMD_ERASE_ALL        0xA3
 #define CMD_READ_CONFIG      0xA2
 #define CMD_UPDATE_CONFIG    0xA1
 #define CMD_UPDATE_APROM     0xA0
+#define CMD_UPDATE_APROM_COMPRESSED 0xB6
+#define CMD_SET_BAUDRATE     0xB5
+#define CMD_READ_PAGE_CRC    0xB7
+#define CMD_UPDATE_APROM_PAGE 0xB8
+#define CMD_READ_APROM       0xB9
+#define READ_APROM_CONTINUOUS 0x01             /* byte 10 of CMD_READ_APROM, stream whole range without request */
 #define PAGE_ERASE_AP        0x22
 #define BYTE_READ_AP         0x00
 #define BYTE_PROGRAM_AP      0x21
@@ -22,20 +47,40 @@
 #define BYTE_PROGRAM_CONFIG  0xE1
 #define READ_UID             0x04
 #define PAGE_SIZE            128
+#define PAGE_CRC_MAX         28               /* CRC-16 of 28 pages in byte 8~63 of reply, page count in byte 2 */
+#define READ_DATA_SIZE       56               /* APROM data in byte 8~63 of CMD_READ_APROM reply */
+#define CONFIG0_LOCK         0x02             /* CONFIG0 bit1 LOCK, 0 is locked, no APROM data or page CRC reply */
 #define APROM_SIZE           14*1024
+#define ISP_UART_CLOCK       (24000000UL/16)  /* Timer3 prescale 1, baud rate = ISP_UART_CLOCK / divisor */
+#define ISP_RXD_PIN          P07
+#define Autobaud_Timeout     1200             /* Timer0 Fsys overflow 2.73ms, 3.3s as Timer0Out_Counter */
+#define Baud_Trial_Counter   250              /* back to old baud rate if no packet in 1s */
 
  
-extern  xdata volatile uint8_t uart_rcvbuf[64]; 
-extern  xdata volatile uint8_t uart_txbuf[64];
+extern  xdata volatile uint8_t uart_rxbuf[2][64];
+extern  volatile uint8_t xdata * data uart_rcvbuf;
+extern  volatile uint8_t xdata * data uart_rxfill;
+extern  xdata volatile uint8_t uart_txdbuf[2][64];
+extern  volatile uint8_t xdata * data uart_txbuf;
+extern  volatile uint8_t xdata * data uart_txsend;
 extern data volatile uint8_t bufhead;
+extern data volatile uint8_t txhead;
 extern  data volatile uint16_t flash_address; 
 extern  data volatile uint16_t AP_size;
 extern  data volatile uint8_t g_timer1Counter;
 extern  data volatile uint8_t count; 
 extern  data volatile uint16_t g_timer0Counter;
-extern  data volatile uint32_t g_checksum;
-extern  data volatile uint32_t g_totalchecksum;
+extern  data volatile uint16_t g_checksum;
+extern  data volatile uint16_t g_rxsum;
+extern  data volatile uint16_t g_totalchecksum;
+extern  data volatile uint8_t g_blankpage;
 extern  bit volatile bUartDataReady;
+extern  bit volatile bUartRxRelease;
+extern  bit volatile g_lzflag;
+extern  bit volatile g_deltaflag;
+extern  bit volatile g_baudTrial;
+extern  xdata uint16_t g_baudDivisor, g_baudPrevious;
+extern  bit volatile bUartTxBusy;
 extern  bit volatile g_timer0Over;
 extern  bit volatile g_timer1Over;
 extern  bit volatile g_programflag;
@@ -48,9 +93,22 @@ void MODIFY_HIRC_24(void);
 void MODIFY_HIRC_16(void);
 void UART0_ini_115200_24MHz(void);
 void Package_checksum(void);
+bit Page_Blank_Check(uint16_t u16Addr);
 void Send_64byte_To_UART0(void);
+void UART0_Rx_Release(void);
 void UART0_ini_115200(void);
 void MODIFY_HIRC_24(void);
 void MODIFY_HIRC_16(void);
 void READ_ID(void);
-void READ_CONFIG(void);
\ No newline at end of file
+void READ_CONFIG(void);
+bit Program_Compressed(uint8_t u8Start);
+uint16_t Page_CRC16(uint16_t u16Addr);
+uint8_t Read_APROM_Packet(uint16_t u16Addr, uint16_t u16End);
+uint16_t Baud_Divisor(uint32_t u32Baud);
+uint32_t Baud_Negotiate(uint32_t u32Baud);
+void Timer3_Set_Divisor(uint16_t u16Div);
+uint16_t Autobaud_Detect(void);
+
+#if !ISP_BLANK_SKIP_ENABLE
+#define Page_Blank_Check(u16Addr)   FALSE
+#endif
@@ -21,9 +21,17 @@ bit BIT_TMP;
   data volatile uint8_t g_timer1Counter;
   data volatile uint8_t count; 
   data volatile uint16_t g_timer0Counter;
-  data volatile uint32_t g_checksum;
-  data volatile uint32_t g_totalchecksum;
+  data volatile uint16_t g_checksum;          /* sum of last received packet, by ISR */
+  data volatile uint16_t g_rxsum;             /* sum of bytes received so far */
+  data volatile uint16_t g_totalchecksum;
+  data volatile uint8_t g_blankpage;          /* pages not erased by blank check */
   bit volatile bUartDataReady;
+  bit volatile g_lzflag;
+  bit volatile g_baudTrial;
+  xdata uint16_t g_baudDivisor, g_baudPrevious;
+#if ISP_BAUDRATE_ENABLE
+  code uint32_t BaudTable[] = {1500000, 921600, 750000, 500000, 460800, 250000, 230400, 115200};
+#endif
   bit volatile g_timer0Over;
   bit volatile g_timer1Over;
   bit volatile g_progarmflag;
@@ -139,14 +147,198 @@ void UART1_ini_115200_24MHz(void)
     EA=1;
 }
 
+#if ISP_BAUDRATE_ENABLE
+/* Timer3 divisor of u32Baud, 0 if baud rate error over 2% */
+uint16_t Baud_Divisor(uint32_t u32Baud)
+{
+    uint32_t u32Div, u32Real, u32Diff;
+
+    if (u32Baud == 0)
+        return 0;
+
+    u32Div = (ISP_UART_CLOCK + u32Baud / 2) / u32Baud;
+
+    if ((u32Div == 0) || (u32Div > 0xFFFF))
+        return 0;
+
+    u32Real = ISP_UART_CLOCK / u32Div;
+    u32Diff = (u32Real > u32Baud) ? (u32Real - u32Baud) : (u32Baud - u32Real);
+
+    if ((u32Diff * 50) > u32Baud)
+        return 0;
+
+    return (uint16_t)u32Div;
+}
+
+/* Fastest table baud rate not over host request and reachable by HIRC 24MHz, 0 if none */
+uint32_t Baud_Negotiate(uint32_t u32Baud)
+{
+    uint8_t i;
+
+    for (i = 0; i < (sizeof(BaudTable) / sizeof(BaudTable[0])); i++)
+    {
+        if ((BaudTable[i] <= u32Baud) && (Baud_Divisor(BaudTable[i]) != 0))
+            return BaudTable[i];
+    }
+
+    return 0;
+}
+
+void Timer3_Set_Divisor(uint16_t u16Div)
+{
+    SFRS = 0;
+    RH3 = HIBYTE(65536 - u16Div);
+    RL3 = LOBYTE(65536 - u16Div);
+}
+
+/* Wait RXD pin level change, FALSE if Timer0 overflow */
+bit Wait_RXD_Fall(void)
+{
+    while (ISP_RXD_PIN)
+    {
+        if (TF0)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+bit Wait_RXD_Rise(void)
+{
+    while (!ISP_RXD_PIN)
+    {
+        if (TF0)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+uint16_t Timer0_Read(void)
+{
+    uint8_t u8High, u8Low;
+
+    do
+    {
+        u8High = TH0;
+        u8Low = TL0;
+    } while (u8High != TH0);
+
+    return ((uint16_t)u8High << 8) | u8Low;
+}
+
+/**
+ * Autobaud by CMD_CONNECT 0xAE, LSB first the line is low for start bit and bit 0, so falling edges are at
+ * bit time 0, 5 and 7. Timer0 counts Fsys from first to third falling edge, the second edge must be at 5/7.
+ * Rest of the packet is skipped until RXD idle one Timer0 overflow, the host resends CMD_CONNECT.
+ * return Timer3 divisor, 0 if no valid sync byte in Autobaud_Timeout
+ */
+uint16_t Autobaud_Detect(void)
+{
+    uint16_t u16Timeout, u16Edge5, u16Edge7, u16Div;
+    uint8_t u8Idle;
+
+    ENABLE_TIMER0_MODE1;
+    TIMER0_FSYS;
+    clr_TCON_TF0;
+    set_TCON_TR0;
+
+    u16Timeout = Autobaud_Timeout;
+    u16Div = 0;
+    u8Idle = 0;
+
+    while ((u16Div == 0) && u16Timeout)
+    {
+        if (TF0)
+        {
+            clr_TCON_TF0;
+            u16Timeout--;
+            continue;
+        }
+
+        if (ISP_RXD_PIN)
+        {
+            u8Idle = 1;
+        }
+        else if (u8Idle)
+        {
+            /* Start bit falling edge, one try counted as one overflow */
+            TH0 = 0;
+            TL0 = 0;
+            u8Idle = 0;
+            u16Timeout--;
+
+            if (!Wait_RXD_Rise() || !Wait_RXD_Fall())
+                continue;
+
+            u16Edge5 = Timer0_Read();
+
+            if (!Wait_RXD_Rise() || !Wait_RXD_Fall())
+                continue;
+
+            u16Edge7 = Timer0_Read();
+
+            /* 7 * edge5 within half bit time of 5 * edge7 */
+            if ((((uint32_t)u16Edge5 * 7 + u16Edge7 / 2) < ((uint32_t)u16Edge7 * 5))
+                    || (((uint32_t)u16Edge5 * 7) > ((uint32_t)u16Edge7 * 5 + u16Edge7 / 2)))
+                continue;
+
+            /* Measured baud rate is Fsys * 7 / edge7, 16 Timer3 counts per bit */
+            u16Div = Baud_Divisor(ISP_UART_CLOCK * 112 / u16Edge7);
+        }
+    }
+
+    /* Skip rest of the packet */
+    if (u16Div)
+    {
+        TH0 = 0;
+        TL0 = 0;
+        clr_TCON_TF0;
+
+        while (!TF0)
+        {
+            if (!ISP_RXD_PIN)
+            {
+                TH0 = 0;
+                TL0 = 0;
+            }
+        }
+    }
+
+    clr_TCON_TR0;
+    clr_TCON_TF0;
+    TMOD &= 0xF0;
+    TIMER0_FSYS_DIV12;
+
+    return u16Div;
+}
+#endif
+
+
+#if ISP_BLANK_SKIP_ENABLE
+/* Blank check of one page by IAP read, MOVC in LDROM reads LDROM. TRUE when all bytes are 0xFF */
+bit Page_Blank_Check(uint16_t u16Addr)
+{
+    uint8_t i;
+
+    IAPCN = BYTE_READ_AP;
+    IAPAH = HIBYTE(u16Addr);
+
+    for (i = 0; i < PAGE_SIZE; i++)
+    {
+        IAPAL = LOBYTE(u16Addr) + i;            //page aligned, low byte not carry
+        set_IAPTRG_IAPGO;
+        if (IAPFD != 0xFF)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+#endif
 
 void Package_checksum(void)
 {
-  g_checksum=0;
-   for(count=0;count<64;count++)
-  {
-    g_checksum =g_checksum+ uart_rcvbuf[count];    
-  }
+  /* g_checksum is summed by receive ISR, only low 16 bits are replied */
   uart_txbuf[0]=g_checksum&0xff;
   uart_txbuf[1]=(g_checksum>>8)&0xff;
   uart_txbuf[4]=uart_rcvbuf[4]+1;
@@ -156,6 +348,38 @@ void Package_checksum(void)
   
 }
 
+#if ISP_COMPRESSED_ENABLE
+/* Decompress payload from u8Start to end of packet into APROM, TRUE when AP_size reached */
+bit Program_Compressed(uint8_t u8Start)
+{
+    uint8_t u8Data;
+
+    LZ_Decode_Input((uint8_t xdata *)&uart_rcvbuf[u8Start], 64 - u8Start);
+
+    while (LZ_Decode_Byte(&u8Data) == PASS)
+    {
+        IAPCN = BYTE_PROGRAM_AP;
+        IAPAL = flash_address & 0xff;
+        IAPAH = (flash_address >> 8) & 0xff;
+        IAPFD = u8Data;
+        set_IAPTRG_IAPGO_WDCLR;
+
+        IAPCN = BYTE_READ_AP;                   //program byte verify
+        set_IAPTRG_IAPGO;
+        if (IAPFD != u8Data)
+            while (1);
+
+        g_totalchecksum = g_totalchecksum + u8Data;
+        flash_address++;
+
+        if (flash_address == AP_size)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+#endif
+
 
 void Send_64byte_To_UART1(void)
 {  
@@ -175,6 +399,7 @@ void UART1_ISR(void) interrupt 15
   SFRS=0;
     if (RI_1 == 1)
     {   
+      g_rxsum += SBUF_1;
       uart_rcvbuf[bufhead++]=  SBUF_1;    
       clr_SCON_1_RI_1;                                         // Clear RI (Receive Interrupt).
     }
@@ -189,6 +414,8 @@ void UART1_ISR(void) interrupt 15
     }
   if(bufhead == 64)
     {
+      g_checksum = g_rxsum;
+      g_rxsum = 0;
       bUartDataReady = TRUE;
       g_timer1Counter=0;
       g_timer1Over=0;
@@ -2,12 +2,26 @@
 #define CMD_SYNC_PACKNO      0xA4
 #define CMD_GET_FWVER        0xA6
 #define FW_VERSION           0x28
+/* Features of the LDROM image, set 0 in C51 define to leave one out when the code size of the map file is over LDROM size of CONFIG1 */
+#ifndef ISP_BAUDRATE_ENABLE
+#define ISP_BAUDRATE_ENABLE   1               /* autobaud of CMD_CONNECT and CMD_SET_BAUDRATE, 0 is fixed 115200 */
+#endif
+#ifndef ISP_COMPRESSED_ENABLE
+#define ISP_COMPRESSED_ENABLE 1               /* CMD_UPDATE_APROM_COMPRESSED, 0 also remove lz_decode.c from the project */
+#endif
+#ifndef ISP_BLANK_SKIP_ENABLE
+#define ISP_BLANK_SKIP_ENABLE 1               /* erase skips blank page, 0 erases every page */
+#endif
+/* bit1 CMD_SET_BAUDRATE, bit2 CMD_UPDATE_APROM_COMPRESSED, bit4 erase skip blank page, returned in byte 9 of CMD_GET_FWVER */
+#define ISP_FEATURE          ((ISP_BAUDRATE_ENABLE<<1) | (ISP_COMPRESSED_ENABLE<<2) | (ISP_BLANK_SKIP_ENABLE<<4))
 #define CMD_RUN_APROM        0xAB
 #define CMD_GET_DEVICEID     0xB1
 #define CMD_ERASE_ALL        0xA3
 #define CMD_READ_CONFIG      0xA2
 #define CMD_UPDATE_CONFIG    0xA1
 #define CMD_UPDATE_APROM     0xA0
+#define CMD_UPDATE_APROM_COMPRESSED 0xB6
+#define CMD_SET_BAUDRATE     0xB5
 #define PAGE_ERASE_AP        0x22
 #define BYTE_READ_AP         0x00
 #define BYTE_PROGRAM_AP      0x21
@@ -18,6 +32,10 @@
 #define READ_UID             0x04
 #define PAGE_SIZE            128
 #define APROM_SIZE           12*1024  
+#define ISP_UART_CLOCK       (24000000UL/16)  /* Timer3 prescale 1, baud rate = ISP_UART_CLOCK / divisor */
+#define ISP_RXD_PIN          P02
+#define Autobaud_Timeout     7500             /* Timer0 Fsys overflow 2.73ms, 20s as g_timer0Counter 5000 */
+#define Baud_Trial_Counter   250              /* back to old baud rate if no packet in 1s */
 
 
 extern  xdata volatile uint8_t uart_rcvbuf[64]; 
@@ -28,9 +46,14 @@ extern  data volatile uint16_t AP_size;
 extern  data volatile uint8_t g_timer1Counter;
 extern  data volatile uint8_t count; 
 extern  data volatile uint16_t g_timer0Counter;
-extern  data volatile uint32_t g_checksum;
-extern  data volatile uint32_t g_totalchecksum;
+extern  data volatile uint16_t g_checksum;
+extern  data volatile uint16_t g_rxsum;
+extern  data volatile uint16_t g_totalchecksum;
+extern  data volatile uint8_t g_blankpage;
 extern  bit volatile bUartDataReady;
+extern  bit volatile g_lzflag;
+extern  bit volatile g_baudTrial;
+extern  xdata uint16_t g_baudDivisor, g_baudPrevious;
 extern  bit volatile g_timer0Over;
 extern  bit volatile g_timer1Over;
 extern  bit volatile g_progarmflag;
@@ -44,6 +67,16 @@ void MODIFY_HIRC_24(void);
 void MODIFY_HIRC_16(void);
 void UART1_ini_115200_24MHz(void);
 void Package_checksum(void);
+bit Page_Blank_Check(uint16_t u16Addr);
 void Send_64byte_To_UART1(void);
 void READ_ID(void);
 void READ_CONFIG(void);
+bit Program_Compressed(uint8_t u8Start);
+uint16_t Baud_Divisor(uint32_t u32Baud);
+uint32_t Baud_Negotiate(uint32_t u32Baud);
+void Timer3_Set_Divisor(uint16_t u16Div);
+uint16_t Autobaud_Detect(void);
+
+#if !ISP_BLANK_SKIP_ENABLE
+#define Page_Blank_Check(u16Addr)   FALSE
+#endif
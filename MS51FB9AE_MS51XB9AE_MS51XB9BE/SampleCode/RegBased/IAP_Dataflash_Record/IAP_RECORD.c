@@ -0,0 +1,81 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 power-fail-safe A/B dataflash record demo, boot counter kept in eeprom_record.c,
+//                 BOD interrupt stops flash write while VDD is low
+//***********************************************************************************************************
+#include "MS51_16K.h"
+
+unsigned char xdata au8Record[REC_DATA_SIZE];
+
+/* BOD interrupt, eeprom_record.c starts no erase or program while bod_event_flag is set */
+void BOD_ISR(void) interrupt 8           // Vector @  0x43
+{
+    _push_(SFRS);
+
+    clr_BODCON0_BOF;
+    bod_event_flag = 1;
+
+    _pop_(SFRS);
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned char i, u8Result;
+
+/* UART0 initial setting
+  * include sys.c in Library for modify HIRC value to 24MHz
+  * include uart.c in Library for UART initial setting
+*/
+    MODIFY_HIRC(HIRC_24);
+    P06_QUASI_MODE;
+    UART_Open(24000000,UART0_Timer3,115200);
+    ENABLE_UART0_PRINTF;
+
+/* BOD 2.7V interrupt without reset, include bod.c in Library */
+    BOD_Open(Enable, VBOD_2_7, BOD_Reset_Disable);
+    BOD_Interrupt(Enable);
+    ENABLE_GLOBAL_INTERRUPT;
+
+/* Newest valid record is selected in one pass, first boot has no record */
+    if (Init_DATAFLASH_RECORD() == PASS)
+    {
+        Read_DATAFLASH_RECORD(au8Record);
+    }
+    else
+    {
+        for (i = 0; i < REC_DATA_SIZE; i++)
+            au8Record[i] = 0;
+    }
+
+/* Byte 0 ~ 1 boot counter, byte 2 ~ 3 sequence of the record read */
+    au8Record[0]++;
+    if (au8Record[0] == 0)
+        au8Record[1]++;
+    au8Record[2] = LOBYTE(u16RecordSequence);
+    au8Record[3] = HIBYTE(u16RecordSequence);
+
+    u8Result = Write_DATAFLASH_RECORD(au8Record);
+
+    printf("\n Boot %d, record sequence %d, write %s", ((unsigned int)au8Record[1] << 8) | au8Record[0], u16RecordSequence,
+           (u8Result == PASS) ? "pass" : (u8Result == REC_ERR_BOD) ? "stopped by BOD" : "fail");
+    printf("\n Page erase %d byte program %d", u16IAPEraseCount, u16IAPProgramCount);
+
+    while (1)
+    {
+        /* Application clears the flag after VDD is back over BOD level (BOS 0) */
+        if (bod_event_flag && !(BODCON0 & SET_BIT0))
+        {
+            bod_event_flag = 0;
+            printf("\n VDD recovered");
+        }
+    }
+}
@@ -0,0 +1,154 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 copy APROM table to XRAM, generic pointer loop compare with dual DPTR copy
+//***********************************************************************************************************
+#include "MS51_16K.h"
+
+#define     BENCH_SRC_ADDR          0x0000      /* program code itself is used as table */
+#define     BENCH_BUF_SIZE          256         /* larger block is copied by 256 bytes per call */
+#define     BENCH_IDATA_SIZE        16
+
+unsigned char xdata BenchBuf[BENCH_BUF_SIZE];
+unsigned char idata BenchIdataBuf[BENCH_IDATA_SIZE];
+unsigned int code BenchSize[] = {16, 128, 1024};
+
+/* Timer0 run Fsys, 1 tick is 1 system clock cycle */
+void Timer0_Start(void)
+{
+    clr_TCON_TR0;
+    clr_TCON_TF0;
+    TH0 = 0;
+    TL0 = 0;
+    set_TCON_TR0;
+}
+
+unsigned long Timer0_Stop(void)
+{
+    clr_TCON_TR0;
+    return (((unsigned long)TF0 << 16) + ((unsigned int)TH0 << 8) + TL0);
+}
+
+/* Same loop as Read_DATAFLASH_ARRAY before memcpy_code.A51 */
+void Copy_Generic(unsigned int u16Addr, unsigned char *pDat, unsigned int u16Size)
+{
+    unsigned int i;
+
+    for (i = 0; i < u16Size; i++)
+        pDat[i] = *(unsigned char code *)(u16Addr + i);
+}
+
+unsigned long Bench_Generic(unsigned int u16Size)
+{
+    unsigned int u16Addr, u16Len;
+
+    u16Addr = BENCH_SRC_ADDR;
+    Timer0_Start();
+
+    while (u16Size)
+    {
+        u16Len = (u16Size > BENCH_BUF_SIZE) ? BENCH_BUF_SIZE : u16Size;
+        Copy_Generic(u16Addr, BenchBuf, u16Len);
+        u16Addr += u16Len;
+        u16Size -= u16Len;
+    }
+
+    return Timer0_Stop();
+}
+
+unsigned long Bench_DualDPTR(unsigned int u16Size)
+{
+    unsigned int u16Addr, u16Len;
+
+    u16Addr = BENCH_SRC_ADDR;
+    Timer0_Start();
+
+    while (u16Size)
+    {
+        u16Len = (u16Size > BENCH_BUF_SIZE) ? BENCH_BUF_SIZE : u16Size;
+        memcpy_code_to_xdata(BenchBuf, (unsigned char code *)u16Addr, u16Len);
+        u16Addr += u16Len;
+        u16Size -= u16Len;
+    }
+
+    return Timer0_Stop();
+}
+
+/* Compare last copied block with APROM */
+unsigned char Bench_Check(unsigned int u16Size)
+{
+    unsigned int i, u16Addr, u16Len;
+
+    u16Len = ((u16Size - 1) % BENCH_BUF_SIZE) + 1;
+    u16Addr = BENCH_SRC_ADDR + u16Size - u16Len;
+
+    for (i = 0; i < u16Len; i++)
+    {
+        if (BenchBuf[i] != *(unsigned char code *)(u16Addr + i))
+            return FAIL;
+    }
+
+    return PASS;
+}
+
+/**
+ * @brief       Copy 16 / 128 / 1024 bytes APROM table to XRAM
+ * @param       None
+ * @return      None
+ * @details     Print system clock cycles of generic pointer loop and memcpy_code_to_xdata,
+ *              the 16 bytes idata copy by memcpy_code_to_idata is printed also.
+ */
+void main(void)
+{
+    unsigned char i;
+    unsigned int j;
+    unsigned long u32Generic, u32DualDPTR, u32Idata;
+    unsigned char u8Result;
+
+/* UART0 initial setting
+  * include sys.c in Library for modify HIRC value to 24MHz
+  * include uart.c in Library for UART initial setting
+*/
+    MODIFY_HIRC(HIRC_24);
+    P06_QUASI_MODE;
+    UART_Open(24000000,UART0_Timer3,115200);
+    ENABLE_UART0_PRINTF;
+
+    /*loop here while P14 = 1; */
+    P14_INPUT_MODE;
+
+    while (P14);
+
+    ENABLE_TIMER0_MODE1;
+    TIMER0_FSYS;
+
+    printf("\n Bytes  Generic  DualDPTR  (Fsys cycles)");
+
+    for (i = 0; i < (sizeof(BenchSize) / sizeof(BenchSize[0])); i++)
+    {
+        u32Generic = Bench_Generic(BenchSize[i]);
+        u8Result = Bench_Check(BenchSize[i]);
+
+        for (j = 0; j < BENCH_BUF_SIZE; j++)
+            BenchBuf[j] = 0;
+
+        u32DualDPTR = Bench_DualDPTR(BenchSize[i]);
+        u8Result |= Bench_Check(BenchSize[i]);
+
+        printf("\n %5u  %7lu  %8lu  %s", BenchSize[i], u32Generic, u32DualDPTR, u8Result == PASS ? "PASS" : "FAIL");
+    }
+
+    Timer0_Start();
+    memcpy_code_to_idata(BenchIdataBuf, (unsigned char code *)BENCH_SRC_ADDR, BENCH_IDATA_SIZE);
+    u32Idata = Timer0_Stop();
+    printf("\n %5d bytes to idata  %lu", BENCH_IDATA_SIZE, u32Idata);
+
+    DISABLE_UART0_PRINTF;
+
+    while (1);
+}
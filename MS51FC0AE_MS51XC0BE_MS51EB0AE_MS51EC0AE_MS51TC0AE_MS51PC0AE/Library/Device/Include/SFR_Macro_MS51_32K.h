@@ -15,21 +15,34 @@
 #include "Function_define_MS51_32K.h"
 #include "adc.h"
 #include "bod.h"
+#include "boot_slot.h"
 #include "common.h"
+#include "crc.h"
 #include "delay.h"
 #include "eeprom_sprom.h"
 #include "eeprom.h"
+#include "eeprom_log.h"
+#include "eeprom_record.h"
+#include "flash_wear.h"
 #include "eeprom_sprom.h"
 #include "I2C.h" 
 #include "IAP.h"
 #include "IAP_SPROM.h"
 #include "isr.h"
+#include "lz_decode.h"
+#include "memcpy_code.h"
+#include "modbus.h"
 #include "pwm0.h"
 #include "pwm123.h"
+#include "sc_iso7816.h"
 #include "spi.h"
 #include "sys.h"
+#include "tlog.h"
 #include "timer.h"
 #include "uart.h"
+#include "uart_putchar.h"
+#include "uart_ring.h"
+#include "uart_sc_ring.h"
 #include "uart2.h"
 #include "uart3.h"
 #include "uart4.h"
@@ -534,7 +547,7 @@
 
 /**** IAPTRG  A4H  PAGE 0 TA protect register ****/
 #define set_IAPTRG_IAPGO                 SFRS=0;BIT_TMP=EA;EA=0;TA=0xAA;TA=0x55;IAPTRG|=0x01;EA=BIT_TMP
-#define set_IAPTRG_IAPGO_WDCLR           SFRS=0;BIT_TMP=EA;EA=0;set_WDCON_WDCLR;TA=0xAA;TA=0x55;IAPTRG|=0x01;EA=BIT_TMP
+#define set_IAPTRG_IAPGO_WDCLR           set_WDCON_WDCLR;BIT_TMP=EA;EA=0;TA=0xAA;TA=0x55;IAPTRG|=0x01;EA=BIT_TMP
 
 /**** IAPUEN  A5H  PAGE 0 TA protect register ****/
 #define set_IAPUEN_SPMEN   BIT_TMP=EA;EA=0;TA=0xAA;TA=0x55;IAPUEN|=0x10;EA=BIT_TMP
@@ -1,19 +1,29 @@
+#define     IAP_REGION_APROM         0
+#define     IAP_REGION_LDROM         1
+
+#define     IAP_VERIFY_NOT_BLANK     0x02
+#define     IAP_VERIFY_MISMATCH      0x03
+
 extern unsigned char xdata DIDBuffer[2];
 extern unsigned char xdata PIDBuffer[2];
 extern unsigned char xdata UIDBuffer[12];
 extern unsigned char xdata UCIDBuffer[12];
 extern unsigned char xdata IAPDataBuf[128];
 extern unsigned char xdata IAPCFBuf[5];
+extern unsigned int xdata u16IAPFailAddress;
+extern unsigned int xdata u16IAPEraseCount;
+extern unsigned int xdata u16IAPProgramCount;
 
 void Trigger_IAP(void);
 void Erase_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
-void Erase_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
+unsigned char Erase_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
 void Program_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
-void Program_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
+unsigned char Program_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
 void Erase_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
-void Erase_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
+unsigned char Erase_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
 void Program_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
-void Program_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
+unsigned char Program_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize);
+unsigned char Program_IAP_Burst(unsigned char u8Region, unsigned int u16IAPStartAddress, const unsigned char *pu8Src, unsigned int u16IAPDataSize);
 void Modify_CONFIG(unsigned char u8CF0,unsigned char u8CF1,unsigned char u8CF2,unsigned char u8CF3,unsigned char u8CF4);
 void Read_UID(void);
 void Read_UCID(void);
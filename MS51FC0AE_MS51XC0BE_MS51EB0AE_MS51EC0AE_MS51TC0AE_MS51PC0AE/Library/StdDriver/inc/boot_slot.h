@@ -0,0 +1,37 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  A/B application slot define, shared by LDROM boot manager (SampleCode/ISP/LDROM_Boot_AB) and APROM    */
+/*  APROM 30KB (LDROM 2KB by CONFIG1), CONFIG0 CBS set to boot from LDROM.                                 */
+/*  0x0000 ~ 0x00FF : vector page, LJMP of reset and interrupt vectors into the booted slot image         */
+/*  slot base       : header page, image from slot base + PAGE_SIZE                                       */
+/*  Slot image is linked with code and interrupt vectors at SLOT_IMAGE_ADDR (C51 INTVECTOR, LX51 CODE).   */
+/*  Header : [version 4][length 2][CRC-32 4][magic 4][checked mark][bad mark], MSB first, magic last.     */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     SLOT_A                  0
+#define     SLOT_B                  1
+#define     SLOT_NONE               0xFF
+
+#define     SLOT_VECTOR_ADDR        0x0000
+#define     SLOT_VECTOR_SIZE        0x0100
+#define     SLOT_VECTOR_NUM         19          /* reset and interrupt 0 ~ 17, vector 0x00, 0x03 ~ 0x8B */
+#define     SLOT_A_ADDR             0x0100
+#define     SLOT_B_ADDR             0x3C80
+#define     SLOT_SIZE               0x3B80
+#define     SLOT_IMAGE_MAX          (SLOT_SIZE - PAGE_SIZE)
+#define     SLOT_ADDR(s)            ((s) == SLOT_A ? SLOT_A_ADDR : SLOT_B_ADDR)
+#define     SLOT_IMAGE_ADDR(s)      (SLOT_ADDR(s) + PAGE_SIZE)
+
+#define     SLOT_HDR_VERSION        0
+#define     SLOT_HDR_LENGTH         4
+#define     SLOT_HDR_CRC            6
+#define     SLOT_HDR_MAGIC          10
+#define     SLOT_HDR_CHECKED        14          /* programmed 0x00 when image CRC-32 is checked */
+#define     SLOT_HDR_BAD            15          /* programmed 0x00 when image CRC-32 not match */
+#define     SLOT_HDR_SIZE           16
+#define     SLOT_MAGIC              0x4D533531  /* "MS51" */
+#define     SLOT_MARK               0x00
+
+unsigned char Boot_Slot_Active(void);
+unsigned long Boot_Slot_Version(unsigned char u8Slot);
+unsigned char Boot_Slot_Erase(unsigned char u8Slot);
+unsigned char Boot_Slot_Program(unsigned char u8Slot, unsigned int u16Offset, const unsigned char *pu8Data, unsigned int u16Size);
+unsigned char Boot_Slot_Commit(unsigned char u8Slot, unsigned long u32Version, unsigned int u16Length, unsigned long u32CRC);
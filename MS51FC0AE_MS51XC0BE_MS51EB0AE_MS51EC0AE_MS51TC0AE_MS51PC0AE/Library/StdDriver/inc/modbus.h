@@ -0,0 +1,61 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Modbus RTU slave define, one slave on UART0 or UART1                                                   */
+/*  modbus.c     : frame CRC by code table while bytes arrive, function 01 02 03 04 05 06 0F 10 on map     */
+/*  modbus_port.c: UART and Timer interrupt, baud rate of Timer3, 3.5 character frame gap of Timer0 / 1    */
+/*  Set MODBUS_ENABLE=1 in project C51 define and add modbus.c and modbus_port.c, then the UART vector of  */
+/*  uart.c or isr.c calls Modbus_UART_ISR and the Timer vector of isr.c, timer.c or the application calls  */
+/*  Modbus_Timer_ISR.                                                                                      */
+/*  The request is served in the timer interrupt at frame end, the reply starts in the same interrupt.     */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef MODBUS_ENABLE
+#define     MODBUS_ENABLE           0
+#endif
+#ifndef MODBUS_UART
+#define     MODBUS_UART             UART0   /* UART0 or UART1 */
+#endif
+#ifndef MODBUS_TIMER
+#define     MODBUS_TIMER            0       /* 0: Timer0, 1: Timer1 (UART0 baud rate is Timer3) */
+#endif
+#ifndef MODBUS_FRAME_MAX
+#define     MODBUS_FRAME_MAX        256     /* ADU with address and CRC */
+#endif
+/* MODBUS_DE_PIN, RS-485 driver enable, e.g. MODBUS_DE_PIN=P05, high while the reply is sent */
+
+#define     MODBUS_COIL             0       /* 0x, read / write bit */
+#define     MODBUS_DISCRETE         1       /* 1x, read bit */
+#define     MODBUS_INPUT_REG        2       /* 3x, read register */
+#define     MODBUS_HOLDING_REG      3       /* 4x, read / write register */
+
+#define     MODBUS_EX_FUNCTION      0x01
+#define     MODBUS_EX_ADDRESS       0x02
+#define     MODBUS_EX_VALUE         0x03
+
+/* One address range of a type. Bits are packed LSB first in unsigned char xdata[], registers are
+   unsigned int xdata[]. A request must be inside one entry. Table ends with u16Count 0. */
+typedef struct
+{
+    unsigned char   u8Type;
+    unsigned int    u16Address;
+    unsigned int    u16Count;
+    void xdata      *pvData;
+} MODBUS_MAP;
+
+extern unsigned char xdata au8ModbusFrame[MODBUS_FRAME_MAX];
+extern unsigned int xdata u16ModbusFrame, u16ModbusCRCError, u16ModbusOverrun, u16ModbusException;
+extern unsigned int code au16ModbusCRC[256];
+
+/* CRC-16 Modbus (reflected 0xA001, init 0xFFFF), one byte */
+#define     MODBUS_CRC(crc, b)      (((crc) >> 8) ^ au16ModbusCRC[((unsigned char)(crc) ^ (b)) & 0xFF])
+
+/* modbus.c, no SFR access */
+void Modbus_Init(unsigned char u8Address, MODBUS_MAP code *pMap);
+void Modbus_RX_Byte(unsigned char u8Data);
+unsigned char Modbus_Frame_End(void);
+unsigned char Modbus_TX_Next(unsigned char *pu8Data);
+unsigned char Modbus_Written(void);
+
+/* modbus_port.c */
+void Modbus_Open(unsigned long u32SysClock, unsigned long u32Baudrate, unsigned char u8Address, MODBUS_MAP code *pMap);
+unsigned char Modbus_Poll(void);
+void Modbus_UART_ISR(void);
+void Modbus_Timer_ISR(void);
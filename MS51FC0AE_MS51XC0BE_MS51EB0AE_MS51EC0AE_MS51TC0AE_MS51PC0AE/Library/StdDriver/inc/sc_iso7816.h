@@ -0,0 +1,79 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  ISO 7816-3 smart card define, SC0 / SC1 / SC2 in smart card mode                                      */
+/*  sc_iso7816.c   : ATR parse, PPS, T=0 TPDU and T=1 block protocol, no SFR access                        */
+/*  sc_iso7816_hw.c: SCn register access, ETU / guard time / convention setting, byte send and receive    */
+/*  Card RST pin is GPIO of application, SC_HW_Set_RST is provided by application.                        */
+/*  Time out is counted in card clock, ISO7816_CARD_CLOCK is the SC clock output of ISO7816_SCDIV.        */
+/*  sc_iso7816_hw.c uses Timer0 by polling while a card function is running.                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef ISO7816_FSYS
+#define     ISO7816_FSYS            24000000    /* Hz, Timer0 time out base */
+#endif
+#ifndef ISO7816_CARD_CLOCK
+#define     ISO7816_CARD_CLOCK      3000000     /* Hz, SC clock output to card */
+#endif
+#ifndef ISO7816_SCDIV
+#define     ISO7816_SCDIV           3           /* SCnETURD1 SCDIV field for ISO7816_CARD_CLOCK, see TRM */
+#endif
+#ifndef ISO7816_IFSD
+#define     ISO7816_IFSD            254         /* T=1 reader information field size */
+#endif
+
+#define     SC0                     0
+#define     SC1                     1
+#define     SC2                     2
+
+#define     SC_OK                   0
+#define     SC_ERR_TIMEOUT          1           /* no byte in WWT / CWT / BWT */
+#define     SC_ERR_PARITY           2           /* character repeated over ISO7816_RETRY times */
+#define     SC_ERR_ATR              3           /* TS, TCK or length of ATR not valid */
+#define     SC_ERR_PPS              4           /* PPS response not match, card must be reset */
+#define     SC_ERR_PROTOCOL         5           /* bad procedure byte or block after retry */
+#define     SC_ERR_LENGTH           6           /* APDU or response over buffer */
+#define     SC_ERR_PARAM            7           /* Fi / Di / T not supported */
+
+#define     ISO7816_RETRY           3
+#define     ISO7816_ATR_MAX         33
+#define     ISO7816_APDU_MAX        261         /* CLA INS P1 P2 Lc 255 data Le */
+#define     ISO7816_RESP_MAX        258         /* 256 data SW1 SW2 */
+
+/* Clock per ETU = Fi / Di, default Fi 372 Di 1. WI / BWI / CWI / IFSC / EDC are protocol defaults until ATR sets them. */
+typedef struct
+{
+    unsigned char   u8Port;
+    unsigned char   au8ATR[ISO7816_ATR_MAX];
+    unsigned char   u8ATRLen;
+    unsigned char   u8HistOffset;       /* historical bytes in au8ATR */
+    unsigned char   u8HistLen;
+    unsigned char   u8TA1;              /* FI high nibble, DI low nibble */
+    unsigned char   u8HasTA1;
+    unsigned char   u8Specific;         /* TA2 present, no PPS */
+    unsigned char   u8Protocol;         /* T = 0 or 1 in use */
+    unsigned char   u8N;                /* TC1 extra guard time */
+    unsigned char   u8WI;               /* T=0 TC2 */
+    unsigned char   u8IFSC;             /* T=1 */
+    unsigned char   u8BWI;
+    unsigned char   u8CWI;
+    unsigned char   u8CRC;              /* T=1 EDC, 1 CRC, 0 LRC */
+    unsigned char   u8NS;               /* T=1 send sequence */
+    unsigned char   u8NR;               /* T=1 expected receive sequence */
+    unsigned char   u8IFSDSent;         /* T=1 S(IFS request) done at first APDU, after PPS */
+    unsigned int    u16EtuClock;        /* Fi / Di in use */
+} SC_CARD;
+
+unsigned char SC_Card_Activate(SC_CARD xdata *pCard, unsigned char u8Port);
+unsigned char SC_Card_PPS(SC_CARD xdata *pCard);
+unsigned char SC_Card_APDU(SC_CARD xdata *pCard, unsigned char xdata *pu8Cmd, unsigned int u16CmdLen,
+                           unsigned char xdata *pu8Resp, unsigned int *pu16RespLen);
+void SC_Card_Deactivate(SC_CARD xdata *pCard);
+
+/* Hardware layer, sc_iso7816_hw.c */
+void SC_HW_Open(unsigned char u8Port);
+void SC_HW_Close(unsigned char u8Port);
+void SC_HW_Set_RST(unsigned char u8Port, unsigned char u8Level);  /* application GPIO */
+void SC_HW_Set_Clock(unsigned char u8Port, unsigned char u8On);
+void SC_HW_Set_ETU(unsigned char u8Port, unsigned int u16EtuClock);
+void SC_HW_Set_Guard(unsigned char u8Port, unsigned char u8Protocol, unsigned char u8N);
+void SC_HW_Wait_Clock(unsigned long u32Clock);
+unsigned char SC_HW_Send(unsigned char u8Port, unsigned char *pu8Data, unsigned int u16Len);
+unsigned char SC_HW_Receive(unsigned char u8Port, unsigned char *pu8Data, unsigned long u32TimeoutClock);
@@ -3,6 +3,9 @@
 #define UART1_Timer3  2
 #define UART0 0
 #define UART1 1
+#define UART2 2      /* SC0 UART mode, uart_sc_ring.c */
+#define UART3 3      /* SC1 */
+#define UART4 4      /* SC2 */
 
 extern   bit PRINTFG,uart0_receive_flag,uart1_receive_flag;
 extern   unsigned char uart0_receive_data,uart1_receive_data;
@@ -0,0 +1,20 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Non blocking putchar define                                                                            */
+/*  Add uart_putchar.c to project with UART_RING_ENABLE=1, printf then queues to UART TX ring and returns. */
+/*  Call UART_Ring_Open(PUTCHAR_UART_PORT) before first printf, ENABLE_UARTx_PRINTF is not used.           */
+/*  putchar and Keil printf are not reentrant, one context per port as uart_ring.c: printf from main       */
+/*  loop or from an interrupt, never in an interrupt while main or another interrupt may be in a printf.   */
+/*  In an interrupt PUTCHAR_BLOCK waits one character time for each byte over the free bytes of ring,      */
+/*  PUTCHAR_DROP returns at once and loses them, see Tool/Printf_Ring_Sim.                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+#define     PUTCHAR_DROP            0       /* TX ring full, character is dropped and counted */
+#define     PUTCHAR_BLOCK           1       /* TX ring full, wait until ring has free byte */
+
+#ifndef PUTCHAR_UART_PORT
+#define     PUTCHAR_UART_PORT       UART0
+#endif
+#ifndef PUTCHAR_OVERFLOW
+#define     PUTCHAR_OVERFLOW        PUTCHAR_DROP
+#endif
+
+extern unsigned int xdata u16PutcharDrop;                            /* characters lost by PUTCHAR_DROP */
@@ -0,0 +1,43 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*  UART2 / UART3 / UART4 (SC0 / SC1 / SC2 in UART mode) interrupt ring buffer define                      */
+/*  RX and TX rings in xdata, each size power of 2 from 2 to 128 bytes.                                    */
+/*  Set UART_SC_RING_ENABLE=1 in project C51 define and add uart_sc_ring.c, then SMC0_ISR / SMC1_ISR /     */
+/*  SMC2_ISR of uart2.c / uart3.c / uart4.c call UART2_Ring_ISR / UART3_Ring_ISR / UART4_Ring_ISR.         */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef UART_SC_RING_ENABLE
+#define     UART_SC_RING_ENABLE     0
+#endif
+
+#ifndef UART2_RX_RING_SIZE
+#define     UART2_RX_RING_SIZE      32
+#endif
+#ifndef UART2_TX_RING_SIZE
+#define     UART2_TX_RING_SIZE      32
+#endif
+#ifndef UART3_RX_RING_SIZE
+#define     UART3_RX_RING_SIZE      32
+#endif
+#ifndef UART3_TX_RING_SIZE
+#define     UART3_TX_RING_SIZE      32
+#endif
+#ifndef UART4_RX_RING_SIZE
+#define     UART4_RX_RING_SIZE      32
+#endif
+#ifndef UART4_TX_RING_SIZE
+#define     UART4_TX_RING_SIZE      32
+#endif
+
+extern unsigned int xdata u16UART2RxOverrun, u16UART3RxOverrun, u16UART4RxOverrun;  /* received bytes lost with RX ring full */
+extern unsigned int xdata u16UART2RxError, u16UART3RxError, u16UART4RxError;        /* parity, frame, break or SC RX overrun */
+extern unsigned char xdata u8UART2RxHighWater, u8UART2TxHighWater;                    /* max bytes ever queued in ring */
+extern unsigned char xdata u8UART3RxHighWater, u8UART3TxHighWater;
+extern unsigned char xdata u8UART4RxHighWater, u8UART4TxHighWater;
+
+void UART_SC_Ring_Open(unsigned char u8UARTPort);
+unsigned char UART_SC_Ring_Write(unsigned char u8UARTPort, unsigned char u8Data);
+unsigned char UART_SC_Ring_Read(unsigned char u8UARTPort, unsigned char *pu8Data);
+unsigned char UART_SC_Ring_Available(unsigned char u8UARTPort);
+unsigned char UART_SC_Ring_TX_Free(unsigned char u8UARTPort);
+void UART2_Ring_ISR(void);
+void UART3_Ring_ISR(void);
+void UART4_Ring_ISR(void);
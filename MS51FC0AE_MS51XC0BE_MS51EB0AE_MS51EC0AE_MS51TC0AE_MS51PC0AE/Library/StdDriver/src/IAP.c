@@ -12,8 +12,8 @@ unsigned char xdata DIDBuffer[2];
 unsigned char xdata PIDBuffer[2];
 unsigned char xdata UIDBuffer[12];
 unsigned char xdata UCIDBuffer[12];
-unsigned char xdata IAPDataBuf[128];
 unsigned char xdata IAPCFBuf[5];
+unsigned int xdata u16IAPFailAddress;
 
 /**
  * @brief       Erase LDROM  
@@ -36,6 +36,8 @@ void Erase_LDROM(unsigned int u16IAPStartAddress,unsigned int u16IAPDataSize)
         IAPAL = LOBYTE(u16Count*PAGE_SIZE + u16IAPStartAddress);
         IAPAH = HIBYTE(u16Count*PAGE_SIZE + u16IAPStartAddress);
         set_IAPTRG_IAPGO_WDCLR;
+        u16IAPEraseCount++;
+        FLASH_WEAR_RECORD;
     } 
     clr_IAPUEN_LDUEN;                    // Disable LDROM modify 
     clr_CHPCON_IAPEN;                    // Disable IAP
@@ -44,30 +46,41 @@ void Erase_LDROM(unsigned int u16IAPStartAddress,unsigned int u16IAPDataSize)
 /**
  * @brief       LDROM blank check
  * @param       u16IAPStartAddress define LDROM area start address
- * @param       u16IAPDataSize define LDROM need be erase bytes size
- * @return      none
- * @details     Check each byte of LDROM is FFH or not.
- * @example      LDROM_BlanckCheck(0x0000,2048);
+ * @param       u16IAPDataSize define LDROM need be check bytes size
+ * @return      PASS, IAP_VERIFY_NOT_BLANK
+ * @details     Check each byte of LDROM is FFH or not, stop at the first fail byte.
+ *              The fail address is saved in u16IAPFailAddress.
+ * @example     if (Erase_Verify_LDROM(0x0000,2048) != PASS) printf("fail at 0x%X", u16IAPFailAddress);
  */
-void Erase_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
+unsigned char Erase_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 {   
     unsigned int u16Count;
+    unsigned char u8Result;
+
+    u8Result = PASS;
     set_CHPCON_IAPEN;
     IAPAL = LOBYTE(u16IAPStartAddress);
     IAPAH = HIBYTE(u16IAPStartAddress);
     IAPCN = BYTE_READ_LDROM;
-
     for(u16Count=0;u16Count<u16IAPDataSize;u16Count++)
     {   
-        IAPFD = 0x00;    
+        IAPFD = 0x00;
         set_IAPTRG_IAPGO;
-        if(IAPFD != 0xFF)
-          while(1);
+        if (IAPFD != 0xFF)
+        {
+            u16IAPFailAddress = u16IAPStartAddress + u16Count;
+            u8Result = IAP_VERIFY_NOT_BLANK;
+            break;
+        }
         IAPAL++;
-        if(IAPAL == 0x00)
-          IAPAH++;
+        if(IAPAL == 0)
+        {
+            IAPAH++;
+        }
     } 
     clr_CHPCON_IAPEN;
+
+    return u8Result;
 }
 
 /**
@@ -92,6 +105,7 @@ void Program_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
     {   
         IAPFD = IAPDataBuf[u16Count];     
         set_IAPTRG_IAPGO_WDCLR;
+        u16IAPProgramCount++;
         IAPAL++;
         if(IAPAL == 0)
         {
@@ -106,15 +120,18 @@ void Program_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 /**
  * @brief       LDROM check loop
  * @param       u16IAPStartAddress define LDROM area start address
- * @param       u16IAPDataSize define LDROM need be erase bytes size
- * @return      none
- * @details     Check with XRAM IAPDataBuf with LDROM
- * @example      LDROM_Program_Verify(0x0000,1024);
+ * @param       u16IAPDataSize define LDROM need be check bytes size
+ * @return      PASS, IAP_VERIFY_MISMATCH
+ * @details     Check with XRAM IAPDataBuf with LDROM, stop at the first fail byte.
+ *              The fail address is saved in u16IAPFailAddress.
+ * @example     if (Program_Verify_LDROM(0x0000,1024) != PASS) printf("fail at 0x%X", u16IAPFailAddress);
  */
-void Program_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
+unsigned char Program_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 {   
     unsigned int u16Count;
+    unsigned char u8Result;
 
+    u8Result = PASS;
     set_CHPCON_IAPEN;
     IAPAL = LOBYTE(u16IAPStartAddress);
     IAPAH = HIBYTE(u16IAPStartAddress);
@@ -123,8 +140,12 @@ void Program_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDa
     {   
         IAPFD = 0x00;
         set_IAPTRG_IAPGO;
-        if (IAPFD != IAPDataBuf[u16Count])    
-            while(1);
+        if (IAPFD != IAPDataBuf[u16Count])
+        {
+            u16IAPFailAddress = u16IAPStartAddress + u16Count;
+            u8Result = IAP_VERIFY_MISMATCH;
+            break;
+        }
         IAPAL++;
         if(IAPAL == 0)
         {
@@ -132,6 +153,8 @@ void Program_Verify_LDROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDa
         }
     } 
     clr_CHPCON_IAPEN;
+
+    return u8Result;
 }
 
 /**
@@ -155,6 +178,8 @@ void Erase_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
         IAPAL = LOBYTE(u16Count*PAGE_SIZE + u16IAPStartAddress);
         IAPAH = HIBYTE(u16Count*PAGE_SIZE + u16IAPStartAddress);
         set_IAPTRG_IAPGO_WDCLR; 
+        u16IAPEraseCount++;
+        FLASH_WEAR_RECORD;
     } 
     clr_IAPUEN_APUEN;                    // Disable APROM modify 
     clr_CHPCON_IAPEN;                    // Disable IAP
@@ -163,30 +188,41 @@ void Erase_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 /**
  * @brief       APROM blank check
  * @param       u16IAPStartAddress define APROM area start address
- * @param       u16IAPDataSize define APROM need be erase bytes size
- * @return      none
- * @details     Check each byte of APPROM is FFH or not.
- * @example      APROM_Blank_Check(0x0000,2048);
+ * @param       u16IAPDataSize define APROM need be check bytes size
+ * @return      PASS, IAP_VERIFY_NOT_BLANK
+ * @details     Check each byte of APROM is FFH or not, stop at the first fail byte.
+ *              The fail address is saved in u16IAPFailAddress.
+ * @example     if (Erase_Verify_APROM(0x0000,2048) != PASS) printf("fail at 0x%X", u16IAPFailAddress);
  */
-void Erase_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
+unsigned char Erase_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 {   
     unsigned int u16Count;
-  
+    unsigned char u8Result;
+
+    u8Result = PASS;
     set_CHPCON_IAPEN;
     IAPAL = LOBYTE(u16IAPStartAddress);
     IAPAH = HIBYTE(u16IAPStartAddress);
     IAPCN = BYTE_READ_APROM;
     for(u16Count=0;u16Count<u16IAPDataSize;u16Count++)
     {   
-        IAPFD = 0x00;    
+        IAPFD = 0x00;
         set_IAPTRG_IAPGO;
-        if(IAPFD != 0xFF)
-          while(1);
+        if (IAPFD != 0xFF)
+        {
+            u16IAPFailAddress = u16IAPStartAddress + u16Count;
+            u8Result = IAP_VERIFY_NOT_BLANK;
+            break;
+        }
         IAPAL++;
-        if(IAPAL == 0x00)
-          IAPAH++;
+        if(IAPAL == 0)
+        {
+            IAPAH++;
+        }
     } 
     clr_CHPCON_IAPEN;
+
+    return u8Result;
 }
 
 /**
@@ -210,6 +246,7 @@ void Program_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
     {   
         IAPFD=IAPDataBuf[u16Count];
         set_IAPTRG_IAPGO_WDCLR;
+        u16IAPProgramCount++;
         IAPAL++;
         if(IAPAL == 0)
         {
@@ -224,15 +261,18 @@ void Program_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 /**
  * @brief       APROM check loop
  * @param       u16IAPStartAddress define APROM area start address
- * @param       u16IAPDataSize define APROM need be erase bytes size
- * @return      none
- * @details     Check with XRAM IAPDataBuf with APROM
- * @example      APROM_Program_Verify(0x0000,1024);
+ * @param       u16IAPDataSize define APROM need be check bytes size
+ * @return      PASS, IAP_VERIFY_MISMATCH
+ * @details     Check with XRAM IAPDataBuf with APROM, stop at the first fail byte.
+ *              The fail address is saved in u16IAPFailAddress.
+ * @example     if (Program_Verify_APROM(0x0000,1024) != PASS) printf("fail at 0x%X", u16IAPFailAddress);
  */
-void Program_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
+unsigned char Program_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDataSize)
 {   
     unsigned int u16Count;
+    unsigned char u8Result;
 
+    u8Result = PASS;
     set_CHPCON_IAPEN;
     IAPAL = LOBYTE(u16IAPStartAddress);
     IAPAH = HIBYTE(u16IAPStartAddress);
@@ -242,7 +282,11 @@ void Program_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDa
         IAPFD = 0x00;
         set_IAPTRG_IAPGO;
         if (IAPFD != IAPDataBuf[u16Count])
-            while(1);
+        {
+            u16IAPFailAddress = u16IAPStartAddress + u16Count;
+            u8Result = IAP_VERIFY_MISMATCH;
+            break;
+        }
         IAPAL++;
         if(IAPAL == 0)
         {
@@ -250,6 +294,122 @@ void Program_Verify_APROM(unsigned int u16IAPStartAddress, unsigned int u16IAPDa
         }
     } 
     clr_CHPCON_IAPEN;
+
+    return u8Result;
+}
+
+
+/**
+ * @brief       APROM / LDROM burst program from pointer
+ * @param       u8Region IAP_REGION_APROM or IAP_REGION_LDROM
+ * @param       u16IAPStartAddress define program area start address
+ * @param       pu8Src data source, xdata or code pointer
+ * @param       u16IAPDataSize define need be program bytes size
+ * @return      PASS / FAIL (IAPFF set by hardware)
+ * @details     IAP enable once per call, watchdog clear and IAPFF check once per page. An xdata or code
+ *              source is read by a typed pointer (MOVX / MOVC and INC DPTR), other memory types by the
+ *              generic pointer. EA is 0 only for the timed access and trigger of each byte, so interrupt
+ *              latency is one byte program time as for Program_APROM. Area must be erased before program.
+ * @example     Program_IAP_Burst(IAP_REGION_APROM,0x1000,IAPDataBuf,128);
+ */
+unsigned char Program_IAP_Burst(unsigned char u8Region, unsigned int u16IAPStartAddress, const unsigned char *pu8Src, unsigned int u16IAPDataSize)
+{
+    unsigned char u8Count, u8Page, u8Result;
+    unsigned char xdata *pu8XRAM;
+    unsigned char code *pu8Code;
+    bit bEA;
+
+    u8Result = PASS;
+    bEA = EA;
+
+    set_CHPCON_IAPEN;
+    if (u8Region == IAP_REGION_LDROM)
+    {
+        set_IAPUEN_LDUEN;
+        IAPCN = BYTE_PROGRAM_LDROM;
+    }
+    else
+    {
+        set_IAPUEN_APUEN;
+        IAPCN = BYTE_PROGRAM_APROM;
+    }
+    IAPAL = LOBYTE(u16IAPStartAddress);
+    IAPAH = HIBYTE(u16IAPStartAddress);
+
+    while (u16IAPDataSize)
+    {
+        u8Page = PAGE_SIZE - (IAPAL & (PAGE_SIZE - 1));         // Bytes left in this page
+        if (u16IAPDataSize < u8Page)
+            u8Page = u16IAPDataSize;
+        u16IAPDataSize -= u8Page;
+        u16IAPProgramCount += u8Page;
+        u8Count = u8Page;
+
+        set_WDCON_WDCLR;
+        if (GENERIC_PTR_TYPE(pu8Src) == PTR_TYPE_XDATA)
+        {
+            pu8XRAM = (unsigned char xdata *)pu8Src;
+            do
+            {
+                IAPFD = *pu8XRAM++;
+                EA = 0;                                         // Only TA and trigger must not be interrupted
+                TA = 0xAA;
+                TA = 0x55;
+                IAPTRG |= 0x01;
+                EA = bEA;
+                IAPAL++;
+            } while (--u8Count);
+        }
+        else if (GENERIC_PTR_TYPE(pu8Src) == PTR_TYPE_CODE)
+        {
+            pu8Code = (unsigned char code *)(unsigned int)pu8Src;     // Offset of the generic pointer
+            do
+            {
+                IAPFD = *pu8Code++;
+                EA = 0;
+                TA = 0xAA;
+                TA = 0x55;
+                IAPTRG |= 0x01;
+                EA = bEA;
+                IAPAL++;
+            } while (--u8Count);
+        }
+        else
+        {
+            do
+            {
+                IAPFD = pu8Src[u8Page - u8Count];
+                EA = 0;
+                TA = 0xAA;
+                TA = 0x55;
+                IAPTRG |= 0x01;
+                EA = bEA;
+                IAPAL++;
+            } while (--u8Count);
+        }
+        pu8Src += u8Page;
+        if (IAPAL == 0)                                         // Carry only happen at page end
+            IAPAH++;
+
+        if (CHPCON & 0x40)                                      // IAPFF, IAP fail
+        {
+            clr_CHPCON_IAPFF;
+            u8Result = FAIL;
+            break;
+        }
+    }
+
+    if (u8Region == IAP_REGION_LDROM)
+    {
+        clr_IAPUEN_LDUEN;
+    }
+    else
+    {
+        clr_IAPUEN_APUEN;
+    }
+    clr_CHPCON_IAPEN;
+
+    return u8Result;
 }
 
 
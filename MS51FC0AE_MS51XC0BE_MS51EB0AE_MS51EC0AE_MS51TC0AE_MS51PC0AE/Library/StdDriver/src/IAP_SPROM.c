@@ -7,7 +7,6 @@
 
 #include "MS51_32K.h"
 
-unsigned char xdata IAPSPDataBuf[127];
 
 
 
@@ -31,6 +30,7 @@ void Erase_SPROM(void)
     IAPAL = 0x80;
     IAPAH = 0x01;
     set_IAPTRG_IAPGO;
+    u16IAPEraseCount++;
 
     clr_IAPUEN_SPUEN;                    //  SPROM modify disable
     clr_CHPCON_IAPEN;                    // Disable IAP
@@ -93,6 +93,7 @@ void Program_SPROM(unsigned int u16IAPDataSize)
     {
         IAPFD = IAPSPDataBuf[u16Count];
         set_IAPTRG_IAPGO;
+        u16IAPProgramCount++;
         IAPAL++;
     }
 
@@ -0,0 +1,24 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+/**
+ * Shared flash scratch page buffer.
+ * Used by Program_APROM / Program_LDROM / Program_SPROM (IAPSPDataBuf) and as page merge buffer by
+ * Write_DATAFLASH_BYTE / WriteDataToOnePage / WriteDataToSPOnePage, only one of them is live at a time.
+ * Application can borrow it between flash write calls, the content is not kept after any eeprom write.
+ */
+unsigned char xdata IAPDataBuf[128];
+
+/**
+ * Flash operation counters, page erase and byte program of APROM / LDROM / SPROM data area.
+ * Counted by IAP.c / IAP_SPROM.c / eeprom.c / eeprom_sprom.c / eeprom_record.c, CONFIG not counted.
+ * Application clears them before an API call and reads them after to get cost of the call.
+ */
+unsigned int xdata u16IAPEraseCount;
+unsigned int xdata u16IAPProgramCount;
@@ -7,6 +7,8 @@
 
 #include "MS51_32K.h"
 
+bit bod_event_flag = 0;                     /* set in BOD interrupt, checked by flash write functions */
+
 /**
   * @brief BOD initial setting 
   * @param[in] u8bodstatus define enable BOD status.
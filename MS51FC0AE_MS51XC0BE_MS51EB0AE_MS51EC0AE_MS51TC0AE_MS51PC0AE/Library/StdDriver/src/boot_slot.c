@@ -0,0 +1,115 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+/**
+ * @brief       Slot of running application
+ * @param       none
+ * @return      SLOT_A / SLOT_B
+ * @details     Reset vector LJMP target of vector page, written by LDROM boot manager.
+ */
+unsigned char Boot_Slot_Active(void)
+{
+    unsigned int u16Target;
+
+    u16Target = ((unsigned int)CBYTE[SLOT_VECTOR_ADDR + 1] << 8) | CBYTE[SLOT_VECTOR_ADDR + 2];
+
+    return (u16Target == SLOT_IMAGE_ADDR(SLOT_B)) ? SLOT_B : SLOT_A;
+}
+
+/**
+ * @brief       Image version of slot header
+ * @param       u8Slot SLOT_A / SLOT_B
+ * @return      version, 0 when header magic not programmed or slot marked bad
+ */
+unsigned long Boot_Slot_Version(unsigned char u8Slot)
+{
+    unsigned char code *pCode;
+
+    pCode = (unsigned char code *)SLOT_ADDR(u8Slot);
+
+    if (((unsigned long)pCode[SLOT_HDR_MAGIC] << 24 | (unsigned long)pCode[SLOT_HDR_MAGIC + 1] << 16
+         | (unsigned int)pCode[SLOT_HDR_MAGIC + 2] << 8 | pCode[SLOT_HDR_MAGIC + 3]) != SLOT_MAGIC
+        || pCode[SLOT_HDR_BAD] == SLOT_MARK)
+        return 0;
+
+    return (unsigned long)pCode[SLOT_HDR_VERSION] << 24 | (unsigned long)pCode[SLOT_HDR_VERSION + 1] << 16
+           | (unsigned int)pCode[SLOT_HDR_VERSION + 2] << 8 | pCode[SLOT_HDR_VERSION + 3];
+}
+
+/**
+ * @brief       Erase inactive slot
+ * @param       u8Slot SLOT_A / SLOT_B
+ * @return      PASS / FAIL (slot is running)
+ * @details     Header page is erased first, the slot is invalid from the first erase.
+ */
+unsigned char Boot_Slot_Erase(unsigned char u8Slot)
+{
+    if (u8Slot == Boot_Slot_Active())
+        return FAIL;
+
+    Erase_APROM(SLOT_ADDR(u8Slot), SLOT_SIZE);
+
+    return PASS;
+}
+
+/**
+ * @brief       Program image data of inactive slot
+ * @param       u8Slot SLOT_A / SLOT_B
+ * @param       u16Offset image offset
+ * @param       pu8Data data pointer, xdata or code
+ * @param       u16Size data bytes
+ * @return      PASS / FAIL (slot is running, over SLOT_IMAGE_MAX or IAP fail)
+ * @details     Slot must be erased by Boot_Slot_Erase before program.
+ */
+unsigned char Boot_Slot_Program(unsigned char u8Slot, unsigned int u16Offset, const unsigned char *pu8Data, unsigned int u16Size)
+{
+    if (u8Slot == Boot_Slot_Active() || u16Offset > SLOT_IMAGE_MAX || u16Size > SLOT_IMAGE_MAX - u16Offset)
+        return FAIL;
+
+    return Program_IAP_Burst(IAP_REGION_APROM, SLOT_IMAGE_ADDR(u8Slot) + u16Offset, pu8Data, u16Size);
+}
+
+/**
+ * @brief       Check programmed image and write slot header
+ * @param       u8Slot SLOT_A / SLOT_B
+ * @param       u32Version image version, the valid slot with larger version is booted
+ * @param       u16Length image bytes
+ * @param       u32CRC CRC-32 of image from update source
+ * @return      PASS / FAIL (slot is running, length error or CRC not match)
+ * @details     Image CRC-32 is read by MOVC, the header is programmed with checked mark so LDROM boot
+ *              manager need not read the image again. Magic is programmed after version, length and CRC.
+ */
+unsigned char Boot_Slot_Commit(unsigned char u8Slot, unsigned long u32Version, unsigned int u16Length, unsigned long u32CRC)
+{
+    unsigned char xdata u8Header[SLOT_HDR_SIZE - 1];
+    unsigned char i;
+
+    if (u8Slot == Boot_Slot_Active() || u16Length == 0 || u16Length > SLOT_IMAGE_MAX)
+        return FAIL;
+
+    if ((CRC32_APROM(CRC32_INIT, SLOT_IMAGE_ADDR(u8Slot), u16Length) ^ CRC32_XOROUT) != u32CRC)
+        return FAIL;
+
+    for (i = 0; i < 4; i++)
+    {
+        u8Header[SLOT_HDR_VERSION + i] = (unsigned char)(u32Version >> (24 - i * 8));
+        u8Header[SLOT_HDR_CRC + i] = (unsigned char)(u32CRC >> (24 - i * 8));
+        u8Header[SLOT_HDR_MAGIC + i] = (unsigned char)((unsigned long)SLOT_MAGIC >> (24 - i * 8));
+    }
+
+    u8Header[SLOT_HDR_LENGTH] = HIBYTE(u16Length);
+    u8Header[SLOT_HDR_LENGTH + 1] = LOBYTE(u16Length);
+    u8Header[SLOT_HDR_CHECKED] = SLOT_MARK;
+
+    /* programmed in address order, an interrupted commit leaves magic not programmed */
+    if (Program_IAP_Burst(IAP_REGION_APROM, SLOT_ADDR(u8Slot), u8Header, SLOT_HDR_SIZE - 1) != PASS)
+        return FAIL;
+
+    return (Boot_Slot_Version(u8Slot) == u32Version) ? PASS : FAIL;
+}
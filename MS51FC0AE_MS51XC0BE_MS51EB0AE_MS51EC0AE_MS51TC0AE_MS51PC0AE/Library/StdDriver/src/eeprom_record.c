@@ -0,0 +1,260 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#if (REC_DATA_SIZE > (PAGE_SIZE - 4))
+#error "REC_DATA_SIZE must not over 124 bytes"
+#endif
+
+unsigned int xdata u16RecordSequence;
+unsigned int xdata u16RecordAddr;                   /* newest valid slot, 0 means no valid record */
+unsigned int xdata u16RecordWritePage;              /* page and slot to be programmed */
+unsigned char xdata u8RecordWriteSlot;
+
+/**
+ * @brief       Check one record slot is blank
+ * @param       u16Addr slot start address
+ * @return      1 blank / 0 not blank
+ */
+unsigned char Record_Slot_Blank(unsigned int u16Addr)
+{
+    unsigned char i;
+    unsigned char code *pCode;
+
+    pCode = (unsigned char code *)u16Addr;
+
+    for (i = 0; i < REC_SLOT_SIZE; i++)
+    {
+        if (pCode[i] != 0xFF)
+            return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief       Program bytes of record area with read back check
+ * @param       u16Addr APROM address
+ * @param       pu8Data data pointer
+ * @param       u8Size data bytes
+ * @return      PASS / FAIL
+ * @details     Caller must enable IAP and APROM update before call.
+ */
+unsigned char Record_Program(unsigned int u16Addr, const unsigned char *pu8Data, unsigned char u8Size)
+{
+    unsigned char i;
+    unsigned char code *pCode;
+
+    pCode = (unsigned char code *)u16Addr;
+    IAPCN = BYTE_PROGRAM_APROM;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+
+    for (i = 0; i < u8Size; i++)
+    {
+        IAPFD = pu8Data[i];
+        set_IAPTRG_IAPGO;
+        u16IAPProgramCount++;
+        IAPAL++;
+    }
+
+    for (i = 0; i < u8Size; i++)
+    {
+        if (pCode[i] != pu8Data[i])
+            return FAIL;
+    }
+
+    return PASS;
+}
+
+/**
+ * @brief       Mount record area
+ * @param       none
+ * @return      PASS valid record found / FAIL no valid record
+ * @details     Single MOVC pass over both pages, each slot CRC checked once,
+ *              the valid slot with the newest sequence is selected. Torn slot (CRC blank or not match) is ignored.
+ *              Mount time is bounded by 2 pages, no flash erase or program in mount.
+ * @example     if (Init_DATAFLASH_RECORD() == PASS) Read_DATAFLASH_RECORD(buf);
+ */
+unsigned char Init_DATAFLASH_RECORD(void)
+{
+    unsigned char u8Slot;
+    unsigned int u16Page, u16Addr, u16Seq, u16CRC;
+    unsigned char code *pCode;
+
+    u16RecordAddr = 0;
+    u16RecordSequence = 0;
+
+    for (u16Page = REC_PAGE0_ADDR; u16Page <= REC_PAGE1_ADDR; u16Page += PAGE_SIZE)
+    {
+        for (u8Slot = 0; u8Slot < REC_SLOT_NUM; u8Slot++)
+        {
+            u16Addr = u16Page + u8Slot * REC_SLOT_SIZE;
+            pCode = (unsigned char code *)u16Addr;
+            u16Seq = pCode[0] | (pCode[1] << 8);
+
+            if (u16Seq == REC_SEQ_BLANK)
+                continue;
+
+            /* CRC not programmed, Write_DATAFLASH_RECORD never uses CRC 0xFFFF */
+            if ((pCode[REC_DATA_SIZE + 2] == 0xFF) && (pCode[REC_DATA_SIZE + 3] == 0xFF))
+                continue;
+
+            u16CRC = CRC16_APROM(CRC16_INIT, u16Addr, REC_DATA_SIZE + 2);
+
+            if ((pCode[REC_DATA_SIZE + 2] != HIBYTE(u16CRC)) || (pCode[REC_DATA_SIZE + 3] != LOBYTE(u16CRC)))
+                continue;
+
+            /* Sequence compare with wrap around */
+            if ((u16RecordAddr == 0) || ((int)(u16Seq - u16RecordSequence) > 0))
+            {
+                u16RecordAddr = u16Addr;
+                u16RecordSequence = u16Seq;
+            }
+        }
+    }
+
+    if (u16RecordAddr == 0)
+    {
+        u16RecordWritePage = REC_PAGE0_ADDR;
+        u8RecordWriteSlot = 0;
+        return FAIL;
+    }
+
+    u16RecordWritePage = u16RecordAddr & ~(PAGE_SIZE - 1);
+    u8RecordWriteSlot = (u16RecordAddr - u16RecordWritePage) / REC_SLOT_SIZE + 1;
+    return PASS;
+}
+
+/**
+ * @brief       Read newest valid record
+ * @param       pu8Data buffer to store REC_DATA_SIZE bytes
+ * @return      PASS / FAIL no valid record
+ * @example     Read_DATAFLASH_RECORD(buf);
+ */
+unsigned char Read_DATAFLASH_RECORD(unsigned char *pu8Data)
+{
+    unsigned char i;
+    unsigned char code *pCode;
+
+    if (u16RecordAddr == 0)
+        return FAIL;
+
+    pCode = (unsigned char code *)(u16RecordAddr + 2);
+
+    for (i = 0; i < REC_DATA_SIZE; i++)
+    {
+        pu8Data[i] = pCode[i];
+    }
+
+    return PASS;
+}
+
+/**
+ * @brief       Write a new record
+ * @param       pu8Data REC_DATA_SIZE bytes record data
+ * @return      PASS / FAIL / REC_ERR_BOD
+ * @details     The new record is programmed into next blank slot, sequence and data first, CRC at last.
+ *              When a page is full the other page is erased, the page keeps the newest valid record is never
+ *              erased, so power lost at any time still leaves the previous record readable.
+ *              No erase or program is started while bod_event_flag is set by BOD interrupt.
+ * @example     Write_DATAFLASH_RECORD(buf);
+ */
+unsigned char Write_DATAFLASH_RECORD(const unsigned char *pu8Data)
+{
+    unsigned char u8Result, u8Retry;
+    unsigned int u16Seq, u16CRC, u16Addr;
+    unsigned char xdata u8Head[2];
+    unsigned char xdata u8Tail[2];
+
+    if (bod_event_flag)
+        return REC_ERR_BOD;
+
+    u16Seq = u16RecordSequence;
+
+    /* CRC 0xFFFF reads as the blank CRC of a torn slot, skip that sequence */
+    do
+    {
+        u16Seq++;
+
+        if (u16Seq == REC_SEQ_BLANK)
+            u16Seq = 0;
+
+        u8Head[0] = LOBYTE(u16Seq);
+        u8Head[1] = HIBYTE(u16Seq);
+        u16CRC = CRC16_Buffer(CRC16_INIT, u8Head, 2);
+        u16CRC = CRC16_Buffer(u16CRC, pu8Data, REC_DATA_SIZE);
+    } while (u16CRC == 0xFFFF);
+
+    u8Tail[0] = HIBYTE(u16CRC);
+    u8Tail[1] = LOBYTE(u16CRC);
+
+    u8Result = FAIL;
+
+    set_CHPCON_IAPEN;
+    set_IAPUEN_APUEN;
+
+    /* A failed slot is left invalid (CRC not match), retry once in next slot */
+    for (u8Retry = 0; u8Retry < 2; u8Retry++)
+    {
+        /* Skip slot not blank, e.g. torn record after power lost */
+        while ((u8RecordWriteSlot < REC_SLOT_NUM) && !Record_Slot_Blank(u16RecordWritePage + u8RecordWriteSlot * REC_SLOT_SIZE))
+        {
+            u8RecordWriteSlot++;
+        }
+
+        if (u8RecordWriteSlot >= REC_SLOT_NUM)
+        {
+            if (bod_event_flag)
+            {
+                u8Result = REC_ERR_BOD;
+                break;
+            }
+
+            /* Page full, erase the page not hold the newest record */
+            if (u16RecordAddr != 0)
+                u16Addr = u16RecordAddr & ~(PAGE_SIZE - 1);
+            else
+                u16Addr = u16RecordWritePage;
+
+            if (u16Addr == REC_PAGE0_ADDR)
+                u16RecordWritePage = REC_PAGE1_ADDR;
+            else
+                u16RecordWritePage = REC_PAGE0_ADDR;
+
+            IAPCN = PAGE_ERASE_APROM;
+            IAPAL = LOBYTE(u16RecordWritePage);
+            IAPAH = HIBYTE(u16RecordWritePage);
+            IAPFD = 0xFF;
+            set_IAPTRG_IAPGO_WDCLR;
+            u16IAPEraseCount++;
+            FLASH_WEAR_RECORD;
+            u8RecordWriteSlot = 0;
+        }
+
+        u16Addr = u16RecordWritePage + u8RecordWriteSlot * REC_SLOT_SIZE;
+        u8RecordWriteSlot++;
+
+        if (Record_Program(u16Addr, u8Head, 2) != PASS)
+            continue;
+        if (Record_Program(u16Addr + 2, pu8Data, REC_DATA_SIZE) != PASS)
+            continue;
+        if (Record_Program(u16Addr + REC_DATA_SIZE + 2, u8Tail, 2) != PASS)
+            continue;
+
+        u16RecordAddr = u16Addr;
+        u16RecordSequence = u16Seq;
+        u8Result = PASS;
+        break;
+    }
+
+    clr_IAPUEN_APUEN;
+    clr_CHPCON_IAPEN;
+
+    return u8Result;
+}
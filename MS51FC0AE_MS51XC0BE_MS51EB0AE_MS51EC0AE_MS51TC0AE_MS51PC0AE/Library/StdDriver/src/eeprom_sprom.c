@@ -47,19 +47,32 @@ void Write_SPROM_DATAFLASH_ARRAY(unsigned int u16_addr, unsigned char *pDat, uns
 //-------------------------------------------------------------------------
 void Read_SPROM_DATAFLASH_ARRAY(unsigned int u16_addr, unsigned char *pDat, unsigned int num)
 {
-    unsigned int i;
+    unsigned char code *pCode;
 
     set_IAPUEN_SPMEN;
-    for (i = 0; i < num; i++)
-        pDat[i] = *(unsigned char code *)(u16_addr+0xFF80 + i);
+    pCode = (unsigned char code *)(u16_addr + 0xFF80);
+
+    /* xdata and idata buffer copied by memcpy_code.A51, other memory type by generic pointer */
+    if (GENERIC_PTR_TYPE(pDat) == PTR_TYPE_XDATA)
+    {
+        memcpy_code_to_xdata((unsigned char xdata *)pDat, pCode, num);
+    }
+    else if ((GENERIC_PTR_TYPE(pDat) == PTR_TYPE_IDATA) && (num < 0x100))
+    {
+        memcpy_code_to_idata((unsigned char idata *)pDat, pCode, num);
+    }
+    else
+    {
+        while (num--)
+            *pDat++ = *pCode++;
+    }
 }
 
 //-----------------------------------------------------------------------------------------------------------
 unsigned char WriteDataToSPOnePage(unsigned int u16_addr, const unsigned char *pDat, unsigned char num)
 {
-    unsigned char i, offset;
+    unsigned char i, offset, u8Data;
     unsigned char code *pCode;
-    unsigned char xdata xd_tmp[127];
 
     set_CHPCON_IAPEN;
     set_IAPUEN_SPMEN;
@@ -78,12 +91,14 @@ unsigned char WriteDataToSPOnePage(unsigned int u16_addr, const unsigned char *p
             IAPCN = PAGE_ERASE_SPROM;
             IAPFD = 0xFF;
             set_IAPTRG_IAPGO;
+            u16IAPEraseCount++;
     }
     
     pCode = (unsigned char code *)(u16_addr+0xFF80);
+    /* Flash bit can be programmed from 1 to 0 without erase, erase page only when any bit need 0 to 1 */
       for (i = 0; i < num; i++)
     {
-        if (pCode[i] != 0xFF)break;
+        if ((pCode[i] & pDat[i]) != pDat[i])break;
     }
 
     if (i == num)
@@ -94,8 +109,12 @@ unsigned char WriteDataToSPOnePage(unsigned int u16_addr, const unsigned char *p
 
         for (i = 0; i < num; i++)
         {
-            IAPFD = pDat[i];
-            set_IAPTRG_IAPGO;
+            if (pCode[i] != pDat[i])                 /* same value no need program */
+            {
+                IAPFD = pDat[i];
+                set_IAPTRG_IAPGO;
+                u16IAPProgramCount++;
+            }
             IAPAL++;
         }
 
@@ -111,14 +130,11 @@ unsigned char WriteDataToSPOnePage(unsigned int u16_addr, const unsigned char *p
 WriteDataToPage20:
         pCode = (unsigned char code *)(0xFF80);
 
-        for (i = 0; i < 128; i++)
-        {
-            xd_tmp[i] = pCode[i];
-        }
-
-        for (i = 0; i < num; i++)
+        /* Only bytes not changed are saved in shared IAPDataBuf, new bytes are merged from pDat in program loop */
+        for (i = 0; i < 127; i++)
         {
-            xd_tmp[offset + i] = pDat[i];
+            if ((i < offset) || (i >= offset + num))
+                IAPDataBuf[i] = pCode[i];
         }
 
         do
@@ -128,20 +144,35 @@ WriteDataToPage20:
             IAPCN = PAGE_ERASE_SPROM;
             IAPFD = 0xFF;
             set_IAPTRG_IAPGO;
+            u16IAPEraseCount++;
             IAPCN = BYTE_PROGRAM_SPROM;
 
             for (i = 0; i < 127; i++)
             {
-                IAPFD = xd_tmp[i];
-                set_IAPTRG_IAPGO;
+                if ((i < offset) || (i >= offset + num))
+                    u8Data = IAPDataBuf[i];
+                else
+                    u8Data = pDat[i - offset];
+
+                if (u8Data != 0xFF)                    /* erased byte no need program */
+                {
+                    IAPFD = u8Data;
+                    set_IAPTRG_IAPGO;
+                    u16IAPProgramCount++;
+                }
                 IAPAL++;
             }
 
-            for (i = 0; i < 128; i++)
+            for (i = 0; i < 127; i++)
             {
-                if (pCode[i] != xd_tmp[i])break;
+                if ((i < offset) || (i >= offset + num))
+                    u8Data = IAPDataBuf[i];
+                else
+                    u8Data = pDat[i - offset];
+
+                if (pCode[i] != u8Data)break;
             }
-        } while (i != 128);
+        } while (i != 127);
 
     }
 
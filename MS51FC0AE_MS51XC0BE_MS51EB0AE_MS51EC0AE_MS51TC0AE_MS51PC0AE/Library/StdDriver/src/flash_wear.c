@@ -0,0 +1,334 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#if (WEAR_TALLY_START > (PAGE_SIZE - 32))
+#error "WEAR_TRACK_PAGE_NUM too large, keep at least 32 tally bytes in a wear page"
+#endif
+
+#if ((WEAR_PAGE0_ADDR >= WEAR_TRACK_ADDR) && (WEAR_PAGE0_ADDR < (WEAR_TRACK_ADDR + WEAR_TRACK_PAGE_NUM * PAGE_SIZE))) || \
+    ((WEAR_PAGE1_ADDR >= WEAR_TRACK_ADDR) && (WEAR_PAGE1_ADDR < (WEAR_TRACK_ADDR + WEAR_TRACK_PAGE_NUM * PAGE_SIZE)))
+#error "Wear area pages must be out of tracked pages"
+#endif
+
+unsigned long xdata WearCount[WEAR_SLOT_NUM];       /* RAM copy, base in page + tally records */
+
+unsigned int xdata u16WearActivePage;               /* 0 means Init_FLASH_WEAR not called */
+unsigned char xdata u8WearWriteOffset;
+unsigned char xdata u8WearSequence;
+
+/**
+ * @brief       Program one byte of the wear area
+ * @param       u16Addr APROM address
+ * @param       u8Data value to be programmed
+ * @return      none
+ * @details     Caller must enable IAP and APROM update before call.
+ */
+void Wear_Program_Byte(unsigned int u16Addr, unsigned char u8Data)
+{
+    IAPCN = BYTE_PROGRAM_APROM;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+    IAPFD = u8Data;
+    set_IAPTRG_IAPGO;
+    u16IAPProgramCount++;
+}
+
+/**
+ * @brief       Erase one page of the wear area if it is not blank
+ * @param       u16Addr page start address
+ * @return      none
+ * @details     Caller must enable IAP and APROM update before call. Erase counted in WEAR_SLOT_SELF of RAM.
+ */
+void Wear_Erase_Page(unsigned int u16Addr)
+{
+    unsigned char i;
+    unsigned char code *pCode;
+
+    pCode = (unsigned char code *)u16Addr;
+
+    for (i = 0; i < PAGE_SIZE; i++)
+    {
+        if (pCode[i] != 0xFF)
+            break;
+    }
+
+    if (i == PAGE_SIZE)
+        return;
+
+    IAPCN = PAGE_ERASE_APROM;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+    IAPFD = 0xFF;
+    set_IAPTRG_IAPGO_WDCLR;
+    u16IAPEraseCount++;
+    WearCount[WEAR_SLOT_SELF]++;
+}
+
+/**
+ * @brief       Move RAM counters into the other wear page as new base
+ * @param       none
+ * @return      none
+ * @details     New page is marked RECEIVING while base counters programmed and ACTIVE after,
+ *              then the old page is erased and its erase is the first tally of the new page.
+ */
+void Wear_Page_Transfer(void)
+{
+    unsigned int u16NewPage, u16OldPage;
+    unsigned char u8Slot, u8Offset, i;
+    unsigned long u32Count;
+
+    u16OldPage = u16WearActivePage;
+
+    if (u16OldPage == WEAR_PAGE0_ADDR)
+        u16NewPage = WEAR_PAGE1_ADDR;
+    else
+        u16NewPage = WEAR_PAGE0_ADDR;
+
+    Wear_Erase_Page(u16NewPage);
+    Wear_Program_Byte(u16NewPage, WEAR_PAGE_RECEIVING);
+    Wear_Program_Byte(u16NewPage + 1, u8WearSequence + 1);
+
+    /* Base counter little endian, byte 0xFF is left blank */
+    u8Offset = WEAR_BASE_START;
+
+    for (u8Slot = 0; u8Slot < WEAR_SLOT_NUM; u8Slot++)
+    {
+        u32Count = WearCount[u8Slot];
+
+        for (i = 0; i < 4; i++)
+        {
+            if ((unsigned char)u32Count != 0xFF)
+                Wear_Program_Byte(u16NewPage + u8Offset, (unsigned char)u32Count);
+
+            u32Count >>= 8;
+            u8Offset++;
+        }
+    }
+
+    Wear_Program_Byte(u16NewPage, WEAR_PAGE_ACTIVE);
+
+    u16WearActivePage = u16NewPage;
+    u8WearWriteOffset = WEAR_TALLY_START;
+    u8WearSequence++;
+
+    Wear_Erase_Page(u16OldPage);
+    Wear_Program_Byte(u16NewPage + u8WearWriteOffset, WEAR_SLOT_SELF);
+    u8WearWriteOffset++;
+}
+
+/**
+ * @brief       Append one tally record
+ * @param       u8Slot counter slot
+ * @return      none
+ * @details     One byte program, page transfer when the active page is full.
+ */
+void Wear_Append(unsigned char u8Slot)
+{
+    if (u8WearWriteOffset >= PAGE_SIZE)
+    {
+        Wear_Page_Transfer();
+    }
+
+    Wear_Program_Byte(u16WearActivePage + u8WearWriteOffset, u8Slot);
+    u8WearWriteOffset++;
+}
+
+/**
+ * @brief       Mount the wear area and build RAM counters
+ * @param       none
+ * @return      none
+ * @details     Select the active page by page status and sequence, finish any interrupted page transfer,
+ *              load base counters and add tally records. Must be called before any flash erase to be counted.
+ * @example     Init_FLASH_WEAR();
+ */
+void Init_FLASH_WEAR(void)
+{
+    unsigned char u8Status0, u8Status1, u8Seq0, u8Seq1;
+    unsigned char u8Slot, u8Offset, i;
+    unsigned int u16OldPage;
+    unsigned long u32Count;
+    unsigned char code *pCode;
+
+    u8Status0 = *(unsigned char code *)WEAR_PAGE0_ADDR;
+    u8Status1 = *(unsigned char code *)WEAR_PAGE1_ADDR;
+    u8Seq0 = *(unsigned char code *)(WEAR_PAGE0_ADDR + 1);
+    u8Seq1 = *(unsigned char code *)(WEAR_PAGE1_ADDR + 1);
+    u16OldPage = 0;
+
+    set_CHPCON_IAPEN;
+    set_IAPUEN_APUEN;
+
+    if ((u8Status0 == WEAR_PAGE_ACTIVE) && (u8Status1 == WEAR_PAGE_ACTIVE))
+    {
+        /* Power lost before old page erased, the page with next sequence is newer */
+        if ((unsigned char)(u8Seq1 - u8Seq0) == 1)
+        {
+            u16WearActivePage = WEAR_PAGE1_ADDR;
+            u16OldPage = WEAR_PAGE0_ADDR;
+        }
+        else
+        {
+            u16WearActivePage = WEAR_PAGE0_ADDR;
+            u16OldPage = WEAR_PAGE1_ADDR;
+        }
+    }
+    else if (u8Status0 == WEAR_PAGE_ACTIVE)
+    {
+        u16WearActivePage = WEAR_PAGE0_ADDR;
+    }
+    else if (u8Status1 == WEAR_PAGE_ACTIVE)
+    {
+        u16WearActivePage = WEAR_PAGE1_ADDR;
+    }
+    else
+    {
+        /* No valid page or power lost while programming base counters, start from zero */
+        Wear_Erase_Page(WEAR_PAGE0_ADDR);
+        Wear_Erase_Page(WEAR_PAGE1_ADDR);
+        Wear_Program_Byte(WEAR_PAGE0_ADDR, WEAR_PAGE_ACTIVE);
+        Wear_Program_Byte(WEAR_PAGE0_ADDR + 1, 0);
+        u16WearActivePage = WEAR_PAGE0_ADDR;
+    }
+
+    u8WearSequence = *(unsigned char code *)(u16WearActivePage + 1);
+    pCode = (unsigned char code *)u16WearActivePage;
+
+    u8Offset = WEAR_BASE_START;
+
+    for (u8Slot = 0; u8Slot < WEAR_SLOT_NUM; u8Slot++)
+    {
+        u32Count = 0;
+
+        for (i = 0; i < 4; i++)
+        {
+            u32Count |= (unsigned long)pCode[u8Offset + i] << (i * 8);
+        }
+
+        if (u32Count == 0xFFFFFFFF)
+            u32Count = 0;
+
+        WearCount[u8Slot] = u32Count;
+        u8Offset += 4;
+    }
+
+    /* Tally records end at first blank byte, torn record out of slot range is skipped */
+    for (u8Offset = WEAR_TALLY_START; u8Offset < PAGE_SIZE; u8Offset++)
+    {
+        u8Slot = pCode[u8Offset];
+
+        if (u8Slot == WEAR_TALLY_BLANK)
+            break;
+
+        if (u8Slot < WEAR_SLOT_NUM)
+            WearCount[u8Slot]++;
+    }
+
+    u8WearWriteOffset = u8Offset;
+
+    if (u16OldPage != 0)
+    {
+        Wear_Erase_Page(u16OldPage);
+        Wear_Append(WEAR_SLOT_SELF);
+    }
+
+    clr_IAPUEN_APUEN;
+    clr_CHPCON_IAPEN;
+}
+
+/**
+ * @brief       Count the page erase just triggered
+ * @param       none
+ * @return      none
+ * @details     Called by FLASH_WEAR_RECORD right after page erase trigger in library, the erased page is taken
+ *              from IAPCN / IAPAH / IAPAL. Tracked APROM page and any LDROM page cost one byte program.
+ *              IAP registers and APUEN are restored, so the caller erase loop is not disturbed.
+ */
+void Flash_Wear_Record(void)
+{
+    unsigned char u8IAPCN, u8IAPAL, u8IAPAH, u8IAPFD, u8APUEN;
+    unsigned char u8Slot;
+    unsigned int u16Addr;
+
+    if (u16WearActivePage == 0)
+        return;
+
+    u8IAPCN = IAPCN;
+    u8IAPAL = IAPAL;
+    u8IAPAH = IAPAH;
+    u8IAPFD = IAPFD;
+    u16Addr = ((unsigned int)u8IAPAH << 8) + u8IAPAL;
+
+    if (u8IAPCN == PAGE_ERASE_LDROM)
+    {
+        u8Slot = WEAR_SLOT_LDROM;
+    }
+    else if ((u8IAPCN == PAGE_ERASE_APROM) && (u16Addr >= WEAR_TRACK_ADDR)
+             && (u16Addr < (WEAR_TRACK_ADDR + WEAR_TRACK_PAGE_NUM * PAGE_SIZE)))
+    {
+        u8Slot = (u16Addr - WEAR_TRACK_ADDR) / PAGE_SIZE;
+    }
+    else
+    {
+        return;
+    }
+
+    u8APUEN = IAPUEN & 0x01;
+    set_IAPUEN_APUEN;
+
+    WearCount[u8Slot]++;
+    Wear_Append(u8Slot);
+
+    if (u8APUEN == 0)
+    {
+        clr_IAPUEN_APUEN;
+    }
+
+    IAPCN = u8IAPCN;
+    IAPAL = u8IAPAL;
+    IAPAH = u8IAPAH;
+    IAPFD = u8IAPFD;
+}
+
+/**
+ * @brief       Read erase count of one slot
+ * @param       u8Slot 0 ~ (WEAR_TRACK_PAGE_NUM-1) tracked page, WEAR_SLOT_LDROM or WEAR_SLOT_SELF
+ * @return      erase count, 0 for invalid slot
+ * @example     u32Count = Flash_Wear_Get_Count((0x3900 - WEAR_TRACK_ADDR) / PAGE_SIZE);
+ */
+unsigned long Flash_Wear_Get_Count(unsigned char u8Slot)
+{
+    if (u8Slot >= WEAR_SLOT_NUM)
+        return 0;
+
+    return WearCount[u8Slot];
+}
+
+/**
+ * @brief       Projected remaining erase cycles of one slot
+ * @param       u8Slot 0 ~ (WEAR_TRACK_PAGE_NUM-1) tracked page, WEAR_SLOT_LDROM or WEAR_SLOT_SELF
+ * @return      WEAR_ENDURANCE minus erase count, 0 when worn out
+ * @details     Wear area pages are erased in turn, WEAR_SLOT_SELF budget is two pages.
+ *              LDROM erases are not split by page, the budget of one page is used as worst case.
+ */
+unsigned long Flash_Wear_Get_Remaining(unsigned char u8Slot)
+{
+    unsigned long u32Budget, u32Count;
+
+    u32Budget = WEAR_ENDURANCE;
+
+    if (u8Slot == WEAR_SLOT_SELF)
+        u32Budget *= 2;
+
+    u32Count = Flash_Wear_Get_Count(u8Slot);
+
+    if (u32Count >= u32Budget)
+        return 0;
+
+    return u32Budget - u32Count;
+}
@@ -0,0 +1,104 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+unsigned char xdata LZWindow[LZ_WINDOW_SIZE];     /* last 256 output bytes, index wraps with u8LZPos */
+
+unsigned char xdata *pLZIn;
+unsigned char u8LZInLen;
+unsigned char u8LZState;
+unsigned char u8LZFlags;
+unsigned char u8LZFlagCount;
+unsigned char u8LZPos;
+unsigned char u8LZDistance;
+unsigned int u16LZRemain;
+
+/**
+ * @brief       Reset decoder before a new compressed stream
+ * @param       none
+ * @return      none
+ */
+void LZ_Decode_Init(void)
+{
+    u8LZInLen = 0;
+    u8LZState = LZ_STATE_FLAG;
+    u8LZFlagCount = 0;
+    u8LZPos = 0;
+    u16LZRemain = 0;
+}
+
+/**
+ * @brief       Give next part of compressed stream
+ * @param       pu8Src XRAM buffer, for example payload of one ISP packet
+ * @param       u8Len byte number
+ * @return      none
+ * @details     Buffer must not change until LZ_Decode_Byte returns FAIL. A token split between two parts
+ *              is kept in decoder state.
+ */
+void LZ_Decode_Input(unsigned char xdata *pu8Src, unsigned char u8Len)
+{
+    pLZIn = pu8Src;
+    u8LZInLen = u8Len;
+}
+
+/**
+ * @brief       Decode one output byte
+ * @param       pu8Out output byte
+ * @return      PASS one byte output, FAIL input used up
+ * @example     while (LZ_Decode_Byte(&u8Data) == PASS) { program u8Data }
+ */
+unsigned char LZ_Decode_Byte(unsigned char *pu8Out)
+{
+    unsigned char u8In;
+
+    while (u16LZRemain == 0)
+    {
+        if (u8LZInLen == 0)
+            return FAIL;
+
+        u8In = *pLZIn++;
+        u8LZInLen--;
+
+        if (u8LZState == LZ_STATE_FLAG)
+        {
+            u8LZFlags = u8In;
+            u8LZFlagCount = 8;
+            u8LZState = LZ_STATE_TOKEN;
+        }
+        else if (u8LZState == LZ_STATE_TOKEN)
+        {
+            u8LZFlagCount--;
+
+            if (u8LZFlags & 0x01)
+            {
+                u8LZFlags >>= 1;
+                u8LZState = (u8LZFlagCount == 0) ? LZ_STATE_FLAG : LZ_STATE_TOKEN;
+                LZWindow[u8LZPos++] = u8In;
+                *pu8Out = u8In;
+                return PASS;
+            }
+
+            u8LZFlags >>= 1;
+            u8LZDistance = u8In;
+            u8LZState = LZ_STATE_LENGTH;
+        }
+        else
+        {
+            u16LZRemain = (unsigned int)u8In + LZ_MIN_MATCH;
+            u8LZState = (u8LZFlagCount == 0) ? LZ_STATE_FLAG : LZ_STATE_TOKEN;
+        }
+    }
+
+    /* Copy one byte of the match, source is distance bytes before */
+    u8In = LZWindow[(unsigned char)(u8LZPos - u8LZDistance - 1)];
+    LZWindow[u8LZPos++] = u8In;
+    u16LZRemain--;
+    *pu8Out = u8In;
+
+    return PASS;
+}
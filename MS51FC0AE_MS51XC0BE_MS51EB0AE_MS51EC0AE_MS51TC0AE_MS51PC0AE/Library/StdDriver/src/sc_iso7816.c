@@ -0,0 +1,794 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+/* ISO 7816-3 Table 7 and Table 8, 0 is RFU */
+static unsigned int code au16Fi[16] = {372, 372, 558, 744, 1116, 1488, 1860, 0, 0, 512, 768, 1024, 1536, 2048, 0, 0};
+static unsigned char code au8Di[16] = {0, 1, 2, 4, 8, 16, 32, 64, 12, 20, 0, 0, 0, 0, 0, 0};
+
+#define RST_LOW_CLOCK           1000UL      /* t2 >= 400 clocks with clock running before RST high */
+#define ATR_FIRST_CLOCK         40000UL     /* TS within 400 to 40000 clocks after RST high */
+#define WWT_CLOCK(wi)           (960UL * 372 * (wi))    /* 960 x D x WI etu = 960 x WI x Fi clocks */
+#define ETU_CLOCK_MAX           4096        /* 12 bits ETURDIV + 1 */
+
+#define T1_PCB_M                0x20        /* I-block more data */
+#define T1_PCB_R                0x80
+#define T1_PCB_S                0xC0
+#define T1_S_IFS_REQ            0xC1
+#define T1_S_IFS_RES            0xE1
+#define T1_S_WTX_REQ            0xC3
+#define T1_S_WTX_RES            0xE3
+
+/* One block buffer for all port, card function is blocking. NAD PCB LEN INF EDC */
+static unsigned char xdata au8Block[3 + 254 + 2];
+
+/**
+ * @brief       Clock per ETU of TA1
+ * @param       u8TA1 FI high nibble, DI low nibble
+ * @return      Fi / Di, 0 when not supported
+ */
+static unsigned int SC_TA1_Etu(unsigned char u8TA1)
+{
+    unsigned int u16Fi = au16Fi[u8TA1 >> 4];
+    unsigned char u8Di = au8Di[u8TA1 & 0x0F];
+
+    if ((u16Fi == 0) || (u8Di == 0) || ((u16Fi / u8Di) > ETU_CLOCK_MAX) || ((u16Fi / u8Di) < 12))
+        return 0;
+
+    return u16Fi / u8Di;
+}
+
+/**
+ * @brief       Receive one ATR byte and keep it in au8ATR
+ * @param       pCard card of port
+ * @param       pu8Byte byte received
+ * @return      SC_OK, SC_ERR_TIMEOUT, SC_ERR_PARITY or SC_ERR_ATR over ISO7816_ATR_MAX
+ */
+static unsigned char SC_ATR_Get(SC_CARD xdata *pCard, unsigned char *pu8Byte, unsigned long u32TimeoutClock)
+{
+    unsigned char u8Ret;
+
+    if (pCard->u8ATRLen >= ISO7816_ATR_MAX)
+        return SC_ERR_ATR;
+
+    u8Ret = SC_HW_Receive(pCard->u8Port, pu8Byte, u32TimeoutClock);
+    if (u8Ret == SC_OK)
+        pCard->au8ATR[pCard->u8ATRLen++] = *pu8Byte;
+
+    return u8Ret;
+}
+
+/**
+ * @brief       Receive and parse ATR, ISO 7816-3 clause 8
+ * @param       pCard card of port, protocol defaults set by caller
+ * @return      SC_OK or SC_ERR_xxx
+ * @details     Y of T0 / TDi tells which of TAi TBi TCi TDi follow. Global TA1 TC1 TA2, T=0 TC2 and the
+ *              first T=1 TAi TBi TCi (i >= 3) are kept. TCK is checked when any protocol other than
+ *              T=0 is offered. Hardware AUTOCEN has set the convention from TS.
+ */
+static unsigned char SC_ATR_Parse(SC_CARD xdata *pCard)
+{
+    unsigned char u8Byte, u8Y, u8K, u8Index, u8T, u8FirstT, u8TCK, u8HasTCK, u8T1Done, u8Ret;
+
+    pCard->u8ATRLen = 0;
+    u8Ret = SC_ATR_Get(pCard, &u8Byte, ATR_FIRST_CLOCK);
+    if (u8Ret != SC_OK)
+        return u8Ret;
+    if ((u8Byte != 0x3B) && (u8Byte != 0x3F))
+        return SC_ERR_ATR;
+
+    u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+    if (u8Ret != SC_OK)
+        return u8Ret;
+
+    u8Y = u8Byte & 0xF0;
+    u8K = u8Byte & 0x0F;
+    u8Index = 1;
+    u8T = 0;
+    u8FirstT = 0xFF;
+    u8HasTCK = 0;
+    u8T1Done = 0;       /* bit 0 TA, bit 1 TB, bit 2 TC of T=1 taken */
+
+    while (u8Y)
+    {
+        if (u8Y & 0x10)
+        {
+            u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+            if (u8Ret != SC_OK)
+                return u8Ret;
+
+            if (u8Index == 1)
+            {
+                pCard->u8TA1 = u8Byte;
+                pCard->u8HasTA1 = 1;
+            }
+            else if (u8Index == 2)
+            {
+                /* Specific mode, T of b4..b1, TA1 used at once unless b5 asks implicit values */
+                pCard->u8Specific = 1;
+                u8FirstT = u8Byte & 0x0F;
+                if (u8Byte & 0x10)
+                    pCard->u8HasTA1 = 0;
+            }
+            else if ((u8T == 1) && !(u8T1Done & 0x01))
+            {
+                pCard->u8IFSC = u8Byte;
+                u8T1Done |= 0x01;
+            }
+        }
+
+        if (u8Y & 0x20)
+        {
+            u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+            if (u8Ret != SC_OK)
+                return u8Ret;
+
+            /* TB1 TB2 (VPP) are deprecated and ignored */
+            if ((u8Index >= 3) && (u8T == 1) && !(u8T1Done & 0x02))
+            {
+                pCard->u8BWI = u8Byte >> 4;
+                pCard->u8CWI = u8Byte & 0x0F;
+                u8T1Done |= 0x02;
+            }
+        }
+
+        if (u8Y & 0x40)
+        {
+            u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+            if (u8Ret != SC_OK)
+                return u8Ret;
+
+            if (u8Index == 1)
+                pCard->u8N = u8Byte;
+            else if ((u8Index == 2) && (u8T == 0))
+                pCard->u8WI = u8Byte;
+            else if ((u8Index >= 3) && (u8T == 1) && !(u8T1Done & 0x04))
+            {
+                pCard->u8CRC = u8Byte & 0x01;
+                u8T1Done |= 0x04;
+            }
+        }
+
+        if (u8Y & 0x80)
+        {
+            u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+            if (u8Ret != SC_OK)
+                return u8Ret;
+
+            u8T = u8Byte & 0x0F;
+            if (u8FirstT == 0xFF)
+                u8FirstT = u8T;
+            if (u8T != 0)
+                u8HasTCK = 1;
+            u8Y = u8Byte & 0xF0;
+        }
+        else
+        {
+            u8Y = 0;
+        }
+
+        u8Index++;
+    }
+
+    pCard->u8HistOffset = pCard->u8ATRLen;
+    pCard->u8HistLen = u8K;
+    while (u8K--)
+    {
+        u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+        if (u8Ret != SC_OK)
+            return u8Ret;
+    }
+
+    if (u8HasTCK)
+    {
+        u8Ret = SC_ATR_Get(pCard, &u8Byte, WWT_CLOCK(10));
+        if (u8Ret != SC_OK)
+            return u8Ret;
+
+        /* XOR from T0 to TCK is 0 */
+        u8TCK = 0;
+        for (u8Index = 1; u8Index < pCard->u8ATRLen; u8Index++)
+            u8TCK ^= pCard->au8ATR[u8Index];
+        if (u8TCK != 0)
+            return SC_ERR_ATR;
+    }
+
+    /* T=0 when TD1 absent, T=15 is global only */
+    if (u8FirstT == 0xFF)
+        u8FirstT = 0;
+    if (u8FirstT > 1)
+        return SC_ERR_PARAM;
+    pCard->u8Protocol = u8FirstT;
+
+    return SC_OK;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  T=1 block                                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief       T=1 EDC over bytes, LRC or CRC
+ * @param       u16EDC LRC / CRC value of former bytes, 0 or 0xFFFF to start
+ * @return      new EDC value
+ * @details     CRC is CCITT polynomial reflected (0x8408) from 0xFFFF, sent high byte first.
+ */
+static unsigned int T1_EDC(SC_CARD xdata *pCard, unsigned int u16EDC, unsigned char *pu8Data, unsigned char u8Len)
+{
+    unsigned char u8Bit;
+
+    while (u8Len--)
+    {
+        if (pCard->u8CRC)
+        {
+            u16EDC ^= *pu8Data++;
+            for (u8Bit = 0; u8Bit < 8; u8Bit++)
+            {
+                if (u16EDC & 0x0001)
+                    u16EDC = (u16EDC >> 1) ^ 0x8408;
+                else
+                    u16EDC >>= 1;
+            }
+        }
+        else
+        {
+            u16EDC ^= *pu8Data++;
+        }
+    }
+
+    return u16EDC;
+}
+
+/**
+ * @brief       Send one T=1 block, NAD is 0
+ * @return      SC_OK or error of SC_HW_Send
+ */
+static unsigned char T1_Send_Block(SC_CARD xdata *pCard, unsigned char u8PCB, unsigned char *pu8Inf, unsigned char u8Len)
+{
+    unsigned char au8Head[3], au8EDC[2], u8Ret;
+    unsigned int u16EDC;
+
+    au8Head[0] = 0;
+    au8Head[1] = u8PCB;
+    au8Head[2] = u8Len;
+    u16EDC = T1_EDC(pCard, pCard->u8CRC ? 0xFFFF : 0, au8Head, 3);
+    u16EDC = T1_EDC(pCard, u16EDC, pu8Inf, u8Len);
+
+    u8Ret = SC_HW_Send(pCard->u8Port, au8Head, 3);
+    if ((u8Ret == SC_OK) && u8Len)
+        u8Ret = SC_HW_Send(pCard->u8Port, pu8Inf, u8Len);
+    if (u8Ret == SC_OK)
+    {
+        if (pCard->u8CRC)
+        {
+            au8EDC[0] = HIBYTE(u16EDC);
+            au8EDC[1] = LOBYTE(u16EDC);
+            u8Ret = SC_HW_Send(pCard->u8Port, au8EDC, 2);
+        }
+        else
+        {
+            au8EDC[0] = LOBYTE(u16EDC);
+            u8Ret = SC_HW_Send(pCard->u8Port, au8EDC, 1);
+        }
+    }
+
+    return u8Ret;
+}
+
+/**
+ * @brief       Receive one T=1 block into au8Block
+ * @param       u8WTX BWT multiplier of S(WTX)
+ * @return      SC_OK, SC_ERR_TIMEOUT, SC_ERR_PARITY for parity / EDC / LEN error
+ * @details     First byte waits BWT = 11 etu + 2^BWI x 960 x 372 clocks, next byte waits CWT = 11 + 2^CWI etu.
+ *              Bad block is read to the end so the next block starts clean.
+ */
+static unsigned char T1_Receive_Block(SC_CARD xdata *pCard, unsigned char u8WTX)
+{
+    unsigned long u32BWT, u32CWT;
+    unsigned int u16Len, u16Index, u16EDC;
+    unsigned char u8Ret, u8Error;
+
+    u32BWT = ((unsigned long)1 << pCard->u8BWI) * 960UL * 372;
+    if (u8WTX > 1)
+    {
+        if (u32BWT > (0xFFFFFFFFUL / u8WTX))
+            u32BWT = 0xFFFFFFFFUL;
+        else
+            u32BWT *= u8WTX;
+    }
+    u32BWT += 11UL * pCard->u16EtuClock;
+    u32CWT = (11UL + ((unsigned long)1 << pCard->u8CWI)) * pCard->u16EtuClock;
+
+    u8Ret = SC_HW_Receive(pCard->u8Port, &au8Block[0], u32BWT);
+    if (u8Ret == SC_ERR_TIMEOUT)
+        return u8Ret;
+    u8Error = u8Ret;
+
+    for (u16Index = 1; u16Index < 3; u16Index++)
+    {
+        u8Ret = SC_HW_Receive(pCard->u8Port, &au8Block[u16Index], u32CWT);
+        if (u8Ret == SC_ERR_TIMEOUT)
+            return u8Ret;
+        if (u8Ret != SC_OK)
+            u8Error = u8Ret;
+    }
+
+    if (au8Block[2] == 0xFF)
+        return SC_ERR_PARITY;
+
+    u16Len = au8Block[2] + (pCard->u8CRC ? 2 : 1);
+    for (u16Index = 0; u16Index < u16Len; u16Index++)
+    {
+        u8Ret = SC_HW_Receive(pCard->u8Port, &au8Block[3 + u16Index], u32CWT);
+        if (u8Ret == SC_ERR_TIMEOUT)
+            return u8Ret;
+        if (u8Ret != SC_OK)
+            u8Error = u8Ret;
+    }
+
+    if (u8Error != SC_OK)
+        return SC_ERR_PARITY;
+    if (au8Block[0] != 0)
+        return SC_ERR_PARITY;
+
+    u16EDC = T1_EDC(pCard, pCard->u8CRC ? 0xFFFF : 0, au8Block, 3 + au8Block[2]);
+    if (pCard->u8CRC)
+    {
+        if ((au8Block[3 + au8Block[2]] != HIBYTE(u16EDC)) || (au8Block[4 + au8Block[2]] != LOBYTE(u16EDC)))
+            return SC_ERR_PARITY;
+    }
+    else if (au8Block[3 + au8Block[2]] != LOBYTE(u16EDC))
+    {
+        return SC_ERR_PARITY;
+    }
+
+    return SC_OK;
+}
+
+/**
+ * @brief       Send a block and get the I, R or S response block of card in au8Block
+ * @return      SC_OK or SC_ERR_xxx after ISO7816_RETRY
+ * @details     Bad or missing block is asked again by R-block with error, ISO 7816-3 rule 7.1 / 7.2.
+ *              S(WTX) and S(IFS) request of card are answered here.
+ */
+static unsigned char T1_Transfer(SC_CARD xdata *pCard, unsigned char u8PCB, unsigned char *pu8Inf, unsigned char u8Len)
+{
+    unsigned char u8Retry = 0, u8WTX = 1, u8Ret, u8Inf;
+
+    u8Ret = T1_Send_Block(pCard, u8PCB, pu8Inf, u8Len);
+    while (1)
+    {
+        if (u8Ret == SC_OK)
+            u8Ret = T1_Receive_Block(pCard, u8WTX);
+        u8WTX = 1;
+
+        if (u8Ret != SC_OK)
+        {
+            if (++u8Retry > ISO7816_RETRY)
+                return u8Ret;
+            u8Ret = T1_Send_Block(pCard, T1_PCB_R | (pCard->u8NR << 4) | ((u8Ret == SC_ERR_PARITY) ? 0x01 : 0x02), 0, 0);
+            continue;
+        }
+
+        u8PCB = au8Block[1];
+        if ((u8PCB & 0xC0) != T1_PCB_S)
+            return SC_OK;
+
+        if (u8PCB == T1_S_WTX_REQ)
+        {
+            u8Inf = au8Block[3];
+            u8WTX = u8Inf;
+            u8Ret = T1_Send_Block(pCard, T1_S_WTX_RES, &u8Inf, 1);
+        }
+        else if (u8PCB == T1_S_IFS_REQ)
+        {
+            u8Inf = au8Block[3];
+            pCard->u8IFSC = u8Inf;
+            u8Ret = T1_Send_Block(pCard, T1_S_IFS_RES, &u8Inf, 1);
+        }
+        else if (u8PCB & 0x20)
+        {
+            return SC_OK;       /* S response to our request */
+        }
+        else
+        {
+            return SC_ERR_PROTOCOL;     /* S(RESYNCH) / S(ABORT) request not supported */
+        }
+    }
+}
+
+/**
+ * @brief       T=1 APDU exchange with I-block chaining both direction
+ * @return      SC_OK or SC_ERR_xxx
+ */
+static unsigned char T1_APDU(SC_CARD xdata *pCard, unsigned char xdata *pu8Cmd, unsigned int u16CmdLen,
+                             unsigned char xdata *pu8Resp, unsigned int *pu16RespLen)
+{
+    unsigned int u16Offset = 0, u16RespLen = 0;
+    unsigned char u8Len, u8More, u8PCB, u8Retry, u8Ret;
+
+    /* Command chain, card answers R(N(R) = next) for each chained block and I-block for the last */
+    while (1)
+    {
+        u8Len = ((u16CmdLen - u16Offset) > pCard->u8IFSC) ? pCard->u8IFSC : (unsigned char)(u16CmdLen - u16Offset);
+        u8More = ((u16Offset + u8Len) < u16CmdLen);
+        u8Retry = 0;
+
+        while (1)
+        {
+            u8Ret = T1_Transfer(pCard, (pCard->u8NS << 6) | (u8More ? T1_PCB_M : 0), pu8Cmd + u16Offset, u8Len);
+            if (u8Ret != SC_OK)
+                return u8Ret;
+
+            u8PCB = au8Block[1];
+            if ((u8PCB & 0xC0) == T1_PCB_R)
+            {
+                if (u8More && (((u8PCB >> 4) & 0x01) != pCard->u8NS))
+                    break;      /* chained block acknowledged */
+                if (++u8Retry > ISO7816_RETRY)
+                    return SC_ERR_PROTOCOL;
+                continue;       /* card asks this I-block again */
+            }
+            if (((u8PCB & 0x80) == 0) && !u8More)
+                break;
+            return SC_ERR_PROTOCOL;
+        }
+
+        pCard->u8NS ^= 1;
+        if (!u8More)
+            break;
+        u16Offset += u8Len;
+    }
+
+    /* Response chain, R(N(R)) asks next chained I-block */
+    while (1)
+    {
+        if (((au8Block[1] >> 6) & 0x01) != pCard->u8NR)
+            return SC_ERR_PROTOCOL;
+        if ((u16RespLen + au8Block[2]) > ISO7816_RESP_MAX)
+            return SC_ERR_LENGTH;
+
+        for (u8Len = 0; u8Len < au8Block[2]; u8Len++)
+            pu8Resp[u16RespLen++] = au8Block[3 + u8Len];
+        pCard->u8NR ^= 1;
+
+        if (!(au8Block[1] & T1_PCB_M))
+            break;
+
+        u8Retry = 0;
+        while (1)
+        {
+            u8Ret = T1_Transfer(pCard, T1_PCB_R | (pCard->u8NR << 4), 0, 0);
+            if (u8Ret != SC_OK)
+                return u8Ret;
+            if ((au8Block[1] & 0x80) == 0)
+                break;
+            if (++u8Retry > ISO7816_RETRY)
+                return SC_ERR_PROTOCOL;
+        }
+    }
+
+    *pu16RespLen = u16RespLen;
+    return SC_OK;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  T=0 TPDU                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief       One T=0 command header exchange
+ * @param       pu8Head CLA INS P1 P2 P3
+ * @param       pu8Data command data of P3 bytes, 0 for response data of P3 bytes (0 is 256)
+ * @param       pu8Resp response data then SW1 SW2 are appended here
+ * @param       pu16RespLen in: bytes in pu8Resp, out: bytes with SW1 SW2
+ * @return      SC_OK or SC_ERR_xxx
+ * @details     Procedure byte 0x60 is NULL, INS sends / receives all rest, ~INS one byte, 6x / 9x is SW1.
+ */
+static unsigned char T0_TPDU(SC_CARD xdata *pCard, unsigned char *pu8Head, unsigned char xdata *pu8Data,
+                             unsigned char xdata *pu8Resp, unsigned int *pu16RespLen)
+{
+    unsigned long u32WWT;
+    unsigned int u16Len, u16Done = 0, u16Base = *pu16RespLen;
+    unsigned char u8Byte, u8Ret;
+
+    /* Fi in use is 372 until TA1 is applied by PPS or specific mode */
+    if (pCard->u16EtuClock == 372)
+        u32WWT = WWT_CLOCK(pCard->u8WI);
+    else
+        u32WWT = 960UL * pCard->u8WI * au16Fi[pCard->u8TA1 >> 4];
+
+    /* P3 = 0 is 256 bytes out of card, or case 1 without data */
+    u16Len = pu8Head[4];
+    if ((pu8Data == 0) && (u16Len == 0))
+        u16Len = 256;
+    if ((pu8Data == 0) && ((u16Base + u16Len + 2) > ISO7816_RESP_MAX))
+        return SC_ERR_LENGTH;
+
+    u8Ret = SC_HW_Send(pCard->u8Port, pu8Head, 5);
+    if (u8Ret != SC_OK)
+        return u8Ret;
+
+    while (1)
+    {
+        u8Ret = SC_HW_Receive(pCard->u8Port, &u8Byte, u32WWT);
+        if (u8Ret != SC_OK)
+            return u8Ret;
+
+        if (u8Byte == 0x60)
+            continue;
+
+        if (((u8Byte & 0xF0) == 0x60) || ((u8Byte & 0xF0) == 0x90))
+        {
+            /* SW1 SW2 after response data, command data is not in pu8Resp */
+            if (pu8Data == 0)
+                u16Base += u16Done;
+            if ((u16Base + 2) > ISO7816_RESP_MAX)
+                return SC_ERR_LENGTH;
+            pu8Resp[u16Base] = u8Byte;
+            u8Ret = SC_HW_Receive(pCard->u8Port, &pu8Resp[u16Base + 1], u32WWT);
+            if (u8Ret != SC_OK)
+                return u8Ret;
+            *pu16RespLen = u16Base + 2;
+            return SC_OK;
+        }
+
+        if ((u8Byte != pu8Head[1]) && (u8Byte != (pu8Head[1] ^ 0xFF)))
+            return SC_ERR_PROTOCOL;
+        if (u16Done >= u16Len)
+            return SC_ERR_PROTOCOL;
+
+        while (u16Done < u16Len)
+        {
+            if (pu8Data)
+                u8Ret = SC_HW_Send(pCard->u8Port, pu8Data + u16Done, 1);
+            else
+                u8Ret = SC_HW_Receive(pCard->u8Port, pu8Resp + u16Base + u16Done, u32WWT);
+            if (u8Ret != SC_OK)
+                return u8Ret;
+            u16Done++;
+
+            if (u8Byte != pu8Head[1])
+                break;      /* ~INS, one byte then next procedure byte */
+        }
+    }
+}
+
+/**
+ * @brief       T=0 APDU, ISO 7816-3 clause 12.2 case 1 to 4 of short APDU
+ * @return      SC_OK or SC_ERR_xxx
+ * @details     Case 4 is sent as case 3 and data is read by GET RESPONSE on 61xx. 6Cxx resends with P3 = xx.
+ */
+static unsigned char T0_APDU(SC_CARD xdata *pCard, unsigned char xdata *pu8Cmd, unsigned int u16CmdLen,
+                             unsigned char xdata *pu8Resp, unsigned int *pu16RespLen)
+{
+    unsigned char au8Head[5], u8Case, u8Retry = 0, u8Ret;
+    unsigned int u16Len;
+
+    for (u8Case = 0; u8Case < 4; u8Case++)
+        au8Head[u8Case] = pu8Cmd[u8Case];
+
+    if (u16CmdLen == 4)
+    {
+        u8Case = 1;
+        au8Head[4] = 0;
+    }
+    else if (u16CmdLen == 5)
+    {
+        u8Case = 2;
+        au8Head[4] = pu8Cmd[4];
+    }
+    else if ((pu8Cmd[4] != 0) && (u16CmdLen == (5 + (unsigned int)pu8Cmd[4])))
+    {
+        u8Case = 3;
+        au8Head[4] = pu8Cmd[4];
+    }
+    else if ((pu8Cmd[4] != 0) && (u16CmdLen == (6 + (unsigned int)pu8Cmd[4])))
+    {
+        u8Case = 4;
+        au8Head[4] = pu8Cmd[4];
+    }
+    else
+    {
+        return SC_ERR_LENGTH;
+    }
+
+    u16Len = 0;
+    u8Ret = T0_TPDU(pCard, au8Head, (u8Case == 2) ? 0 : pu8Cmd + 5, pu8Resp, &u16Len);
+
+    while (u8Ret == SC_OK)
+    {
+        u16Len -= 2;
+        if ((pu8Resp[u16Len] == 0x6C) && (u8Case == 2) && (u8Retry++ < ISO7816_RETRY))
+        {
+            au8Head[4] = pu8Resp[u16Len + 1];
+            u8Ret = T0_TPDU(pCard, au8Head, 0, pu8Resp, &u16Len);
+        }
+        else if ((pu8Resp[u16Len] == 0x61) && (u8Case != 1) && (u8Case != 3))
+        {
+            /* GET RESPONSE, data appended to former data */
+            au8Head[1] = 0xC0;
+            au8Head[2] = 0;
+            au8Head[3] = 0;
+            au8Head[4] = pu8Resp[u16Len + 1];
+            u8Case = 2;
+            u8Ret = T0_TPDU(pCard, au8Head, 0, pu8Resp, &u16Len);
+        }
+        else
+        {
+            *pu16RespLen = u16Len + 2;
+            return SC_OK;
+        }
+    }
+
+    return u8Ret;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Card function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief       Cold reset, ATR, ETU and guard time setting of card
+ * @param       pCard card data, filled here
+ * @param       u8Port SC0, SC1 or SC2
+ * @return      SC_OK or SC_ERR_xxx, card is deactivated on error
+ * @details     ETU stays Fi 372 / Di 1 until SC_Card_PPS in negotiable mode. In specific mode TA1 is used
+ *              at once.
+ * @example     SC_Card_Activate(&Card, SC0);
+ */
+unsigned char SC_Card_Activate(SC_CARD xdata *pCard, unsigned char u8Port)
+{
+    unsigned char u8Ret;
+
+    memset(pCard, 0, sizeof(SC_CARD));
+    pCard->u8Port = u8Port;
+    pCard->u8WI = 10;
+    pCard->u8IFSC = 32;
+    pCard->u8BWI = 4;
+    pCard->u8CWI = 13;
+    pCard->u16EtuClock = 372;
+
+    SC_HW_Open(u8Port);
+    SC_HW_Set_RST(u8Port, 0);
+    SC_HW_Set_Clock(u8Port, 1);
+    SC_HW_Wait_Clock(RST_LOW_CLOCK);
+    SC_HW_Set_RST(u8Port, 1);
+
+    u8Ret = SC_ATR_Parse(pCard);
+    if ((u8Ret == SC_OK) && pCard->u8Specific && pCard->u8HasTA1)
+    {
+        pCard->u16EtuClock = SC_TA1_Etu(pCard->u8TA1);
+        if (pCard->u16EtuClock == 0)
+            u8Ret = SC_ERR_PARAM;
+    }
+    if (u8Ret != SC_OK)
+    {
+        SC_Card_Deactivate(pCard);
+        return u8Ret;
+    }
+
+    /* N = 255 is minimum of 12 etu in T=0 and 11 etu in T=1 */
+    SC_HW_Set_ETU(u8Port, pCard->u16EtuClock);
+    SC_HW_Set_Guard(u8Port, pCard->u8Protocol, pCard->u8N);
+
+    if ((pCard->u8IFSC == 0) || (pCard->u8IFSC == 0xFF))
+        pCard->u8IFSC = 32;
+
+    return SC_OK;
+}
+
+/**
+ * @brief       PPS exchange of TA1 right after ATR, ISO 7816-3 clause 9
+ * @param       pCard card activated by SC_Card_Activate
+ * @return      SC_OK with new ETU or default kept, SC_ERR_PPS when card must be reset
+ * @details     Nothing is sent in specific mode, without TA1 or with default TA1.
+ * @example     SC_Card_PPS(&Card);
+ */
+unsigned char SC_Card_PPS(SC_CARD xdata *pCard)
+{
+    unsigned char au8PPS[6], u8Index, u8Len, u8Check, u8Ret;
+    unsigned int u16Etu;
+
+    if (pCard->u8Specific || !pCard->u8HasTA1 || (pCard->u8TA1 == 0x11) || (pCard->u8TA1 == 0x01))
+        return SC_OK;
+
+    u16Etu = SC_TA1_Etu(pCard->u8TA1);
+    if (u16Etu == 0)
+        return SC_OK;       /* stay at default, not an error of card */
+
+    au8PPS[0] = 0xFF;
+    au8PPS[1] = 0x10 | pCard->u8Protocol;
+    au8PPS[2] = pCard->u8TA1;
+    au8PPS[3] = au8PPS[0] ^ au8PPS[1] ^ au8PPS[2];
+
+    u8Ret = SC_HW_Send(pCard->u8Port, au8PPS, 4);
+    if (u8Ret != SC_OK)
+        return u8Ret;
+
+    /* PPSS PPS0 [PPS1] [PPS2] [PPS3] PCK */
+    u8Len = 2;
+    for (u8Index = 0; u8Index < u8Len; u8Index++)
+    {
+        if (SC_HW_Receive(pCard->u8Port, &au8PPS[u8Index], WWT_CLOCK(10)) != SC_OK)
+            return SC_ERR_PPS;
+        if (u8Index == 1)
+        {
+            u8Len += ((au8PPS[1] >> 4) & 0x01) + ((au8PPS[1] >> 5) & 0x01) + ((au8PPS[1] >> 6) & 0x01) + 1;
+            if (u8Len > sizeof(au8PPS))
+                return SC_ERR_PPS;
+        }
+    }
+
+    u8Check = 0;
+    for (u8Index = 0; u8Index < u8Len; u8Index++)
+        u8Check ^= au8PPS[u8Index];
+    if ((u8Check != 0) || (au8PPS[0] != 0xFF) || ((au8PPS[1] & 0x0F) != pCard->u8Protocol))
+        return SC_ERR_PPS;
+
+    if (au8PPS[1] & 0x10)
+    {
+        if (au8PPS[2] != pCard->u8TA1)
+            return SC_ERR_PPS;
+        pCard->u16EtuClock = u16Etu;
+        SC_HW_Set_ETU(pCard->u8Port, u16Etu);
+    }
+    else
+    {
+        pCard->u8HasTA1 = 0;        /* card keeps Fd / Dd */
+    }
+
+    return SC_OK;
+}
+
+/**
+ * @brief       Send command APDU and get response APDU of short length
+ * @param       pu8Cmd CLA INS P1 P2 [Lc data] [Le]
+ * @param       pu8Resp response data and SW1 SW2, ISO7816_RESP_MAX bytes
+ * @param       pu16RespLen response length with SW1 SW2
+ * @return      SC_OK or SC_ERR_xxx
+ * @details     T=1 first APDU sends S(IFS request) of ISO7816_IFSD, PPS must be the first exchange after ATR.
+ * @example     SC_Card_APDU(&Card, au8Select, sizeof(au8Select), au8Resp, &u16RespLen);
+ */
+unsigned char SC_Card_APDU(SC_CARD xdata *pCard, unsigned char xdata *pu8Cmd, unsigned int u16CmdLen,
+                           unsigned char xdata *pu8Resp, unsigned int *pu16RespLen)
+{
+    unsigned char u8IFSD, u8Ret;
+
+    *pu16RespLen = 0;
+    if ((u16CmdLen < 4) || (u16CmdLen > ISO7816_APDU_MAX))
+        return SC_ERR_LENGTH;
+
+    if (pCard->u8Protocol == 1)
+    {
+        if (!pCard->u8IFSDSent)
+        {
+            u8IFSD = ISO7816_IFSD;
+            u8Ret = T1_Transfer(pCard, T1_S_IFS_REQ, &u8IFSD, 1);
+            if ((u8Ret == SC_OK) && (au8Block[1] != T1_S_IFS_RES))
+                u8Ret = SC_ERR_PROTOCOL;
+            if (u8Ret != SC_OK)
+                return u8Ret;
+            pCard->u8IFSDSent = 1;
+        }
+        return T1_APDU(pCard, pu8Cmd, u16CmdLen, pu8Resp, pu16RespLen);
+    }
+
+    return T0_APDU(pCard, pu8Cmd, u16CmdLen, pu8Resp, pu16RespLen);
+}
+
+/**
+ * @brief       Deactivation, RST low, clock stop, SC off
+ * @example     SC_Card_Deactivate(&Card);
+ */
+void SC_Card_Deactivate(SC_CARD xdata *pCard)
+{
+    SC_HW_Set_RST(pCard->u8Port, 0);
+    SC_HW_Set_Clock(pCard->u8Port, 0);
+    SC_HW_Close(pCard->u8Port);
+}
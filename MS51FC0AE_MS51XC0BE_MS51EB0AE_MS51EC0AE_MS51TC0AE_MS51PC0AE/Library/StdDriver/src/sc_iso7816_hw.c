@@ -0,0 +1,388 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#define SC_CR0_NSB              0x80    /* 1: 11 etu character (T=1), 0: 12 etu (T=0) */
+#define SC_CR0_T                0x40    /* 1: T=1, 0: T=0 error signal and character repeat */
+#define SC_CR0_RXBGTEN          0x20
+#define SC_CR0_AUTOCEN          0x08    /* convention from TS */
+#define SC_CR0_TXOFF            0x04
+#define SC_CR0_RXOFF            0x02
+#define SC_CR0_SCEN             0x01
+#define SC_CR1_CLKKEEP          0x02
+#define SC_TSR_ACT              0x80
+#define SC_TSR_PEF              0x10
+#define SC_TSR_TXEMPTY          0x08
+#define SC_TSR_RXEMPTY          0x02
+#define SC_TSR_ERROR            0x71    /* SCnTSR BEF, FEF, PEF, RXOV */
+
+#define SC_TIMER_RELOAD         (65536 - (ISO7816_FSYS / 12 / 1000))   /* Timer0 1 ms */
+#define SC_CLOCK_PER_MS         (ISO7816_CARD_CLOCK / 1000)
+
+static unsigned char xdata au8SCProtocol[3];
+
+/* SCn registers are direct SFR, one switch per access */
+static void SC_HW_CR0(unsigned char u8Port, unsigned char u8Set, unsigned char u8Clr)
+{
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0CR0 = (SC0CR0 & ~u8Clr) | u8Set;
+            break;
+        case SC1:
+            SC1CR0 = (SC1CR0 & ~u8Clr) | u8Set;
+            break;
+        case SC2:
+            SC2CR0 = (SC2CR0 & ~u8Clr) | u8Set;
+            break;
+    }
+}
+
+static void SC_HW_CR1(unsigned char u8Port, unsigned char u8Set, unsigned char u8Clr)
+{
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0CR1 = (SC0CR1 & ~u8Clr) | u8Set;
+            break;
+        case SC1:
+            SC1CR1 = (SC1CR1 & ~u8Clr) | u8Set;
+            break;
+        case SC2:
+            SC2CR1 = (SC2CR1 & ~u8Clr) | u8Set;
+            break;
+    }
+}
+
+static unsigned char SC_HW_TSR(unsigned char u8Port)
+{
+    unsigned char u8TSR = 0;
+
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            u8TSR = SC0TSR;
+            break;
+        case SC1:
+            u8TSR = SC1TSR;
+            break;
+        case SC2:
+            u8TSR = SC2TSR;
+            break;
+    }
+    return u8TSR;
+}
+
+static void SC_HW_TSR_Clear(unsigned char u8Port, unsigned char u8Flag)
+{
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0TSR &= ~u8Flag;
+            break;
+        case SC1:
+            SC1TSR &= ~u8Flag;
+            break;
+        case SC2:
+            SC2TSR &= ~u8Flag;
+            break;
+    }
+}
+
+static unsigned char SC_HW_DR_Read(unsigned char u8Port)
+{
+    unsigned char u8Data = 0;
+
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            u8Data = SC0DR;
+            break;
+        case SC1:
+            u8Data = SC1DR;
+            break;
+        case SC2:
+            u8Data = SC2DR;
+            break;
+    }
+    return u8Data;
+}
+
+static void SC_HW_DR_Write(unsigned char u8Port, unsigned char u8Data)
+{
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0DR = u8Data;
+            break;
+        case SC1:
+            SC1DR = u8Data;
+            break;
+        case SC2:
+            SC2DR = u8Data;
+            break;
+    }
+}
+
+/* Timer0 1 ms tick by polling TF0, card clock count to tick */
+static unsigned long SC_HW_Timer_Start(unsigned long u32Clock)
+{
+    SFRS = 0;
+    clr_TCON_TR0;
+    TIMER0_FSYS_DIV12;
+    ENABLE_TIMER0_MODE1;
+    TL0 = LOBYTE(SC_TIMER_RELOAD);
+    TH0 = HIBYTE(SC_TIMER_RELOAD);
+    clr_TCON_TF0;
+    set_TCON_TR0;
+
+    return u32Clock / SC_CLOCK_PER_MS + 1;
+}
+
+static unsigned char SC_HW_Timer_Tick(void)
+{
+    SFRS = 0;
+    if (!TF0)
+        return 0;
+
+    clr_TCON_TR0;
+    TL0 = LOBYTE(SC_TIMER_RELOAD);
+    TH0 = HIBYTE(SC_TIMER_RELOAD);
+    clr_TCON_TF0;
+    set_TCON_TR0;
+    return 1;
+}
+
+/**
+ * @brief       SCn in smart card mode, card clock off
+ * @param       u8Port SC0, SC1 or SC2
+ * @return      none
+ * @details     UARTEN 0, parity on, 8 bit, AUTOCEN convention from TS, T=0 12 etu, ETU 372 clocks.
+ *              Receiver on, transmitter off until SC_HW_Send. SC clock pin is set by SCEN.
+ */
+void SC_HW_Open(unsigned char u8Port)
+{
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0CR0 = SC_CR0_SCEN;
+            SC0CR1 = 0;
+            SC0IE = 0;
+            SC0EGT = 0;
+            SC0ETURD0 = LOBYTE(372 - 1);
+            SC0ETURD1 = (ISO7816_SCDIV << 4) | (HIBYTE(372 - 1) & 0x0F);
+            SC0CR0 = SC_CR0_SCEN | SC_CR0_AUTOCEN | SC_CR0_TXOFF;
+            SC0TSR &= ~SC_TSR_ERROR;
+            break;
+        case SC1:
+            SC1CR0 = SC_CR0_SCEN;
+            SC1CR1 = 0;
+            SC1IE = 0;
+            SC1EGT = 0;
+            SC1ETURD0 = LOBYTE(372 - 1);
+            SC1ETURD1 = (ISO7816_SCDIV << 4) | (HIBYTE(372 - 1) & 0x0F);
+            SC1CR0 = SC_CR0_SCEN | SC_CR0_AUTOCEN | SC_CR0_TXOFF;
+            SC1TSR &= ~SC_TSR_ERROR;
+            break;
+        case SC2:
+            SC2CR0 = SC_CR0_SCEN;
+            SC2CR1 = 0;
+            SC2IE = 0;
+            SC2EGT = 0;
+            SC2ETURD0 = LOBYTE(372 - 1);
+            SC2ETURD1 = (ISO7816_SCDIV << 4) | (HIBYTE(372 - 1) & 0x0F);
+            SC2CR0 = SC_CR0_SCEN | SC_CR0_AUTOCEN | SC_CR0_TXOFF;
+            SC2TSR &= ~SC_TSR_ERROR;
+            break;
+    }
+    au8SCProtocol[u8Port] = 0;
+}
+
+/**
+ * @brief       SCn off
+ */
+void SC_HW_Close(unsigned char u8Port)
+{
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0CR1 = 0;
+            SC0CR0 = 0;
+            break;
+        case SC1:
+            SC1CR1 = 0;
+            SC1CR0 = 0;
+            break;
+        case SC2:
+            SC2CR1 = 0;
+            SC2CR0 = 0;
+            break;
+    }
+}
+
+/**
+ * @brief       Card clock output on or off
+ * @details     CLKKEEP keeps SC clock running without character transfer.
+ */
+void SC_HW_Set_Clock(unsigned char u8Port, unsigned char u8On)
+{
+    if (u8On)
+        SC_HW_CR1(u8Port, SC_CR1_CLKKEEP, 0);
+    else
+        SC_HW_CR1(u8Port, 0, SC_CR1_CLKKEEP);
+}
+
+/**
+ * @brief       Clock per ETU, ETURDIV = Fi / Di - 1
+ * @param       u16EtuClock 12 to 4096
+ */
+void SC_HW_Set_ETU(unsigned char u8Port, unsigned int u16EtuClock)
+{
+    u16EtuClock -= 1;
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0ETURD0 = LOBYTE(u16EtuClock);
+            SC0ETURD1 = (SC0ETURD1 & 0xF0) | (HIBYTE(u16EtuClock) & 0x0F);
+            break;
+        case SC1:
+            SC1ETURD0 = LOBYTE(u16EtuClock);
+            SC1ETURD1 = (SC1ETURD1 & 0xF0) | (HIBYTE(u16EtuClock) & 0x0F);
+            break;
+        case SC2:
+            SC2ETURD0 = LOBYTE(u16EtuClock);
+            SC2ETURD1 = (SC2ETURD1 & 0xF0) | (HIBYTE(u16EtuClock) & 0x0F);
+            break;
+    }
+}
+
+/**
+ * @brief       Character frame of protocol and extra guard time N of TC1
+ * @details     T=0 12 etu with error signal, T=1 11 etu and block guard time on receive.
+ *              N = 255 is the minimum frame, EGT 0.
+ */
+void SC_HW_Set_Guard(unsigned char u8Port, unsigned char u8Protocol, unsigned char u8N)
+{
+    au8SCProtocol[u8Port] = u8Protocol;
+    if (u8N == 255)
+        u8N = 0;
+
+    if (u8Protocol == 1)
+        SC_HW_CR0(u8Port, SC_CR0_NSB | SC_CR0_T | SC_CR0_RXBGTEN, 0);
+    else
+        SC_HW_CR0(u8Port, 0, SC_CR0_NSB | SC_CR0_T | SC_CR0_RXBGTEN);
+
+    SFRS = 2;
+    switch (u8Port)
+    {
+        case SC0:
+            SC0EGT = u8N;
+            break;
+        case SC1:
+            SC1EGT = u8N;
+            break;
+        case SC2:
+            SC2EGT = u8N;
+            break;
+    }
+}
+
+/**
+ * @brief       Wait card clock count
+ */
+void SC_HW_Wait_Clock(unsigned long u32Clock)
+{
+    unsigned long u32Tick = SC_HW_Timer_Start(u32Clock);
+
+    while (u32Tick)
+    {
+        if (SC_HW_Timer_Tick())
+            u32Tick--;
+    }
+    clr_TCON_TR0;
+}
+
+/**
+ * @brief       Send bytes, receiver off while sending
+ * @return      SC_OK, SC_ERR_PARITY when T=0 card still signals error after hardware repeat
+ * @details     T=0 character repeat on error signal is done by hardware, PEF is left after the last repeat.
+ */
+unsigned char SC_HW_Send(unsigned char u8Port, unsigned char *pu8Data, unsigned int u16Len)
+{
+    unsigned char u8Ret = SC_OK;
+
+    SC_HW_CR0(u8Port, SC_CR0_RXOFF, SC_CR0_TXOFF);
+    SC_HW_TSR_Clear(u8Port, SC_TSR_ERROR);
+
+    while (u16Len--)
+    {
+        while (!(SC_HW_TSR(u8Port) & SC_TSR_TXEMPTY));
+        SC_HW_DR_Write(u8Port, *pu8Data++);
+    }
+    while (!(SC_HW_TSR(u8Port) & SC_TSR_TXEMPTY));
+    while (SC_HW_TSR(u8Port) & SC_TSR_ACT);
+
+    if ((au8SCProtocol[u8Port] == 0) && (SC_HW_TSR(u8Port) & SC_TSR_PEF))
+        u8Ret = SC_ERR_PARITY;
+
+    SC_HW_TSR_Clear(u8Port, SC_TSR_ERROR);
+    SC_HW_CR0(u8Port, SC_CR0_TXOFF, SC_CR0_RXOFF);
+
+    return u8Ret;
+}
+
+/**
+ * @brief       Receive one byte in time out
+ * @param       u32TimeoutClock card clock, WWT / CWT / BWT of caller
+ * @return      SC_OK, SC_ERR_TIMEOUT, SC_ERR_PARITY
+ * @details     T=0 byte with parity error is dropped, hardware has sent error signal and card repeats it.
+ *              Over ISO7816_RETRY repeats is SC_ERR_PARITY. T=1 byte is kept with SC_ERR_PARITY, the block
+ *              is rejected by caller.
+ */
+unsigned char SC_HW_Receive(unsigned char u8Port, unsigned char *pu8Data, unsigned long u32TimeoutClock)
+{
+    unsigned long u32Tick = SC_HW_Timer_Start(u32TimeoutClock);
+    unsigned char u8TSR, u8Repeat = 0;
+
+    while (u32Tick)
+    {
+        u8TSR = SC_HW_TSR(u8Port);
+        if (!(u8TSR & SC_TSR_RXEMPTY))
+        {
+            *pu8Data = SC_HW_DR_Read(u8Port);
+            if (!(u8TSR & SC_TSR_ERROR))
+            {
+                clr_TCON_TR0;
+                return SC_OK;
+            }
+
+            SC_HW_TSR_Clear(u8Port, SC_TSR_ERROR);
+            if ((au8SCProtocol[u8Port] == 1) || (++u8Repeat > ISO7816_RETRY))
+            {
+                clr_TCON_TR0;
+                return SC_ERR_PARITY;
+            }
+            continue;
+        }
+
+        if (SC_HW_Timer_Tick())
+            u32Tick--;
+    }
+
+    clr_TCON_TR0;
+    return SC_ERR_TIMEOUT;
+}
@@ -11,7 +11,11 @@
 void Timer0_ISR(void) interrupt 1            /*interrupt address is 0x000B */
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_TIMER == 0)
+    Modbus_Timer_ISR();
+#else
     TF0 = 0;
+#endif
     _pop_(SFRS);
 }
 
@@ -14,6 +14,11 @@ unsigned char uart0_receive_data, uart1_receive_data;
 void Serial_ISR(void) interrupt 4
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_UART == UART0)
+    Modbus_UART_ISR();
+#elif UART_RING_ENABLE
+    UART0_Ring_ISR();
+#else
     if (RI)
     {
         uart0_receive_flag = 1;
@@ -28,6 +33,7 @@ void Serial_ISR(void) interrupt 4
 //            TI = 0;
 //        }
     }
+#endif
     _pop_(SFRS);
 }  
 
@@ -36,6 +42,11 @@ void Serial_ISR(void) interrupt 4
 void SerialPort1_ISR(void) interrupt 15
 {
     _push_(SFRS);
+#if MODBUS_ENABLE && (MODBUS_UART == UART1)
+    Modbus_UART_ISR();
+#elif UART_RING_ENABLE
+    UART1_Ring_ISR();
+#else
 
     if (RI_1 == 1)
     {
@@ -51,6 +62,7 @@ void SerialPort1_ISR(void) interrupt 15
             clr_SCON_1_TI_1;                             /* if emission occur */
         }
     }
+#endif
     _pop_(SFRS);
 }  
 
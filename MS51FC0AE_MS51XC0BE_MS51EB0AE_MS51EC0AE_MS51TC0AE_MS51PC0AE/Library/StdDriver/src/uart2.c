@@ -13,11 +13,15 @@ bit uart2rvflag;
 void SMC0_ISR(void) interrupt 21          // Vector @  0x9B
 {
     _push_(SFRS);
+#if UART_SC_RING_ENABLE
+    UART2_Ring_ISR();
+#else
  /* Since only enable receive interrupt, not add flag check */
         SFRS = 2;
         uart2rvflag = 1;
         uart2rvbuffer = SC0DR;
 
+#endif
     _pop_(SFRS);
 }
 /**
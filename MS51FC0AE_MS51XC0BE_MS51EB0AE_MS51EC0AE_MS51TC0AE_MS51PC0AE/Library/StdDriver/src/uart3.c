@@ -14,9 +14,13 @@ bit uart3rvflag;
 void SMC1_ISR(void) interrupt 22          // Vector @  0x9B
 {
     _push_(SFRS);
+#if UART_SC_RING_ENABLE
+    UART3_Ring_ISR();
+#else
         SFRS = 2;
         uart3rvflag = 1;
         uart3rvbuffer = SC1DR;
+#endif
     _pop_(SFRS);
 }
 /**
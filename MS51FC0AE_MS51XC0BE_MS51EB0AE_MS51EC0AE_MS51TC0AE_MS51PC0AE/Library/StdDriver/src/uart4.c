@@ -13,9 +13,13 @@ bit uart4rvflag;
 void SMC2_ISR(void) interrupt 23          // Vector @  0x9B
 {
     _push_(SFRS);
+#if UART_SC_RING_ENABLE
+    UART4_Ring_ISR();
+#else
         SFRS =2;
         uart4rvflag = 1;
         uart4rvbuffer = SC2DR;
+#endif
     _pop_(SFRS);
 }
 /**
@@ -0,0 +1,56 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#if !UART_RING_ENABLE
+#error "uart_putchar.c needs UART_RING_ENABLE=1 in project define"
+#endif
+
+#if (PUTCHAR_OVERFLOW != PUTCHAR_DROP) && (PUTCHAR_OVERFLOW != PUTCHAR_BLOCK)
+#error "PUTCHAR_OVERFLOW must be PUTCHAR_DROP or PUTCHAR_BLOCK"
+#endif
+
+unsigned int xdata u16PutcharDrop;
+
+/**
+ * @brief       Queue one character to PUTCHAR_UART_PORT TX ring
+ * @param       u8Data character
+ * @return      none
+ * @details     PUTCHAR_BLOCK polls TI while waiting, so a printf with EA = 0 still drains the ring.
+ */
+static void Putchar_Queue(unsigned char u8Data)
+{
+#if PUTCHAR_OVERFLOW == PUTCHAR_BLOCK
+
+    while (!UART_Ring_Write(PUTCHAR_UART_PORT, u8Data))
+        UART_Ring_TX_Poll(PUTCHAR_UART_PORT);
+
+#else
+
+    if (!UART_Ring_Write(PUTCHAR_UART_PORT, u8Data))
+        u16PutcharDrop++;
+
+#endif
+}
+
+/**
+ * @brief       printf output, replace Keil library putchar
+ * @param       c character
+ * @return      c
+ * @details     Same as library putchar, '\n' is sent as CR LF. Return after queue, not wait TI.
+ *              Not reentrant as Keil printf, one context per port: call printf from main loop or from
+ *              an interrupt, not from both at the same time.
+ */
+char putchar(char c)
+{
+    if (c == '\n')
+        Putchar_Queue(0x0D);
+
+    Putchar_Queue(c);
+    return c;
+}
@@ -0,0 +1,366 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#define RING_SIZE_ERROR(n)      ((((n) & ((n) - 1)) != 0) || ((n) < 2) || ((n) > 128))
+
+#if RING_SIZE_ERROR(UART0_RX_RING_SIZE) || RING_SIZE_ERROR(UART0_TX_RING_SIZE) || \
+    RING_SIZE_ERROR(UART1_RX_RING_SIZE) || RING_SIZE_ERROR(UART1_TX_RING_SIZE)
+#error "UART ring size must be power of 2 from 2 to 128"
+#endif
+
+/* Head and tail are free running, count = head - tail, index = count & (size - 1) */
+unsigned char xdata UART0RxRing[UART0_RX_RING_SIZE];
+unsigned char xdata UART0TxRing[UART0_TX_RING_SIZE];
+unsigned char xdata UART1RxRing[UART1_RX_RING_SIZE];
+unsigned char xdata UART1TxRing[UART1_TX_RING_SIZE];
+unsigned char data u8UART0RxHead, u8UART0RxTail, u8UART0TxHead, u8UART0TxTail;
+unsigned char data u8UART1RxHead, u8UART1RxTail, u8UART1TxHead, u8UART1TxTail;
+bit bUART0TxBusy, bUART1TxBusy;                     /* SBUF loaded, next byte sent by TI interrupt */
+
+unsigned int xdata u16UART0RxOverrun, u16UART1RxOverrun;
+unsigned char xdata u8UART0RxHighWater, u8UART0TxHighWater;
+unsigned char xdata u8UART1RxHighWater, u8UART1TxHighWater;
+
+/**
+ * @brief       UART0 ring service, call from vector 4
+ * @param       none
+ * @return      none
+ * @details     Caller saves SFRS. Received byte is dropped and counted when RX ring is full.
+ */
+void UART0_Ring_ISR(void)
+{
+    unsigned char u8Count;
+
+    SFRS = 0;
+
+    if (RI)
+    {
+        RI = 0;
+        u8Count = u8UART0RxHead - u8UART0RxTail;
+
+        if (u8Count < UART0_RX_RING_SIZE)
+        {
+            UART0RxRing[u8UART0RxHead & (UART0_RX_RING_SIZE - 1)] = SBUF;
+            u8UART0RxHead++;
+
+            if (u8Count >= u8UART0RxHighWater)
+                u8UART0RxHighWater = u8Count + 1;
+        }
+        else
+        {
+            u16UART0RxOverrun++;
+        }
+    }
+
+    if (TI)
+    {
+        TI = 0;
+
+        if (u8UART0TxTail != u8UART0TxHead)
+        {
+            SBUF = UART0TxRing[u8UART0TxTail & (UART0_TX_RING_SIZE - 1)];
+            u8UART0TxTail++;
+        }
+        else
+        {
+            bUART0TxBusy = 0;
+        }
+    }
+}
+
+/**
+ * @brief       UART1 ring service, call from vector 15
+ * @param       none
+ * @return      none
+ * @details     Caller saves SFRS. Received byte is dropped and counted when RX ring is full.
+ */
+void UART1_Ring_ISR(void)
+{
+    unsigned char u8Count;
+
+    SFRS = 0;
+
+    if (RI_1)
+    {
+        RI_1 = 0;
+        u8Count = u8UART1RxHead - u8UART1RxTail;
+
+        if (u8Count < UART1_RX_RING_SIZE)
+        {
+            UART1RxRing[u8UART1RxHead & (UART1_RX_RING_SIZE - 1)] = SBUF_1;
+            u8UART1RxHead++;
+
+            if (u8Count >= u8UART1RxHighWater)
+                u8UART1RxHighWater = u8Count + 1;
+        }
+        else
+        {
+            u16UART1RxOverrun++;
+        }
+    }
+
+    if (TI_1)
+    {
+        TI_1 = 0;
+
+        if (u8UART1TxTail != u8UART1TxHead)
+        {
+            SBUF_1 = UART1TxRing[u8UART1TxTail & (UART1_TX_RING_SIZE - 1)];
+            u8UART1TxTail++;
+        }
+        else
+        {
+            bUART1TxBusy = 0;
+        }
+    }
+}
+
+/**
+ * @brief       Empty rings, clear counters and enable UART interrupt
+ * @param       u8UARTPort UART0 or UART1
+ * @return      none
+ * @details     Call after UART_Open. Global interrupt is enabled by application.
+ * @example     UART_Ring_Open(UART0);
+ */
+void UART_Ring_Open(unsigned char u8UARTPort)
+{
+    switch (u8UARTPort)
+    {
+        case UART0:
+            DISABLE_UART0_INTERRUPT;
+            u8UART0RxHead = u8UART0RxTail = 0;
+            u8UART0TxHead = u8UART0TxTail = 0;
+            bUART0TxBusy = 0;
+            u16UART0RxOverrun = 0;
+            u8UART0RxHighWater = u8UART0TxHighWater = 0;
+            SFRS = 0;
+            RI = 0;
+            TI = 0;
+            ENABLE_UART0_INTERRUPT;
+            break;
+
+        case UART1:
+            DISABLE_UART1_INTERRUPT;
+            u8UART1RxHead = u8UART1RxTail = 0;
+            u8UART1TxHead = u8UART1TxTail = 0;
+            bUART1TxBusy = 0;
+            u16UART1RxOverrun = 0;
+            u8UART1RxHighWater = u8UART1TxHighWater = 0;
+            SFRS = 0;
+            RI_1 = 0;
+            TI_1 = 0;
+            ENABLE_UART1_INTERRUPT;
+            break;
+    }
+}
+
+/**
+ * @brief       Queue one byte to transmit, not wait
+ * @param       u8UARTPort UART0 or UART1
+ * @param       u8Data byte to send
+ * @return      1 queued, 0 TX ring full
+ * @details     An idle UART is started by writing SBUF directly, the rest are sent by TI interrupt.
+ *              Not reentrant, arguments are in overlay memory. Call for one port from one context only,
+ *              e.g. main loop, an interrupt before EA = 0 overwrites the byte of the interrupted call.
+ *              SFRS is kept.
+ */
+unsigned char UART_Ring_Write(unsigned char u8UARTPort, unsigned char u8Data)
+{
+    unsigned char u8Count, u8SFRS;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+    u8SFRS = SFRS;
+    SFRS = 0;
+
+    switch (u8UARTPort)
+    {
+        case UART0:
+            u8Count = u8UART0TxHead - u8UART0TxTail;
+
+            if (u8Count >= UART0_TX_RING_SIZE)
+            {
+                SFRS = u8SFRS;
+                EA = bEA;
+                return 0;
+            }
+
+            if (!bUART0TxBusy)
+            {
+                bUART0TxBusy = 1;
+                SBUF = u8Data;
+            }
+            else
+            {
+                UART0TxRing[u8UART0TxHead & (UART0_TX_RING_SIZE - 1)] = u8Data;
+                u8UART0TxHead++;
+
+                if (u8Count >= u8UART0TxHighWater)
+                    u8UART0TxHighWater = u8Count + 1;
+            }
+            break;
+
+        case UART1:
+            u8Count = u8UART1TxHead - u8UART1TxTail;
+
+            if (u8Count >= UART1_TX_RING_SIZE)
+            {
+                SFRS = u8SFRS;
+                EA = bEA;
+                return 0;
+            }
+
+            if (!bUART1TxBusy)
+            {
+                bUART1TxBusy = 1;
+                SBUF_1 = u8Data;
+            }
+            else
+            {
+                UART1TxRing[u8UART1TxHead & (UART1_TX_RING_SIZE - 1)] = u8Data;
+                u8UART1TxHead++;
+
+                if (u8Count >= u8UART1TxHighWater)
+                    u8UART1TxHighWater = u8Count + 1;
+            }
+            break;
+    }
+
+    SFRS = u8SFRS;
+    EA = bEA;
+    return 1;
+}
+
+/**
+ * @brief       Send next TX ring byte by polling TI
+ * @param       u8UARTPort UART0 or UART1
+ * @return      none
+ * @details     For waiting on a full TX ring while UART interrupt can not run, EA = 0 or inside an
+ *              interrupt of same or higher priority. SFRS is kept.
+ */
+void UART_Ring_TX_Poll(unsigned char u8UARTPort)
+{
+    unsigned char u8SFRS;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+    u8SFRS = SFRS;
+    SFRS = 0;
+
+    switch (u8UARTPort)
+    {
+        case UART0:
+            if (TI)
+            {
+                TI = 0;
+
+                if (u8UART0TxTail != u8UART0TxHead)
+                {
+                    SBUF = UART0TxRing[u8UART0TxTail & (UART0_TX_RING_SIZE - 1)];
+                    u8UART0TxTail++;
+                }
+                else
+                {
+                    bUART0TxBusy = 0;
+                }
+            }
+            break;
+
+        case UART1:
+            if (TI_1)
+            {
+                TI_1 = 0;
+
+                if (u8UART1TxTail != u8UART1TxHead)
+                {
+                    SBUF_1 = UART1TxRing[u8UART1TxTail & (UART1_TX_RING_SIZE - 1)];
+                    u8UART1TxTail++;
+                }
+                else
+                {
+                    bUART1TxBusy = 0;
+                }
+            }
+            break;
+    }
+
+    SFRS = u8SFRS;
+    EA = bEA;
+}
+
+/**
+ * @brief       Get one received byte, not wait
+ * @param       u8UARTPort UART0 or UART1
+ * @param       pu8Data received byte
+ * @return      1 byte read, 0 RX ring empty
+ * @details     Tail is only written here and head only in interrupt, so no interrupt disable needed.
+ */
+unsigned char UART_Ring_Read(unsigned char u8UARTPort, unsigned char *pu8Data)
+{
+    switch (u8UARTPort)
+    {
+        case UART0:
+            if (u8UART0RxHead == u8UART0RxTail)
+                return 0;
+
+            *pu8Data = UART0RxRing[u8UART0RxTail & (UART0_RX_RING_SIZE - 1)];
+            u8UART0RxTail++;
+            return 1;
+
+        case UART1:
+            if (u8UART1RxHead == u8UART1RxTail)
+                return 0;
+
+            *pu8Data = UART1RxRing[u8UART1RxTail & (UART1_RX_RING_SIZE - 1)];
+            u8UART1RxTail++;
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Received bytes waiting in RX ring
+ * @param       u8UARTPort UART0 or UART1
+ * @return      byte count
+ */
+unsigned char UART_Ring_Available(unsigned char u8UARTPort)
+{
+    switch (u8UARTPort)
+    {
+        case UART0:
+            return u8UART0RxHead - u8UART0RxTail;
+
+        case UART1:
+            return u8UART1RxHead - u8UART1RxTail;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Free bytes of TX ring
+ * @param       u8UARTPort UART0 or UART1
+ * @return      byte count UART_Ring_Write can queue now
+ */
+unsigned char UART_Ring_TX_Free(unsigned char u8UARTPort)
+{
+    switch (u8UARTPort)
+    {
+        case UART0:
+            return UART0_TX_RING_SIZE - (unsigned char)(u8UART0TxHead - u8UART0TxTail);
+
+        case UART1:
+            return UART1_TX_RING_SIZE - (unsigned char)(u8UART1TxHead - u8UART1TxTail);
+    }
+
+    return 0;
+}
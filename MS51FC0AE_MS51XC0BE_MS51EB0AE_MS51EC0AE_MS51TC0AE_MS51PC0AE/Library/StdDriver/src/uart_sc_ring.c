@@ -0,0 +1,414 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#define RING_SIZE_ERROR(n)      ((((n) & ((n) - 1)) != 0) || ((n) < 2) || ((n) > 128))
+
+#if RING_SIZE_ERROR(UART2_RX_RING_SIZE) || RING_SIZE_ERROR(UART2_TX_RING_SIZE) || \
+    RING_SIZE_ERROR(UART3_RX_RING_SIZE) || RING_SIZE_ERROR(UART3_TX_RING_SIZE) || \
+    RING_SIZE_ERROR(UART4_RX_RING_SIZE) || RING_SIZE_ERROR(UART4_TX_RING_SIZE)
+#error "UART ring size must be power of 2 from 2 to 128"
+#endif
+
+#define SC_IS_RDAIF             0x01    /* SCnIS, cleared by SCnDR read */
+#define SC_IS_TBEIF             0x02    /* SCnIS, cleared by SCnDR write */
+#define SC_IS_TERRIF            0x04
+#define SC_IE_RDAIEN            0x01
+#define SC_IE_TBEIEN            0x02
+#define SC_IE_TERRIEN           0x04
+#define SC_TSR_ERROR            0x71    /* SCnTSR BEF, FEF, PEF, RXOV */
+
+/* Head and tail are free running, count = head - tail, index = count & (size - 1) */
+unsigned char xdata UART2RxRing[UART2_RX_RING_SIZE];
+unsigned char xdata UART2TxRing[UART2_TX_RING_SIZE];
+unsigned char xdata UART3RxRing[UART3_RX_RING_SIZE];
+unsigned char xdata UART3TxRing[UART3_TX_RING_SIZE];
+unsigned char xdata UART4RxRing[UART4_RX_RING_SIZE];
+unsigned char xdata UART4TxRing[UART4_TX_RING_SIZE];
+unsigned char data u8UART2RxHead, u8UART2RxTail, u8UART2TxHead, u8UART2TxTail;
+unsigned char data u8UART3RxHead, u8UART3RxTail, u8UART3TxHead, u8UART3TxTail;
+unsigned char data u8UART4RxHead, u8UART4RxTail, u8UART4TxHead, u8UART4TxTail;
+
+unsigned int xdata u16UART2RxOverrun, u16UART3RxOverrun, u16UART4RxOverrun;
+unsigned int xdata u16UART2RxError, u16UART3RxError, u16UART4RxError;
+unsigned char xdata u8UART2RxHighWater, u8UART2TxHighWater;
+unsigned char xdata u8UART3RxHighWater, u8UART3TxHighWater;
+unsigned char xdata u8UART4RxHighWater, u8UART4TxHighWater;
+
+/**
+ * @brief       UART2 ring service, call from SMC0_ISR
+ * @param       none
+ * @return      none
+ * @details     Caller saves SFRS. Errors are counted and cleared, received byte is dropped and counted
+ *              when RX ring is full. TX empty interrupt is disabled when TX ring is empty.
+ */
+void UART2_Ring_ISR(void)
+{
+    unsigned char u8Count, u8Data;
+
+    SFRS = 2;
+
+    if (SC0TSR & SC_TSR_ERROR)
+    {
+        u16UART2RxError++;
+        SC0TSR &= ~SC_TSR_ERROR;
+        SC0IS &= ~SC_IS_TERRIF;
+    }
+
+    if (SC0IS & SC_IS_RDAIF)
+    {
+        u8Data = SC0DR;
+        u8Count = u8UART2RxHead - u8UART2RxTail;
+
+        if (u8Count < UART2_RX_RING_SIZE)
+        {
+            UART2RxRing[u8UART2RxHead & (UART2_RX_RING_SIZE - 1)] = u8Data;
+            u8UART2RxHead++;
+
+            if (u8Count >= u8UART2RxHighWater)
+                u8UART2RxHighWater = u8Count + 1;
+        }
+        else
+        {
+            u16UART2RxOverrun++;
+        }
+    }
+
+    if ((SC0IE & SC_IE_TBEIEN) && (SC0IS & SC_IS_TBEIF))
+    {
+        if (u8UART2TxTail != u8UART2TxHead)
+        {
+            SC0DR = UART2TxRing[u8UART2TxTail & (UART2_TX_RING_SIZE - 1)];
+            u8UART2TxTail++;
+        }
+        else
+        {
+            SC0IE &= ~SC_IE_TBEIEN;
+        }
+    }
+}
+
+/**
+ * @brief       UART3 ring service, call from SMC1_ISR
+ * @param       none
+ * @return      none
+ * @details     Caller saves SFRS. Errors are counted and cleared, received byte is dropped and counted
+ *              when RX ring is full. TX empty interrupt is disabled when TX ring is empty.
+ */
+void UART3_Ring_ISR(void)
+{
+    unsigned char u8Count, u8Data;
+
+    SFRS = 2;
+
+    if (SC1TSR & SC_TSR_ERROR)
+    {
+        u16UART3RxError++;
+        SC1TSR &= ~SC_TSR_ERROR;
+        SC1IS &= ~SC_IS_TERRIF;
+    }
+
+    if (SC1IS & SC_IS_RDAIF)
+    {
+        u8Data = SC1DR;
+        u8Count = u8UART3RxHead - u8UART3RxTail;
+
+        if (u8Count < UART3_RX_RING_SIZE)
+        {
+            UART3RxRing[u8UART3RxHead & (UART3_RX_RING_SIZE - 1)] = u8Data;
+            u8UART3RxHead++;
+
+            if (u8Count >= u8UART3RxHighWater)
+                u8UART3RxHighWater = u8Count + 1;
+        }
+        else
+        {
+            u16UART3RxOverrun++;
+        }
+    }
+
+    if ((SC1IE & SC_IE_TBEIEN) && (SC1IS & SC_IS_TBEIF))
+    {
+        if (u8UART3TxTail != u8UART3TxHead)
+        {
+            SC1DR = UART3TxRing[u8UART3TxTail & (UART3_TX_RING_SIZE - 1)];
+            u8UART3TxTail++;
+        }
+        else
+        {
+            SC1IE &= ~SC_IE_TBEIEN;
+        }
+    }
+}
+
+/**
+ * @brief       UART4 ring service, call from SMC2_ISR
+ * @param       none
+ * @return      none
+ * @details     Caller saves SFRS. Errors are counted and cleared, received byte is dropped and counted
+ *              when RX ring is full. TX empty interrupt is disabled when TX ring is empty.
+ */
+void UART4_Ring_ISR(void)
+{
+    unsigned char u8Count, u8Data;
+
+    SFRS = 2;
+
+    if (SC2TSR & SC_TSR_ERROR)
+    {
+        u16UART4RxError++;
+        SC2TSR &= ~SC_TSR_ERROR;
+        SC2IS &= ~SC_IS_TERRIF;
+    }
+
+    if (SC2IS & SC_IS_RDAIF)
+    {
+        u8Data = SC2DR;
+        u8Count = u8UART4RxHead - u8UART4RxTail;
+
+        if (u8Count < UART4_RX_RING_SIZE)
+        {
+            UART4RxRing[u8UART4RxHead & (UART4_RX_RING_SIZE - 1)] = u8Data;
+            u8UART4RxHead++;
+
+            if (u8Count >= u8UART4RxHighWater)
+                u8UART4RxHighWater = u8Count + 1;
+        }
+        else
+        {
+            u16UART4RxOverrun++;
+        }
+    }
+
+    if ((SC2IE & SC_IE_TBEIEN) && (SC2IS & SC_IS_TBEIF))
+    {
+        if (u8UART4TxTail != u8UART4TxHead)
+        {
+            SC2DR = UART4TxRing[u8UART4TxTail & (UART4_TX_RING_SIZE - 1)];
+            u8UART4TxTail++;
+        }
+        else
+        {
+            SC2IE &= ~SC_IE_TBEIEN;
+        }
+    }
+}
+
+/**
+ * @brief       Empty rings, clear counters and enable SC receive, error and TX empty interrupt
+ * @param       u8UARTPort UART2, UART3 or UART4
+ * @return      none
+ * @details     Call after UARTn_Open and pin setting. Global interrupt is enabled by application.
+ * @example     UART_SC_Ring_Open(UART3);
+ */
+void UART_SC_Ring_Open(unsigned char u8UARTPort)
+{
+    SFRS = 2;
+
+    switch (u8UARTPort)
+    {
+        case UART2:
+            SC0IE = 0;
+            u8UART2RxHead = u8UART2RxTail = 0;
+            u8UART2TxHead = u8UART2TxTail = 0;
+            u16UART2RxOverrun = 0;
+            u16UART2RxError = 0;
+            u8UART2RxHighWater = u8UART2TxHighWater = 0;
+            clr_SC0CR0_TXOFF;
+            clr_SC0CR0_RXOFF;
+            SC0TSR &= ~SC_TSR_ERROR;
+            SC0IE = SC_IE_RDAIEN | SC_IE_TERRIEN;
+            break;
+
+        case UART3:
+            SC1IE = 0;
+            u8UART3RxHead = u8UART3RxTail = 0;
+            u8UART3TxHead = u8UART3TxTail = 0;
+            u16UART3RxOverrun = 0;
+            u16UART3RxError = 0;
+            u8UART3RxHighWater = u8UART3TxHighWater = 0;
+            clr_SC1CR0_TXOFF;
+            clr_SC1CR0_RXOFF;
+            SC1TSR &= ~SC_TSR_ERROR;
+            SC1IE = SC_IE_RDAIEN | SC_IE_TERRIEN;
+            break;
+
+        case UART4:
+            SC2IE = 0;
+            u8UART4RxHead = u8UART4RxTail = 0;
+            u8UART4TxHead = u8UART4TxTail = 0;
+            u16UART4RxOverrun = 0;
+            u16UART4RxError = 0;
+            u8UART4RxHighWater = u8UART4TxHighWater = 0;
+            clr_SC2CR0_TXOFF;
+            clr_SC2CR0_RXOFF;
+            SC2TSR &= ~SC_TSR_ERROR;
+            SC2IE = SC_IE_RDAIEN | SC_IE_TERRIEN;
+            break;
+    }
+}
+
+/**
+ * @brief       Queue one byte to transmit, not wait
+ * @param       u8UARTPort UART2, UART3 or UART4
+ * @param       u8Data byte to send
+ * @return      1 queued, 0 TX ring full
+ * @details     TX empty interrupt is enabled after queue, it fires at once when SC transmit buffer is empty.
+ *              SFRS is kept.
+ */
+unsigned char UART_SC_Ring_Write(unsigned char u8UARTPort, unsigned char u8Data)
+{
+    unsigned char u8Count, u8SFRS;
+    bit bEA;
+
+    bEA = EA;
+    EA = 0;
+    u8SFRS = SFRS;
+    SFRS = 2;
+
+    switch (u8UARTPort)
+    {
+        case UART2:
+            u8Count = u8UART2TxHead - u8UART2TxTail;
+
+            if (u8Count >= UART2_TX_RING_SIZE)
+                break;
+
+            UART2TxRing[u8UART2TxHead & (UART2_TX_RING_SIZE - 1)] = u8Data;
+            u8UART2TxHead++;
+
+            if (u8Count >= u8UART2TxHighWater)
+                u8UART2TxHighWater = u8Count + 1;
+
+            SC0IE |= SC_IE_TBEIEN;
+            SFRS = u8SFRS;
+            EA = bEA;
+            return 1;
+
+        case UART3:
+            u8Count = u8UART3TxHead - u8UART3TxTail;
+
+            if (u8Count >= UART3_TX_RING_SIZE)
+                break;
+
+            UART3TxRing[u8UART3TxHead & (UART3_TX_RING_SIZE - 1)] = u8Data;
+            u8UART3TxHead++;
+
+            if (u8Count >= u8UART3TxHighWater)
+                u8UART3TxHighWater = u8Count + 1;
+
+            SC1IE |= SC_IE_TBEIEN;
+            SFRS = u8SFRS;
+            EA = bEA;
+            return 1;
+
+        case UART4:
+            u8Count = u8UART4TxHead - u8UART4TxTail;
+
+            if (u8Count >= UART4_TX_RING_SIZE)
+                break;
+
+            UART4TxRing[u8UART4TxHead & (UART4_TX_RING_SIZE - 1)] = u8Data;
+            u8UART4TxHead++;
+
+            if (u8Count >= u8UART4TxHighWater)
+                u8UART4TxHighWater = u8Count + 1;
+
+            SC2IE |= SC_IE_TBEIEN;
+            SFRS = u8SFRS;
+            EA = bEA;
+            return 1;
+    }
+
+    SFRS = u8SFRS;
+    EA = bEA;
+    return 0;
+}
+
+/**
+ * @brief       Get one received byte, not wait
+ * @param       u8UARTPort UART2, UART3 or UART4
+ * @param       pu8Data received byte
+ * @return      1 byte read, 0 RX ring empty
+ * @details     Tail is only written here and head only in interrupt, so no interrupt disable needed.
+ */
+unsigned char UART_SC_Ring_Read(unsigned char u8UARTPort, unsigned char *pu8Data)
+{
+    switch (u8UARTPort)
+    {
+        case UART2:
+            if (u8UART2RxHead == u8UART2RxTail)
+                return 0;
+
+            *pu8Data = UART2RxRing[u8UART2RxTail & (UART2_RX_RING_SIZE - 1)];
+            u8UART2RxTail++;
+            return 1;
+
+        case UART3:
+            if (u8UART3RxHead == u8UART3RxTail)
+                return 0;
+
+            *pu8Data = UART3RxRing[u8UART3RxTail & (UART3_RX_RING_SIZE - 1)];
+            u8UART3RxTail++;
+            return 1;
+
+        case UART4:
+            if (u8UART4RxHead == u8UART4RxTail)
+                return 0;
+
+            *pu8Data = UART4RxRing[u8UART4RxTail & (UART4_RX_RING_SIZE - 1)];
+            u8UART4RxTail++;
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Received bytes waiting in RX ring
+ * @param       u8UARTPort UART2, UART3 or UART4
+ * @return      byte count
+ */
+unsigned char UART_SC_Ring_Available(unsigned char u8UARTPort)
+{
+    switch (u8UARTPort)
+    {
+        case UART2:
+            return u8UART2RxHead - u8UART2RxTail;
+
+        case UART3:
+            return u8UART3RxHead - u8UART3RxTail;
+
+        case UART4:
+            return u8UART4RxHead - u8UART4RxTail;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Free bytes of TX ring
+ * @param       u8UARTPort UART2, UART3 or UART4
+ * @return      byte count UART_SC_Ring_Write can queue now
+ */
+unsigned char UART_SC_Ring_TX_Free(unsigned char u8UARTPort)
+{
+    switch (u8UARTPort)
+    {
+        case UART2:
+            return UART2_TX_RING_SIZE - (unsigned char)(u8UART2TxHead - u8UART2TxTail);
+
+        case UART3:
+            return UART3_TX_RING_SIZE - (unsigned char)(u8UART3TxHead - u8UART3TxTail);
+
+        case UART4:
+            return UART4_TX_RING_SIZE - (unsigned char)(u8UART4TxHead - u8UART4TxTail);
+    }
+
+    return 0;
+}
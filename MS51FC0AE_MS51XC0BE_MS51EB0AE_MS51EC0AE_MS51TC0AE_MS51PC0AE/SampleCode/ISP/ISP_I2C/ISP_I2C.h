@@ -7,12 +7,14 @@
 #define CMD_SYNC_PACKNO      0xA4
 #define CMD_GET_FWVER        0xA6
 #define FW_VERSION           0x27
+#define ISP_FEATURE          0x14     /* bit2 CMD_UPDATE_APROM_COMPRESSED, bit4 erase skip blank page, returned in byte 9 of CMD_GET_FWVER */
 #define CMD_RUN_APROM        0xAB
 #define CMD_GET_DEVICEID     0xB1
 #define CMD_ERASE_ALL        0xA3
 #define CMD_READ_CONFIG      0xA2
 #define CMD_UPDATE_CONFIG    0xA1
 #define CMD_UPDATE_APROM     0xA0
+#define CMD_UPDATE_APROM_COMPRESSED 0xB6
 #define PAGE_ERASE_AP        0x22
 #define BYTE_READ_AP         0x00
 #define BYTE_PROGRAM_AP      0x21
@@ -33,9 +35,12 @@ extern  data volatile uint16_t AP_size;
 extern  data volatile uint8_t g_timer1Counter;
 extern  data volatile uint8_t count; 
 extern  data volatile uint16_t g_timer0Counter;
-extern  data volatile uint32_t g_checksum;
-extern  data volatile uint32_t g_totalchecksum;
+extern  data volatile uint16_t g_checksum;
+extern  data volatile uint16_t g_rxsum;
+extern  data volatile uint16_t g_totalchecksum;
+extern  data volatile uint8_t g_blankpage;
 extern  bit volatile bI2CDataReady;
+extern  bit volatile g_lzflag;
 extern  bit volatile bISPDataReady;
 extern  bit volatile g_timer0Over;
 extern  bit volatile g_timer1Over;
@@ -49,8 +54,10 @@ void MODIFY_HIRC_24(void);
 void MODIFY_HIRC_16(void);
 void UART0_ini_115200_24MHz(void);
 void Package_checksum(void);
+bit Page_Blank_Check(uint16_t u16Addr);
 
 void MODIFY_HIRC_24(void);
 void MODIFY_HIRC_16(void);
 void READ_ID(void);
-void READ_CONFIG(void);
\ No newline at end of file
+void READ_CONFIG(void);
+bit Program_Compressed(uint8_t u8Start);
\ No newline at end of file
@@ -0,0 +1,76 @@
+#define trig_IAPGO           SFRS=0;TA=0xAA;TA=0x55;IAPTRG|=0x01
+
+#define TRUE       1
+#define FALSE     0
+
+#define CMD_CONNECT          0xAE
+#define CMD_SYNC_PACKNO      0xA4
+#define CMD_GET_FWVER        0xA6
+#define FW_VERSION           0x27
+#define ISP_FEATURE          0x14     /* bit2 CMD_UPDATE_APROM_COMPRESSED, bit4 erase skip blank page, returned in byte 9 of CMD_GET_FWVER */
+#define CMD_RUN_APROM        0xAB
+#define CMD_GET_DEVICEID     0xB1
+#define CMD_ERASE_ALL        0xA3
+#define CMD_READ_CONFIG      0xA2
+#define CMD_UPDATE_CONFIG    0xA1
+#define CMD_UPDATE_APROM     0xA0
+#define CMD_UPDATE_APROM_COMPRESSED 0xB6
+#define PAGE_ERASE_AP        0x22
+#define BYTE_READ_AP         0x00
+#define BYTE_PROGRAM_AP      0x21
+#define BYTE_READ_ID         0x0C
+#define PAGE_ERASE_CONFIG    0xE2
+#define BYTE_READ_CONFIG     0xC0
+#define BYTE_PROGRAM_CONFIG  0xE1
+#define READ_UID             0x04
+#define PAGE_SIZE            128
+#define APROM_SIZE           30*1024
+/*
+  READY handshake: READY falls at the first command byte of a frame and rises when the reply is in SPDR /
+  tx_buf. After the 64th command byte the master waits for READY high, it is low by then, so the old high
+  of the last reply is never taken as the new one.
+
+  Byte timing: SPDR is single buffered for transmit and reloaded by SPI_ISR, so the master leaves at least
+  10us from the last SCK edge of a byte to the first SCK edge of the next one, SCK up to 1MHz.
+  Estimate, not measured, Fsys 16MHz HIRC: a pending Timer0_ISR 50 clocks, SPI_ISR entry and push 25,
+  SPIF clear, bufhead check and tx_buf[] xdata read to the SPDR write 35, total 110 clocks = 6.9us. The
+  command path to RETI is 90 clocks, receive is double buffered so that fits one byte plus the gap.
+*/
+#define ISP_READY_PIN        P03      /* high: ready for command or reply loaded, low: busy */
+#define SPI_FRAME_TIMEOUT    90       /* Timer0 ticks, unfinished command or reply frame is dropped */
+
+ 
+extern  xdata volatile uint8_t rx_buf[64]; 
+extern  xdata volatile uint8_t tx_buf[64];
+extern data volatile uint8_t bufhead;
+extern  data volatile uint16_t flash_address; 
+extern  data volatile uint16_t AP_size;
+extern  data volatile uint8_t g_timer1Counter;
+extern  data volatile uint8_t count; 
+extern  data volatile uint16_t g_timer0Counter;
+extern  data volatile uint16_t g_checksum;
+extern  data volatile uint16_t g_rxsum;
+extern  data volatile uint16_t g_totalchecksum;
+extern  data volatile uint8_t g_blankpage;
+extern  bit volatile bSPIDataReady;
+extern  bit volatile g_lzflag;
+extern  bit volatile g_timer0Over;
+extern  bit volatile g_timer1Over;
+extern  bit volatile g_progarmflag;
+
+extern unsigned char PID_highB,PID_lowB,DID_highB,DID_lowB,CONF0,CONF1,CONF2,CONF4;
+extern unsigned char recv_CONF0,recv_CONF1,recv_CONF2,recv_CONF4;
+void Init_SPI(void);
+void SPI_Reply_Ready(void);
+void TM0_ini(void);
+void MODIFY_HIRC_24(void);
+void MODIFY_HIRC_16(void);
+void UART0_ini_115200_24MHz(void);
+void Package_checksum(void);
+bit Page_Blank_Check(uint16_t u16Addr);
+
+void MODIFY_HIRC_24(void);
+void MODIFY_HIRC_16(void);
+void READ_ID(void);
+void READ_CONFIG(void);
+bit Program_Compressed(uint8_t u8Start);
\ No newline at end of file
@@ -12,17 +12,36 @@
 #include "MS51_32K.h"
 #include "isp_uart0.h"
 
-xdata volatile uint8_t uart_rcvbuf[64];
-xdata volatile uint8_t uart_txbuf[64];
+/* Serial_ISR fills uart_rxfill while main loop programs uart_rcvbuf, host may send next data packet before reply. */
+/* The full uart_rxfill is handed over only after UART0_Rx_Release, one packet in flight at most.              */
+/* Serial_ISR sends uart_txsend while main loop fills uart_txbuf, CMD_READ_APROM stream has no gap between packets */
+xdata volatile uint8_t uart_rxbuf[2][64];
+volatile uint8_t xdata * data uart_rcvbuf;
+volatile uint8_t xdata * data uart_rxfill;
+xdata volatile uint8_t uart_txdbuf[2][64];
+volatile uint8_t xdata * data uart_txbuf;
+volatile uint8_t xdata * data uart_txsend;
 data volatile uint8_t bufhead;
+data volatile uint8_t txhead;
 data volatile uint16_t flash_address;
 data volatile uint16_t AP_size;
 data volatile uint8_t g_timer1Counter;
 data volatile uint8_t count;
 data volatile uint16_t g_timer0Counter;
-data volatile uint32_t g_checksum;
-data volatile uint32_t g_totalchecksum;
+data volatile uint16_t g_checksum;          /* sum of last received packet, by ISR */
+data volatile uint16_t g_rxsum;             /* sum of bytes received so far */
+data volatile uint16_t g_totalchecksum;
+data volatile uint8_t g_blankpage;          /* pages not erased by blank check */
 bit volatile bUartDataReady;
+bit volatile bUartRxRelease;       /* main loop is done with uart_rcvbuf, next packet can be handed over */
+bit volatile g_lzflag;
+bit volatile g_deltaflag;
+bit volatile g_baudTrial;
+xdata uint16_t g_baudDivisor, g_baudPrevious;
+#if ISP_BAUDRATE_ENABLE
+code uint32_t BaudTable[] = {1500000, 921600, 750000, 500000, 460800, 250000, 230400, 115200};
+#endif
+bit volatile bUartTxBusy;
 bit volatile g_timer0Over;
 bit volatile g_timer1Over;
 bit volatile g_programflag;
@@ -132,20 +151,209 @@ void UART0_ini_115200_24MHz(void)
     RL3    = 0xF3;          /*LOBYTE(65536 - 13)*/
     set_T3CON_TR3;          /*Trigger Timer3*/
 
+    uart_rxfill = uart_rxbuf[0];
+    uart_rcvbuf = uart_rxbuf[1];
+    uart_txbuf = uart_txdbuf[0];
+    uart_txsend = uart_txdbuf[1];
+    bUartTxBusy = FALSE;
+    bUartRxRelease = TRUE;
+
     ES = 1;
     EA = 1;
 }
 
+#if ISP_BAUDRATE_ENABLE
+/* Timer3 divisor of u32Baud, 0 if baud rate error over 2% */
+uint16_t Baud_Divisor(uint32_t u32Baud)
+{
+    uint32_t u32Div, u32Real, u32Diff;
 
-void Package_checksum(void)
+    if (u32Baud == 0)
+        return 0;
+
+    u32Div = (ISP_UART_CLOCK + u32Baud / 2) / u32Baud;
+
+    if ((u32Div == 0) || (u32Div > 0xFFFF))
+        return 0;
+
+    u32Real = ISP_UART_CLOCK / u32Div;
+    u32Diff = (u32Real > u32Baud) ? (u32Real - u32Baud) : (u32Baud - u32Real);
+
+    if ((u32Diff * 50) > u32Baud)
+        return 0;
+
+    return (uint16_t)u32Div;
+}
+
+/* Fastest table baud rate not over host request and reachable by HIRC 24MHz, 0 if none */
+uint32_t Baud_Negotiate(uint32_t u32Baud)
 {
-    g_checksum = 0;
+    uint8_t i;
 
-    for (count = 0; count < 64; count++)
+    for (i = 0; i < (sizeof(BaudTable) / sizeof(BaudTable[0])); i++)
     {
-        g_checksum = g_checksum + uart_rcvbuf[count];
+        if ((BaudTable[i] <= u32Baud) && (Baud_Divisor(BaudTable[i]) != 0))
+            return BaudTable[i];
     }
 
+    return 0;
+}
+
+void Timer3_Set_Divisor(uint16_t u16Div)
+{
+    SFRS = 0;
+    RH3 = HIBYTE(65536 - u16Div);
+    RL3 = LOBYTE(65536 - u16Div);
+}
+
+/* Wait RXD pin level change, FALSE if Timer0 overflow */
+bit Wait_RXD_Fall(void)
+{
+    while (ISP_RXD_PIN)
+    {
+        if (TF0)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+bit Wait_RXD_Rise(void)
+{
+    while (!ISP_RXD_PIN)
+    {
+        if (TF0)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+uint16_t Timer0_Read(void)
+{
+    uint8_t u8High, u8Low;
+
+    do
+    {
+        u8High = TH0;
+        u8Low = TL0;
+    } while (u8High != TH0);
+
+    return ((uint16_t)u8High << 8) | u8Low;
+}
+
+/**
+ * Autobaud by CMD_CONNECT 0xAE, LSB first the line is low for start bit and bit 0, so falling edges are at
+ * bit time 0, 5 and 7. Timer0 counts Fsys from first to third falling edge, the second edge must be at 5/7.
+ * Rest of the packet is skipped until RXD idle one Timer0 overflow, the host resends CMD_CONNECT.
+ * return Timer3 divisor, 0 if no valid sync byte in Autobaud_Timeout
+ */
+uint16_t Autobaud_Detect(void)
+{
+    uint16_t u16Timeout, u16Edge5, u16Edge7, u16Div;
+    uint8_t u8Idle;
+
+    ENABLE_TIMER0_MODE1;
+    TIMER0_FSYS;
+    clr_TCON_TF0;
+    set_TCON_TR0;
+
+    u16Timeout = Autobaud_Timeout;
+    u16Div = 0;
+    u8Idle = 0;
+
+    while ((u16Div == 0) && u16Timeout)
+    {
+        if (TF0)
+        {
+            clr_TCON_TF0;
+            u16Timeout--;
+            continue;
+        }
+
+        if (ISP_RXD_PIN)
+        {
+            u8Idle = 1;
+        }
+        else if (u8Idle)
+        {
+            /* Start bit falling edge, one try counted as one overflow */
+            TH0 = 0;
+            TL0 = 0;
+            u8Idle = 0;
+            u16Timeout--;
+
+            if (!Wait_RXD_Rise() || !Wait_RXD_Fall())
+                continue;
+
+            u16Edge5 = Timer0_Read();
+
+            if (!Wait_RXD_Rise() || !Wait_RXD_Fall())
+                continue;
+
+            u16Edge7 = Timer0_Read();
+
+            /* 7 * edge5 within half bit time of 5 * edge7 */
+            if ((((uint32_t)u16Edge5 * 7 + u16Edge7 / 2) < ((uint32_t)u16Edge7 * 5))
+                    || (((uint32_t)u16Edge5 * 7) > ((uint32_t)u16Edge7 * 5 + u16Edge7 / 2)))
+                continue;
+
+            /* Measured baud rate is Fsys * 7 / edge7, 16 Timer3 counts per bit */
+            u16Div = Baud_Divisor(ISP_UART_CLOCK * 112 / u16Edge7);
+        }
+    }
+
+    /* Skip rest of the packet */
+    if (u16Div)
+    {
+        TH0 = 0;
+        TL0 = 0;
+        clr_TCON_TF0;
+
+        while (!TF0)
+        {
+            if (!ISP_RXD_PIN)
+            {
+                TH0 = 0;
+                TL0 = 0;
+            }
+        }
+    }
+
+    clr_TCON_TR0;
+    clr_TCON_TF0;
+    TMOD &= 0xF0;
+    TIMER0_FSYS_DIV12;
+
+    return u16Div;
+}
+#endif
+
+
+#if ISP_BLANK_SKIP_ENABLE
+/* Blank check of one page by IAP read, MOVC in LDROM reads LDROM. TRUE when all bytes are 0xFF */
+bit Page_Blank_Check(uint16_t u16Addr)
+{
+    uint8_t i;
+
+    IAPCN = BYTE_READ_AP;
+    IAPAH = HIBYTE(u16Addr);
+
+    for (i = 0; i < PAGE_SIZE; i++)
+    {
+        IAPAL = LOBYTE(u16Addr) + i;            //page aligned, low byte not carry
+        set_IAPTRG_IAPGO;
+        if (IAPFD != 0xFF)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+#endif
+
+void Package_checksum(void)
+{
+    /* g_checksum is summed by receive ISR, only low 16 bits are replied */
     uart_txbuf[0] = g_checksum & 0xff;
     uart_txbuf[1] = (g_checksum >> 8) & 0xff;
     uart_txbuf[4] = uart_rcvbuf[4] + 1;
@@ -156,43 +364,189 @@ void Package_checksum(void)
 
 }
 
+#if ISP_PAGE_CRC_ENABLE
+/* CRC-16/CCITT nibble table, same CRC as CRC16_APROM of library crc.c */
+code uint16_t PageCRCTable[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/* CRC-16/CCITT (init 0xFFFF) of one APROM page, ISP runs in LDROM so APROM is read by IAP not MOVC */
+uint16_t Page_CRC16(uint16_t u16Addr)
+{
+    uint16_t u16CRC;
+    uint8_t i, u8Data;
+
+    u16CRC = 0xFFFF;
+    IAPCN = BYTE_READ_AP;
+
+    for (i = 0; i < PAGE_SIZE; i++)
+    {
+        IAPAL = LOBYTE(u16Addr);
+        IAPAH = HIBYTE(u16Addr);
+        set_IAPTRG_IAPGO;
+        u8Data = IAPFD;
+        u16CRC = (u16CRC << 4) ^ PageCRCTable[(HIBYTE(u16CRC) >> 4) ^ (u8Data >> 4)];
+        u16CRC = (u16CRC << 4) ^ PageCRCTable[(HIBYTE(u16CRC) >> 4) ^ (u8Data & 0x0F)];
+        u16Addr++;
+    }
+
+    return u16CRC;
+}
+#endif
+
+#if ISP_READ_APROM_ENABLE
+/* Fill byte 8~63 of uart_txbuf from APROM u16Addr by IAP read, MOVC in LDROM reads LDROM. Return byte count before u16End */
+uint8_t Read_APROM_Packet(uint16_t u16Addr, uint16_t u16End)
+{
+    uint8_t i, u8Len;
+
+    u8Len = READ_DATA_SIZE;
+
+    if ((u16End - u16Addr) < READ_DATA_SIZE)
+        u8Len = u16End - u16Addr;
+
+    uart_txbuf[2] = LOBYTE(u16Addr);
+    uart_txbuf[3] = HIBYTE(u16Addr);
+    uart_txbuf[6] = u8Len;
+    IAPCN = BYTE_READ_AP;
+
+    for (i = 0; i < READ_DATA_SIZE; i++)
+    {
+        if (i < u8Len)
+        {
+            IAPAL = LOBYTE(u16Addr);
+            IAPAH = HIBYTE(u16Addr);
+            set_IAPTRG_IAPGO;
+            uart_txbuf[8 + i] = IAPFD;
+            u16Addr++;
+        }
+        else
+        {
+            uart_txbuf[8 + i] = 0xFF;
+        }
+    }
+
+    return u8Len;
+}
+#endif
+
+#if ISP_COMPRESSED_ENABLE
+/* Decompress payload from u8Start to end of packet into APROM, TRUE when AP_size reached */
+bit Program_Compressed(uint8_t u8Start)
+{
+    uint8_t u8Data;
+
+    LZ_Decode_Input((uint8_t xdata *)&uart_rcvbuf[u8Start], 64 - u8Start);
+
+    while (LZ_Decode_Byte(&u8Data) == PASS)
+    {
+        IAPCN = BYTE_PROGRAM_AP;
+        IAPAL = flash_address & 0xff;
+        IAPAH = (flash_address >> 8) & 0xff;
+        IAPFD = u8Data;
+        set_IAPTRG_IAPGO_WDCLR;
+
+        IAPCN = BYTE_READ_AP;                   //program byte verify
+        set_IAPTRG_IAPGO;
+        if (IAPFD != u8Data)
+            while (1);
+
+        g_totalchecksum = g_totalchecksum + u8Data;
+        flash_address++;
+
+        if (flash_address == AP_size)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+#endif
+
+
+/* Hand over full uart_rxfill as uart_rcvbuf, next packet is received into the other buffer.
+   Only after the main loop released uart_rcvbuf, called in Serial_ISR or with EA = 0. */
+#define UART0_RX_HANDOVER                       \
+    uart_rcvbuf = uart_rxfill;                  \
+    if (uart_rxfill == uart_rxbuf[0])           \
+        uart_rxfill = uart_rxbuf[1];            \
+    else                                        \
+        uart_rxfill = uart_rxbuf[0];            \
+    g_checksum = g_rxsum;                       \
+    g_rxsum = 0;                                \
+    bUartRxRelease = FALSE;                     \
+    bUartDataReady = TRUE;                      \
+    g_timer1Counter = 0;                        \
+    g_timer1Over = 0;                           \
+    bufhead = 0
+
+/* Main loop is done with uart_rcvbuf, a packet already waiting in uart_rxfill is handed over at once */
+void UART0_Rx_Release(void)
+{
+    EA = 0;
+    bUartDataReady = FALSE;
+    bUartRxRelease = TRUE;
+
+    if (bufhead == 64)
+    {
+        UART0_RX_HANDOVER;
+    }
+
+    EA = 1;
+}
 
+/* Send uart_txbuf after last reply and swap it with uart_txsend, first byte only, the others are sent by Serial_ISR */
 void Send_64byte_To_UART0(void)
 {
-    SFRS = 0;
-    for (count = 0; count < 64; count++)
+    while (bUartTxBusy)     /* uart_txsend still in use by last reply */
     {
-        TI = 0;
-        SBUF = uart_txbuf[count];
-        while (TI == 0);
         set_WDCON_WDCLR;
     }
+
+    uart_txsend = uart_txbuf;
+
+    if (uart_txbuf == uart_txdbuf[0])
+        uart_txbuf = uart_txdbuf[1];
+    else
+        uart_txbuf = uart_txdbuf[0];
+
+    SFRS = 0;
+    txhead = 1;
+    bUartTxBusy = TRUE;
+    SBUF = uart_txsend[0];
 }
 
 void Serial_ISR(void) interrupt 4
 {
     _push_(SFRS);
 
+    SFRS = 0;
     if (RI == 1)
     {
-        uart_rcvbuf[bufhead++] =  SBUF;
+        if (bufhead < 64)                                    // full packet waits for UART0_Rx_Release
+        {
+            g_rxsum += SBUF;
+            uart_rxfill[bufhead++] =  SBUF;
+        }
         clr_SCON_RI;                                         // Clear RI (Receive Interrupt).
     }
     if (TI == 1)
     {
         clr_SCON_TI;                                         // Clear TI (Transmit Interrupt).
+        if (txhead < 64)
+            SBUF = uart_txsend[txhead++];
+        else
+            bUartTxBusy = FALSE;
     }
     if (bufhead == 1)
     {
         g_timer1Over = 0;
         g_timer1Counter = 90; //for check uart timeout using
     }
-    if (bufhead == 64)
+    if ((bufhead == 64) && bUartRxRelease)
     {
-        bUartDataReady = TRUE;
-        g_timer1Counter = 0;
-        g_timer1Over = 0;
-        bufhead = 0;
+        UART0_RX_HANDOVER;
     }
     _pop_(SFRS);
 }
@@ -12,6 +12,7 @@
 //***********************************************************************************************************
 #include "MS51_32K.H"
 #include "isp_uart1.h"
+unsigned long xdata u32_baud;
 /************************************************************************************************************
 *    Main function 
 ************************************************************************************************************/
@@ -20,8 +21,17 @@ void main (void)
 
   set_CHPCON_IAPEN;
   MODIFY_HIRC_24();
-/*uart initial for ISP programmer GUI, always use 115200 baudrate*/
+#if ISP_BAUDRATE_ENABLE
+/*uart initial for ISP programmer GUI, baud rate detected from CMD_CONNECT*/
+  g_baudDivisor = Autobaud_Detect();            //baud rate of host CMD_CONNECT sync byte
+  if(g_baudDivisor == 0)
+    goto _APROM;
   UART1_ini_115200_24MHz();
+  Timer3_Set_Divisor(g_baudDivisor);
+#else
+/*uart initial for ISP programmer GUI, always use 115200 baudrate */
+  UART1_ini_115200_24MHz();
+#endif
   TM0_ini();
 
   g_timer0Over=0;
@@ -32,9 +42,26 @@ while(1)
 {
         if(bUartDataReady == TRUE)
         {
+#if ISP_BAUDRATE_ENABLE
+          if(g_baudTrial)                         //packet received in new baud rate
+          {
+            g_baudTrial=0;
+            g_timer0Counter=0;
+          }
+#endif
           EA=0; //DISABLE ALL INTERRUPT                  
           if(g_progarmflag==1)
           {
+#if ISP_COMPRESSED_ENABLE
+            if(g_lzflag)
+            {
+              if(Program_Compressed(8))
+              {
+                g_progarmflag=0;
+              }
+              goto END_2;
+            }
+#endif
             for(count=8;count<64;count++)
             {
               IAPCN = BYTE_PROGRAM_AP;          //program byte
@@ -83,10 +110,38 @@ END_2:
             {
               Package_checksum();
               uart_txbuf[8]=FW_VERSION;  
+              uart_txbuf[9]=ISP_FEATURE;
               Send_64byte_To_UART1();  
             break;
             }
             
+#if ISP_BAUDRATE_ENABLE
+            case CMD_SET_BAUDRATE:
+            {
+              u32_baud = uart_rcvbuf[8];
+              u32_baud |= ((uint32_t)uart_rcvbuf[9]<<8);
+              u32_baud |= ((uint32_t)uart_rcvbuf[10]<<16);
+              u32_baud |= ((uint32_t)uart_rcvbuf[11]<<24);
+              u32_baud = Baud_Negotiate(u32_baud);
+              Package_checksum();
+              uart_txbuf[8]=u32_baud&0xff;
+              uart_txbuf[9]=(u32_baud>>8)&0xff;
+              uart_txbuf[10]=(u32_baud>>16)&0xff;
+              uart_txbuf[11]=(u32_baud>>24)&0xff;
+              Send_64byte_To_UART1();
+              if(u32_baud)                            //reply in old baud rate, then switch
+              {
+                g_baudPrevious=g_baudDivisor;
+                g_baudDivisor=Baud_Divisor(u32_baud);
+                Timer3_Set_Divisor(g_baudDivisor);
+                g_baudTrial=1;
+                g_timer0Counter=Baud_Trial_Counter;
+                g_timer0Over=0;
+              }
+              break;
+            }
+#endif
+
             case CMD_RUN_APROM:            
             {
               goto _APROM;
@@ -109,17 +164,27 @@ END_2:
             {
 //              set_CHPCON_IAPEN;
               set_IAPUEN_APUEN;
-              IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
-              IAPCN = PAGE_ERASE_AP;
               
+              g_blankpage=0;
               for(flash_address=0x0000;flash_address<APROM_SIZE/PAGE_SIZE;flash_address++)
-              {        
-                IAPAL = LOBYTE(flash_address*PAGE_SIZE);
-                IAPAH = HIBYTE(flash_address*PAGE_SIZE);
-                set_IAPTRG_IAPGO;
-              }            
+              {
+                if(Page_Blank_Check(flash_address*PAGE_SIZE))  //blank page need not erase
+                {
+                  g_blankpage++;
+                }
+                else
+                {
+                  IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
+                  IAPCN = PAGE_ERASE_AP;
+                  IAPAL = LOBYTE(flash_address*PAGE_SIZE);
+                  IAPAH = HIBYTE(flash_address*PAGE_SIZE);
+                  set_IAPTRG_IAPGO;
+                }
+              }
               
               Package_checksum();
+              uart_txbuf[10]=g_blankpage;
+              uart_txbuf[11]=0;
               Send_64byte_To_UART1();  
               break;
             }
@@ -185,19 +250,30 @@ END_2:
               break;
             }
             
+#if ISP_COMPRESSED_ENABLE
+            case CMD_UPDATE_APROM_COMPRESSED:
+#endif
             case CMD_UPDATE_APROM:            
             {
 //              set_CHPCON_IAPEN;
               set_IAPUEN_APUEN;
-              IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
-              IAPCN = PAGE_ERASE_AP;
               
+              g_blankpage=0;
               for(flash_address=0x0000;flash_address<APROM_SIZE/PAGE_SIZE;flash_address++)
-              {        
-                IAPAL = LOBYTE(flash_address*PAGE_SIZE);
-                IAPAH = HIBYTE(flash_address*PAGE_SIZE);
-                set_IAPTRG_IAPGO;
-              }            
+              {
+                if(Page_Blank_Check(flash_address*PAGE_SIZE))  //blank page need not erase
+                {
+                  g_blankpage++;
+                }
+                else
+                {
+                  IAPFD = 0xFF;          //Erase must set IAPFD = 0xFF
+                  IAPCN = PAGE_ERASE_AP;
+                  IAPAL = LOBYTE(flash_address*PAGE_SIZE);
+                  IAPAH = HIBYTE(flash_address*PAGE_SIZE);
+                  set_IAPTRG_IAPGO;
+                }
+              }
               
               g_totalchecksum=0;
               flash_address=0;
@@ -206,6 +282,17 @@ END_2:
               AP_size|=(uart_rcvbuf[13]<<8);  
               g_progarmflag=1;
 
+              g_lzflag=0;
+#if ISP_COMPRESSED_ENABLE
+              if(uart_rcvbuf[0]==CMD_UPDATE_APROM_COMPRESSED)
+              {
+                g_lzflag=1;
+                LZ_Decode_Init();
+                if(Program_Compressed(16))
+                  g_progarmflag=0;
+                goto END_1;
+              }
+#endif
               for(count=16;count<64;count++)
               {
                 IAPCN = BYTE_PROGRAM_AP;
@@ -234,28 +321,47 @@ END_1:
               Package_checksum();
               uart_txbuf[8]=g_totalchecksum&0xff;
               uart_txbuf[9]=(g_totalchecksum>>8)&0xff;
+              uart_txbuf[10]=g_blankpage;
+              uart_txbuf[11]=0;
               Send_64byte_To_UART1();  
               break;
             }
           }  
           bUartDataReady = FALSE;
-          bufhead = 0;            
+          bufhead = 0;
+          g_rxsum=0;
           EA=1;
       }
       //For connect timer out  
       if(g_timer0Over==1)
-      {       
-       goto _APROM;
+      {
+#if ISP_BAUDRATE_ENABLE
+        if(g_baudTrial)                         //no packet in new baud rate, back to old one
+        {
+          g_baudDivisor=g_baudPrevious;
+          Timer3_Set_Divisor(g_baudDivisor);
+          g_baudTrial=0;
+          g_timer0Over=0;
+        }
+        else
+#endif
+        {
+          goto _APROM;
+        }
       }
       
       //for uart time out or buffer error
-       if(g_timer1Over==1)
-      {       
-       if((bufhead<64)&&(bufhead>0)||(bufhead>64))
-         {
-         bufhead=0;         
-         }
-      }  
+      if(g_timer1Over==1)
+      {
+        EA=0;                                   //Serial_ISR may store byte 0 of next packet
+        if((bufhead<64)&&(bufhead>0)||(bufhead>64))
+        {
+          bufhead=0;
+          g_rxsum=0;
+        }
+        g_timer1Over=0;
+        EA=1;
+      }
 
 }   
 
@@ -0,0 +1,194 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 LDROM boot manager of A/B application slots, slot layout define in boot_slot.h
+//
+//  Set CONFIG0 CBS boot from LDROM and CONFIG1 LDROM 2KB. Each reset runs this code:
+//  1. Read both slot headers, a slot with magic and checked mark is valid without reading the image.
+//  2. Slot with magic but no checked mark (programmed by ICP / ISP) is CRC-32 checked once by IAP read,
+//     checked or bad mark is programmed so the image is not read again on next boot.
+//  3. Valid slot with larger version is booted, vector page is rewritten if it points to the other slot.
+//  4. Software reset to APROM, the vector page LJMP to the slot image.
+//  Normal boot reads 2 headers and the vector page LJMPs, below 1ms. MOVC in LDROM reads LDROM, so the
+//  one time image check uses IAP read. No valid slot: stay in LDROM.
+//***********************************************************************************************************
+#include "MS51_32K.h"
+
+bit BIT_TMP;
+unsigned char xdata SlotHeader[2][SLOT_HDR_SIZE];
+
+/* IAP read APROM, MOVC in LDROM reads LDROM */
+void Slot_Read(unsigned int u16Addr, unsigned char *pu8Buf, unsigned char u8Size)
+{
+    IAPCN = BYTE_READ_APROM;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+
+    while (u8Size--)
+    {
+        set_IAPTRG_IAPGO;
+        *pu8Buf++ = IAPFD;
+        IAPAL++;
+        if (IAPAL == 0)
+            IAPAH++;
+    }
+}
+
+void Slot_Program_Byte(unsigned int u16Addr, unsigned char u8Data)
+{
+    set_IAPUEN_APUEN;
+    IAPCN = BYTE_PROGRAM_APROM;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+    IAPFD = u8Data;
+    set_IAPTRG_IAPGO;
+    clr_IAPUEN_APUEN;
+}
+
+unsigned long Slot_Header_Long(unsigned char *pu8Buf)
+{
+    return (unsigned long)pu8Buf[0] << 24 | (unsigned long)pu8Buf[1] << 16 | (unsigned int)pu8Buf[2] << 8 | pu8Buf[3];
+}
+
+/**
+ * @brief       Check one slot
+ * @param       u8Slot SLOT_A / SLOT_B
+ * @return      PASS / FAIL
+ * @details     Image CRC-32 is calculated only when checked mark is not programmed,
+ *              the result is kept by checked mark or bad mark.
+ */
+unsigned char Slot_Check(unsigned char u8Slot)
+{
+    unsigned char *pu8Header;
+    unsigned int u16Addr, u16Length;
+    unsigned long u32CRC;
+
+    pu8Header = SlotHeader[u8Slot];
+    Slot_Read(SLOT_ADDR(u8Slot), pu8Header, SLOT_HDR_SIZE);
+    u16Length = ((unsigned int)pu8Header[SLOT_HDR_LENGTH] << 8) | pu8Header[SLOT_HDR_LENGTH + 1];
+
+    if (Slot_Header_Long(&pu8Header[SLOT_HDR_MAGIC]) != SLOT_MAGIC || pu8Header[SLOT_HDR_BAD] == SLOT_MARK
+        || u16Length == 0 || u16Length > SLOT_IMAGE_MAX)
+        return FAIL;
+
+    if (pu8Header[SLOT_HDR_CHECKED] == SLOT_MARK)
+        return PASS;
+
+    u32CRC = CRC32_INIT;
+    u16Addr = SLOT_IMAGE_ADDR(u8Slot);
+    IAPCN = BYTE_READ_APROM;
+    IAPAL = LOBYTE(u16Addr);
+    IAPAH = HIBYTE(u16Addr);
+
+    while (u16Length--)
+    {
+        set_IAPTRG_IAPGO;
+        u32CRC = CRC32_Update(u32CRC, IAPFD);
+        IAPAL++;
+        if (IAPAL == 0)
+            IAPAH++;
+    }
+
+    if ((u32CRC ^ CRC32_XOROUT) == Slot_Header_Long(&pu8Header[SLOT_HDR_CRC]))
+    {
+        Slot_Program_Byte(SLOT_ADDR(u8Slot) + SLOT_HDR_CHECKED, SLOT_MARK);
+        return PASS;
+    }
+
+    Slot_Program_Byte(SLOT_ADDR(u8Slot) + SLOT_HDR_BAD, SLOT_MARK);
+    return FAIL;
+}
+
+/**
+ * @brief       Point vector page to slot image
+ * @param       u8Slot SLOT_A / SLOT_B
+ * @return      none
+ * @details     LJMP of reset and each interrupt vector to the same offset in slot image. Vector page
+ *              is compared first and only erased / programmed after the booted slot changed.
+ *              An interrupted rewrite does not match and is done again on next boot.
+ */
+void Slot_Vector_Update(unsigned char u8Slot)
+{
+    unsigned char u8Vector[3];
+    unsigned int u16Addr, u16Target;
+    unsigned char i;
+    bit bMatch;
+
+    bMatch = 1;
+
+    for (i = 0; i < SLOT_VECTOR_NUM && bMatch; i++)
+    {
+        u16Addr = (i == 0) ? SLOT_VECTOR_ADDR : SLOT_VECTOR_ADDR + i * 8 - 5;
+        u16Target = SLOT_IMAGE_ADDR(u8Slot) + u16Addr - SLOT_VECTOR_ADDR;
+        Slot_Read(u16Addr, u8Vector, 3);
+        bMatch = (u8Vector[0] == 0x02 && u8Vector[1] == HIBYTE(u16Target) && u8Vector[2] == LOBYTE(u16Target));
+    }
+
+    if (bMatch)
+        return;
+
+    set_IAPUEN_APUEN;
+    IAPFD = 0xFF;
+    IAPCN = PAGE_ERASE_APROM;
+
+    for (u16Addr = SLOT_VECTOR_ADDR; u16Addr < SLOT_VECTOR_ADDR + SLOT_VECTOR_SIZE; u16Addr += PAGE_SIZE)
+    {
+        IAPAL = LOBYTE(u16Addr);
+        IAPAH = HIBYTE(u16Addr);
+        set_IAPTRG_IAPGO;
+    }
+
+    clr_IAPUEN_APUEN;
+
+    /* reset vector LJMP is programmed last, Boot_Slot_Active of APROM reads it */
+    for (i = SLOT_VECTOR_NUM; i > 0; i--)
+    {
+        u16Addr = (i == 1) ? SLOT_VECTOR_ADDR : SLOT_VECTOR_ADDR + (i - 1) * 8 - 5;
+        u16Target = SLOT_IMAGE_ADDR(u8Slot) + u16Addr - SLOT_VECTOR_ADDR;
+        Slot_Program_Byte(u16Addr + 1, HIBYTE(u16Target));
+        Slot_Program_Byte(u16Addr + 2, LOBYTE(u16Target));
+        Slot_Program_Byte(u16Addr, 0x02);
+    }
+}
+
+void main(void)
+{
+    unsigned char u8ValidA, u8ValidB, u8Boot;
+
+    set_CHPCON_IAPEN;
+
+    u8ValidA = Slot_Check(SLOT_A);
+    u8ValidB = Slot_Check(SLOT_B);
+
+    if (u8ValidA == PASS && u8ValidB == PASS)
+    {
+        u8Boot = (Slot_Header_Long(&SlotHeader[SLOT_B][SLOT_HDR_VERSION]) > Slot_Header_Long(&SlotHeader[SLOT_A][SLOT_HDR_VERSION]))
+                 ? SLOT_B : SLOT_A;
+    }
+    else if (u8ValidA == PASS)
+    {
+        u8Boot = SLOT_A;
+    }
+    else if (u8ValidB == PASS)
+    {
+        u8Boot = SLOT_B;
+    }
+    else
+    {
+        /* No valid application, program a slot by ICP */
+        while (1);
+    }
+
+    Slot_Vector_Update(u8Boot);
+
+    clr_CHPCON_IAPEN;
+    TA = 0xAA; TA = 0x55; CHPCON = 0x80;                   //software reset enable boot from APROM
+
+    /* Trap the CPU */
+    while(1);
+}
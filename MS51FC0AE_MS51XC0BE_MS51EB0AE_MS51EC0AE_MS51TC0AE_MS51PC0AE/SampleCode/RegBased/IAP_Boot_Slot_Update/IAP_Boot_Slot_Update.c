@@ -0,0 +1,108 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 A/B slot application, update inactive slot by UART0 while running
+//
+//  LDROM must be programmed with SampleCode/ISP/LDROM_Boot_AB, slot layout define in boot_slot.h.
+//  Project is linked for slot A: C51 INTVECTOR(0x0180), LX51 CLASSES code 0x0180-0x3C7F, STARTUP_SLOT.A51
+//  SLOT_IMAGE 0180H. For slot B image change them to 0x3D00, code 0x3D00-0x77FF.
+//
+//  UART0 115200 command
+//  'V' : print running slot and slot versions
+//  'U' : followed by version[4] length[2] CRC-32[4] MSB first, device replies 'R' after slot erase,
+//        then each 128 bytes block (last block length bytes only) is replied '.' after programmed.
+//        Image is committed with CRC-32 check and device resets to LDROM boot manager.
+//***********************************************************************************************************
+#include "MS51_32K.h"
+
+unsigned long Receive_Long(unsigned char u8Size)
+{
+    unsigned long u32Data = 0;
+
+    while (u8Size--)
+        u32Data = (u32Data << 8) | Receive_Data(UART0);
+
+    return u32Data;
+}
+
+void Slot_Update(void)
+{
+    unsigned long u32Version, u32CRC;
+    unsigned int u16Length, u16Offset;
+    unsigned char u8Slot, u8Size, i;
+
+    u32Version = Receive_Long(4);
+    u16Length = (unsigned int)Receive_Long(2);
+    u32CRC = Receive_Long(4);
+    u8Slot = Boot_Slot_Active() == SLOT_A ? SLOT_B : SLOT_A;
+
+    if (u16Length == 0 || u16Length > SLOT_IMAGE_MAX || Boot_Slot_Erase(u8Slot) != PASS)
+    {
+        UART_Send_Data(UART0, 'E');
+        return;
+    }
+
+    UART_Send_Data(UART0, 'R');
+
+    for (u16Offset = 0; u16Offset < u16Length; u16Offset += u8Size)
+    {
+        u8Size = (u16Length - u16Offset > PAGE_SIZE) ? PAGE_SIZE : (unsigned char)(u16Length - u16Offset);
+
+        for (i = 0; i < u8Size; i++)
+            IAPDataBuf[i] = Receive_Data(UART0);
+
+        if (Boot_Slot_Program(u8Slot, u16Offset, IAPDataBuf, u8Size) != PASS)
+        {
+            UART_Send_Data(UART0, 'E');
+            return;
+        }
+
+        UART_Send_Data(UART0, '.');
+    }
+
+    if (Boot_Slot_Commit(u8Slot, u32Version, u16Length, u32CRC) != PASS)
+    {
+        printf("\n Slot %c commit fail", 'A' + u8Slot);
+        return;
+    }
+
+    printf("\n Slot %c version %lu committed, reset", 'A' + u8Slot, u32Version);
+    Timer0_Delay(24000000, 10, 1000);
+    Software_Reset(BOOT_LDROM);
+}
+
+void main(void)
+{
+    unsigned char u8Cmd;
+
+/* UART0 initial setting
+  * include sys.c in Library for modify HIRC value to 24MHz
+  * include uart.c in Library for UART initial setting
+*/
+    MODIFY_HIRC(HIRC_24);
+    P06_PUSHPULL_MODE;
+    UART_Open(24000000,UART0_Timer3,115200);
+    ENABLE_UART0_PRINTF;
+
+    printf("\n Running slot %c", 'A' + Boot_Slot_Active());
+
+    while (1)
+    {
+        u8Cmd = Receive_Data(UART0);
+
+        if (u8Cmd == 'V')
+        {
+            printf("\n Running slot %c, slot A version %lu, slot B version %lu", 'A' + Boot_Slot_Active(),
+                   Boot_Slot_Version(SLOT_A), Boot_Slot_Version(SLOT_B));
+        }
+        else if (u8Cmd == 'U')
+        {
+            Slot_Update();
+        }
+    }
+}
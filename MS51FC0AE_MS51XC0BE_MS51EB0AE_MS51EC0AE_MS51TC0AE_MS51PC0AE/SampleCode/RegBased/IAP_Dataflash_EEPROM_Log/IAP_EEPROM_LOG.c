@@ -0,0 +1,108 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#include "MS51_32K.h"
+
+#define     EEPROM_BYTE_ADDR        0x3900      /* compare address for Write_DATAFLASH_BYTE, out of log pages */
+#define     TEST_LOOP               200
+
+unsigned int xdata u16LogMaxTick, u16ByteMaxTick;
+unsigned long xdata u32LogTotalTick, u32ByteTotalTick;
+
+/* Timer0 run Fsys/12, 0.5us per tick at 24MHz */
+void Timer0_Start(void)
+{
+    clr_TCON_TR0;
+    TH0 = 0;
+    TL0 = 0;
+    set_TCON_TR0;
+}
+
+unsigned int Timer0_Stop(void)
+{
+    clr_TCON_TR0;
+    return ((TH0 << 8) + TL0);
+}
+
+/**
+ * @brief       Log-structured dataflash store compare with Write_DATAFLASH_BYTE
+ * @param       None
+ * @return      None
+ * @details     Write the same data sequence by both way, print write time and flash erase / program count.
+ */
+void main(void)
+{
+    unsigned int i, u16Tick, u16Erase, u16Program;
+    unsigned char u8Key, u8Data;
+
+/* UART0 initial setting
+  * include sys.c in Library for modify HIRC value to 24MHz
+  * include uart.c in Library for UART initial setting
+*/
+    MODIFY_HIRC(HIRC_24);
+    P06_PUSHPULL_MODE;
+    UART_Open(24000000,UART0_Timer3,115200);
+    ENABLE_UART0_PRINTF;
+
+    /*loop here while P35 = 1; */
+    P35_INPUT_MODE;
+
+    while (P35);
+
+    ENABLE_TIMER0_MODE1;
+    TIMER0_FSYS_DIV12;
+
+    /** Log-structured store * include eeprom_log.c in Library       */
+    Init_DATAFLASH_LOG();
+    u16LogEraseCount = 0;
+    u16LogProgramCount = 0;
+    u16LogMaxTick = 0;
+    u32LogTotalTick = 0;
+
+    for (i = 0; i < TEST_LOOP; i++)
+    {
+        u8Key = i % LOG_KEY_NUM;
+        u8Data = i;
+        Timer0_Start();
+        Write_DATAFLASH_LOG(u8Key, u8Data);
+        u16Tick = Timer0_Stop();
+        u32LogTotalTick += u16Tick;
+
+        if (u16Tick > u16LogMaxTick)
+            u16LogMaxTick = u16Tick;
+
+        if (Read_DATAFLASH_LOG(u8Key) != u8Data)
+            printf("\n Log key %bd read back error", u8Key);
+    }
+
+    u16Erase = u16LogEraseCount;
+    u16Program = u16LogProgramCount;
+
+    /** Read-modify-write whole page store * include eeprom.c in Library       */
+    u16ByteMaxTick = 0;
+    u32ByteTotalTick = 0;
+    u16IAPEraseCount = 0;
+    u16IAPProgramCount = 0;
+
+    for (i = 0; i < TEST_LOOP; i++)
+    {
+        Timer0_Start();
+        Write_DATAFLASH_BYTE(EEPROM_BYTE_ADDR + (i % LOG_KEY_NUM), i);
+        u16Tick = Timer0_Stop();
+        u32ByteTotalTick += u16Tick;
+
+        if (u16Tick > u16ByteMaxTick)
+            u16ByteMaxTick = u16Tick;
+    }
+
+    printf("\n %d writes, time unit 0.5us", TEST_LOOP);
+    printf("\n Log  : average %ld max %d, page erase %d byte program %d", u32LogTotalTick / TEST_LOOP, u16LogMaxTick, u16Erase, u16Program);
+    printf("\n Byte : average %ld max %d, page erase %d byte program %d", u32ByteTotalTick / TEST_LOOP, u16ByteMaxTick, u16IAPEraseCount, u16IAPProgramCount);
+    DISABLE_UART0_PRINTF;
+
+    while (1);
+}
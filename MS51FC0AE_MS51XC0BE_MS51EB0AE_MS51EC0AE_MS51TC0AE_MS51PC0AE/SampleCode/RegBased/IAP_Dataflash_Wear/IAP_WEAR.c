@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 flash wear telemetry demo, project define FLASH_WEAR_ENABLE=1
+//***********************************************************************************************************
+#include "MS51_32K.h"
+
+#define     WEAR_TEST_ADDR          0x3900      /* tracked page written by Write_DATAFLASH_BYTE */
+#define     WEAR_TEST_LOOP          10
+
+/**
+ * @brief       UART dump of wear counters
+ * @param       None
+ * @return      None
+ * @details     One line per slot: slot, page, erase count, projected remaining erase cycles.
+ */
+void Flash_Wear_Dump(void)
+{
+    unsigned char i;
+
+    printf("\n Slot  Page       Erase  Remaining");
+
+    for (i = 0; i < WEAR_SLOT_NUM; i++)
+    {
+        if (i < WEAR_TRACK_PAGE_NUM)
+            printf("\n %4bd  0x%04X", i, WEAR_TRACK_ADDR + i * PAGE_SIZE);
+        else if (i == WEAR_SLOT_LDROM)
+            printf("\n %4bd  LDROM ", i);
+        else
+            printf("\n %4bd  WEAR  ", i);
+
+        printf(" %8lu  %9lu", Flash_Wear_Get_Count(i), Flash_Wear_Get_Remaining(i));
+    }
+}
+
+void main(void)
+{
+    unsigned char i, u8Cmd;
+
+/* UART0 initial setting
+  * include sys.c in Library for modify HIRC value to 24MHz
+  * include uart.c in Library for UART initial setting
+*/
+    MODIFY_HIRC(HIRC_24);
+    P06_PUSHPULL_MODE;
+    UART_Open(24000000,UART0_Timer3,115200);
+    ENABLE_UART0_PRINTF;
+
+    /** Wear counters must be loaded before any erase * include flash_wear.c in Library */
+    Init_FLASH_WEAR();
+
+    printf("\n 'E' : erase test page %d times, 'W' : dump wear counters", WEAR_TEST_LOOP);
+
+    while (1)
+    {
+        u8Cmd = Receive_Data(UART0);
+
+        if (u8Cmd == 'E')
+        {
+            /* 0xAA and 0x55 in turn, every write need page erase */
+            for (i = 0; i < WEAR_TEST_LOOP; i++)
+                Write_DATAFLASH_BYTE(WEAR_TEST_ADDR, (i & 1) ? 0x55 : 0xAA);
+
+            printf("\n Done");
+        }
+        else if (u8Cmd == 'W')
+        {
+            Flash_Wear_Dump();
+        }
+    }
+}
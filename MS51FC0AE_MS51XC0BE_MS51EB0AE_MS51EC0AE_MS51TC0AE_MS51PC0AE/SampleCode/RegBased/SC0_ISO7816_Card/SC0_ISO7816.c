@@ -0,0 +1,80 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 SC0 ISO 7816-3 card, cold reset and ATR, PPS, SELECT of PSE by T=0 or T=1
+//  SC0 DAT on UART2 TXD pin P3.0 (open drain, external pull up), SC0 CLK on P1.7, card RST on P0.5
+//  Check the pin function table of data sheet for SC0 CLK / DAT of the package in use.
+//  UART0 P0.6 printf 115200 by Timer3, Timer0 is used by sc_iso7816_hw.c
+//***********************************************************************************************************
+#include "MS51_32K.h"
+
+unsigned char code au8SelectPSE[] = {0x00, 0xA4, 0x04, 0x00, 0x0E,
+                                     '1', 'P', 'A', 'Y', '.', 'S', 'Y', 'S', '.', 'D', 'D', 'F', '0', '1', 0x00};
+
+SC_CARD xdata Card;
+unsigned char xdata au8Cmd[ISO7816_APDU_MAX];
+unsigned char xdata au8Resp[ISO7816_RESP_MAX];
+
+/**
+ * @brief       Card RST pin of SC0, called by sc_iso7816.c
+ */
+void SC_HW_Set_RST(unsigned char u8Port, unsigned char u8Level)
+{
+    if (u8Port == SC0)
+        P05 = u8Level;
+}
+
+void Print_Hex(unsigned char xdata *pu8Data, unsigned int u16Len)
+{
+    while (u16Len--)
+        printf(" %bX", *pu8Data++);
+    printf("\n");
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned int u16RespLen;
+    unsigned char u8Ret;
+
+    MODIFY_HIRC(HIRC_24);
+    P06_PUSHPULL_MODE;
+    UART_Open(24000000, UART0_Timer3, 115200);
+    ENABLE_UART0_PRINTF;
+
+    P05 = 0;
+    P05_PUSHPULL_MODE;
+    P17_PUSHPULL_MODE;
+    P30_OPENDRAIN_MODE;
+    ENABLE_UART2_TXD_P30;
+    ENABLE_UART2_RXD_P17;
+
+    u8Ret = SC_Card_Activate(&Card, SC0);
+    printf("\nActivate %bu, ATR", u8Ret);
+    Print_Hex(Card.au8ATR, Card.u8ATRLen);
+
+    if (u8Ret == SC_OK)
+    {
+        u8Ret = SC_Card_PPS(&Card);
+        printf("T=%bu, PPS %bu, ETU %u clocks\n", Card.u8Protocol, u8Ret, Card.u16EtuClock);
+    }
+
+    if (u8Ret == SC_OK)
+    {
+        memcpy(au8Cmd, au8SelectPSE, sizeof(au8SelectPSE));
+        u8Ret = SC_Card_APDU(&Card, au8Cmd, sizeof(au8SelectPSE), au8Resp, &u16RespLen);
+        printf("SELECT %bu, response", u8Ret);
+        Print_Hex(au8Resp, u16RespLen);
+    }
+
+    SC_Card_Deactivate(&Card);
+
+    while (1);
+}
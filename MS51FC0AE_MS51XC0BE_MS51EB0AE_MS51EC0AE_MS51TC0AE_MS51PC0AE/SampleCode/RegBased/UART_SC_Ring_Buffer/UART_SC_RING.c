@@ -0,0 +1,102 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: MS51 five UART echo by interrupt ring buffer, UART0 / UART1 by uart_ring.c,
+//                 UART2 / UART3 / UART4 (SC0 / SC1 / SC2) by uart_sc_ring.c
+//  Project define UART_RING_ENABLE=1, UART_SC_RING_ENABLE=1
+//  UART0 P0.6 / P0.7, UART1 P1.6 / P0.2, UART2 P3.0 / P1.7, UART3 P1.2 / P1.1, UART4 P2.3 / P2.2
+//***********************************************************************************************************
+#include "MS51_32K.h"
+
+/**
+ * @brief       Queue string to UART0 TX ring
+ * @param       pcStr string end with 0
+ * @return      None
+ * @details     Wait only while TX ring is full.
+ */
+void UART0_Ring_Puts(char *pcStr)
+{
+    while (*pcStr)
+    {
+        if (UART_Ring_Write(UART0, *pcStr))
+            pcStr++;
+    }
+}
+
+/************************************************************************************************************/
+/*  Main function                                                                                           */
+/************************************************************************************************************/
+void main(void)
+{
+    unsigned char u8Data, u8Port;
+    char xdata acLine[64];
+
+    MODIFY_HIRC(HIRC_24);
+
+    P06_QUASI_MODE;
+    P07_INPUT_MODE;
+    P16_QUASI_MODE;
+    P02_INPUT_MODE;
+    ENABLE_UART1_TXD_P16;
+    ENABLE_UART1_RXD_P02;
+    P30_QUASI_MODE;
+    P17_INPUT_MODE;
+    ENABLE_UART2_TXD_P30;
+    ENABLE_UART2_RXD_P17;
+    P12_QUASI_MODE;
+    P11_INPUT_MODE;
+    ENABLE_UART3_TXD_P12;
+    ENABLE_UART3_RXD_P11;
+    P23_QUASI_MODE;
+    P22_INPUT_MODE;
+    ENABLE_UART4_TXD_P23;
+    ENABLE_UART4_RXD_P22;
+
+    UART_Open(24000000, UART0_Timer1, 115200);
+    UART_Open(24000000, UART1_Timer3, 115200);
+    UART2_Open(24000000, 115200);
+    UART3_Open(24000000, 115200);
+    UART4_Open(24000000, 115200);
+
+    UART_Ring_Open(UART0);
+    UART_Ring_Open(UART1);
+    UART_SC_Ring_Open(UART2);
+    UART_SC_Ring_Open(UART3);
+    UART_SC_Ring_Open(UART4);
+    ENABLE_GLOBAL_INTERRUPT;
+
+    UART0_Ring_Puts("\r\nFive UART ring echo, '?' on UART0 prints UART2..4 counters\r\n");
+
+/* Main loop only moves bytes between rings, no port is polled by flag */
+    while (1)
+    {
+        while (UART_Ring_Read(UART0, &u8Data))
+        {
+            if (u8Data == '?')
+            {
+                sprintf(acLine, "\r\nerror %u %u %u, overrun %u %u %u\r\n",
+                        u16UART2RxError, u16UART3RxError, u16UART4RxError,
+                        u16UART2RxOverrun, u16UART3RxOverrun, u16UART4RxOverrun);
+                UART0_Ring_Puts(acLine);
+            }
+            else
+            {
+                while (!UART_Ring_Write(UART0, u8Data));
+            }
+        }
+
+        while (UART_Ring_Read(UART1, &u8Data))
+            while (!UART_Ring_Write(UART1, u8Data));
+
+        for (u8Port = UART2; u8Port <= UART4; u8Port++)
+        {
+            while (UART_SC_Ring_Read(u8Port, &u8Data))
+                while (!UART_SC_Ring_Write(u8Port, u8Data));
+        }
+    }
+}
@@ -0,0 +1,9 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Keil is not case sensitive, SFR_Macro_MS51_16K.h includes "Function_define_MS51_16K.h" */
+#include "../../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/Device/Include/Function_Define_MS51_16K.h"
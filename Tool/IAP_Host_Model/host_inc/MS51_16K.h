@@ -0,0 +1,64 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Host build of the MS51 16K library for iap_host_model, GCC x86-64.                                     */
+/*  The real SFR_Macro_MS51_16K.h and StdDriver headers are used, only the Keil keywords and the SFR are   */
+/*  replaced:                                                                                              */
+/*    code      GCC __seg_gs address space, GS base is the 64 KB code space image of the IAP model, so     */
+/*              (unsigned char code *)u16Addr reads the model flash as MOVC does                           */
+/*    int       short, 16 bit as Keil C51 (expressions are still promoted to 32 bit)                       */
+/*    SFR       each access is a call of Host_SFR_Access, the IAP model runs the IAP command of a write of  */
+/*              IAPTRG.IAPGO at the next SFR access, e.g. EA = BIT_TMP of set_IAPTRG_IAPGO                 */
+/*  Include system headers before this file, they must not see the int define.                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#define xdata
+#define idata
+#define pdata
+#define data
+#define code                    __seg_gs
+#define bit                     unsigned char
+#define reentrant
+#define putchar                 fw_putchar          /* uart_putchar.h prototype differs from stdio.h */
+#define int                     short
+
+/* Function_Define_MS51_16K.h types of Keil width, host sys/types.h has other int32_t */
+#define uint8_t                 fw_uint8_t
+#define uint16_t                fw_uint16_t
+#define uint32_t                fw_uint32_t
+#define int8_t                  fw_int8_t
+#define int16_t                 fw_int16_t
+#define int32_t                 fw_int32_t
+
+#include "../../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/Device/Include/SFR_Macro_MS51_16K.h"
+
+/* No generic pointer memory type on host, all buffers are xdata */
+#undef  GENERIC_PTR_TYPE
+#define GENERIC_PTR_TYPE(p)     PTR_TYPE_XDATA
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SFR used by the IAP sources, index is the SFR address, EA has its own index                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define HOST_SFR_EA             0x100
+#define HOST_SFR_NUM            0x101
+
+unsigned char *Host_SFR_Access(unsigned short u16Index);
+
+#define SFRS                    (*Host_SFR_Access(0x91))
+#define CHPCON                  (*Host_SFR_Access(0x9F))
+#define IAPTRG                  (*Host_SFR_Access(0xA4))
+#define IAPUEN                  (*Host_SFR_Access(0xA5))
+#define IAPAL                   (*Host_SFR_Access(0xA6))
+#define IAPAH                   (*Host_SFR_Access(0xA7))
+#define WDCON                   (*Host_SFR_Access(0xAA))
+#define IAPFD                   (*Host_SFR_Access(0xAE))
+#define IAPCN                   (*Host_SFR_Access(0xAF))
+#define TA                      (*Host_SFR_Access(0xC7))
+#define EA                      (*Host_SFR_Access(HOST_SFR_EA))
@@ -0,0 +1,11 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Keil intrinsic functions, the IAP sources use none of them */
+#define _nop_()
+#define _push_(x)
+#define _pop_(x)
@@ -0,0 +1,935 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Host IAP register model of MS51 16K, runs IAP.c, eeprom.c, eeprom_log.c and
+//                 eeprom_record.c of the library on Linux
+//
+//  Build : make            (GCC x86-64, see Makefile and host_inc/MS51_16K.h)
+//
+//  Usage : iap_host_model [-n count] [-s seed] [-v]
+//
+//  The library sources are compiled against host_inc/MS51_16K.h, only "code" of the constant tables of crc.c
+//  and eeprom_log.c is removed by the Makefile. Each access of CHPCON, IAPUEN, IAPTRG, IAPAL, IAPAH, IAPFD,
+//  IAPCN, WDCON, TA and EA calls Host_SFR_Access, MOVC reads of code space go to the model flash through the
+//  GS segment. SPROM (eeprom_sprom.c) is not modelled, its address arithmetic depends on the 16 bit int of
+//  Keil also in constant expressions.
+//
+//  Model
+//    TA                a write of CHPCON / IAPUEN / IAPTRG / WDCON is kept only right after TA = 0xAA, 0x55
+//    IAPTRG.IAPGO      runs IAPCN at IAPAH:IAPAL, IAPFF of CHPCON is set when IAPEN or the update enable
+//                      bit of IAPUEN is 0, the command is unknown or the address is out of the area
+//    page erase        128 bytes to 0xFF, IAPFD must be 0xFF, MODEL_ERASE_US
+//    byte program      flash byte AND IAPFD, program never sets a bit, MODEL_PROGRAM_US
+//    power lost        at the n-th erase / program of a call the page or byte is left half done (random
+//                      bits) and the call is left by longjmp, then SFR reset and the Init API run again
+//    program fail      the n-th byte program leaves the byte unchanged, the call reads back and goes on
+//
+//  Tests: IAP.c erase / program / verify / burst / LDROM, eeprom.c byte / page / array writes against a
+//  shadow image, eeprom_log.c and eeprom_record.c random writes with reboot, a power lost at each flash
+//  operation of a page transfer / record write (and of the recovery in Init_DATAFLASH_LOG), a program
+//  fail at each byte program. After each call the firmware counters must equal the model counts, EA must
+//  be kept, IAPEN must be cleared and no TA protected write may be lost. Program_IAP_Burst may keep EA = 0
+//  for one byte program only.
+//
+//  Options
+//    -n <count>        random writes of each test, default 2000
+//    -s <seed>         random seed, default 1
+//    -v                print each test
+//***********************************************************************************************************
+#include <asm/prctl.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "MS51_16K.h"
+#undef int
+#undef data
+
+#define APROM_SIZE              0x4000
+#define LDROM_SIZE              0x1000
+#define CODE_SPACE_SIZE         0x10000
+#define MODEL_ERASE_US          5000        /* approximate page erase time, as isp_uart_host */
+#define MODEL_PROGRAM_US        25          /* approximate byte program time, as isp_uart_host */
+
+#define SFR_CHPCON              0x9F
+#define SFR_IAPTRG              0xA4
+#define SFR_IAPUEN              0xA5
+#define SFR_IAPAL               0xA6
+#define SFR_IAPAH               0xA7
+#define SFR_WDCON               0xAA
+#define SFR_IAPFD               0xAE
+#define SFR_IAPCN               0xAF
+#define SFR_TA                  0xC7
+
+/* Library globals not in headers, and symbols of bod.c / common.c not linked */
+extern unsigned char u8LogWriteOffset;
+bit BIT_TMP;
+bit bod_event_flag;
+
+static struct
+{
+    /* code space image, GS base, APROM at 0x0000 */
+    uint8_t  *pu8Code;
+    uint8_t  au8LDROM[LDROM_SIZE];
+    uint8_t  au8Config[8];
+    uint8_t  au8UID[12];
+
+    /* SFR and TA state */
+    uint8_t  au8SFR[HOST_SFR_NUM];
+    unsigned u32Last;
+    uint8_t  u8LastValue;
+    int      i32Pending;
+    int      i32TAStage;
+
+    /* counters since power on */
+    unsigned u32Erase, u32Program, u32IAPFail, u32TAError, u32EraseFD;
+    unsigned long u32TimeUs;
+    unsigned long u32EAOffUs, u32EAOffMaxUs;  /* u32TimeUs at EA = 0, longest flash time with EA = 0 */
+    unsigned au32PageErase[APROM_SIZE / PAGE_SIZE];
+
+    /* fault injection, operation number of erase + program */
+    unsigned u32Op;
+    unsigned u32PowerLostAt;
+    unsigned u32ProgramFailAt;
+    jmp_buf  PowerJmp;
+
+    /* result */
+    unsigned u32Tests, u32Failed;
+    int      i32Verbose;
+} g_iap;
+
+/* Cost of one call, model counts */
+typedef struct
+{
+    unsigned u32Erase, u32Program;
+    unsigned long u32TimeUs;
+} COST_T;
+
+/* Cost sum of one API */
+typedef struct
+{
+    const char *pcName;
+    unsigned u32Calls;
+    unsigned long u32Erase, u32Program, u32TimeUs;
+} API_COST_T;
+
+static API_COST_T g_cost[] =
+{
+    { "Write_DATAFLASH_BYTE" },
+    { "WriteDataToOnePage" },
+    { "Write_DATAFLASH_ARRAY" },
+    { "Write_DATAFLASH_LOG" },
+    { "Write_DATAFLASH_RECORD" },
+};
+
+enum { COST_BYTE, COST_PAGE, COST_ARRAY, COST_LOG, COST_RECORD };
+
+/* Call_End checks without cost, library counters of IAP.c or of eeprom_log.c */
+#define CALL_IAP                (-1)
+#define CALL_LOG                (-2)
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  IAP model                                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Model_Fail(void)
+{
+    g_iap.au8SFR[SFR_CHPCON] |= 0x40;           /* IAPFF */
+    g_iap.u32IAPFail++;
+}
+
+static void Model_Power_Lost(void)
+{
+    longjmp(g_iap.PowerJmp, 1);
+}
+
+static void Model_Erase(uint8_t *pu8Area, unsigned u32Size, unsigned u32Addr, uint8_t u8Enable)
+{
+    unsigned u32Page, i;
+
+    if (!(g_iap.au8SFR[SFR_IAPUEN] & u8Enable) || (u32Addr >= u32Size))
+    {
+        Model_Fail();
+        return;
+    }
+    if (g_iap.au8SFR[SFR_IAPFD] != 0xFF)
+        g_iap.u32EraseFD++;
+
+    u32Page = u32Addr & ~(PAGE_SIZE - 1);
+    g_iap.u32Erase++;
+    g_iap.u32TimeUs += MODEL_ERASE_US;
+    if (pu8Area == g_iap.pu8Code)
+        g_iap.au32PageErase[u32Page / PAGE_SIZE]++;
+
+    if (++g_iap.u32Op == g_iap.u32PowerLostAt)
+    {
+        for (i = 0; i < PAGE_SIZE; i++)
+            pu8Area[u32Page + i] |= (uint8_t)rand();
+        Model_Power_Lost();
+    }
+    memset(pu8Area + u32Page, 0xFF, PAGE_SIZE);
+}
+
+static void Model_Program(uint8_t *pu8Area, unsigned u32Size, unsigned u32Addr, uint8_t u8Enable)
+{
+    if (!(g_iap.au8SFR[SFR_IAPUEN] & u8Enable) || (u32Addr >= u32Size))
+    {
+        Model_Fail();
+        return;
+    }
+
+    g_iap.u32Program++;
+    g_iap.u32TimeUs += MODEL_PROGRAM_US;
+
+    if (++g_iap.u32Op == g_iap.u32PowerLostAt)
+    {
+        pu8Area[u32Addr] &= g_iap.au8SFR[SFR_IAPFD] | (uint8_t)rand();
+        Model_Power_Lost();
+    }
+    if (g_iap.u32Op == g_iap.u32ProgramFailAt)
+        return;
+    pu8Area[u32Addr] &= g_iap.au8SFR[SFR_IAPFD];
+}
+
+static void Model_Read(const uint8_t *pu8Area, unsigned u32Size, unsigned u32Addr)
+{
+    if (u32Addr >= u32Size)
+    {
+        Model_Fail();
+        return;
+    }
+    g_iap.au8SFR[SFR_IAPFD] = pu8Area[u32Addr];
+}
+
+static void Model_IAP_Go(void)
+{
+    unsigned u32Addr = (g_iap.au8SFR[SFR_IAPAH] << 8) | g_iap.au8SFR[SFR_IAPAL];
+
+    if (!(g_iap.au8SFR[SFR_CHPCON] & 0x01))
+    {
+        Model_Fail();
+        return;
+    }
+
+    switch (g_iap.au8SFR[SFR_IAPCN])
+    {
+        case BYTE_READ_APROM:       Model_Read(g_iap.pu8Code, APROM_SIZE, u32Addr); break;
+        case BYTE_PROGRAM_APROM:    Model_Program(g_iap.pu8Code, APROM_SIZE, u32Addr, 0x01); break;
+        case PAGE_ERASE_APROM:      Model_Erase(g_iap.pu8Code, APROM_SIZE, u32Addr, 0x01); break;
+        case BYTE_READ_LDROM:       Model_Read(g_iap.au8LDROM, LDROM_SIZE, u32Addr); break;
+        case BYTE_PROGRAM_LDROM:    Model_Program(g_iap.au8LDROM, LDROM_SIZE, u32Addr, 0x02); break;
+        case PAGE_ERASE_LDROM:      Model_Erase(g_iap.au8LDROM, LDROM_SIZE, u32Addr, 0x02); break;
+        case BYTE_READ_CONFIG:      Model_Read(g_iap.au8Config, sizeof(g_iap.au8Config), u32Addr); break;
+        case READ_UID:              Model_Read(g_iap.au8UID, sizeof(g_iap.au8UID), u32Addr); break;
+        default:                    Model_Fail(); break;
+    }
+}
+
+/* Finish the previous SFR access, the write is known only at the next access */
+static void Model_SFR_Commit(void)
+{
+    unsigned u32Addr;
+    int i32Open;
+
+    if (!g_iap.i32Pending)
+        return;
+    g_iap.i32Pending = 0;
+    u32Addr = g_iap.u32Last;
+
+    if (u32Addr == SFR_TA)
+    {
+        if (g_iap.au8SFR[SFR_TA] == 0xAA)
+            g_iap.i32TAStage = 1;
+        else if ((g_iap.au8SFR[SFR_TA] == 0x55) && (g_iap.i32TAStage == 1))
+            g_iap.i32TAStage = 2;
+        else
+            g_iap.i32TAStage = 0;
+        return;
+    }
+
+    i32Open = (g_iap.i32TAStage == 2);
+    g_iap.i32TAStage = 0;
+
+    if (g_iap.au8SFR[u32Addr] == g_iap.u8LastValue)
+        return;
+
+    if (u32Addr == HOST_SFR_EA)
+    {
+        if (g_iap.au8SFR[HOST_SFR_EA] == 0)
+            g_iap.u32EAOffUs = g_iap.u32TimeUs;
+        else if (g_iap.u32TimeUs - g_iap.u32EAOffUs > g_iap.u32EAOffMaxUs)
+            g_iap.u32EAOffMaxUs = g_iap.u32TimeUs - g_iap.u32EAOffUs;
+        return;
+    }
+
+    if (((u32Addr == SFR_CHPCON) || (u32Addr == SFR_IAPUEN) || (u32Addr == SFR_IAPTRG) || (u32Addr == SFR_WDCON))
+            && !i32Open)
+    {
+        g_iap.au8SFR[u32Addr] = g_iap.u8LastValue;
+        g_iap.u32TAError++;
+        return;
+    }
+
+    if ((u32Addr == SFR_IAPTRG) && (g_iap.au8SFR[SFR_IAPTRG] & 0x01))
+    {
+        g_iap.au8SFR[SFR_IAPTRG] &= 0xFE;
+        Model_IAP_Go();
+    }
+    if (u32Addr == SFR_WDCON)
+        g_iap.au8SFR[SFR_WDCON] &= 0xBF;        /* WDCLR cleared by hardware */
+}
+
+unsigned char *Host_SFR_Access(unsigned short u16Index)
+{
+    Model_SFR_Commit();
+    g_iap.u32Last = u16Index;
+    g_iap.u8LastValue = g_iap.au8SFR[u16Index];
+    g_iap.i32Pending = 1;
+    return &g_iap.au8SFR[u16Index];
+}
+
+/* Reset of SFR and fault injection, flash kept */
+static void Model_Power_On(void)
+{
+    memset(g_iap.au8SFR, 0, sizeof(g_iap.au8SFR));
+    g_iap.i32Pending = 0;
+    g_iap.i32TAStage = 0;
+    g_iap.u32PowerLostAt = 0;
+    g_iap.u32ProgramFailAt = 0;
+    bod_event_flag = 0;
+}
+
+static void Model_Init(void)
+{
+    unsigned i;
+
+    g_iap.pu8Code = aligned_alloc(CODE_SPACE_SIZE, CODE_SPACE_SIZE);
+    if ((g_iap.pu8Code == NULL) || (syscall(SYS_arch_prctl, ARCH_SET_GS, (unsigned long)g_iap.pu8Code) != 0))
+    {
+        perror("code space");
+        exit(2);
+    }
+    memset(g_iap.pu8Code, 0xFF, CODE_SPACE_SIZE);
+    memset(g_iap.au8LDROM, 0xFF, sizeof(g_iap.au8LDROM));
+    memset(g_iap.au8Config, 0xFF, sizeof(g_iap.au8Config));
+    for (i = 0; i < sizeof(g_iap.au8UID); i++)
+        g_iap.au8UID[i] = (uint8_t)(0x30 + i);
+    Model_Power_On();
+}
+
+static void Model_Blank(void)
+{
+    memset(g_iap.pu8Code, 0xFF, APROM_SIZE);
+    memset(g_iap.au8LDROM, 0xFF, sizeof(g_iap.au8LDROM));
+}
+
+/* memcpy_code.A51 on host */
+void memcpy_code_to_xdata(unsigned char *pu8Dst, unsigned char code *pu8Src, unsigned short u16Size)
+{
+    while (u16Size--)
+        *pu8Dst++ = *pu8Src++;
+}
+
+void memcpy_code_to_idata(unsigned char *pu8Dst, unsigned char code *pu8Src, unsigned char u8Size)
+{
+    while (u8Size--)
+        *pu8Dst++ = *pu8Src++;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Test helpers                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Result(const char *pcName, int i32Pass)
+{
+    g_iap.u32Tests++;
+    if (!i32Pass)
+    {
+        g_iap.u32Failed++;
+        printf("  FAIL %s\n", pcName);
+    }
+    else if (g_iap.i32Verbose)
+    {
+        printf("  pass %s\n", pcName);
+    }
+}
+
+/* Start of an API call, application runs with EA = 1 */
+static void Call_Begin(COST_T *pCost)
+{
+    g_iap.au8SFR[HOST_SFR_EA] = 1;
+    pCost->u32Erase = g_iap.u32Erase;
+    pCost->u32Program = g_iap.u32Program;
+    pCost->u32TimeUs = g_iap.u32TimeUs;
+    u16IAPEraseCount = 0;
+    u16IAPProgramCount = 0;
+    u16LogEraseCount = 0;
+    u16LogProgramCount = 0;
+}
+
+/* End of an API call, cost of the call and library state checks, return 0 when a check fails */
+static int Call_End(COST_T *pCost, int i32Api)
+{
+    int i32Pass, i32Log = (i32Api == COST_LOG) || (i32Api == CALL_LOG);
+
+    Model_SFR_Commit();
+    pCost->u32Erase = g_iap.u32Erase - pCost->u32Erase;
+    pCost->u32Program = g_iap.u32Program - pCost->u32Program;
+    pCost->u32TimeUs = g_iap.u32TimeUs - pCost->u32TimeUs;
+
+    if (i32Api >= 0)
+    {
+        g_cost[i32Api].u32Calls++;
+        g_cost[i32Api].u32Erase += pCost->u32Erase;
+        g_cost[i32Api].u32Program += pCost->u32Program;
+        g_cost[i32Api].u32TimeUs += pCost->u32TimeUs;
+    }
+
+    i32Pass = (g_iap.au8SFR[HOST_SFR_EA] == 1) && !(g_iap.au8SFR[SFR_CHPCON] & 0x01)
+              && (g_iap.u32TAError == 0) && (g_iap.u32EraseFD == 0);
+    if (i32Log)
+        i32Pass = i32Pass && (u16LogEraseCount == pCost->u32Erase) && (u16LogProgramCount == pCost->u32Program);
+    else
+        i32Pass = i32Pass && (u16IAPEraseCount == pCost->u32Erase) && (u16IAPProgramCount == pCost->u32Program);
+
+    if (!i32Pass)
+    {
+        printf("  EA %u CHPCON %02X TA error %u erase IAPFD error %u, erase %u/%u program %u/%u (library/model)\n",
+               g_iap.au8SFR[HOST_SFR_EA], g_iap.au8SFR[SFR_CHPCON], g_iap.u32TAError, g_iap.u32EraseFD,
+               i32Log ? u16LogEraseCount : u16IAPEraseCount, pCost->u32Erase,
+               i32Log ? u16LogProgramCount : u16IAPProgramCount, pCost->u32Program);
+        g_iap.u32TAError = 0;
+        g_iap.u32EraseFD = 0;
+    }
+    return i32Pass;
+}
+
+static void Random_Fill(uint8_t *pu8Buf, unsigned u32Len)
+{
+    while (u32Len--)
+        *pu8Buf++ = (uint8_t)rand();
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  IAP.c                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Test_IAP(void)
+{
+    uint8_t au8A[PAGE_SIZE], au8B[PAGE_SIZE], au8Burst[300];
+    COST_T cost;
+    unsigned i, u32Fail;
+    int i32Ok;
+    uint8_t u8Result;
+
+    printf("IAP.c\n");
+    Model_Blank();
+
+    Call_Begin(&cost);
+    Erase_APROM(0x3000, 0x400);
+    i32Ok = Call_End(&cost, CALL_IAP);
+    Result("Erase_APROM 8 pages", i32Ok && (cost.u32Erase == 8) && (cost.u32Program == 0));
+    Result("Erase_Verify_APROM blank", Erase_Verify_APROM(0x3000, 0x400) == PASS);
+
+    Random_Fill(au8A, PAGE_SIZE);
+    memcpy(IAPDataBuf, au8A, PAGE_SIZE);
+    Call_Begin(&cost);
+    Program_APROM(0x3000, PAGE_SIZE);
+    i32Ok = Call_End(&cost, CALL_IAP);
+    Result("Program_APROM 128 bytes", i32Ok && (cost.u32Program == PAGE_SIZE)
+           && (memcmp(g_iap.pu8Code + 0x3000, au8A, PAGE_SIZE) == 0));
+    Result("Program_Verify_APROM", Program_Verify_APROM(0x3000, PAGE_SIZE) == PASS);
+    Result("CRC16_APROM", CRC16_APROM(CRC16_INIT, 0x3000, PAGE_SIZE) == CRC16_Buffer(CRC16_INIT, au8A, PAGE_SIZE));
+
+    /* program without erase only clears bits */
+    Random_Fill(au8B, PAGE_SIZE);
+    memcpy(IAPDataBuf, au8B, PAGE_SIZE);
+    Program_APROM(0x3000, PAGE_SIZE);
+    for (i = 0; i < PAGE_SIZE; i++)
+        au8A[i] &= au8B[i];
+    Result("program over data clears bits only", memcmp(g_iap.pu8Code + 0x3000, au8A, PAGE_SIZE) == 0);
+    for (u32Fail = 0; (u32Fail < PAGE_SIZE) && (au8A[u32Fail] == au8B[u32Fail]); u32Fail++)
+        ;
+    u8Result = Program_Verify_APROM(0x3000, PAGE_SIZE);
+    Result("Program_Verify_APROM mismatch address", (u8Result == IAP_VERIFY_MISMATCH) && (u16IAPFailAddress == 0x3000 + u32Fail));
+    u8Result = Erase_Verify_APROM(0x3000, 0x400);
+    Result("Erase_Verify_APROM not blank", (u8Result == IAP_VERIFY_NOT_BLANK) && (u16IAPFailAddress == 0x3000));
+
+    /* burst over page boundary */
+    Erase_APROM(0x3000, 0x400);
+    Random_Fill(au8Burst, sizeof(au8Burst));
+    Call_Begin(&cost);
+    g_iap.u32EAOffMaxUs = 0;
+    u8Result = Program_IAP_Burst(IAP_REGION_APROM, 0x3050, au8Burst, sizeof(au8Burst));
+    i32Ok = Call_End(&cost, CALL_IAP);
+    Result("Program_IAP_Burst 300 bytes over 3 pages", i32Ok && (u8Result == PASS) && (cost.u32Program == sizeof(au8Burst))
+           && (memcmp(g_iap.pu8Code + 0x3050, au8Burst, sizeof(au8Burst)) == 0));
+    Result("Program_IAP_Burst EA = 0 for one byte program only", g_iap.u32EAOffMaxUs == MODEL_PROGRAM_US);
+
+    g_iap.u32IAPFail = 0;
+    Erase_APROM(0x3F80, PAGE_SIZE);
+    u8Result = Program_IAP_Burst(IAP_REGION_APROM, 0x3FC0, au8Burst, PAGE_SIZE);
+    Model_SFR_Commit();
+    Result("Program_IAP_Burst over APROM end sets IAPFF", (u8Result == FAIL) && (g_iap.u32IAPFail == 64)
+           && !(g_iap.au8SFR[SFR_CHPCON] & 0x40));
+
+    /* LDROM */
+    Call_Begin(&cost);
+    Erase_LDROM(0x0000, LDROM_SIZE);
+    i32Ok = Call_End(&cost, CALL_IAP);
+    Result("Erase_LDROM 32 pages", i32Ok && (cost.u32Erase == LDROM_SIZE / PAGE_SIZE));
+    Result("Erase_Verify_LDROM", Erase_Verify_LDROM(0x0000, LDROM_SIZE) == PASS);
+    Random_Fill(au8A, PAGE_SIZE);
+    memcpy(IAPDataBuf, au8A, PAGE_SIZE);
+    Call_Begin(&cost);
+    Program_LDROM(0x0200, PAGE_SIZE);
+    i32Ok = Call_End(&cost, CALL_IAP);
+    Result("Program_LDROM", i32Ok && (memcmp(g_iap.au8LDROM + 0x200, au8A, PAGE_SIZE) == 0));
+    Result("Program_Verify_LDROM", Program_Verify_LDROM(0x0200, PAGE_SIZE) == PASS);
+    Result("CRC16_LDROM", CRC16_LDROM(CRC16_INIT, 0x0200, PAGE_SIZE) == CRC16_Buffer(CRC16_INIT, au8A, PAGE_SIZE));
+    Result("APROM not changed by LDROM erase", memcmp(g_iap.pu8Code + 0x3050, au8Burst, 0x30) == 0);
+
+    Read_UID();
+    Result("Read_UID", memcmp(UIDBuffer, g_iap.au8UID, sizeof(g_iap.au8UID)) == 0);
+    Model_SFR_Commit();
+    Result("no TA protected write lost", g_iap.u32TAError == 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  eeprom.c                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#define EEPROM_ADDR             0x3800
+#define EEPROM_SIZE             0x200
+
+static void Test_EEPROM(unsigned u32Count)
+{
+    uint8_t au8Shadow[EEPROM_SIZE], au8Buf[EEPROM_SIZE], au8Old;
+    COST_T cost;
+    unsigned n, u32Addr, u32Len, u32Done, u32Bad = 0, u32BitClear = 0, u32BitClearErase = 0;
+    int i32Ok = 1;
+
+    printf("eeprom.c\n");
+    Model_Blank();
+    memset(au8Shadow, 0xFF, sizeof(au8Shadow));
+
+    for (n = 0; n < u32Count; n++)
+    {
+        u32Addr = rand() % EEPROM_SIZE;
+
+        switch (rand() % 3)
+        {
+            case 0:
+                au8Old = au8Shadow[u32Addr];
+                /* half of the writes only clear bits */
+                au8Buf[0] = (rand() & 1) ? (au8Old & (uint8_t)rand()) : (uint8_t)rand();
+                Call_Begin(&cost);
+                Write_DATAFLASH_BYTE(EEPROM_ADDR + u32Addr, au8Buf[0]);
+                i32Ok &= Call_End(&cost, COST_BYTE);
+                au8Shadow[u32Addr] = au8Buf[0];
+                if ((au8Old & au8Buf[0]) == au8Buf[0])
+                {
+                    u32BitClear++;
+                    u32BitClearErase += cost.u32Erase;
+                }
+                break;
+
+            case 1:
+                u32Len = 1 + rand() % 40;
+                Random_Fill(au8Buf, u32Len);
+                Call_Begin(&cost);
+                u32Done = WriteDataToOnePage(EEPROM_ADDR + u32Addr, au8Buf, u32Len);
+                i32Ok &= Call_End(&cost, COST_PAGE);
+                if (u32Len > PAGE_SIZE - (u32Addr % PAGE_SIZE))
+                    u32Len = PAGE_SIZE - (u32Addr % PAGE_SIZE);
+                if (u32Done != u32Len)
+                    u32Bad++;
+                memcpy(au8Shadow + u32Addr, au8Buf, u32Len);
+                break;
+
+            default:
+                u32Len = 1 + rand() % 300;
+                if (u32Addr + u32Len > EEPROM_SIZE)
+                    u32Len = EEPROM_SIZE - u32Addr;
+                Random_Fill(au8Buf, u32Len);
+                Call_Begin(&cost);
+                Write_DATAFLASH_ARRAY(EEPROM_ADDR + u32Addr, au8Buf, u32Len);
+                i32Ok &= Call_End(&cost, COST_ARRAY);
+                memcpy(au8Shadow + u32Addr, au8Buf, u32Len);
+                break;
+        }
+
+        if (memcmp(g_iap.pu8Code + EEPROM_ADDR, au8Shadow, EEPROM_SIZE) != 0)
+            u32Bad++;
+    }
+
+    Result("random byte / page / array writes equal shadow", u32Bad == 0);
+    Result("counters equal model, EA kept, IAPEN cleared", i32Ok);
+    Result("write only clearing bits has no erase", (u32BitClear > 0) && (u32BitClearErase == 0));
+    Read_DATAFLASH_ARRAY(EEPROM_ADDR, au8Buf, EEPROM_SIZE);
+    Result("Read_DATAFLASH_ARRAY", memcmp(au8Buf, au8Shadow, EEPROM_SIZE) == 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  eeprom_log.c                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint8_t g_au8LogShadow[LOG_KEY_NUM];
+
+static int Log_Check(int i32Key, uint8_t u8Old, uint8_t u8New)
+{
+    int i;
+
+    for (i = 0; i < LOG_KEY_NUM; i++)
+    {
+        if (i == i32Key)
+        {
+            if ((Read_DATAFLASH_LOG(i) != u8Old) && (Read_DATAFLASH_LOG(i) != u8New))
+                return 0;
+        }
+        else if (Read_DATAFLASH_LOG(i) != g_au8LogShadow[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int Log_Write(uint8_t u8Key, uint8_t u8Data)
+{
+    COST_T cost;
+    uint8_t u8Result;
+    int i32Ok;
+
+    Call_Begin(&cost);
+    u8Result = Write_DATAFLASH_LOG(u8Key, u8Data);
+    i32Ok = Call_End(&cost, COST_LOG);
+    if (u8Result == PASS)
+        g_au8LogShadow[u8Key] = u8Data;
+    return i32Ok && (u8Result == PASS);
+}
+
+static void Log_Init(void)
+{
+    COST_T cost;
+
+    Call_Begin(&cost);
+    Init_DATAFLASH_LOG();
+    Call_End(&cost, CALL_LOG);
+}
+
+/* Write with power lost at the n-th flash operation, volatile for longjmp */
+static int Log_Write_Power_Lost(uint8_t u8Key, uint8_t u8Data, unsigned u32At)
+{
+    volatile int i32Lost = 0;
+
+    g_iap.u32Op = 0;
+    g_iap.u32PowerLostAt = u32At;
+    g_iap.au8SFR[HOST_SFR_EA] = 1;
+    if (setjmp(g_iap.PowerJmp) == 0)
+        Write_DATAFLASH_LOG(u8Key, u8Data);
+    else
+        i32Lost = 1;
+    Model_Power_On();
+    return i32Lost;
+}
+
+static int Log_Init_Power_Lost(unsigned u32At)
+{
+    volatile int i32Lost = 0;
+
+    g_iap.u32Op = 0;
+    g_iap.u32PowerLostAt = u32At;
+    if (setjmp(g_iap.PowerJmp) == 0)
+        Init_DATAFLASH_LOG();
+    else
+        i32Lost = 1;
+    Model_Power_On();
+    return i32Lost;
+}
+
+/* Fill the active page until the next write needs a page transfer */
+static uint8_t Log_Fill_Page(void)
+{
+    uint8_t u8Key = 0;
+
+    while (u8LogWriteOffset < PAGE_SIZE)
+    {
+        u8Key = (uint8_t)(rand() % LOG_KEY_NUM);
+        Log_Write(u8Key, (uint8_t)(g_au8LogShadow[u8Key] + 1));
+    }
+    return u8Key;
+}
+
+static void Test_Log(unsigned u32Count)
+{
+    uint8_t au8Snap[2 * PAGE_SIZE], au8Torn[2 * PAGE_SIZE], au8Shadow[LOG_KEY_NUM];
+    uint8_t u8Key, u8Old, u8New;
+    unsigned n, k, j, u32Lost = 0, u32Bad = 0, u32Recovery = 0, u32Fail = 0;
+    int i32Ok = 1;
+
+    printf("eeprom_log.c\n");
+    Model_Blank();
+    memset(g_au8LogShadow, 0xFF, sizeof(g_au8LogShadow));
+    Log_Init();
+    Result("Init_DATAFLASH_LOG formats blank area", (g_iap.pu8Code[LOG_PAGE0_ADDR] == LOG_PAGE_ACTIVE));
+
+    for (n = 0; n < u32Count; n++)
+    {
+        u8Key = (uint8_t)(rand() % LOG_KEY_NUM);
+        i32Ok &= Log_Write(u8Key, (uint8_t)rand());
+        if (Read_DATAFLASH_LOG(u8Key) != g_au8LogShadow[u8Key])
+            u32Bad++;
+        if ((n % 97) == 0)
+        {
+            Log_Init();
+            if (!Log_Check(-1, 0, 0))
+                u32Bad++;
+        }
+    }
+    Result("random writes, read back and after reboot", u32Bad == 0);
+    Result("counters equal model, EA kept, IAPEN cleared", i32Ok);
+
+    /* power lost at each erase / program of a write with page transfer, and of the recovery after it */
+    Log_Fill_Page();
+    memcpy(au8Snap, g_iap.pu8Code + LOG_PAGE0_ADDR, sizeof(au8Snap));
+    memcpy(au8Shadow, g_au8LogShadow, sizeof(au8Shadow));
+    u8Key = (uint8_t)(rand() % LOG_KEY_NUM);
+    u8Old = g_au8LogShadow[u8Key];
+    u8New = (uint8_t)(u8Old ^ 0xA5);
+
+    for (u32Bad = 0, k = 1; ; k++)
+    {
+        memcpy(g_iap.pu8Code + LOG_PAGE0_ADDR, au8Snap, sizeof(au8Snap));
+        memcpy(g_au8LogShadow, au8Shadow, sizeof(au8Shadow));
+        Init_DATAFLASH_LOG();
+        if (!Log_Write_Power_Lost(u8Key, u8New, k))
+            break;
+        u32Lost++;
+        memcpy(au8Torn, g_iap.pu8Code + LOG_PAGE0_ADDR, sizeof(au8Torn));
+
+        for (j = 1; Log_Init_Power_Lost(j); j++)
+        {
+            u32Recovery++;
+            Init_DATAFLASH_LOG();
+            if (!Log_Check(u8Key, u8Old, u8New))
+                u32Bad++;
+            memcpy(g_iap.pu8Code + LOG_PAGE0_ADDR, au8Torn, sizeof(au8Torn));
+        }
+        Init_DATAFLASH_LOG();
+        if (!Log_Check(u8Key, u8Old, u8New))
+            u32Bad++;
+        if (!Log_Write(u8Key, u8New) || !Log_Check(u8Key, u8New, u8New))
+            u32Bad++;
+    }
+    if (g_iap.i32Verbose)
+        printf("  %u power lost points in write with page transfer, %u in recovery\n", u32Lost, u32Recovery);
+    Result("power lost in page transfer keeps every key", (u32Lost > LOG_KEY_NUM) && (u32Bad == 0));
+
+    /* program fail at each byte program of a write with page transfer, no reboot */
+    for (u32Bad = 0, k = 1; ; k++)
+    {
+        memcpy(g_iap.pu8Code + LOG_PAGE0_ADDR, au8Snap, sizeof(au8Snap));
+        memcpy(g_au8LogShadow, au8Shadow, sizeof(au8Shadow));
+        Init_DATAFLASH_LOG();
+        g_iap.u32Op = 0;
+        g_iap.u32ProgramFailAt = k;
+        Log_Write(u8Key, u8New);
+        if (g_iap.u32Op < k)
+            break;
+        g_iap.u32ProgramFailAt = 0;
+        if (g_au8LogShadow[u8Key] != u8New)
+            u32Fail++;
+        if (!Log_Check(-1, 0, 0))
+            u32Bad++;
+        if (!Log_Write(u8Key, u8New) || !Log_Check(-1, 0, 0))
+            u32Bad++;
+        Init_DATAFLASH_LOG();
+        if (!Log_Check(-1, 0, 0))
+            u32Bad++;
+    }
+    g_iap.u32ProgramFailAt = 0;
+    if (g_iap.i32Verbose)
+        printf("  %u program fail points, %u writes returned FAIL\n", k - 1, u32Fail);
+    Result("program fail keeps every key, next write and reboot", (u32Fail > 0) && (u32Bad == 0));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  eeprom_record.c                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+static int Record_Read_Is(const uint8_t *pu8Expect)
+{
+    uint8_t au8Buf[REC_DATA_SIZE];
+
+    if (Init_DATAFLASH_RECORD() != PASS)
+        return pu8Expect == NULL;
+    if (pu8Expect == NULL)
+        return 0;
+    Read_DATAFLASH_RECORD(au8Buf);
+    return memcmp(au8Buf, pu8Expect, REC_DATA_SIZE) == 0;
+}
+
+static int Record_Write_Power_Lost(const uint8_t *pu8Data, unsigned u32At)
+{
+    volatile int i32Lost = 0;
+
+    g_iap.u32Op = 0;
+    g_iap.u32PowerLostAt = u32At;
+    g_iap.au8SFR[HOST_SFR_EA] = 1;
+    if (setjmp(g_iap.PowerJmp) == 0)
+        Write_DATAFLASH_RECORD(pu8Data);
+    else
+        i32Lost = 1;
+    Model_Power_On();
+    return i32Lost;
+}
+
+static void Test_Record(unsigned u32Count)
+{
+    uint8_t au8Old[REC_DATA_SIZE], au8New[REC_DATA_SIZE], au8Snap[2 * PAGE_SIZE];
+    COST_T cost;
+    unsigned n, k, u32Lost = 0, u32Bad = 0, u32Fail = 0;
+    uint8_t u8Result;
+    int i32Ok = 1, i32HasOld;
+
+    printf("eeprom_record.c\n");
+    Model_Blank();
+    Result("Init_DATAFLASH_RECORD blank area has no record", Init_DATAFLASH_RECORD() == FAIL);
+    u16RecordSequence = 0xFFF0;                 /* first writes run over the 16 bit sequence wrap */
+
+    for (n = 0; n < u32Count; n++)
+    {
+        Random_Fill(au8New, REC_DATA_SIZE);
+        Call_Begin(&cost);
+        u8Result = Write_DATAFLASH_RECORD(au8New);
+        i32Ok &= Call_End(&cost, COST_RECORD);
+        if ((u8Result != PASS) || !Record_Read_Is(au8New))
+            u32Bad++;
+    }
+    Result("random writes, read after reboot, sequence wrap", u32Bad == 0);
+    Result("counters equal model, EA kept, IAPEN cleared", i32Ok);
+
+    bod_event_flag = 1;
+    Call_Begin(&cost);
+    u8Result = Write_DATAFLASH_RECORD(au8New);
+    Call_End(&cost, CALL_IAP);
+    bod_event_flag = 0;
+    Result("REC_ERR_BOD and no flash operation under BOD", (u8Result == REC_ERR_BOD) && (cost.u32Erase + cost.u32Program == 0));
+
+    /* power lost at each operation of 2 * REC_SLOT_NUM + 1 writes, page erase included */
+    for (u32Bad = 0, n = 0; n < 2 * REC_SLOT_NUM + 1; n++)
+    {
+        i32HasOld = (Init_DATAFLASH_RECORD() == PASS);
+        if (i32HasOld)
+            Read_DATAFLASH_RECORD(au8Old);
+        memcpy(au8Snap, g_iap.pu8Code + REC_PAGE0_ADDR, sizeof(au8Snap));
+        Random_Fill(au8New, REC_DATA_SIZE);
+
+        for (k = 1; ; k++)
+        {
+            memcpy(g_iap.pu8Code + REC_PAGE0_ADDR, au8Snap, sizeof(au8Snap));
+            Init_DATAFLASH_RECORD();
+            if (!Record_Write_Power_Lost(au8New, k))
+                break;
+            u32Lost++;
+            if (!Record_Read_Is(i32HasOld ? au8Old : NULL) && !Record_Read_Is(au8New))
+                u32Bad++;
+            /* next write after the torn one */
+            Write_DATAFLASH_RECORD(au8New);
+            if (!Record_Read_Is(au8New))
+                u32Bad++;
+        }
+    }
+    if (g_iap.i32Verbose)
+        printf("  %u power lost points\n", u32Lost);
+    Result("power lost keeps previous or new record", u32Bad == 0);
+
+    /* program fail at each byte program of a write, retry in next slot */
+    Init_DATAFLASH_RECORD();
+    Read_DATAFLASH_RECORD(au8Old);
+    memcpy(au8Snap, g_iap.pu8Code + REC_PAGE0_ADDR, sizeof(au8Snap));
+    Random_Fill(au8New, REC_DATA_SIZE);
+    for (u32Bad = 0, k = 1; ; k++)
+    {
+        memcpy(g_iap.pu8Code + REC_PAGE0_ADDR, au8Snap, sizeof(au8Snap));
+        Init_DATAFLASH_RECORD();
+        g_iap.u32Op = 0;
+        g_iap.u32ProgramFailAt = k;
+        u8Result = Write_DATAFLASH_RECORD(au8New);
+        g_iap.u32ProgramFailAt = 0;
+        if (g_iap.u32Op < k)
+            break;
+        if (u8Result != PASS)
+            u32Fail++;
+        if (!Record_Read_Is((u8Result == PASS) ? au8New : au8Old))
+            u32Bad++;
+    }
+    if (g_iap.i32Verbose)
+        printf("  %u program fail points, %u writes returned FAIL\n", k - 1, u32Fail);
+    Result("program fail retried in next slot", (u32Fail == 0) && (u32Bad == 0));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+static void Print_Cost(void)
+{
+    unsigned i, u32Max = 0;
+    API_COST_T *p;
+
+    printf("API cost per call, model counts\n");
+    printf("  %-24s %8s %8s %10s %10s\n", "", "calls", "erase", "program", "time us");
+    for (i = 0; i < sizeof(g_cost) / sizeof(g_cost[0]); i++)
+    {
+        p = &g_cost[i];
+        if (p->u32Calls == 0)
+            continue;
+        printf("  %-24s %8u %8.3f %10.2f %10.0f\n", p->pcName, p->u32Calls, (double)p->u32Erase / p->u32Calls,
+               (double)p->u32Program / p->u32Calls, (double)p->u32TimeUs / p->u32Calls);
+    }
+    for (i = 0; i < APROM_SIZE / PAGE_SIZE; i++)
+    {
+        if (g_iap.au32PageErase[i] > g_iap.au32PageErase[u32Max])
+            u32Max = i;
+    }
+    printf("  most erased page 0x%04X: %u erases\n", u32Max * PAGE_SIZE, g_iap.au32PageErase[u32Max]);
+}
+
+static void Usage(void)
+{
+    fprintf(stderr, "usage: iap_host_model [-n count] [-s seed] [-v]\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned u32Count = 2000, u32Seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': u32Count = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': u32Seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'v': g_iap.i32Verbose = 1; break;
+            default: Usage();
+        }
+    }
+    if ((optind != argc) || (u32Count == 0))
+        Usage();
+
+    srand(u32Seed);
+    Model_Init();
+
+    Test_IAP();
+    Test_EEPROM(u32Count);
+    Test_Log(u32Count);
+    Test_Record(u32Count);
+    Print_Cost();
+
+    printf("result: %u tests, %u failed\n", g_iap.u32Tests, g_iap.u32Failed);
+
+    return g_iap.u32Failed ? 1 : 0;
+}
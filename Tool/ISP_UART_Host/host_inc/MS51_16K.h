@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Host build of ISP_UART0 of MS51 16K for the simulated device of isp_uart_host, GCC C++ x86-64.         */
+/*  isp_uart0.c, main_autosize_wdtdis.c and lz_decode.c are compiled as C++ against this file and the real */
+/*  SFR_Macro_MS51_16K.h, only the Keil keywords and the SFR are replaced:                                 */
+/*    code      removed, ISP reads APROM by IAP only                                                       */
+/*    int       short, 16 bit as Keil C51 (expressions are still promoted to 32 bit)                       */
+/*    SFR/sbit  a HOST_SFR object, each read, write or read-modify-write is one call of isp_device.cpp, so  */
+/*              SBUF = x starts the transmit and IAPTRG |= 0x01 runs the IAP command at once, and an       */
+/*              interrupt is taken only between two accesses, never inside of IAPTRG |= 0x01              */
+/*    interrupt removed from Serial_ISR and Timer0_ISR by the Makefile, isp_device.cpp calls them          */
+/*  Include system headers before this file, they must not see the int define.                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#define HOST_SBIT(sfr, b)       (0x100 | (sfr) | (b))   /* index of an sbit, 8051 bit address + 0x100 */
+
+unsigned char Host_SFR_Read(unsigned short u16Index);
+void Host_SFR_Modify(unsigned short u16Index, unsigned char u8And, unsigned char u8Or);
+
+class HOST_SFR
+{
+public:
+    explicit HOST_SFR(unsigned short u16Index) : m_u16Index(u16Index) {}
+    operator unsigned char() const                  { return Host_SFR_Read(m_u16Index); }
+    HOST_SFR &operator=(unsigned char u8Value)      { Host_SFR_Modify(m_u16Index, 0x00, u8Value); return *this; }
+    HOST_SFR &operator=(const HOST_SFR &Sfr)        { return *this = (unsigned char)Sfr; }   /* TH0=TL0=0 */
+    HOST_SFR &operator|=(unsigned char u8Value)     { Host_SFR_Modify(m_u16Index, 0xFF, u8Value); return *this; }
+    HOST_SFR &operator&=(unsigned char u8Value)     { Host_SFR_Modify(m_u16Index, u8Value, 0x00); return *this; }
+
+private:
+    unsigned short m_u16Index;
+};
+
+#define xdata
+#define idata
+#define pdata
+#define data
+#define code
+#define bit                     unsigned char
+#define reentrant
+#define putchar                 fw_putchar          /* uart_putchar.h prototype differs from stdio.h */
+#define int                     short
+
+/* Function_Define_MS51_16K.h types of Keil width, host sys/types.h has other int32_t */
+#define uint8_t                 fw_uint8_t
+#define uint16_t                fw_uint16_t
+#define uint32_t                fw_uint32_t
+#define int8_t                  fw_int8_t
+#define int16_t                 fw_int16_t
+#define int32_t                 fw_int32_t
+
+#include "../../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/Device/Include/SFR_Macro_MS51_16K.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SFR and sbit used by ISP_UART0                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+#define P0                      HOST_SFR(0x80)
+#define RCTRIM0                 HOST_SFR(0x84)
+#define RCTRIM1                 HOST_SFR(0x85)
+#define PCON                    HOST_SFR(0x87)
+#define TCON                    HOST_SFR(0x88)
+#define TMOD                    HOST_SFR(0x89)
+#define TL0                     HOST_SFR(0x8A)
+#define TH0                     HOST_SFR(0x8C)
+#define CKCON                   HOST_SFR(0x8E)
+#define SFRS                    HOST_SFR(0x91)
+#define SCON                    HOST_SFR(0x98)
+#define SBUF                    HOST_SFR(0x99)
+#define CHPCON                  HOST_SFR(0x9F)
+#define IAPTRG                  HOST_SFR(0xA4)
+#define IAPUEN                  HOST_SFR(0xA5)
+#define IAPAL                   HOST_SFR(0xA6)
+#define IAPAH                   HOST_SFR(0xA7)
+#define IE                      HOST_SFR(0xA8)
+#define WDCON                   HOST_SFR(0xAA)
+#define IAPFD                   HOST_SFR(0xAE)
+#define IAPCN                   HOST_SFR(0xAF)
+#define P0M1                    HOST_SFR(0xB1)
+#define P0M2                    HOST_SFR(0xB2)
+#define IPH                     HOST_SFR(0xB7)
+#define T3CON                   HOST_SFR(0xC4)
+#define RL3                     HOST_SFR(0xC5)
+#define RH3                     HOST_SFR(0xC6)
+#define TA                      HOST_SFR(0xC7)
+
+#define P07                     HOST_SFR(HOST_SBIT(0x80, 7))
+#define TR0                     HOST_SFR(HOST_SBIT(0x88, 4))
+#define TF0                     HOST_SFR(HOST_SBIT(0x88, 5))
+#define RI                      HOST_SFR(HOST_SBIT(0x98, 0))
+#define TI                      HOST_SFR(HOST_SBIT(0x98, 1))
+#define ET0                     HOST_SFR(HOST_SBIT(0xA8, 1))
+#define ES                      HOST_SFR(HOST_SBIT(0xA8, 4))
+#define EA                      HOST_SFR(HOST_SBIT(0xA8, 7))
@@ -0,0 +1,811 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Simulated MS51 16K of isp_uart_host -s, runs the ISP_UART0 firmware on an SFR model
+//
+//  Build : make            (GCC, see Makefile and host_inc/MS51_16K.h)
+//
+//  isp_uart0.c, main_autosize_wdtdis.c and lz_decode.c of the 16K library are compiled as C++ against
+//  host_inc/MS51_16K.h, the Makefile only removes "interrupt n" of the ISR and renames main to ISP_Main.
+//  Each SFR access is a call of Host_SFR_Read or Host_SFR_Modify. ISP_Main runs in the device process
+//  forked by isp_uart_host, UART0 is the pty master.
+//
+//  Model
+//    Fsys              24 MHz. Until SCON.REN the device time is ACCESS_NS per SFR access and never ahead of
+//                      CLOCK_MONOTONIC, so Autobaud_Detect sees the RXD edges at the bit times also when the
+//                      host stops the device process for a while. Then the time is CLOCK_MONOTONIC
+//    interrupt         Serial_ISR (RI / TI and ES) and Timer0_ISR (TF0 and ET0) when EA is 1. Taken after an
+//                      SFR access of main, and by a TICK_US SIGALRM when main is between two SFR accesses,
+//                      e.g. in while(bUartTxBusy). An ISR is not interrupted, IP / IPH are not modelled
+//    Timer0            mode 0 / 1 of TMOD, Fsys / 12 or Fsys by CKCON.T0M, TF0 at overflow
+//    RXD P07           while SCON.REN is 0 each host byte is a waveform (start bit, 8 data bits LSB first,
+//                      stop bit) at the host baud rate for Autobaud_Detect, back to back as written by the
+//                      host, and the UART does not receive it
+//    UART0 receive     with SCON.REN a host byte is put in SBUF and RI is set when RI is 0, no overrun
+//    UART0 transmit    TI is set 10 bit times after a write of SBUF at the device baud rate. The tick is moved
+//                      to the end of the byte, so a reply goes out at the baud rate also while main idles
+//                      between two SFR accesses. The bytes are written to the host by 64, one reply, as a
+//                      pty write per byte takes about one byte time of 1500000 baud from main
+//    baud rate         Timer3 reload RH3:RL3 and prescale, PCON.SMOD. A byte is received or sent as ~byte
+//                      when device and host baud rate (tcgetattr of the pty) differ more than 3 %
+//    TA                a write of CHPCON / IAPUEN / IAPTRG / WDCON / RCTRIM0 / RCTRIM1 is kept only right
+//                      after TA = 0xAA, 0x55. SFRS is written without TA by the library, it is not checked
+//    IAPTRG.IAPGO      runs IAPCN at IAPAH:IAPAL: APROM byte read / byte program (AND) / page erase, CONFIG
+//                      byte read / program / erase, DID, UID (0xFF). CHPCON.IAPFF is set when IAPEN or the
+//                      update enable bit of IAPUEN is 0, the address is out of flash or the command unknown
+//    CHPCON.SWRST      software reset, the device runs APROM and ignores the host
+//    timing            -t of isp_uart_host: 10 bit times per received byte, ISP_DEVICE_ERASE_US and
+//                      ISP_DEVICE_PROGRAM_US per IAP command with the CPU stopped
+//    drop              -l <n> of isp_uart_host: every n-th 64 bytes reply is not sent to the host
+//    lock              -k of isp_uart_host: CONFIG0 LOCK is 0 until a CONFIG erase
+//***********************************************************************************************************
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "isp_device.h"
+#include "MS51_16K.h"
+#undef int
+#undef data
+#undef bit
+
+void ISP_Main(void);
+void Serial_ISR(void);
+void Timer0_ISR(void);
+
+#define FSYS_HZ                 24000000.0
+#define TICK_US                 50
+#define ACCESS_NS               250.0       /* device time of one SFR access before SCON.REN */
+#define RX_POLL_NS              20000.0     /* pty read at most every 20 us */
+#define RX_RING_SIZE            4096
+#define BAUD_TOLERANCE          0.03
+
+#define SFR_P0                  0x80
+#define SFR_RCTRIM0             0x84
+#define SFR_RCTRIM1             0x85
+#define SFR_PCON                0x87
+#define SFR_TCON                0x88
+#define SFR_TMOD                0x89
+#define SFR_TL0                 0x8A
+#define SFR_TH0                 0x8C
+#define SFR_CKCON               0x8E
+#define SFR_SCON                0x98
+#define SFR_SBUF                0x99
+#define SFR_CHPCON              0x9F
+#define SFR_IAPTRG              0xA4
+#define SFR_IAPUEN              0xA5
+#define SFR_IAPAL               0xA6
+#define SFR_IAPAH               0xA7
+#define SFR_IE                  0xA8
+#define SFR_WDCON               0xAA
+#define SFR_IAPFD               0xAE
+#define SFR_IAPCN               0xAF
+#define SFR_T3CON               0xC4
+#define SFR_RL3                 0xC5
+#define SFR_RH3                 0xC6
+#define SFR_TA                  0xC7
+
+#define PCON_SMOD               0x80
+#define TCON_TR0                0x10
+#define TCON_TF0                0x20
+#define CKCON_T0M               0x08
+#define SCON_RI                 0x01
+#define SCON_TI                 0x02
+#define SCON_REN                0x10
+#define CHPCON_IAPEN            0x01
+#define CHPCON_IAPFF            0x40
+#define CHPCON_SWRST            0x80
+#define IAPUEN_APUEN            0x01
+#define IAPUEN_CFUEN            0x04
+#define IE_ET0                  0x02
+#define IE_ES                   0x10
+#define IE_EA                   0x80
+
+#define IAP_READ_AP             0x00        /* IAPCN of the ISP_UART0 IAP commands */
+#define IAP_PROGRAM_AP          0x21
+#define IAP_ERASE_AP            0x22
+#define IAP_READ_UID            0x04
+#define IAP_READ_DID            0x0C
+#define IAP_READ_CONFIG         0xC0
+#define IAP_PROGRAM_CONFIG      0xE1
+#define IAP_ERASE_CONFIG        0xE2
+
+#define IAP_PAGE_SIZE           128
+#define IAP_CONFIG_SIZE         8
+
+static struct
+{
+    ISP_DEVICE   *pDevice;
+    unsigned char sfr[256];
+    unsigned char config[IAP_CONFIG_SIZE];
+    unsigned char sbuf_rx;
+
+    /* Host bytes not yet received, with host baud rate and time of the pty read */
+    unsigned char rx_byte[RX_RING_SIZE];
+    unsigned      rx_baud[RX_RING_SIZE];
+    double        rx_time[RX_RING_SIZE];
+    unsigned      rx_head, rx_tail;
+    double        rx_poll;                  /* time of the last pty read */
+    double        rx_next;                  /* end of the last received byte, timing */
+
+    /* RXD waveform before SCON.REN */
+    int           wire_active;
+    unsigned char wire_byte;
+    double        wire_start, wire_end, wire_bit;
+
+    int           tx_busy;
+    double        tx_done;
+    unsigned long tx_count;
+    unsigned char tx_reply[64];             /* bytes of the reply not yet written to the pty */
+
+    double        t0_time, t0_count;        /* Timer0 count at t0_time */
+    int           host_time;                /* device time is CLOCK_MONOTONIC, from SCON.REN */
+    double        access_time, access_base; /* device time before SCON.REN and its CLOCK_MONOTONIC start */
+    int           ta_step;                  /* 1 after TA = 0xAA, 2 after TA = 0x55 */
+    int           tick;
+    double        tick_at;                  /* tx_done the tick is set to */
+
+    volatile sig_atomic_t in_model;         /* SFR access of main, no interrupt */
+    volatile sig_atomic_t in_isr;           /* ISR or interrupt dispatch running */
+    jmp_buf       reset;
+    unsigned long ta_lost, iap_error;
+} g_dev;
+
+static double Now_Ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void Wait_Until(double t)
+{
+    while (Now_Ns() < t);
+}
+
+/* Device time, i32Access is 1 for an SFR access */
+static double Device_Ns(int i32Access)
+{
+    if (g_dev.host_time)
+        return Now_Ns();
+
+    if (i32Access)
+    {
+        g_dev.access_time += ACCESS_NS;
+        Wait_Until(g_dev.access_base + g_dev.access_time);
+    }
+
+    return g_dev.access_time;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  UART0                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+static unsigned Host_Baud(void)
+{
+    static const struct
+    {
+        speed_t  speed;
+        unsigned baud;
+    } Table[] =
+    {
+        {B9600, 9600}, {B19200, 19200}, {B38400, 38400}, {B57600, 57600}, {B115200, 115200},
+        {B230400, 230400}, {B460800, 460800}, {B500000, 500000}, {B921600, 921600}, {B1000000, 1000000},
+        {B1500000, 1500000}, {B2000000, 2000000}
+    };
+    struct termios tio;
+    speed_t speed;
+    unsigned i;
+
+    if (tcgetattr(g_dev.pDevice->fd, &tio) < 0)
+        return 0;
+
+    speed = cfgetospeed(&tio);
+
+    for (i = 0; i < sizeof(Table) / sizeof(Table[0]); i++)
+    {
+        if (Table[i].speed == speed)
+            return Table[i].baud;
+    }
+
+    return 0;
+}
+
+/* Timer3 baud rate clock of UART0 */
+static double Device_Baud(void)
+{
+    unsigned u32Div;
+
+    u32Div = 0x10000 - ((g_dev.sfr[SFR_RH3] << 8) | g_dev.sfr[SFR_RL3]);
+
+    return FSYS_HZ / (1 << (g_dev.sfr[SFR_T3CON] & 0x07)) / ((g_dev.sfr[SFR_PCON] & PCON_SMOD) ? 16 : 32) / u32Div;
+}
+
+static int Baud_Match(unsigned u32Host)
+{
+    return fabs(Device_Baud() - u32Host) <= u32Host * BAUD_TOLERANCE;
+}
+
+/* Read the bytes written by the host */
+static void Rx_Poll(double now)
+{
+    unsigned char buf[256];
+    unsigned u32Baud;
+    int i, n, free;
+
+    if (now - g_dev.rx_poll < RX_POLL_NS)
+        return;
+
+    g_dev.rx_poll = now;
+    free = RX_RING_SIZE - (g_dev.rx_head - g_dev.rx_tail);
+    n = read(g_dev.pDevice->fd, buf, free < (int)sizeof(buf) ? free : (int)sizeof(buf));
+
+    if (n <= 0)
+        return;
+
+    u32Baud = Host_Baud();
+
+    for (i = 0; i < n; i++)
+    {
+        g_dev.rx_byte[g_dev.rx_head % RX_RING_SIZE] = buf[i];
+        g_dev.rx_baud[g_dev.rx_head % RX_RING_SIZE] = u32Baud;
+        g_dev.rx_time[g_dev.rx_head % RX_RING_SIZE] = now;
+        g_dev.rx_head++;
+    }
+}
+
+/* Level of RXD, bytes are on the line one after another from the time the device has read them */
+static unsigned char Wire_RXD(double now)
+{
+    unsigned i;
+    double k;
+
+    for (;;)
+    {
+        if (g_dev.wire_active && now < g_dev.wire_end)
+            break;
+
+        g_dev.wire_active = 0;
+        Rx_Poll(now);
+
+        if (g_dev.rx_head == g_dev.rx_tail)
+            return 1;
+
+        i = g_dev.rx_tail++ % RX_RING_SIZE;
+        g_dev.wire_byte = g_dev.rx_byte[i];
+        g_dev.wire_bit = 1e9 / (g_dev.rx_baud[i] ? g_dev.rx_baud[i] : 115200);
+        g_dev.wire_start = (g_dev.wire_end > g_dev.rx_time[i]) ? g_dev.wire_end : g_dev.rx_time[i];
+        g_dev.wire_end = g_dev.wire_start + 10 * g_dev.wire_bit;
+        g_dev.wire_active = 1;
+    }
+
+    if (now < g_dev.wire_start)
+        return 1;
+
+    k = floor((now - g_dev.wire_start) / g_dev.wire_bit);
+
+    if (k < 1)
+        return 0;
+
+    if (k < 9)
+        return (g_dev.wire_byte >> (int)(k - 1)) & 1;
+
+    return 1;
+}
+
+static void Write_Reply(const unsigned char *pu8Data, unsigned u32Len)
+{
+    struct pollfd pfd;
+    long n;
+
+    while (u32Len)
+    {
+        n = write(g_dev.pDevice->fd, pu8Data, u32Len);
+
+        if (n > 0)
+        {
+            pu8Data += n;
+            u32Len -= n;
+            continue;
+        }
+
+        if (n < 0 && errno != EAGAIN && errno != EINTR)
+            return;
+
+        pfd.fd = g_dev.pDevice->fd;
+        pfd.events = POLLOUT;
+        poll(&pfd, 1, 100);
+    }
+}
+
+/* Bytes are written to the pty by 64, so the host gets a reply after its last byte, not while main sends it */
+static void Uart_Send(unsigned char u8Data, double now)
+{
+    unsigned u32Pos = g_dev.tx_count % 64;
+
+    if (!Baud_Match(Host_Baud()))
+        u8Data = ~u8Data;
+
+    g_dev.tx_reply[u32Pos] = u8Data;
+
+    if (u32Pos == 63 && (g_dev.pDevice->drop_every == 0 || (g_dev.tx_count / 64 + 1) % g_dev.pDevice->drop_every != 0))
+        Write_Reply(g_dev.tx_reply, 64);
+
+    g_dev.tx_count++;
+    g_dev.tx_busy = 1;
+    g_dev.tx_done = now + 10 * 1e9 / Device_Baud();
+}
+
+static void Uart_Update(double now)
+{
+    unsigned i;
+    double t;
+
+    if ((g_dev.sfr[SFR_SCON] & (SCON_REN | SCON_RI)) == SCON_REN)
+    {
+        Rx_Poll(now);
+
+        if (g_dev.rx_head != g_dev.rx_tail)
+        {
+            i = g_dev.rx_tail % RX_RING_SIZE;
+            t = now;
+
+            if (g_dev.pDevice->timing)
+                t = ((g_dev.rx_next > g_dev.rx_time[i]) ? g_dev.rx_next : g_dev.rx_time[i]) + 10 * 1e9 / g_dev.rx_baud[i];
+
+            if (now >= t)
+            {
+                g_dev.rx_next = t;
+                g_dev.sbuf_rx = Baud_Match(g_dev.rx_baud[i]) ? g_dev.rx_byte[i] : ~g_dev.rx_byte[i];
+                g_dev.sfr[SFR_SCON] |= SCON_RI;
+                g_dev.rx_tail++;
+            }
+        }
+    }
+
+    if (g_dev.tx_busy && now >= g_dev.tx_done)
+    {
+        g_dev.tx_busy = 0;
+        g_dev.sfr[SFR_SCON] |= SCON_TI;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Timer0                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static double Timer0_Period(void)
+{
+    return (g_dev.sfr[SFR_TMOD] & 0x03) ? 65536.0 : 8192.0;
+}
+
+static void Timer0_Update(double now)
+{
+    double rate;
+
+    if (g_dev.sfr[SFR_TCON] & TCON_TR0)
+    {
+        rate = (g_dev.sfr[SFR_CKCON] & CKCON_T0M) ? FSYS_HZ : FSYS_HZ / 12;
+        g_dev.t0_count += (now - g_dev.t0_time) * rate / 1e9;
+
+        if (g_dev.t0_count >= Timer0_Period())
+        {
+            g_dev.sfr[SFR_TCON] |= TCON_TF0;
+            g_dev.t0_count = fmod(g_dev.t0_count, Timer0_Period());
+        }
+    }
+
+    g_dev.t0_time = now;
+}
+
+/* TH0 / TL0 of the count, mode 0 is TH0 8 bits and TL0 5 bits */
+static unsigned char Timer0_Read(unsigned char u8Addr)
+{
+    unsigned u32Count = (unsigned)g_dev.t0_count;
+
+    if ((g_dev.sfr[SFR_TMOD] & 0x03) == 0)
+        return (u8Addr == SFR_TH0) ? (u32Count >> 5) & 0xFF : u32Count & 0x1F;
+
+    return (u8Addr == SFR_TH0) ? (u32Count >> 8) & 0xFF : u32Count & 0xFF;
+}
+
+static void Timer0_Write(unsigned char u8Addr, unsigned char u8Value)
+{
+    unsigned u32Count = (unsigned)g_dev.t0_count;
+
+    if ((g_dev.sfr[SFR_TMOD] & 0x03) == 0)
+        u32Count = (u8Addr == SFR_TH0) ? (u8Value << 5) | (u32Count & 0x1F) : (u32Count & 0x1FE0) | (u8Value & 0x1F);
+    else
+        u32Count = (u8Addr == SFR_TH0) ? (u8Value << 8) | (u32Count & 0xFF) : (u32Count & 0xFF00) | u8Value;
+
+    g_dev.t0_count = u32Count;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Interrupt                                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Next tick at the end of the byte in transmit, then every TICK_US */
+static void Tick_Next(double now)
+{
+    struct itimerval it;
+    double us;
+
+    if (!g_dev.tick || !g_dev.tx_busy || g_dev.tick_at == g_dev.tx_done)
+        return;
+
+    us = (g_dev.tx_done - now) / 1000 + 1;
+    memset(&it, 0, sizeof(it));
+    it.it_interval.tv_usec = TICK_US;
+    it.it_value.tv_usec = (us < 1) ? 1 : (us < TICK_US) ? (long)us : TICK_US;
+    setitimer(ITIMER_REAL, &it, NULL);
+    g_dev.tick_at = g_dev.tx_done;
+}
+
+static void Irq_Dispatch(void)
+{
+    double now;
+
+    if (g_dev.in_isr)
+        return;
+
+    g_dev.in_isr = 1;
+
+    for (;;)
+    {
+        now = Device_Ns(0);
+        Timer0_Update(now);
+        Uart_Update(now);
+
+        if (!(g_dev.sfr[SFR_IE] & IE_EA))
+            break;
+
+        if ((g_dev.sfr[SFR_IE] & IE_ES) && (g_dev.sfr[SFR_SCON] & (SCON_RI | SCON_TI)))
+        {
+            Serial_ISR();
+            continue;
+        }
+
+        if ((g_dev.sfr[SFR_IE] & IE_ET0) && (g_dev.sfr[SFR_TCON] & TCON_TF0))
+        {
+            g_dev.sfr[SFR_TCON] &= ~TCON_TF0;       /* cleared by the vector */
+            Timer0_ISR();
+            continue;
+        }
+
+        break;
+    }
+
+    Tick_Next(now);
+    g_dev.in_isr = 0;
+}
+
+static void Tick_Handler(int sig)
+{
+    int i32Errno = errno;
+
+    (void)sig;
+
+    if (!g_dev.in_model && !g_dev.in_isr)
+        Irq_Dispatch();
+
+    errno = i32Errno;
+}
+
+static void Tick_Set(int i32On)
+{
+    struct sigaction sa;
+    struct itimerval it;
+
+    if (i32On == g_dev.tick)
+        return;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = i32On ? Tick_Handler : SIG_IGN;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+
+    memset(&it, 0, sizeof(it));
+    it.it_interval.tv_usec = i32On ? TICK_US : 0;
+    it.it_value.tv_usec = i32On ? TICK_US : 0;
+    setitimer(ITIMER_REAL, &it, NULL);
+    g_dev.tick = i32On;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  IAP                                                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Iap_Run(void)
+{
+    unsigned char *pu8Flash = g_dev.pDevice->flash;
+    unsigned char u8Cmd, u8Data;
+    unsigned u32Addr, u32Us = 0;
+    int i32Ok;
+
+    u8Cmd = g_dev.sfr[SFR_IAPCN];
+    u8Data = g_dev.sfr[SFR_IAPFD];
+    u32Addr = (g_dev.sfr[SFR_IAPAH] << 8) | g_dev.sfr[SFR_IAPAL];
+    i32Ok = (g_dev.sfr[SFR_CHPCON] & CHPCON_IAPEN) != 0;
+
+    switch (u8Cmd)
+    {
+        case IAP_READ_AP:
+            i32Ok = i32Ok && u32Addr < ISP_DEVICE_FLASH_SIZE;
+
+            if (i32Ok)
+                g_dev.sfr[SFR_IAPFD] = pu8Flash[u32Addr];
+            break;
+
+        case IAP_PROGRAM_AP:
+            i32Ok = i32Ok && (g_dev.sfr[SFR_IAPUEN] & IAPUEN_APUEN) && u32Addr < ISP_DEVICE_FLASH_SIZE;
+
+            if (i32Ok)
+                pu8Flash[u32Addr] &= u8Data;
+
+            u32Us = ISP_DEVICE_PROGRAM_US;
+            break;
+
+        case IAP_ERASE_AP:
+            i32Ok = i32Ok && (g_dev.sfr[SFR_IAPUEN] & IAPUEN_APUEN) && u32Addr < ISP_DEVICE_FLASH_SIZE && u8Data == 0xFF;
+
+            if (i32Ok)
+                memset(&pu8Flash[u32Addr & ~(IAP_PAGE_SIZE - 1)], 0xFF, IAP_PAGE_SIZE);
+
+            u32Us = ISP_DEVICE_ERASE_US;
+            break;
+
+        case IAP_READ_UID:
+            g_dev.sfr[SFR_IAPFD] = 0xFF;
+            break;
+
+        case IAP_READ_DID:
+            g_dev.sfr[SFR_IAPFD] = (ISP_DEVICE_ID >> ((u32Addr & 0x03) * 8)) & 0xFF;
+            break;
+
+        case IAP_READ_CONFIG:
+            g_dev.sfr[SFR_IAPFD] = g_dev.config[u32Addr % IAP_CONFIG_SIZE];
+            break;
+
+        case IAP_PROGRAM_CONFIG:
+            i32Ok = i32Ok && (g_dev.sfr[SFR_IAPUEN] & IAPUEN_CFUEN);
+
+            if (i32Ok)
+                g_dev.config[u32Addr % IAP_CONFIG_SIZE] &= u8Data;
+
+            u32Us = ISP_DEVICE_PROGRAM_US;
+            break;
+
+        case IAP_ERASE_CONFIG:
+            i32Ok = i32Ok && (g_dev.sfr[SFR_IAPUEN] & IAPUEN_CFUEN) && u8Data == 0xFF;
+
+            if (i32Ok)
+                memset(g_dev.config, 0xFF, sizeof(g_dev.config));
+
+            u32Us = ISP_DEVICE_ERASE_US;
+            break;
+
+        default:
+            i32Ok = 0;
+            break;
+    }
+
+    if (!i32Ok)
+    {
+        g_dev.sfr[SFR_CHPCON] |= CHPCON_IAPFF;
+        g_dev.iap_error++;
+    }
+
+    /* CPU stops until the flash is done, the UART goes on */
+    if (g_dev.pDevice->timing && u32Us)
+        Wait_Until(Now_Ns() + u32Us * 1000.0);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SFR                                                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+static unsigned char Sfr_Read(unsigned char u8Addr, double now)
+{
+    switch (u8Addr)
+    {
+        case SFR_TL0:
+        case SFR_TH0:
+            Timer0_Update(now);
+            return Timer0_Read(u8Addr);
+
+        case SFR_TCON:
+            Timer0_Update(now);
+            break;
+
+        case SFR_SCON:
+            Uart_Update(now);
+            break;
+
+        case SFR_SBUF:
+            return g_dev.sbuf_rx;
+
+        case SFR_P0:
+            return (g_dev.sfr[SFR_P0] & 0x7F) | (Wire_RXD(now) << 7);
+    }
+
+    return g_dev.sfr[u8Addr];
+}
+
+static void Sfr_Write(unsigned char u8Addr, unsigned char u8Value, double now)
+{
+    switch (u8Addr)
+    {
+        case SFR_TA:
+            g_dev.ta_step = (u8Value == 0xAA) ? 1 : (g_dev.ta_step == 1 && u8Value == 0x55) ? 2 : 0;
+            g_dev.sfr[SFR_TA] = u8Value;
+            return;
+
+        case SFR_CHPCON:
+        case SFR_IAPUEN:
+        case SFR_IAPTRG:
+        case SFR_WDCON:
+        case SFR_RCTRIM0:
+        case SFR_RCTRIM1:
+            if (g_dev.ta_step != 2)
+            {
+                g_dev.ta_lost++;
+                g_dev.ta_step = 0;
+                return;
+            }
+            break;
+    }
+
+    g_dev.ta_step = 0;
+
+    switch (u8Addr)
+    {
+        case SFR_TL0:
+        case SFR_TH0:
+            Timer0_Update(now);
+            Timer0_Write(u8Addr, u8Value);
+            return;
+
+        case SFR_TCON:
+        case SFR_TMOD:
+        case SFR_CKCON:
+            Timer0_Update(now);
+            break;
+
+        case SFR_SBUF:
+            Uart_Send(u8Value, now);
+            return;
+
+        case SFR_SCON:
+            if ((u8Value & SCON_REN) && !g_dev.host_time)
+            {
+                Timer0_Update(now);
+                g_dev.t0_time = Now_Ns();
+                g_dev.host_time = 1;
+            }
+            break;
+
+        case SFR_IAPTRG:
+            if (u8Value & 0x01)
+                Iap_Run();
+            return;
+
+        case SFR_CHPCON:
+            if (u8Value & CHPCON_SWRST)
+                longjmp(g_dev.reset, 1);
+            break;
+
+        case SFR_IE:
+            if (u8Value & (IE_ES | IE_ET0))
+                Tick_Set(1);
+            break;
+    }
+
+    g_dev.sfr[u8Addr] = u8Value;
+}
+
+unsigned char Host_SFR_Read(unsigned short u16Index)
+{
+    unsigned char u8Value;
+
+    g_dev.in_model = 1;
+
+    if (u16Index & 0x100)
+        u8Value = (Sfr_Read(u16Index & 0xF8, Device_Ns(1)) >> (u16Index & 0x07)) & 1;
+    else
+        u8Value = Sfr_Read(u16Index & 0xFF, Device_Ns(1));
+
+    g_dev.ta_step = 0;
+    g_dev.in_model = 0;
+    Irq_Dispatch();
+
+    return u8Value;
+}
+
+/* Write (u8And 0) or read-modify-write of one SFR or sbit, one instruction of the CPU */
+void Host_SFR_Modify(unsigned short u16Index, unsigned char u8And, unsigned char u8Or)
+{
+    unsigned char u8Addr, u8Mask, u8Value;
+    double now;
+
+    g_dev.in_model = 1;
+    now = Device_Ns(1);
+
+    if (u16Index & 0x100)
+    {
+        u8Addr = u16Index & 0xF8;
+        u8Mask = 1 << (u16Index & 0x07);
+        u8Value = g_dev.sfr[u8Addr] & ~u8Mask;
+
+        if ((((g_dev.sfr[u8Addr] & u8Mask) ? 1 : 0) & u8And) | u8Or)
+            u8Value |= u8Mask;
+
+        if (u8Addr == SFR_TCON)
+            Timer0_Update(now);
+
+        g_dev.sfr[u8Addr] = u8Value;
+
+        if (u8Addr == SFR_IE && (u8Value & (IE_ES | IE_ET0)))
+            Tick_Set(1);
+    }
+    else
+    {
+        u8Addr = u16Index & 0xFF;
+        u8Value = u8And ? (Sfr_Read(u8Addr, now) & u8And) | u8Or : u8Or;
+        Sfr_Write(u8Addr, u8Value, now);
+    }
+
+    g_dev.in_model = 0;
+    Irq_Dispatch();
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Device                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Power on, run ISP_UART0 until software reset, then APROM, which ignores the host until it closes the pty */
+void Isp_Device_Run(ISP_DEVICE *pDevice)
+{
+    unsigned char buf[256];
+    struct pollfd pfd;
+
+    memset(&g_dev, 0, sizeof(g_dev));
+    g_dev.pDevice = pDevice;
+    memset(g_dev.config, 0xFF, sizeof(g_dev.config));
+
+    if (pDevice->locked)
+        g_dev.config[0] &= ~0x02;
+
+    g_dev.sfr[SFR_P0] = 0xFF;
+    g_dev.access_base = Now_Ns();
+    fcntl(pDevice->fd, F_SETFL, fcntl(pDevice->fd, F_GETFL) | O_NONBLOCK);
+
+    if (setjmp(g_dev.reset) == 0)
+        ISP_Main();
+
+    Tick_Set(0);
+    g_dev.in_model = 0;
+
+    if (g_dev.ta_lost || g_dev.iap_error)
+        fprintf(stderr, "device: %lu TA protected writes lost, %lu IAP errors\n", g_dev.ta_lost, g_dev.iap_error);
+
+    pfd.fd = pDevice->fd;
+    pfd.events = POLLIN;
+
+    while (poll(&pfd, 1, -1) >= 0 && !(pfd.revents & (POLLHUP | POLLERR)))
+    {
+        if (read(pDevice->fd, buf, sizeof(buf)) < 0 && errno != EAGAIN && errno != EINTR)
+            break;
+    }
+}
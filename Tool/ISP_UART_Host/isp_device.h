@@ -0,0 +1,28 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Simulated MS51 16K running ISP_UART0 main_autosize_wdtdis.c, see isp_device.cpp                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#define ISP_DEVICE_FLASH_SIZE   0x4000      /* APROM and LDROM of MS51 16K, ISP_UART0 uses 14 KB APROM */
+#define ISP_DEVICE_ID           0x00000000  /* dummy DID / PID of CMD_GET_DEVICEID, not a real part */
+#define ISP_DEVICE_ERASE_US     5000        /* approximate page erase time for timing */
+#define ISP_DEVICE_PROGRAM_US   25          /* approximate byte program time for timing */
+
+typedef struct
+{
+    long            fd;                     /* pty master, the host has the pty slave */
+    unsigned char  *flash;                  /* ISP_DEVICE_FLASH_SIZE bytes, shared with the host process */
+    unsigned long   drop_every;             /* drop every n-th 64 bytes reply, 0 none */
+    long            timing;                 /* UART wire time and flash time */
+    long            locked;                 /* CONFIG0 LOCK bit is 0 */
+} ISP_DEVICE;
+
+#ifdef __cplusplus
+extern "C"
+#endif
+void Isp_Device_Run(ISP_DEVICE *pDevice);
@@ -0,0 +1,1103 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Linux host programmer for MS51 ISP_UART0 / ISP_UART1 with simulated device
+//
+//  Build : make            (see Makefile, the simulated device is C++)
+//
+//  Usage : isp_uart_host [options] <port> <command> [file]
+//          isp_uart_host [options] -s [sim options] <command> [file]
+//
+//  Command
+//    info              connect, print FW version, ISP feature, device ID and CONFIG
+//    program <bin>     update APROM from start address, device runs APROM when the last byte is programmed
+//    verify <bin>      read back APROM from start address by CMD_READ_APROM and compare with <bin>
+//    erase             erase all APROM
+//    run               reset device to APROM
+//
+//  Options
+//    -b <baud>         baud rate, default 115200, the bootloader detects it from CMD_CONNECT
+//    -B <baud>         after connect ask the device for <baud> by CMD_SET_BAUDRATE (ISP_FEATURE bit1), the
+//                      device offers the fastest rate of its table not over <baud>. The update goes on at -b
+//                      when the offer is 0 or not supported by the port
+//    -a <addr>         APROM start address of program, default 0
+//    -d                delta program, only pages with different CRC are updated (ISP_FEATURE bit3)
+//    -z                compressed program, the image is sent as LZ_Pack stream by CMD_UPDATE_APROM_COMPRESSED
+//                      (ISP_FEATURE bit2), not with -d
+//    -1                one data packet in flight, without it the next data packet is sent before the reply
+//                      of the last one when the device has ISP_FEATURE bit0
+//    -c                continuous verify, device streams the whole range after one request (ISP_FEATURE bit5)
+//    -r <n>            retry count of one packet / one update, default 3
+//    -w <ms>           reply timeout, default 500
+//
+//  Simulated device, -s replaces <port> by a pty served by a forked device process, which runs ISP_UART0
+//  isp_uart0.c and main_autosize_wdtdis.c of MS51 16K on the SFR model of isp_device.cpp. Its APROM is
+//  shared with the host, program checks it against <bin> after the update.
+//    -l <n>            drop every n-th reply of the device to test retry and timeout
+//    -t                add UART receive time and ISP_DEVICE_ERASE_US / ISP_DEVICE_PROGRAM_US flash time, the
+//                      UART transmit time is always there
+//    -i <bin>          preload simulated APROM, e.g. old firmware for delta program
+//    -k                locked CONFIG0, no APROM data or page CRC is read back
+//***********************************************************************************************************
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "isp_device.h"
+#include "lz_pack.h"
+
+#define CMD_UPDATE_DATA         0x00
+#define CMD_CONNECT             0xAE
+#define CMD_SYNC_PACKNO         0xA4
+#define CMD_GET_FWVER           0xA6
+#define CMD_RUN_APROM           0xAB
+#define CMD_GET_DEVICEID        0xB1
+#define CMD_ERASE_ALL           0xA3
+#define CMD_READ_CONFIG         0xA2
+#define CMD_UPDATE_CONFIG       0xA1
+#define CMD_UPDATE_APROM        0xA0
+#define CMD_UPDATE_APROM_COMPRESSED 0xB6
+#define CMD_SET_BAUDRATE        0xB5
+#define CMD_READ_PAGE_CRC       0xB7
+#define CMD_UPDATE_APROM_PAGE   0xB8
+#define CMD_READ_APROM          0xB9
+#define READ_APROM_CONTINUOUS   0x01        /* byte 10 of CMD_READ_APROM */
+
+#define FEATURE_PIPELINE        0x01        /* ISP_FEATURE bit0, next data packet may be sent before the reply */
+#define FEATURE_BAUDRATE        0x02        /* ISP_FEATURE bit1 */
+#define FEATURE_COMPRESSED      0x04        /* ISP_FEATURE bit2 */
+#define FEATURE_PAGE_CRC        0x08        /* ISP_FEATURE bit3 */
+#define FEATURE_BLANK_SKIP      0x10        /* ISP_FEATURE bit4, erase skipped page count in reply byte 10..11 */
+#define FEATURE_READ_APROM      0x20        /* ISP_FEATURE bit5 */
+#define CONFIG0_LOCK            0x02        /* CONFIG0 bit1, 0 is locked and CMD_READ_APROM replies no data */
+
+#define PACKET_SIZE             64
+#define PAGE_SIZE               128
+#define PAGE_CRC_MAX            28
+#define FIRST_DATA_SIZE         48          /* CMD_UPDATE_APROM payload from byte 16 */
+#define NEXT_DATA_SIZE          56          /* data packet payload from byte 8 */
+#define READ_DATA_SIZE          56          /* CMD_READ_APROM data from byte 8, address in byte 2..3, count in byte 6 */
+#define CONNECT_RETRY           50          /* first CMD_CONNECT is used by autobaud and not replied */
+#define ERASE_WAIT_MS           10          /* reply wait added per page erased by the command */
+#define ERASE_ALL_PAGES         240         /* APROM_SIZE / PAGE_SIZE of CMD_ERASE_ALL */
+
+#define APROM_MAX               (32 * 1024)
+#define PIPELINE_MAX            2           /* ISP_UART0 holds one packet in process and one received */
+#define BAUD_TRIAL_MS           1200        /* device goes back to the old baud rate without packet in 1 s */
+
+typedef struct
+{
+    int      fd;
+    uint32_t packno;
+    int      timeout_ms;
+    int      retry;
+    unsigned packets;
+    unsigned retries;
+    unsigned timeouts;
+    uint8_t  feature;                       /* ISP_FEATURE of CMD_GET_FWVER */
+    int      resumed;                       /* update restarted by CMD_UPDATE_APROM_PAGE, device stays in ISP */
+    unsigned blank_pages;                   /* pages not erased by device blank check */
+    uint32_t packed;                        /* LZ_Pack size of CMD_UPDATE_APROM_COMPRESSED image */
+    int      window;                        /* data packets in flight, 1 or PIPELINE_MAX */
+} ISP_LINK;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Common                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint16_t Packet_Sum(const uint8_t *pu8Buf)
+{
+    uint16_t u16Sum = 0;
+    int i;
+
+    for (i = 0; i < PACKET_SIZE; i++)
+        u16Sum += pu8Buf[i];
+
+    return u16Sum;
+}
+
+/* CRC-16/CCITT, init 0xFFFF, same as CRC16_APROM of crc.c and Page_CRC16 of ISP_UART0 */
+static uint16_t Page_CRC16(const uint8_t *pu8Buf, int i32Len)
+{
+    uint16_t u16CRC = 0xFFFF;
+    int i, j;
+
+    for (i = 0; i < i32Len; i++)
+    {
+        u16CRC ^= (uint16_t)pu8Buf[i] << 8;
+
+        for (j = 0; j < 8; j++)
+            u16CRC = (u16CRC & 0x8000) ? (uint16_t)((u16CRC << 1) ^ 0x1021) : (uint16_t)(u16CRC << 1);
+    }
+
+    return u16CRC;
+}
+
+static void Put_U32(uint8_t *pu8Buf, uint32_t u32Value)
+{
+    pu8Buf[0] = u32Value & 0xFF;
+    pu8Buf[1] = (u32Value >> 8) & 0xFF;
+    pu8Buf[2] = (u32Value >> 16) & 0xFF;
+    pu8Buf[3] = (u32Value >> 24) & 0xFF;
+}
+
+static uint32_t Get_U32(const uint8_t *pu8Buf)
+{
+    return pu8Buf[0] | ((uint32_t)pu8Buf[1] << 8) | ((uint32_t)pu8Buf[2] << 16) | ((uint32_t)pu8Buf[3] << 24);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int Write_All(int fd, const uint8_t *pu8Buf, int i32Len)
+{
+    int n;
+
+    while (i32Len > 0)
+    {
+        n = write(fd, pu8Buf, i32Len);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return -1;
+        }
+
+        pu8Buf += n;
+        i32Len -= n;
+    }
+
+    return 0;
+}
+
+/* Read one packet, -1 when timeout_ms passed before 64 bytes arrived, timeout_ms < 0 waits forever */
+static int Read_Packet(int fd, uint8_t *pu8Buf, int timeout_ms)
+{
+    struct pollfd pfd;
+    double deadline;
+    int got = 0, n, wait_ms;
+
+    deadline = Now() + timeout_ms / 1000.0;
+
+    while (got < PACKET_SIZE)
+    {
+        wait_ms = -1;
+
+        if (timeout_ms >= 0)
+        {
+            wait_ms = (int)((deadline - Now()) * 1000);
+
+            if (wait_ms <= 0)
+                return -1;
+        }
+
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        n = poll(&pfd, 1, wait_ms);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return -1;
+
+        n = read(fd, pu8Buf + got, PACKET_SIZE - got);
+
+        if (n <= 0)
+        {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+
+            return -1;
+        }
+
+        got += n;
+    }
+
+    return 0;
+}
+
+static speed_t Baud_To_Speed(unsigned u32Baud)
+{
+    switch (u32Baud)
+    {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 500000:  return B500000;
+        case 921600:  return B921600;
+        case 1500000: return B1500000;
+        default:      return 0;
+    }
+}
+
+static int Set_Raw(int fd, unsigned u32Baud)
+{
+    struct termios tio;
+    speed_t speed;
+
+    speed = Baud_To_Speed(u32Baud);
+
+    if (speed == 0 || tcgetattr(fd, &tio) < 0)
+        return -1;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static long Load_File(const char *pcName, uint8_t *pu8Buf, long i32Max)
+{
+    FILE *fp;
+    long n;
+
+    fp = fopen(pcName, "rb");
+
+    if (fp == NULL)
+        return -1;
+
+    n = (long)fread(pu8Buf, 1, i32Max, fp);
+
+    if (fgetc(fp) != EOF)
+        n = -1;
+
+    fclose(fp);
+    return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Simulated device                                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Fork device process on pty master, return pty slave in raw mode */
+static int Sim_Start(ISP_DEVICE *pDevice, unsigned u32Baud, pid_t *pPid)
+{
+    int master, slave;
+    pid_t pid;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+        return -1;
+
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+
+    if (slave < 0 || Set_Raw(slave, u32Baud) < 0)
+        return -1;
+
+    pid = fork();
+
+    if (pid < 0)
+        return -1;
+
+    if (pid == 0)
+    {
+        close(slave);
+        pDevice->fd = master;
+        Isp_Device_Run(pDevice);
+        _exit(0);
+    }
+
+    close(master);
+    *pPid = pid;
+    return slave;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Host                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Reply of pu8Tx: its checksum and its packet number + 1 */
+static int Reply_Valid(const uint8_t *pu8Tx, const uint8_t *pu8Rx)
+{
+    uint16_t u16Sum, u16PackNo;
+
+    u16Sum = Packet_Sum(pu8Tx);
+    u16PackNo = (uint16_t)(Get_U32(&pu8Tx[4]) + 1);
+
+    return (pu8Rx[0] | (pu8Rx[1] << 8)) == u16Sum && (pu8Rx[4] | (pu8Rx[5] << 8)) == u16PackNo;
+}
+
+/* Send one packet and wait valid reply, no resend when i32Retry is 0. Return 0 on reply */
+static int Isp_Transfer_Wait(ISP_LINK *pLink, uint8_t *pu8Tx, uint8_t *pu8Rx, int i32Retry, int i32WaitMs)
+{
+    int i32Try;
+
+    Put_U32(&pu8Tx[4], pLink->packno);
+
+    for (i32Try = 0; i32Try <= i32Retry; i32Try++)
+    {
+        if (i32Try)
+        {
+            pLink->retries++;
+            tcflush(pLink->fd, TCIFLUSH);
+        }
+
+        pLink->packets++;
+
+        if (Write_All(pLink->fd, pu8Tx, PACKET_SIZE) < 0)
+            return -1;
+
+        while (Read_Packet(pLink->fd, pu8Rx, i32WaitMs) == 0)
+        {
+            if (Reply_Valid(pu8Tx, pu8Rx))
+            {
+                pLink->packno += 2;
+                return 0;
+            }
+        }
+
+        pLink->timeouts++;
+    }
+
+    return -1;
+}
+
+static int Isp_Transfer(ISP_LINK *pLink, uint8_t *pu8Tx, uint8_t *pu8Rx, int i32Retry)
+{
+    return Isp_Transfer_Wait(pLink, pu8Tx, pu8Rx, i32Retry, pLink->timeout_ms);
+}
+
+static int Isp_Command(ISP_LINK *pLink, uint8_t u8Cmd, uint8_t *pu8Rx)
+{
+    uint8_t tx[PACKET_SIZE] = {0};
+    int i32WaitMs;
+
+    tx[0] = u8Cmd;
+    i32WaitMs = pLink->timeout_ms;
+
+    if (u8Cmd == CMD_ERASE_ALL)
+        i32WaitMs += ERASE_ALL_PAGES * ERASE_WAIT_MS;
+
+    return Isp_Transfer_Wait(pLink, tx, pu8Rx, pLink->retry, i32WaitMs);
+}
+
+static int Isp_Connect(ISP_LINK *pLink)
+{
+    uint8_t tx[PACKET_SIZE] = {0}, rx[PACKET_SIZE];
+
+    tx[0] = CMD_CONNECT;
+    pLink->packno = 1;
+
+    if (Isp_Transfer(pLink, tx, rx, CONNECT_RETRY) < 0)
+    {
+        fprintf(stderr, "no reply of CMD_CONNECT\n");
+        return -1;
+    }
+
+    if (Isp_Command(pLink, CMD_SYNC_PACKNO, rx) < 0 || Isp_Command(pLink, CMD_GET_FWVER, rx) < 0)
+        return -1;
+
+    printf("FW version 0x%02X, ISP feature 0x%02X\n", rx[8], rx[9]);
+    pLink->feature = rx[9];
+
+    if (!(pLink->feature & FEATURE_PIPELINE))
+        pLink->window = 1;
+    return 0;
+}
+
+/*
+ * CMD_SET_BAUDRATE, the device replies its offer at the old baud rate and then changes to it. Without a
+ * packet at the new rate in 1 s it goes back, so when the port cannot take the offer or CMD_SYNC_PACKNO
+ * fails at the new rate, the host waits for that and goes on at the old rate.
+ */
+static int Isp_Set_Baud(ISP_LINK *pLink, unsigned u32Old, unsigned u32Baud)
+{
+    uint8_t tx[PACKET_SIZE] = {0}, rx[PACKET_SIZE];
+    unsigned u32Offer;
+
+    tx[0] = CMD_SET_BAUDRATE;
+    Put_U32(&tx[8], u32Baud);
+
+    if (Isp_Transfer(pLink, tx, rx, pLink->retry) < 0)
+        return -1;
+
+    u32Offer = Get_U32(&rx[8]);
+
+    if (u32Offer == 0)
+    {
+        printf("baud rate %u not offered by device, %u kept\n", u32Baud, u32Old);
+        return 0;
+    }
+
+    tcdrain(pLink->fd);
+    usleep(2000);                               /* device changes after its reply is sent */
+
+    if (Set_Raw(pLink->fd, u32Offer) == 0 && Isp_Command(pLink, CMD_SYNC_PACKNO, rx) == 0)
+    {
+        printf("baud rate %u\n", u32Offer);
+        return 0;
+    }
+
+    printf("baud rate %u offered by device not usable, %u kept\n", u32Offer, u32Old);
+    Set_Raw(pLink->fd, u32Old);
+    usleep(BAUD_TRIAL_MS * 1000);
+    tcflush(pLink->fd, TCIFLUSH);
+
+    return Isp_Command(pLink, CMD_SYNC_PACKNO, rx);
+}
+
+/*
+ * Data packets of an update from *pu32Pos of the sent stream, up to pLink->window packets in flight.
+ * u32Out and u16Total are the image bytes programmed and their checksum before *pu32Pos. The device replies
+ * in order, so a valid reply of a packet in flight also confirms the packets before it and a lost reply is
+ * covered by the next one. *pu32Pos is moved to the end of the last confirmed packet.
+ * Return 0 when all data is replied, 1 when a reply is missing (the update restarts), -1 on error.
+ */
+static int Isp_Data(ISP_LINK *pLink, const uint8_t *pu8Send, uint32_t u32Send, const uint8_t *pu8Data,
+                    const uint32_t *pu32Done, uint32_t u32Out, uint16_t u16Total, uint32_t *pu32Pos)
+{
+    uint8_t tx[PIPELINE_MAX][PACKET_SIZE], rx[PACKET_SIZE];
+    uint16_t au16Total[PIPELINE_MAX];
+    uint32_t au32End[PIPELINE_MAX];
+    uint32_t u32Pos, u32Len, i;
+    int i32Head = 0, i32Count = 0, j, k;
+
+    u32Pos = *pu32Pos;
+
+    while (u32Pos < u32Send || i32Count)
+    {
+        while (i32Count < pLink->window && u32Pos < u32Send)
+        {
+            k = (i32Head + i32Count) % PIPELINE_MAX;
+            memset(tx[k], 0xFF, PACKET_SIZE);
+            memset(tx[k], 0, 8);
+            tx[k][0] = CMD_UPDATE_DATA;
+            u32Len = (u32Send - u32Pos) < NEXT_DATA_SIZE ? (u32Send - u32Pos) : NEXT_DATA_SIZE;
+            memcpy(&tx[k][8], &pu8Send[u32Pos], u32Len);
+            Put_U32(&tx[k][4], pLink->packno);
+
+            for (i = u32Out, u32Out = pu32Done ? pu32Done[u32Pos + u32Len - 1] : u32Pos + u32Len; i < u32Out; i++)
+                u16Total += pu8Data[i];
+
+            pLink->packno += 2;
+            pLink->packets++;
+
+            if (Write_All(pLink->fd, tx[k], PACKET_SIZE) < 0)
+                return -1;
+
+            u32Pos += u32Len;
+            au16Total[k] = u16Total;
+            au32End[k] = u32Pos;
+            i32Count++;
+        }
+
+        if (Read_Packet(pLink->fd, rx, pLink->timeout_ms) < 0)
+        {
+            pLink->timeouts++;
+            return 1;
+        }
+
+        for (j = 0; j < i32Count && !Reply_Valid(tx[(i32Head + j) % PIPELINE_MAX], rx); j++);
+
+        if (j == i32Count)
+            continue;
+
+        k = (i32Head + j) % PIPELINE_MAX;
+
+        if ((rx[8] | (rx[9] << 8)) != au16Total[k])
+        {
+            fprintf(stderr, "checksum 0x%04X of device, 0x%04X expected\n", rx[8] | (rx[9] << 8), au16Total[k]);
+            return -1;
+        }
+
+        *pu32Pos = au32End[k];
+        i32Head = (k + 1) % PIPELINE_MAX;
+        i32Count -= j + 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Program u32Size bytes to u16Addr by CMD_UPDATE_APROM, CMD_UPDATE_APROM_PAGE or CMD_UPDATE_APROM_COMPRESSED
+ * and data packets of Isp_Data. A data packet is not resent, the update is restarted. With ISP_FEATURE bit3 it restarts
+ * by CMD_UPDATE_APROM_PAGE from the page of the last replied byte, else from u16Addr. If the device is
+ * still in g_programflag, the restart packet is programmed as data before the new erase, so the first
+ * reply may be a data reply and only a reply with the checksum of the first 48 bytes is accepted.
+ * A lost reply of the last CMD_UPDATE_APROM packet cannot be restarted, the device already runs APROM.
+ * CMD_UPDATE_APROM_COMPRESSED sends the LZ_Pack stream of the image and always restarts from u16Addr, the
+ * decoder state of the device is lost. Its reply checksum is of the bytes decoded so far, LZ_Pack gives
+ * their count after each packed byte.
+ */
+static int Isp_Update(ISP_LINK *pLink, uint8_t u8Cmd, uint16_t u16Addr, const uint8_t *pu8Data, uint32_t u32Size)
+{
+    uint8_t tx[PACKET_SIZE], rx[PACKET_SIZE];
+    const uint8_t *pu8Send;
+    uint8_t *pu8Packed = NULL;
+    uint32_t *pu32Done = NULL;
+    uint32_t u32Send, u32Skip, u32Done, u32Fail, u32Len, u32Out, u32Blank, i;
+    uint16_t u16Start, u16Total;
+    int i32Try, i32Restart, i32WaitMs, i32Erased = 0, i32Ret = -1;
+
+    pu8Send = pu8Data;
+    u32Send = u32Size;
+    u32Blank = 0;
+
+    if (u8Cmd == CMD_UPDATE_APROM_COMPRESSED)
+    {
+        pu8Packed = malloc(LZ_PACK_BOUND(u32Size));
+        pu32Done = malloc(LZ_PACK_BOUND(u32Size) * sizeof(uint32_t));
+
+        if (pu8Packed == NULL || pu32Done == NULL)
+            goto Exit;
+
+        u32Send = LZ_Pack(pu8Data, u32Size, pu8Packed, pu32Done);
+        pu8Send = pu8Packed;
+        pLink->packed = u32Send;
+    }
+
+    u32Skip = 0;
+    u32Done = 0;
+    u32Fail = 0;
+
+    for (i32Restart = 0; i32Restart <= pLink->retry; i32Restart++)
+    {
+        /* Retry count is for one fail position, a restart passing it starts a new count */
+        if (u32Done > u32Fail)
+        {
+            u32Fail = u32Done;
+            i32Restart = 0;
+        }
+
+        if (i32Restart)
+        {
+            pLink->retries++;
+
+            if ((pLink->feature & FEATURE_PAGE_CRC) && pu32Done == NULL
+                    && ((u16Addr + u32Done) & ~(PAGE_SIZE - 1)) >= u16Addr)
+            {
+                u32Skip = ((u16Addr + u32Done) & ~(PAGE_SIZE - 1)) - u16Addr;
+                u8Cmd = CMD_UPDATE_APROM_PAGE;
+                pLink->resumed = 1;
+            }
+        }
+
+        u16Start = u16Addr + u32Skip;
+        memset(tx, 0xFF, sizeof(tx));
+        memset(tx, 0, 16);
+        tx[0] = u8Cmd;
+        Put_U32(&tx[8], u16Start);
+        Put_U32(&tx[12], u32Size - u32Skip);
+        u32Len = (u32Send - u32Skip) < FIRST_DATA_SIZE ? (u32Send - u32Skip) : FIRST_DATA_SIZE;
+        memcpy(&tx[16], &pu8Send[u32Skip], u32Len);
+        Put_U32(&tx[4], pLink->packno);
+
+        /* Checksum of the image bytes the device has programmed after this packet */
+        u16Total = 0;
+        u32Out = pu32Done ? pu32Done[u32Len - 1] : u32Skip + u32Len;
+
+        for (i = u32Skip; i < u32Out; i++)
+            u16Total += pu8Data[i];
+
+        tcflush(pLink->fd, TCIFLUSH);
+        pLink->packets++;
+
+        if (Write_All(pLink->fd, tx, PACKET_SIZE) < 0)
+            goto Exit;
+
+        i32Try = -1;
+        i32WaitMs = pLink->timeout_ms + ((u16Start & (PAGE_SIZE - 1)) + u32Size - u32Skip + PAGE_SIZE - 1) / PAGE_SIZE * ERASE_WAIT_MS;
+
+        while (Read_Packet(pLink->fd, rx, i32WaitMs) == 0)
+        {
+            if (Reply_Valid(tx, rx) && (rx[8] | (rx[9] << 8)) == u16Total)
+            {
+                i32Try = 0;
+                break;
+            }
+        }
+
+        if (i32Try < 0)
+        {
+            pLink->timeouts++;
+            continue;
+        }
+
+        pLink->packno += 2;
+        u32Done = u32Skip + u32Len;
+
+        /* Count of the first erase only, a restart checks pages again which are programmed by then */
+        if ((pLink->feature & FEATURE_BLANK_SKIP) && !i32Erased)
+            u32Blank = rx[10] | (rx[11] << 8);
+
+        i32Erased = 1;
+
+        i32Try = Isp_Data(pLink, pu8Send, u32Send, pu8Data, pu32Done, u32Out, u16Total, &u32Done);
+
+        if (i32Try < 0)
+            goto Exit;
+
+        if (i32Try == 0)
+        {
+            i32Ret = 0;
+            break;
+        }
+    }
+
+Exit:
+    pLink->blank_pages += u32Blank;
+    free(pu8Packed);
+    free(pu32Done);
+    return i32Ret;
+}
+
+/* Update pages with different CRC, one CMD_UPDATE_APROM_PAGE per run of changed pages */
+static int Isp_Delta(ISP_LINK *pLink, uint16_t u16Addr, const uint8_t *pu8Image, uint32_t u32Size, uint32_t *pu32Sent)
+{
+    uint8_t tx[PACKET_SIZE], rx[PACKET_SIZE];
+    uint8_t *pu8Dirty;
+    uint32_t u32Pages, u32Page, u32Run, u32Num, i;
+    int i32Ret = 0;
+
+    u32Pages = (u32Size + PAGE_SIZE - 1) / PAGE_SIZE;
+    pu8Dirty = calloc(u32Pages, 1);
+
+    if (pu8Dirty == NULL)
+        return -1;
+
+    for (u32Page = 0; u32Page < u32Pages; u32Page += u32Num)
+    {
+        u32Num = (u32Pages - u32Page) < PAGE_CRC_MAX ? (u32Pages - u32Page) : PAGE_CRC_MAX;
+        memset(tx, 0, sizeof(tx));
+        tx[0] = CMD_READ_PAGE_CRC;
+        tx[8] = (u16Addr + u32Page * PAGE_SIZE) & 0xFF;
+        tx[9] = ((u16Addr + u32Page * PAGE_SIZE) >> 8) & 0xFF;
+        tx[10] = (uint8_t)u32Num;
+
+        if (Isp_Transfer(pLink, tx, rx, pLink->retry) < 0)
+        {
+            free(pu8Dirty);
+            return -1;
+        }
+
+        /* rx[2] pages replied, fewer at APROM end and none when CONFIG0 is locked, the others are updated */
+        for (i = 0; i < u32Num; i++)
+        {
+            if (i >= rx[2] || (rx[8 + i * 2] | (rx[9 + i * 2] << 8)) != Page_CRC16(&pu8Image[(u32Page + i) * PAGE_SIZE], PAGE_SIZE))
+                pu8Dirty[u32Page + i] = 1;
+        }
+    }
+
+    *pu32Sent = 0;
+
+    for (u32Page = 0; u32Page < u32Pages && i32Ret == 0; u32Page = u32Run)
+    {
+        if (!pu8Dirty[u32Page])
+        {
+            u32Run = u32Page + 1;
+            continue;
+        }
+
+        for (u32Run = u32Page; u32Run < u32Pages && pu8Dirty[u32Run]; u32Run++);
+
+        printf("  update 0x%04X - 0x%04X\n", u16Addr + u32Page * PAGE_SIZE, u16Addr + u32Run * PAGE_SIZE - 1);
+        i32Ret = Isp_Update(pLink, CMD_UPDATE_APROM_PAGE, u16Addr + u32Page * PAGE_SIZE,
+                            &pu8Image[u32Page * PAGE_SIZE], (u32Run - u32Page) * PAGE_SIZE);
+        *pu32Sent += (u32Run - u32Page) * PAGE_SIZE;
+    }
+
+    free(pu8Dirty);
+    return i32Ret;
+}
+
+/* Wait until the device stops sending, e.g. rest of a broken CMD_READ_APROM stream */
+static void Isp_Drain(ISP_LINK *pLink)
+{
+    uint8_t rx[PACKET_SIZE];
+
+    while (Read_Packet(pLink->fd, rx, pLink->timeout_ms) == 0);
+
+    tcflush(pLink->fd, TCIFLUSH);
+}
+
+/*
+ * Read u32Size bytes from u16Addr by CMD_READ_APROM. One request per 56 bytes, or with i32Continuous one
+ * request per range and the device streams packet number + 1, + 2 ... A wrong or lost stream packet
+ * restarts the stream from the next address still missing.
+ */
+static int Isp_Read(ISP_LINK *pLink, uint16_t u16Addr, uint8_t *pu8Buf, uint32_t u32Size, int i32Continuous)
+{
+    uint8_t tx[PACKET_SIZE], rx[PACKET_SIZE];
+    uint32_t u32Done, u32Fail, u32Len;
+    uint16_t u16Sum, u16PackNo;
+    int i32Try;
+
+    u32Done = 0;
+    u32Fail = 0;
+
+    for (i32Try = 0; i32Try <= pLink->retry && u32Done < u32Size; i32Try++)
+    {
+        if (u32Done > u32Fail)
+        {
+            u32Fail = u32Done;
+            i32Try = 0;
+        }
+
+        if (i32Try)
+        {
+            pLink->retries++;
+            Isp_Drain(pLink);
+        }
+
+        memset(tx, 0, sizeof(tx));
+        tx[0] = CMD_READ_APROM;
+        Put_U32(&tx[8], u16Addr + u32Done);
+        Put_U32(&tx[12], u32Size - u32Done);
+        tx[10] = i32Continuous ? READ_APROM_CONTINUOUS : 0;
+
+        if (!i32Continuous)
+        {
+            if (Isp_Transfer(pLink, tx, rx, pLink->retry) < 0)
+                return -1;
+
+            if ((rx[2] | (rx[3] << 8)) != (uint16_t)(u16Addr + u32Done) || rx[6] == 0 || rx[6] > READ_DATA_SIZE)
+            {
+                fprintf(stderr, "no data at 0x%04X, APROM end or CONFIG0 locked\n", u16Addr + u32Done);
+                return -1;
+            }
+
+            u32Len = (u32Size - u32Done) < rx[6] ? (u32Size - u32Done) : rx[6];
+            memcpy(&pu8Buf[u32Done], &rx[8], u32Len);
+            u32Done += u32Len;
+            i32Try = -1;
+            continue;
+        }
+
+        Put_U32(&tx[4], pLink->packno);
+        u16Sum = Packet_Sum(tx);
+        u16PackNo = (uint16_t)pLink->packno;
+        pLink->packets++;
+
+        if (Write_All(pLink->fd, tx, PACKET_SIZE) < 0)
+            return -1;
+
+        while (u32Done < u32Size)
+        {
+            if (Read_Packet(pLink->fd, rx, pLink->timeout_ms) < 0)
+            {
+                pLink->timeouts++;
+                break;
+            }
+
+            u16PackNo++;
+
+            if ((rx[0] | (rx[1] << 8)) != u16Sum || (rx[4] | (rx[5] << 8)) != u16PackNo
+                    || (rx[2] | (rx[3] << 8)) != (uint16_t)(u16Addr + u32Done) || rx[6] > READ_DATA_SIZE)
+                break;
+
+            if (rx[6] == 0)
+            {
+                fprintf(stderr, "no data at 0x%04X, APROM end or CONFIG0 locked\n", u16Addr + u32Done);
+                return -1;
+            }
+
+            u32Len = (u32Size - u32Done) < rx[6] ? (u32Size - u32Done) : rx[6];
+            memcpy(&pu8Buf[u32Done], &rx[8], u32Len);
+            u32Done += u32Len;
+        }
+
+        pLink->packno = (uint32_t)u16PackNo + 1;
+    }
+
+    return u32Done < u32Size ? -1 : 0;
+}
+
+/* CMD_RUN_APROM has no reply */
+static void Isp_Run_APROM(ISP_LINK *pLink)
+{
+    uint8_t tx[PACKET_SIZE] = {0};
+
+    tx[0] = CMD_RUN_APROM;
+    Put_U32(&tx[4], pLink->packno);
+    Write_All(pLink->fd, tx, PACKET_SIZE);
+}
+
+static void Usage(void)
+{
+    fprintf(stderr,
+            "usage: isp_uart_host [-b baud] [-B baud] [-a addr] [-d|-z] [-1] [-c] [-r retry] [-w ms] <port> info|program <bin>|verify <bin>|erase|run\n"
+            "       isp_uart_host [options] -s [-l n] [-t] [-i bin] [-k] info|program <bin>|verify <bin>|erase|run\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t image[APROM_MAX + PAGE_SIZE], readback[APROM_MAX];
+    ISP_DEVICE device;
+    ISP_LINK link;
+    uint8_t rx[PACKET_SIZE];
+    const char *pcPort = NULL, *pcCmd, *pcPreload = NULL;
+    unsigned u32Baud = 115200, u32NewBaud = 0, u32Addr = 0;
+    uint32_t u32Sent, i;
+    long i32Size = 0;
+    int opt, i32Sim = 0, i32Delta = 0, i32Packed = 0, i32Continuous = 0, i32Ret = 0, i32Status;
+    pid_t pid = 0;
+    double start, elapsed;
+
+    memset(&link, 0, sizeof(link));
+    link.retry = 3;
+    link.timeout_ms = 500;
+    link.window = PIPELINE_MAX;
+    memset(&device, 0, sizeof(device));
+
+    while ((opt = getopt(argc, argv, "b:B:a:dz1cr:w:sl:ti:k")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': u32Baud = strtoul(optarg, NULL, 0); break;
+            case 'B': u32NewBaud = strtoul(optarg, NULL, 0); break;
+            case 'a': u32Addr = strtoul(optarg, NULL, 0); break;
+            case 'd': i32Delta = 1; break;
+            case 'z': i32Packed = 1; break;
+            case '1': link.window = 1; break;
+            case 'c': i32Continuous = 1; break;
+            case 'r': link.retry = atoi(optarg); break;
+            case 'w': link.timeout_ms = atoi(optarg); break;
+            case 's': i32Sim = 1; break;
+            case 'l': device.drop_every = strtoul(optarg, NULL, 0); break;
+            case 't': device.timing = 1; break;
+            case 'k': device.locked = 1; break;
+            case 'i': pcPreload = optarg; break;
+            default:  Usage();
+        }
+    }
+
+    if (i32Delta && i32Packed)
+        Usage();
+
+    if (!i32Sim)
+    {
+        if (optind >= argc)
+            Usage();
+
+        pcPort = argv[optind++];
+    }
+
+    if (optind >= argc)
+        Usage();
+
+    pcCmd = argv[optind++];
+
+    if (strcmp(pcCmd, "program") == 0 || strcmp(pcCmd, "verify") == 0)
+    {
+        if (optind >= argc)
+            Usage();
+
+        memset(image, 0xFF, sizeof(image));
+        i32Size = Load_File(argv[optind], image, APROM_MAX);
+
+        if (i32Size <= 0 || u32Addr + i32Size > 0xFFFF)
+        {
+            fprintf(stderr, "%s: cannot read or too large\n", argv[optind]);
+            return 1;
+        }
+    }
+
+    if (i32Sim)
+    {
+        /* APROM of the device process stays readable by the host */
+        device.flash = mmap(NULL, ISP_DEVICE_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+        if (device.flash == MAP_FAILED)
+        {
+            perror("mmap");
+            return 1;
+        }
+
+        memset(device.flash, 0xFF, ISP_DEVICE_FLASH_SIZE);
+
+        if (pcPreload && Load_File(pcPreload, device.flash, ISP_DEVICE_FLASH_SIZE) < 0)
+        {
+            fprintf(stderr, "%s: cannot read or too large\n", pcPreload);
+            return 1;
+        }
+
+        link.fd = Sim_Start(&device, u32Baud, &pid);
+    }
+    else
+    {
+        link.fd = open(pcPort, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+        if (link.fd >= 0 && Set_Raw(link.fd, u32Baud) < 0)
+        {
+            fprintf(stderr, "%s: baud rate %u not supported\n", pcPort, u32Baud);
+            return 1;
+        }
+    }
+
+    if (link.fd < 0)
+    {
+        perror(i32Sim ? "pty" : pcPort);
+        return 1;
+    }
+
+    if (Isp_Connect(&link) < 0)
+    {
+        i32Ret = 1;
+    }
+    else if (u32NewBaud && !(link.feature & FEATURE_BAUDRATE))
+    {
+        fprintf(stderr, "baud rate change needs ISP_FEATURE bit1\n");
+        i32Ret = 1;
+    }
+    else if (u32NewBaud && Isp_Set_Baud(&link, u32Baud, u32NewBaud) < 0)
+    {
+        i32Ret = 1;
+    }
+    else if (strcmp(pcCmd, "info") == 0)
+    {
+        if (Isp_Command(&link, CMD_GET_DEVICEID, rx) == 0)
+            printf("Device ID 0x%08X\n", Get_U32(&rx[8]));
+
+        if (Isp_Command(&link, CMD_READ_CONFIG, rx) == 0)
+            printf("CONFIG %02X %02X %02X %02X\n", rx[8], rx[9], rx[10], rx[12]);
+    }
+    else if (strcmp(pcCmd, "erase") == 0)
+    {
+        i32Ret = Isp_Command(&link, CMD_ERASE_ALL, rx) < 0;
+
+        if (i32Ret == 0 && (link.feature & FEATURE_BLANK_SKIP))
+            link.blank_pages = rx[10] | (rx[11] << 8);
+    }
+    else if (strcmp(pcCmd, "run") == 0)
+    {
+        Isp_Run_APROM(&link);
+    }
+    else if (strcmp(pcCmd, "program") == 0)
+    {
+        start = Now();
+        u32Sent = i32Size;
+
+        if (i32Delta)
+        {
+            if (!(link.feature & FEATURE_PAGE_CRC) || (u32Addr & (PAGE_SIZE - 1)))
+            {
+                fprintf(stderr, "delta program needs ISP_FEATURE bit3 and page aligned address\n");
+                i32Ret = 1;
+            }
+            else
+            {
+                i32Ret = Isp_Delta(&link, u32Addr, image, i32Size, &u32Sent) < 0;
+                Isp_Run_APROM(&link);
+            }
+        }
+        else if (i32Packed)
+        {
+            if (!(link.feature & FEATURE_COMPRESSED))
+            {
+                fprintf(stderr, "compressed program needs ISP_FEATURE bit2\n");
+                i32Ret = 1;
+            }
+            else
+            {
+                i32Ret = Isp_Update(&link, CMD_UPDATE_APROM_COMPRESSED, u32Addr, image, i32Size) < 0;
+                u32Sent = link.packed;
+            }
+        }
+        else
+        {
+            i32Ret = Isp_Update(&link, CMD_UPDATE_APROM, u32Addr, image, i32Size) < 0;
+
+            if (link.resumed)
+                Isp_Run_APROM(&link);
+        }
+
+        elapsed = Now() - start;
+        printf("%s: %ld bytes image, %u bytes sent, %.3f s, %.0f bytes/s, %d data packets in flight\n",
+               i32Ret ? "FAIL" : "PASS", i32Size, u32Sent, elapsed, elapsed > 0 ? u32Sent / elapsed : 0.0, link.window);
+    }
+    else if (strcmp(pcCmd, "verify") == 0)
+    {
+        start = Now();
+
+        if (!(link.feature & FEATURE_READ_APROM))
+        {
+            fprintf(stderr, "verify needs ISP_FEATURE bit5\n");
+            i32Ret = 1;
+        }
+        else if (Isp_Read(&link, u32Addr, readback, i32Size, i32Continuous) < 0)
+        {
+            i32Ret = 1;
+        }
+        else
+        {
+            for (i = 0; i < (uint32_t)i32Size && readback[i] == image[i]; i++);
+
+            if (i < (uint32_t)i32Size)
+            {
+                fprintf(stderr, "0x%04X: 0x%02X of device, 0x%02X expected\n", u32Addr + i, readback[i], image[i]);
+                i32Ret = 1;
+            }
+        }
+
+        elapsed = Now() - start;
+        printf("%s: %ld bytes verified, %.3f s, %.0f bytes/s\n", i32Ret ? "FAIL" : "PASS",
+               i32Size, elapsed, elapsed > 0 ? i32Size / elapsed : 0.0);
+    }
+    else
+    {
+        Usage();
+    }
+
+    printf("packets %u, retries %u, timeouts %u, blank pages not erased %u\n", link.packets, link.retries, link.timeouts,
+           link.blank_pages);
+
+    close(link.fd);
+
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, &i32Status, 0);
+    }
+
+    /* Simulated APROM after program, also when the host has missed the last reply */
+    if (i32Sim && strcmp(pcCmd, "program") == 0)
+    {
+        for (i = 0; i < (uint32_t)i32Size && u32Addr + i < ISP_DEVICE_FLASH_SIZE && device.flash[u32Addr + i] == image[i]; i++);
+
+        if (i < (uint32_t)i32Size)
+        {
+            printf("device APROM FAIL at 0x%04X\n", u32Addr + i);
+            i32Ret = 1;
+        }
+        else
+        {
+            printf("device APROM PASS\n");
+        }
+    }
+
+    return i32Ret;
+}
@@ -0,0 +1,13 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Host build of lz_decode.c for lz_pack_test, Keil memory type keyword removed, no SFR */
+#define xdata
+#define FAIL                    1
+#define PASS                    0
+
+#include "../../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/StdDriver/inc/lz_decode.h"
@@ -0,0 +1,144 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: LZ packer of CMD_UPDATE_APROM_COMPRESSED images, stream format of lz_decode.c
+//
+//  Build : cc -O2 -o lz_pack lz_pack.c
+//          isp_uart_host and lz_pack_test link LZ_Pack() only, built with -DLZ_PACK_LIB
+//
+//  Usage : lz_pack <bin> <packed>
+//
+//  Greedy longest match in the last 256 bytes, 3 ~ 258 bytes. isp_uart_host -z packs the image itself, the
+//  packed file is for other hosts, e.g. ISP_UART1 or ISP_I2C, which send it as the payload of
+//  CMD_UPDATE_APROM_COMPRESSED with the size of <bin> in byte 12..13.
+//***********************************************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lz_pack.h"
+
+/**
+ * @brief       Pack u32Len bytes of pu8In
+ * @param       pu8Out LZ_PACK_BOUND(u32Len) bytes
+ * @param       pu32Done NULL or one word per packed byte, count of pu8In bytes the decoder has output after
+ *              that byte, for the expected checksum of each ISP reply
+ * @return      packed size
+ */
+uint32_t LZ_Pack(const uint8_t *pu8In, uint32_t u32Len, uint8_t *pu8Out, uint32_t *pu32Done)
+{
+    uint32_t u32Pos, u32Out, u32Flag, u32Dist, u32Max, u32Best, u32BestDist, n;
+    int i32Token;
+
+    u32Pos = 0;
+    u32Out = 0;
+    u32Flag = 0;
+    i32Token = 8;
+
+    while (u32Pos < u32Len)
+    {
+        if (i32Token == 8)
+        {
+            u32Flag = u32Out;
+            pu8Out[u32Out] = 0;
+
+            if (pu32Done)
+                pu32Done[u32Out] = u32Pos;
+
+            u32Out++;
+            i32Token = 0;
+        }
+
+        u32Max = (u32Len - u32Pos) < LZ_PACK_MAX_MATCH ? (u32Len - u32Pos) : LZ_PACK_MAX_MATCH;
+        u32Best = 0;
+        u32BestDist = 0;
+
+        for (u32Dist = 1; u32Dist <= LZ_PACK_WINDOW && u32Dist <= u32Pos && u32Best < u32Max; u32Dist++)
+        {
+            for (n = 0; n < u32Max && pu8In[u32Pos + n] == pu8In[u32Pos + n - u32Dist]; n++);
+
+            if (n > u32Best)
+            {
+                u32Best = n;
+                u32BestDist = u32Dist;
+            }
+        }
+
+        if (u32Best >= LZ_PACK_MIN_MATCH)
+        {
+            pu8Out[u32Out] = (uint8_t)(u32BestDist - 1);
+
+            if (pu32Done)
+                pu32Done[u32Out] = u32Pos;
+
+            u32Out++;
+            u32Pos += u32Best;
+            pu8Out[u32Out] = (uint8_t)(u32Best - LZ_PACK_MIN_MATCH);
+        }
+        else
+        {
+            pu8Out[u32Flag] |= 1 << i32Token;
+            pu8Out[u32Out] = pu8In[u32Pos++];
+        }
+
+        if (pu32Done)
+            pu32Done[u32Out] = u32Pos;
+
+        u32Out++;
+        i32Token++;
+    }
+
+    return u32Out;
+}
+
+#ifndef LZ_PACK_LIB
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    uint8_t *pu8In, *pu8Out;
+    long i32Len;
+    uint32_t u32Out;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: lz_pack <bin> <packed>\n");
+        return 2;
+    }
+
+    fp = fopen(argv[1], "rb");
+
+    if (fp == NULL || fseek(fp, 0, SEEK_END) < 0 || (i32Len = ftell(fp)) <= 0 || i32Len > 0xFFFF)
+    {
+        fprintf(stderr, "%s: cannot read or not 1 ~ 65535 bytes\n", argv[1]);
+        return 1;
+    }
+
+    rewind(fp);
+    pu8In = malloc(i32Len);
+    pu8Out = malloc(LZ_PACK_BOUND(i32Len));
+
+    if (pu8In == NULL || pu8Out == NULL || fread(pu8In, 1, i32Len, fp) != (size_t)i32Len)
+    {
+        fprintf(stderr, "%s: cannot read\n", argv[1]);
+        return 1;
+    }
+
+    fclose(fp);
+    u32Out = LZ_Pack(pu8In, i32Len, pu8Out, NULL);
+    fp = fopen(argv[2], "wb");
+
+    if (fp == NULL || fwrite(pu8Out, 1, u32Out, fp) != u32Out || fclose(fp) != 0)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    printf("%ld bytes packed to %u bytes, %.1f%%\n", i32Len, u32Out, u32Out * 100.0 / i32Len);
+    return 0;
+}
+#endif
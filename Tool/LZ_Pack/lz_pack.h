@@ -0,0 +1,21 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Host LZ packer of the stream decoded by lz_decode.c (CMD_UPDATE_APROM_COMPRESSED)                      */
+/*  Flag byte and 8 tokens, flag bit 0 first. Bit 1 token is one literal byte, bit 0 token is distance - 1 */
+/*  and length - LZ_PACK_MIN_MATCH. A match never refers before the first byte, the window of the decoder */
+/*  is not cleared by LZ_Decode_Init.                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+#include <stdint.h>
+
+#define LZ_PACK_MIN_MATCH       3           /* LZ_MIN_MATCH of lz_decode.h */
+#define LZ_PACK_MAX_MATCH       (LZ_PACK_MIN_MATCH + 255)
+#define LZ_PACK_WINDOW          256         /* LZ_WINDOW_SIZE of lz_decode.h */
+#define LZ_PACK_BOUND(n)        ((n) + ((n) + 7) / 8)   /* packed size of n bytes is never more */
+
+uint32_t LZ_Pack(const uint8_t *pu8In, uint32_t u32Len, uint8_t *pu8Out, uint32_t *pu32Done);
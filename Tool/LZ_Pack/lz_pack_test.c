@@ -0,0 +1,329 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Round trip test of lz_pack.c and the library lz_decode.c into a simulated 32 KB APROM
+//
+//  Build : SRC=../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/StdDriver/src
+//          cc -O2 -DLZ_PACK_LIB -I host_inc -o lz_pack_test lz_pack_test.c lz_pack.c $SRC/lz_decode.c
+//
+//  Usage : lz_pack_test [-s seed] [-v] [bin ...]
+//
+//  Each image is packed and fed to LZ_Decode_Input / LZ_Decode_Byte as Program_Compressed of ISP does:
+//  the first part is the 48 bytes of CMD_UPDATE_APROM_COMPRESSED, the others the 56 bytes of a data packet,
+//  the last one padded by 0xFF, and decoding stops at the image size. Then again with random parts of 1 ~ 64
+//  bytes and with single bytes, so every token is split at every byte. After each part the output count
+//  must equal the pu32Done of LZ_Pack (isp_uart_host checks the device checksum by it), at the end the APROM
+//  must equal the image and the rest of the APROM must still be 0xFF.
+//
+//  Images: 32 KB blank, random and firmware like, distance 256 / length 258 limits, overlapping match,
+//  1 ~ 300 bytes, and each <bin> up to 32 KB.
+//
+//  Options
+//    -s <seed>         random seed, default 1
+//    -v                print each test
+//***********************************************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lz_pack.h"
+#include "MS51_16K.h"
+
+#define APROM_SIZE              (32 * 1024)
+#define FIRST_DATA_SIZE         48          /* CMD_UPDATE_APROM_COMPRESSED payload from byte 16 */
+#define NEXT_DATA_SIZE          56          /* data packet payload from byte 8 */
+
+#define SPLIT_ISP               0
+#define SPLIT_RANDOM            1
+#define SPLIT_BYTE              2
+
+static uint8_t au8APROM[APROM_SIZE];
+static uint8_t au8Packed[LZ_PACK_BOUND(APROM_SIZE)];
+static uint32_t au32Done[LZ_PACK_BOUND(APROM_SIZE)];
+static uint8_t au8Distance[LZ_PACK_BOUND(APROM_SIZE)];     /* 1 at distance byte of a match token */
+static unsigned u32Tests, u32Failed, u32Split;
+static int i32Verbose;
+
+static const char *SplitName[] = {"48/56", "random", "1 byte"};
+
+/* Decode one stream into au8APROM by parts, return 0 when output and APROM are right */
+static int Decode_Image(const uint8_t *pu8Image, uint32_t u32Size, uint32_t u32Packed, int i32Split)
+{
+    uint8_t au8Part[64];
+    uint8_t u8Data;
+    uint32_t u32Pos, u32Len, u32Addr, u32Expect, i;
+
+    memset(au8APROM, 0xFF, sizeof(au8APROM));
+    LZ_Decode_Init();
+    u32Addr = 0;
+
+    for (u32Pos = 0; u32Pos < u32Packed && u32Addr < u32Size; u32Pos += u32Len)
+    {
+        if (i32Split == SPLIT_ISP)
+            u32Len = u32Pos ? NEXT_DATA_SIZE : FIRST_DATA_SIZE;
+        else if (i32Split == SPLIT_RANDOM)
+            u32Len = 1 + rand() % 64;
+        else
+            u32Len = 1;
+
+        memset(au8Part, 0xFF, sizeof(au8Part));
+
+        for (i = 0; i < u32Len && u32Pos + i < u32Packed; i++)
+            au8Part[i] = au8Packed[u32Pos + i];
+
+        /* Match token split between two parts of a 48/56 split, the length byte comes from decoder state */
+        if (i32Split == SPLIT_ISP && u32Pos + u32Len < u32Packed && au8Distance[u32Pos + u32Len - 1])
+            u32Split++;
+
+        LZ_Decode_Input(au8Part, (unsigned char)u32Len);
+
+        while (u32Addr < u32Size && LZ_Decode_Byte(&u8Data) == PASS)
+            au8APROM[u32Addr++] = u8Data;
+
+        u32Expect = (u32Pos + u32Len < u32Packed) ? au32Done[u32Pos + u32Len - 1] : u32Size;
+
+        if (u32Addr != u32Expect)
+        {
+            printf("  %u bytes output after %u packed bytes, %u expected\n", u32Addr, u32Pos + u32Len, u32Expect);
+            return -1;
+        }
+    }
+
+    if (u32Addr != u32Size)
+    {
+        printf("  stream ended after %u bytes of %u\n", u32Addr, u32Size);
+        return -1;
+    }
+
+    for (i = 0; i < u32Size && au8APROM[i] == pu8Image[i]; i++);
+
+    if (i < u32Size)
+    {
+        printf("  0x%04X: 0x%02X decoded, 0x%02X expected\n", i, au8APROM[i], pu8Image[i]);
+        return -1;
+    }
+
+    for (i = u32Size; i < APROM_SIZE && au8APROM[i] == 0xFF; i++);
+
+    if (i < APROM_SIZE)
+    {
+        printf("  0x%04X: 0x%02X written after end of image\n", i, au8APROM[i]);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void Test_Image(const char *pcName, const uint8_t *pu8Image, uint32_t u32Size)
+{
+    uint32_t u32Packed, i, k;
+    uint8_t u8Flag = 0;
+    int i32Split, i32Fail;
+
+    u32Packed = LZ_Pack(pu8Image, u32Size, au8Packed, au32Done);
+    i32Fail = 0;
+
+    /* Mark distance bytes by the flag bits */
+    memset(au8Distance, 0, u32Packed);
+
+    for (i = 0, k = 0; i < u32Packed; k = (k + 1) % 9)
+    {
+        if (k == 0)
+        {
+            u8Flag = au8Packed[i++];
+        }
+        else if (u8Flag & (1 << (k - 1)))
+        {
+            i++;
+        }
+        else
+        {
+            au8Distance[i] = 1;
+            i += 2;
+        }
+    }
+
+    if (u32Packed > LZ_PACK_BOUND(u32Size))
+    {
+        printf("  %u bytes packed to %u, over LZ_PACK_BOUND\n", u32Size, u32Packed);
+        i32Fail = 1;
+    }
+
+    for (i32Split = SPLIT_ISP; i32Split <= SPLIT_BYTE && !i32Fail; i32Split++)
+    {
+        if (Decode_Image(pu8Image, u32Size, u32Packed, i32Split) < 0)
+        {
+            printf("  %s parts\n", SplitName[i32Split]);
+            i32Fail = 1;
+        }
+    }
+
+    u32Tests++;
+
+    if (i32Fail)
+    {
+        u32Failed++;
+        printf("  FAIL %s\n", pcName);
+    }
+    else if (i32Verbose || u32Size >= 1024)
+    {
+        printf("  pass %s: %u bytes packed to %u, %.1f%%\n", pcName, u32Size, u32Packed, u32Packed * 100.0 / u32Size);
+    }
+}
+
+/* 8051 like code: short instruction patterns with random operands, copied blocks, tables, 0xFF at the end */
+static void Make_Firmware(uint8_t *pu8Image, uint32_t u32Size)
+{
+    static const uint8_t au8Op[][3] =
+    {
+        {0x90, 0x00, 0x00}, {0xE0, 0x00, 0x00}, {0xF0, 0x00, 0x00}, {0x75, 0xA4, 0x00}, {0x12, 0x00, 0x00},
+        {0x22, 0x00, 0x00}, {0x74, 0x00, 0x00}, {0xE5, 0x00, 0x00}, {0xF5, 0x00, 0x00}, {0x80, 0x00, 0x00}
+    };
+    static const uint8_t au8OpLen[] = {3, 1, 1, 3, 3, 1, 2, 2, 2, 2};
+    uint32_t u32Pos, u32Len, u32From, i, k;
+
+    u32Pos = 0;
+
+    while (u32Pos < u32Size * 3 / 4)
+    {
+        switch (rand() % 8)
+        {
+            case 0:                             /* copy of earlier code, inside or outside of the window */
+                if (u32Pos < 16)
+                    break;
+
+                u32Len = 4 + rand() % 300;
+                u32From = u32Pos - 1 - rand() % (u32Pos < 1000 ? u32Pos : 1000);
+
+                for (i = 0; i < u32Len && u32Pos < u32Size; i++)
+                    pu8Image[u32Pos++] = pu8Image[u32From + i];
+                break;
+
+            case 1:                             /* table */
+                u32Len = 8 + rand() % 64;
+
+                for (i = 0; i < u32Len && u32Pos < u32Size; i++)
+                    pu8Image[u32Pos++] = rand();
+                break;
+
+            default:
+                for (i = 0; i < 16; i++)
+                {
+                    k = rand() % 10;
+
+                    if (u32Pos + au8OpLen[k] > u32Size)
+                        break;
+
+                    pu8Image[u32Pos++] = au8Op[k][0];
+
+                    if (au8OpLen[k] > 1)
+                        pu8Image[u32Pos++] = (k == 3) ? au8Op[k][1] : rand() % 16;
+
+                    if (au8OpLen[k] > 2)
+                        pu8Image[u32Pos++] = rand();
+                }
+                break;
+        }
+    }
+
+    for (; u32Pos < u32Size; u32Pos++)
+        pu8Image[u32Pos] = 0xFF;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t au8Image[APROM_SIZE], au8Small[300];
+    char acName[64];
+    FILE *fp;
+    uint32_t u32Size, i;
+    int opt;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "s:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 's': srand(strtoul(optarg, NULL, 0)); break;
+            case 'v': i32Verbose = 1; break;
+            default:
+                fprintf(stderr, "usage: lz_pack_test [-s seed] [-v] [bin ...]\n");
+                return 2;
+        }
+    }
+
+    printf("lz_pack.c / lz_decode.c\n");
+
+    memset(au8Image, 0xFF, sizeof(au8Image));
+    Test_Image("blank 32 KB", au8Image, APROM_SIZE);
+
+    for (i = 0; i < APROM_SIZE; i++)
+        au8Image[i] = rand();
+
+    Test_Image("random 32 KB", au8Image, APROM_SIZE);
+
+    Make_Firmware(au8Image, APROM_SIZE);
+    Test_Image("firmware like 32 KB", au8Image, APROM_SIZE);
+
+    /* Same 256 bytes again, only distance 256 matches */
+    for (i = 0; i < 4096; i++)
+        au8Image[i] = (i < LZ_PACK_WINDOW) ? rand() : au8Image[i - LZ_PACK_WINDOW];
+
+    Test_Image("distance 256", au8Image, 4096);
+
+    /* Runs around the length limit */
+    for (u32Size = 0, i = LZ_PACK_MAX_MATCH - 2; i <= LZ_PACK_MAX_MATCH + 3; i++)
+    {
+        au8Image[u32Size] = rand();
+        memset(&au8Image[u32Size + 1], au8Image[u32Size], i);
+        u32Size += i + 1;
+    }
+
+    Test_Image("length 258", au8Image, u32Size);
+
+    /* Distance 1 ~ 3 shorter than the length, the decoder copies bytes it has just written */
+    for (i = 0; i < 2000; i++)
+        au8Image[i] = (i % 3 == 0) ? 'a' : (i % 3 == 1) ? 'b' : 'c';
+
+    Test_Image("overlapping match", au8Image, 2000);
+
+    for (u32Size = 1; u32Size <= sizeof(au8Small); u32Size++)
+    {
+        for (i = 0; i < u32Size; i++)
+            au8Small[i] = (rand() % 4) ? (uint8_t)(i % 7) : rand();
+
+        sprintf(acName, "%u bytes", u32Size);
+        Test_Image(acName, au8Small, u32Size);
+    }
+
+    printf("  1 ~ %u bytes\n", (unsigned)sizeof(au8Small));
+
+    for (; optind < argc; optind++)
+    {
+        fp = fopen(argv[optind], "rb");
+
+        if (fp == NULL)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+
+        u32Size = fread(au8Image, 1, sizeof(au8Image), fp);
+        fclose(fp);
+
+        if (u32Size)
+            Test_Image(argv[optind], au8Image, u32Size);
+    }
+
+    printf("  %u match tokens split between two 48/56 packets\n", u32Split);
+    printf("result: %u tests, %u failed\n", u32Tests, u32Failed);
+
+    return u32Failed != 0;
+}
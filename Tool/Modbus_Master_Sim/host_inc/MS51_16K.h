@@ -0,0 +1,81 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Host build of modbus.c and modbus_port.c of MS51 16K for modbus_master_sim, GCC C++ x86-64.            */
+/*  Both are compiled as C++ against this file and the real SFR_Macro_MS51_16K.h, only the Keil keywords   */
+/*  and the SFR are replaced:                                                                              */
+/*    code      removed                                                                                    */
+/*    int       short, 16 bit as Keil C51 (expressions are still promoted to 32 bit)                       */
+/*    SFR/sbit  a HOST_SFR object, each read, write or read-modify-write is one call of the model in       */
+/*              modbus_master_sim.cpp, so TR0 = 1 starts Timer0 at once, and an interrupt is taken only    */
+/*              between two accesses                                                                       */
+/*  Include system headers before this file, they must not see the int define.                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#define HOST_SBIT(sfr, b)       (0x100 | (sfr) | (b))   /* index of an sbit, 8051 bit address + 0x100 */
+
+unsigned char Host_SFR_Read(unsigned short u16Index);
+void Host_SFR_Modify(unsigned short u16Index, unsigned char u8And, unsigned char u8Or);
+
+class HOST_SFR
+{
+public:
+    explicit HOST_SFR(unsigned short u16Index) : m_u16Index(u16Index) {}
+    operator unsigned char() const                  { return Host_SFR_Read(m_u16Index); }
+    HOST_SFR &operator=(unsigned char u8Value)      { Host_SFR_Modify(m_u16Index, 0x00, u8Value); return *this; }
+    HOST_SFR &operator=(const HOST_SFR &Sfr)        { return *this = (unsigned char)Sfr; }   /* TH0=TL0=0 */
+    HOST_SFR &operator|=(unsigned char u8Value)     { Host_SFR_Modify(m_u16Index, 0xFF, u8Value); return *this; }
+    HOST_SFR &operator&=(unsigned char u8Value)     { Host_SFR_Modify(m_u16Index, u8Value, 0x00); return *this; }
+
+private:
+    unsigned short m_u16Index;
+};
+
+#define xdata
+#define idata
+#define pdata
+#define data
+#define code
+#define bit                     unsigned char
+#define reentrant
+#define putchar                 fw_putchar          /* uart_putchar.h prototype differs from stdio.h */
+#define int                     short
+
+/* Function_Define_MS51_16K.h types of Keil width, host sys/types.h has other int32_t */
+#define uint8_t                 fw_uint8_t
+#define uint16_t                fw_uint16_t
+#define uint32_t                fw_uint32_t
+#define int8_t                  fw_int8_t
+#define int16_t                 fw_int16_t
+#define int32_t                 fw_int32_t
+
+#include "../../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/Device/Include/SFR_Macro_MS51_16K.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SFR and sbit used by modbus_port.c with UART0, Timer0 and MODBUS_DE_PIN=P05                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TCON                    HOST_SFR(0x88)
+#define TMOD                    HOST_SFR(0x89)
+#define TL0                     HOST_SFR(0x8A)
+#define TH0                     HOST_SFR(0x8C)
+#define CKCON                   HOST_SFR(0x8E)
+#define SFRS                    HOST_SFR(0x91)
+#define SCON                    HOST_SFR(0x98)
+#define SBUF                    HOST_SFR(0x99)
+#define IE                      HOST_SFR(0xA8)
+
+#define P05                     HOST_SFR(HOST_SBIT(0x80, 5))
+#define TR0                     HOST_SFR(HOST_SBIT(0x88, 4))
+#define TF0                     HOST_SFR(HOST_SBIT(0x88, 5))
+#define RI                      HOST_SFR(HOST_SBIT(0x98, 0))
+#define TI                      HOST_SFR(HOST_SBIT(0x98, 1))
+#define ET0                     HOST_SFR(HOST_SBIT(0xA8, 1))
+#define ES                      HOST_SFR(HOST_SBIT(0xA8, 4))
+#define EA                      HOST_SFR(HOST_SBIT(0xA8, 7))
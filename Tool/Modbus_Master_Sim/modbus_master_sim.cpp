@@ -0,0 +1,996 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Host test of modbus.c and modbus_port.c, a Modbus RTU master against the slave on an SFR
+//                 model of UART0 and Timer0 in simulated time
+//
+//  Build : make            (GCC, see Makefile and host_inc/MS51_16K.h)
+//  Usage : modbus_master_sim [-b baud] [-n count] [-s seed] [-v]
+//
+//  modbus.c and modbus_port.c of the 16K library are compiled as C++ against host_inc/MS51_16K.h with
+//  MODBUS_UART UART0, MODBUS_TIMER 0 and MODBUS_DE_PIN=P05. Each SFR access is a call of Host_SFR_Read or
+//  Host_SFR_Modify. The slave runs Modbus_Open and the main loop of UART0_Modbus_RTU_Slave, the Timer0 and
+//  UART0 vectors call Modbus_Timer_ISR and Modbus_UART_ISR.
+//
+//  Model
+//    CPU               ACCESS_NS per SFR access, VECTOR_NS per interrupt. The C code between two accesses
+//                      takes no time, so the reply start is checked for the timer and UART sequence of
+//                      modbus_port.c, not for the cycles of Modbus_Execute
+//    interrupt         Timer0 (TF0 and ET0, TF0 cleared by the vector) before UART0 (RI / TI and ES), the
+//                      vector order, when EA is 1. Taken after an SFR access or while main waits, an ISR is
+//                      not interrupted
+//    Timer0            mode 1 of TMOD, Fsys / 12 or Fsys by CKCON T0M, Fsys 24 MHz, counts while TR0 is 1,
+//                      TF0 at overflow
+//    UART0             8N1 of 10 bits. A master byte sets RI at its stop bit and is lost when RI is still 1.
+//                      TI is set 10 bits after a write of SBUF, a write of SBUF while a byte is sent is
+//                      counted as an overwrite. P05 DE is high while a reply byte is sent
+//
+//  The master checks each reply against its own copy of the map and checks the time of every reply: the
+//  first byte starts T3.5 to T3.5 + one character (11 bits) after the stop bit of the request, no gap inside
+//  the reply is over 1.5 characters, DE is low after it, and Modbus_Poll reported the served write.
+//
+//  Tests: read and write of each function code, quantity and address exceptions, unknown function, other
+//  slave address, bad CRC, broadcast, a frame with 1.5 character silence, a frame split by a T3.5 gap,
+//  frame over MODBUS_FRAME_MAX, then <count> random requests. Slave counters are read back as input
+//  registers 100 to 103.
+//
+//  Options
+//    -b <baud>         bit rate, default 9600, T3.5 is 1750 us above 19200
+//    -n <count>        random requests, default 300
+//    -s <seed>         random seed, default 1
+//    -v                print frames
+//***********************************************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MS51_16K.h"
+#undef int
+#undef data
+#undef bit
+
+#define FSYS                    24000000UL
+#define ACCESS_NS               250.0       /* one SFR access with the code around it, 6 clocks of 24 MHz */
+#define VECTOR_NS               1000.0      /* LCALL of the vector, push, pop and RETI */
+#define REPLY_WAIT_NS           200e6
+#define NEVER                   1e30
+#define ISR_STORM               10000
+#define LINE_MAX                (MODBUS_FRAME_MAX + 64)
+
+#define SLAVE_ADDRESS           1
+#define DIAG_ADDRESS            100         /* input registers of slave counters */
+
+#define SFR_P0                  0x80
+#define SFR_TCON                0x88
+#define SFR_TMOD                0x89
+#define SFR_TL0                 0x8A
+#define SFR_TH0                 0x8C
+#define SFR_CKCON               0x8E
+#define SFR_SFRS                0x91
+#define SFR_SCON                0x98
+#define SFR_SBUF                0x99
+#define SFR_IE                  0xA8
+
+#define P0_DE                   0x20
+#define TCON_TR0                0x10
+#define TCON_TF0                0x20
+#define CKCON_T0M               0x08
+#define SCON_RI                 0x01
+#define SCON_TI                 0x02
+#define IE_ET0                  0x02
+#define IE_ES                   0x10
+#define IE_EA                   0x80
+
+/* Map data, one copy in the slave and one in the master as the expected content */
+typedef struct
+{
+    unsigned char  au8Coil[5];              /* coil 0 to 39 */
+    unsigned char  au8CoilHigh[2];          /* coil 100 to 115 */
+    unsigned char  au8Discrete[3];          /* discrete input 0 to 23 */
+    unsigned short au16Input[16];           /* input register 0 to 15 */
+    unsigned short au16Diag[4];             /* input register 100 to 103 */
+    unsigned short au16Holding[130];        /* holding register 0 to 129 */
+    unsigned short au16HoldingHigh[10];     /* holding register 1000 to 1009 */
+} MAP_DATA;
+
+static MAP_DATA s_Slave, s_Master;
+
+#define MAP_TABLE(d)                                                \
+{                                                                   \
+    {MODBUS_COIL,        0,            40,  (d).au8Coil},           \
+    {MODBUS_COIL,        100,          16,  (d).au8CoilHigh},       \
+    {MODBUS_DISCRETE,    0,            24,  (d).au8Discrete},       \
+    {MODBUS_INPUT_REG,   0,            16,  (d).au16Input},         \
+    {MODBUS_INPUT_REG,   DIAG_ADDRESS, 4,   (d).au16Diag},          \
+    {MODBUS_HOLDING_REG, 0,            130, (d).au16Holding},       \
+    {MODBUS_HOLDING_REG, 1000,         10,  (d).au16HoldingHigh},   \
+    {0, 0, 0, 0}                                                    \
+}
+
+static MODBUS_MAP SlaveMap[] = MAP_TABLE(s_Slave);
+static MODBUS_MAP MasterMap[] = MAP_TABLE(s_Master);
+
+static struct
+{
+    unsigned char sfr[256];
+    double        now;
+    int           in_isr;
+
+    /* Timer0, TH0:TL0 is the count at t0_start while TR0 is 1 */
+    double        t0_start;
+
+    /* UART0 */
+    unsigned      baud;
+    double        bit_ns;
+    unsigned long open_clock, open_baud;
+    unsigned      open_port;
+    unsigned char rx_sbuf;
+    unsigned char rx_byte[LINE_MAX];        /* request bytes of the master */
+    double        rx_at[LINE_MAX];          /* stop bit of each request byte */
+    unsigned      rx_len, rx_next;
+    int           tx_busy;
+    double        tx_done;
+    unsigned char reply[LINE_MAX];          /* reply bytes of the slave */
+    double        reply_at[LINE_MAX];       /* write of SBUF, start bit */
+    unsigned      reply_len;
+    unsigned long rx_lost, tx_overwrite, de_error;
+
+    /* slave main loop */
+    unsigned char written, expect_written;
+
+    /* master */
+    double        char_ns;                  /* 11 bit character of T3.5 */
+    double        t35_ns;
+    int           verbose;
+    unsigned      frames, crc_errors, overruns, exceptions;   /* expected slave counters */
+    unsigned      tests, failed, replies;
+    double        start_max, start_min, gap_max;
+} g_sim;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SFR model                                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+static double Timer0_Tick_Ns(void)
+{
+    return ((g_sim.sfr[SFR_CKCON] & CKCON_T0M) ? 1.0 : 12.0) * 1e9 / FSYS;
+}
+
+/* Count of Timer0 up to now, TF0 at overflow, mode 1 goes on from 0 */
+static void Timer0_Update(void)
+{
+    double tick = Timer0_Tick_Ns();
+    unsigned long u32Ticks, u32Count;
+
+    if (!(g_sim.sfr[SFR_TCON] & TCON_TR0))
+        return;
+
+    u32Ticks = (unsigned long)((g_sim.now - g_sim.t0_start) / tick + 1e-6);
+    if (u32Ticks == 0)
+        return;
+
+    u32Count = ((unsigned long)g_sim.sfr[SFR_TH0] << 8 | g_sim.sfr[SFR_TL0]) + u32Ticks;
+    if (u32Count > 0xFFFF)
+        g_sim.sfr[SFR_TCON] |= TCON_TF0;
+
+    g_sim.sfr[SFR_TH0] = (unsigned char)(u32Count >> 8);
+    g_sim.sfr[SFR_TL0] = (unsigned char)u32Count;
+    g_sim.t0_start += u32Ticks * tick;
+}
+
+static double Timer0_Overflow_At(void)
+{
+    unsigned long u32Count = (unsigned long)g_sim.sfr[SFR_TH0] << 8 | g_sim.sfr[SFR_TL0];
+
+    if (!(g_sim.sfr[SFR_TCON] & TCON_TR0))
+        return NEVER;
+
+    return g_sim.t0_start + (0x10000 - u32Count) * Timer0_Tick_Ns();
+}
+
+static void Line_Update(void)
+{
+    Timer0_Update();
+
+    if (g_sim.tx_busy && g_sim.now >= g_sim.tx_done)
+    {
+        g_sim.tx_busy = 0;
+        g_sim.sfr[SFR_SCON] |= SCON_TI;
+    }
+
+    while ((g_sim.rx_next < g_sim.rx_len) && (g_sim.rx_at[g_sim.rx_next] <= g_sim.now))
+    {
+        if (g_sim.sfr[SFR_SCON] & SCON_RI)
+        {
+            g_sim.rx_lost++;
+        }
+        else
+        {
+            g_sim.rx_sbuf = g_sim.rx_byte[g_sim.rx_next];
+            g_sim.sfr[SFR_SCON] |= SCON_RI;
+        }
+
+        g_sim.rx_next++;
+    }
+}
+
+static void Irq_Dispatch(void)
+{
+    unsigned char u8SFRS;
+    unsigned u32Isr = 0;
+
+    if (g_sim.in_isr)
+        return;
+
+    g_sim.in_isr = 1;
+
+    for (;;)
+    {
+        Line_Update();
+
+        /* an ISR that does not clear its flag is taken again at once */
+        if (++u32Isr > ISR_STORM)
+        {
+            printf("FAIL %u interrupts in a row, TCON %02X, SCON %02X\n", ISR_STORM, g_sim.sfr[SFR_TCON],
+                   g_sim.sfr[SFR_SCON]);
+            exit(1);
+        }
+
+        if (!(g_sim.sfr[SFR_IE] & IE_EA))
+            break;
+
+        /* Timer0_ISR of UART0_Modbus_RTU_Slave and UART0 vector of uart.c save SFRS */
+        if ((g_sim.sfr[SFR_IE] & IE_ET0) && (g_sim.sfr[SFR_TCON] & TCON_TF0))
+        {
+            g_sim.now += VECTOR_NS;
+            g_sim.sfr[SFR_TCON] &= ~TCON_TF0;
+            u8SFRS = g_sim.sfr[SFR_SFRS];
+            Modbus_Timer_ISR();
+            g_sim.sfr[SFR_SFRS] = u8SFRS;
+            continue;
+        }
+
+        if ((g_sim.sfr[SFR_IE] & IE_ES) && (g_sim.sfr[SFR_SCON] & (SCON_RI | SCON_TI)))
+        {
+            g_sim.now += VECTOR_NS;
+            u8SFRS = g_sim.sfr[SFR_SFRS];
+            Modbus_UART_ISR();
+            g_sim.sfr[SFR_SFRS] = u8SFRS;
+            continue;
+        }
+
+        break;
+    }
+
+    g_sim.in_isr = 0;
+}
+
+unsigned char Host_SFR_Read(unsigned short u16Index)
+{
+    unsigned char u8Value;
+
+    g_sim.now += ACCESS_NS;
+    Line_Update();
+
+    if (u16Index & 0x100)
+        u8Value = (g_sim.sfr[u16Index & 0xF8] >> (u16Index & 0x07)) & 1;
+    else if (u16Index == SFR_SBUF)
+        u8Value = g_sim.rx_sbuf;
+    else
+        u8Value = g_sim.sfr[u16Index & 0xFF];
+
+    Irq_Dispatch();
+    return u8Value;
+}
+
+/* Write (u8And 0) or read-modify-write of one SFR or sbit, one instruction of the CPU */
+void Host_SFR_Modify(unsigned short u16Index, unsigned char u8And, unsigned char u8Or)
+{
+    unsigned char u8Addr, u8Mask, u8Old;
+
+    g_sim.now += ACCESS_NS;
+    Line_Update();
+
+    if (u16Index & 0x100)
+    {
+        u8Addr = u16Index & 0xF8;
+        u8Mask = 1 << (u16Index & 0x07);
+    }
+    else
+    {
+        u8Addr = u16Index & 0xFF;
+        u8Mask = 0xFF;
+    }
+
+    u8Old = g_sim.sfr[u8Addr];
+
+    if (u16Index & 0x100)
+    {
+        if ((((u8Old & u8Mask) ? 1 : 0) & u8And) | u8Or)
+            g_sim.sfr[u8Addr] |= u8Mask;
+        else
+            g_sim.sfr[u8Addr] &= ~u8Mask;
+    }
+    else if (u8Addr == SFR_SBUF)
+    {
+        if (g_sim.tx_busy)
+            g_sim.tx_overwrite++;
+        if (!(g_sim.sfr[SFR_P0] & P0_DE))
+            g_sim.de_error++;
+
+        if (g_sim.reply_len < LINE_MAX)
+        {
+            g_sim.reply[g_sim.reply_len] = u8Or;
+            g_sim.reply_at[g_sim.reply_len++] = g_sim.now;
+        }
+
+        g_sim.tx_busy = 1;
+        g_sim.tx_done = g_sim.now + 10 * g_sim.bit_ns;
+    }
+    else
+    {
+        g_sim.sfr[u8Addr] = (u8Old & u8And) | u8Or;
+    }
+
+    /* TR0 0 to 1 starts the count, a write of TL0 / TH0 restarts the tick */
+    if (((u8Addr == SFR_TCON) && !(u8Old & TCON_TR0) && (g_sim.sfr[SFR_TCON] & TCON_TR0)) ||
+        (u8Addr == SFR_TL0) || (u8Addr == SFR_TH0))
+        g_sim.t0_start = g_sim.now;
+
+    /* DE released while the last byte is on the bus */
+    if ((u8Addr == SFR_P0) && (u8Old & P0_DE) && !(g_sim.sfr[SFR_P0] & P0_DE) && g_sim.tx_busy)
+        g_sim.de_error++;
+
+    Irq_Dispatch();
+}
+
+/* uart.c is not built, baud rate of Modbus_Open is checked against the line */
+void UART_Open(unsigned long u32SysClock, unsigned char u8UARTPort, unsigned long u32Baudrate)
+{
+    g_sim.open_clock = u32SysClock;
+    g_sim.open_port = u8UARTPort;
+    g_sim.open_baud = u32Baudrate;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Slave, main loop of UART0_Modbus_RTU_Slave                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+/* One pass of the main loop, then wait without SFR access for the next event up to t_end */
+static void Slave_Step(double t_end)
+{
+    unsigned char u8Function, bEA;
+    double next = t_end;
+
+    u8Function = Modbus_Poll();
+    if (u8Function)
+        g_sim.written = u8Function;
+
+    bEA = EA;
+    EA = 0;
+    s_Slave.au16Diag[0] = u16ModbusFrame;
+    s_Slave.au16Diag[1] = u16ModbusCRCError;
+    s_Slave.au16Diag[2] = u16ModbusOverrun;
+    s_Slave.au16Diag[3] = u16ModbusException;
+    EA = bEA;
+
+    if ((g_sim.rx_next < g_sim.rx_len) && (g_sim.rx_at[g_sim.rx_next] < next))
+        next = g_sim.rx_at[g_sim.rx_next];
+    if (g_sim.tx_busy && (g_sim.tx_done < next))
+        next = g_sim.tx_done;
+    if (Timer0_Overflow_At() < next)
+        next = Timer0_Overflow_At();
+
+    if (next > g_sim.now)
+        g_sim.now = next;
+
+    Irq_Dispatch();
+}
+
+static int Slave_Start(void)
+{
+    int i32Pass = 1;
+
+    Modbus_Open(FSYS, g_sim.baud, SLAVE_ADDRESS, SlaveMap);
+    EA = 1;
+
+    if ((g_sim.open_clock != FSYS) || (g_sim.open_port != UART0_Timer3) || (g_sim.open_baud != g_sim.baud))
+    {
+        printf("  UART_Open %lu Hz, port %u, %lu bps\n", g_sim.open_clock, g_sim.open_port, g_sim.open_baud);
+        i32Pass = 0;
+    }
+
+    if (((g_sim.sfr[SFR_TMOD] & 0x0F) != 0x01) || (g_sim.sfr[SFR_CKCON] & CKCON_T0M) ||
+        (g_sim.sfr[SFR_TCON] & TCON_TR0) || !(g_sim.sfr[SFR_IE] & IE_ET0) || !(g_sim.sfr[SFR_IE] & IE_ES) ||
+        (g_sim.sfr[SFR_P0] & P0_DE))
+    {
+        printf("  TMOD %02X, CKCON %02X, TCON %02X, IE %02X, P0 %02X after Modbus_Open\n", g_sim.sfr[SFR_TMOD],
+               g_sim.sfr[SFR_CKCON], g_sim.sfr[SFR_TCON], g_sim.sfr[SFR_IE], g_sim.sfr[SFR_P0]);
+        i32Pass = 0;
+    }
+
+    return i32Pass;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Master                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static unsigned short Crc16(const unsigned char *pu8Buf, unsigned u32Len)
+{
+    unsigned u32Crc = 0xFFFF;
+    unsigned i, b;
+
+    for (i = 0; i < u32Len; i++)
+    {
+        u32Crc ^= pu8Buf[i];
+        for (b = 0; b < 8; b++)
+            u32Crc = (u32Crc & 1) ? ((u32Crc >> 1) ^ 0xA001) : (u32Crc >> 1);
+    }
+
+    return (unsigned short)u32Crc;
+}
+
+static void Print_Hex(const char *pcTitle, const unsigned char *pu8Buf, unsigned u32Len)
+{
+    unsigned i;
+
+    printf("  %s", pcTitle);
+    for (i = 0; i < u32Len; i++)
+        printf(" %02X", pu8Buf[i]);
+    printf("\n");
+}
+
+/* ADU with CRC on the line from now, u32Split > 0 adds gap_ns of silence before byte u32Split. Return stop
+   bit time of the last byte */
+static double Master_Send(const unsigned char *pu8Adu, unsigned u32Len, unsigned u32Split, double gap_ns)
+{
+    double at = g_sim.now;
+    unsigned i;
+
+    if (g_sim.verbose)
+        Print_Hex("M>", pu8Adu, u32Len);
+
+    for (i = 0; i < u32Len; i++)
+    {
+        if (u32Split && (i == u32Split))
+            at += gap_ns;
+        at += 10 * g_sim.bit_ns;
+        g_sim.rx_byte[i] = pu8Adu[i];
+        g_sim.rx_at[i] = at;
+    }
+
+    g_sim.rx_len = u32Len;
+    g_sim.rx_next = 0;
+    g_sim.reply_len = 0;
+
+    return at;
+}
+
+/* Run the slave until the reply ends with T3.5 silence or REPLY_WAIT_NS without reply. Return 1 when the
+   reply times are in bound */
+static int Master_Receive(double sent_ns)
+{
+    double t_end, start, gap;
+    int i32Pass = 1;
+    unsigned i;
+
+    for (;;)
+    {
+        if (g_sim.reply_len)
+            t_end = g_sim.reply_at[g_sim.reply_len - 1] + 10 * g_sim.bit_ns + g_sim.t35_ns;
+        else
+            t_end = sent_ns + REPLY_WAIT_NS;
+
+        if (g_sim.now >= t_end)
+            break;
+
+        Slave_Step(t_end);
+    }
+
+    if (g_sim.verbose && g_sim.reply_len)
+        Print_Hex("S>", g_sim.reply, g_sim.reply_len);
+
+    if (g_sim.sfr[SFR_P0] & P0_DE)
+    {
+        printf("  DE high after reply\n");
+        i32Pass = 0;
+    }
+
+    if (g_sim.reply_len == 0)
+        return i32Pass;
+
+    start = g_sim.reply_at[0] - sent_ns;
+    if (start > g_sim.start_max)
+        g_sim.start_max = start;
+    if (start < g_sim.start_min)
+        g_sim.start_min = start;
+
+    if ((start < g_sim.t35_ns - Timer0_Tick_Ns()) || (start > g_sim.t35_ns + g_sim.char_ns))
+    {
+        printf("  reply starts %.1f us after request, T3.5 %.1f us, character %.1f us\n", start / 1e3,
+               g_sim.t35_ns / 1e3, g_sim.char_ns / 1e3);
+        i32Pass = 0;
+    }
+
+    for (i = 1; i < g_sim.reply_len; i++)
+    {
+        gap = g_sim.reply_at[i] - g_sim.reply_at[i - 1] - 10 * g_sim.bit_ns;
+        if (gap > g_sim.gap_max)
+            g_sim.gap_max = gap;
+        if (gap > 1.5 * g_sim.char_ns)
+        {
+            printf("  gap of %.1f us before reply byte %u\n", gap / 1e3, i);
+            i32Pass = 0;
+        }
+    }
+
+    return i32Pass;
+}
+
+static void Result(const char *pcName, int i32Pass)
+{
+    g_sim.tests++;
+    if (!i32Pass)
+    {
+        g_sim.failed++;
+        printf("  FAIL %s\n", pcName);
+    }
+    else if (g_sim.verbose)
+    {
+        printf("  pass %s\n", pcName);
+    }
+}
+
+/*
+ * Send PDU to u8Address and compare reply PDU, u32ExpectLen 0 for no reply.
+ * u8Corrupt flips the CRC, u32Split and gap_ns add a gap inside the frame.
+ */
+static void Transfer(const char *pcName, unsigned char u8Address, const unsigned char *pu8Pdu, unsigned u32PduLen,
+                     const unsigned char *pu8Expect, unsigned u32ExpectLen, int i32Corrupt, unsigned u32Split,
+                     double gap_ns)
+{
+    unsigned char au8Tx[MODBUS_FRAME_MAX + 64];
+    unsigned short u16Crc;
+    double sent;
+    int i32Pass, i32Time;
+
+    au8Tx[0] = u8Address;
+    memcpy(&au8Tx[1], pu8Pdu, u32PduLen);
+    u16Crc = Crc16(au8Tx, u32PduLen + 1);
+    if (i32Corrupt)
+        u16Crc ^= 0x0100;
+    au8Tx[u32PduLen + 1] = (unsigned char)u16Crc;
+    au8Tx[u32PduLen + 2] = (unsigned char)(u16Crc >> 8);
+
+    sent = Master_Send(au8Tx, u32PduLen + 3, u32Split, gap_ns);
+    i32Time = Master_Receive(sent);
+
+    if (u32ExpectLen == 0)
+    {
+        i32Pass = (g_sim.reply_len == 0);
+    }
+    else
+    {
+        g_sim.replies++;
+        i32Pass = (g_sim.reply_len == u32ExpectLen + 3) && (g_sim.reply[0] == u8Address) &&
+                  !memcmp(&g_sim.reply[1], pu8Expect, u32ExpectLen) && (Crc16(g_sim.reply, g_sim.reply_len) == 0);
+    }
+
+    if (g_sim.written != g_sim.expect_written)
+    {
+        printf("  Modbus_Poll %02X, written %02X\n", g_sim.written, g_sim.expect_written);
+        i32Pass = 0;
+    }
+
+    if ((!i32Pass || !i32Time) && !g_sim.verbose)
+    {
+        Print_Hex("request", au8Tx, u32PduLen + 3);
+        Print_Hex("reply  ", g_sim.reply, g_sim.reply_len);
+    }
+
+    g_sim.written = 0;
+    g_sim.expect_written = 0;
+    Result(pcName, i32Pass && i32Time);
+}
+
+/* Map copy of master */
+static MODBUS_MAP *Shadow_Find(unsigned char u8Type, unsigned u32Start, unsigned u32Count)
+{
+    MODBUS_MAP *pEntry;
+
+    for (pEntry = MasterMap; pEntry->u16Count; pEntry++)
+    {
+        if ((pEntry->u8Type == u8Type) && (u32Start >= pEntry->u16Address) &&
+            (u32Start + u32Count <= (unsigned)pEntry->u16Address + pEntry->u16Count))
+            return pEntry;
+    }
+
+    return NULL;
+}
+
+static unsigned Shadow_Bit(MODBUS_MAP *pEntry, unsigned u32Address)
+{
+    u32Address -= pEntry->u16Address;
+    return (((unsigned char *)pEntry->pvData)[u32Address >> 3] >> (u32Address & 7)) & 1;
+}
+
+static void Shadow_Set_Bit(MODBUS_MAP *pEntry, unsigned u32Address, unsigned u32Value)
+{
+    u32Address -= pEntry->u16Address;
+    if (u32Value)
+        ((unsigned char *)pEntry->pvData)[u32Address >> 3] |= (unsigned char)(1 << (u32Address & 7));
+    else
+        ((unsigned char *)pEntry->pvData)[u32Address >> 3] &= (unsigned char)~(1 << (u32Address & 7));
+}
+
+static unsigned short *Shadow_Reg(MODBUS_MAP *pEntry, unsigned u32Address)
+{
+    return (unsigned short *)pEntry->pvData + (u32Address - pEntry->u16Address);
+}
+
+/* Expected exception reply, counted in slave */
+static unsigned Expect_Exception(unsigned char *pu8Expect, unsigned char u8Function, unsigned char u8Code)
+{
+    pu8Expect[0] = (unsigned char)(u8Function | 0x80);
+    pu8Expect[1] = u8Code;
+    g_sim.exceptions++;
+    return 2;
+}
+
+/* Function 01 02 03 04 */
+static void Test_Read(const char *pcName, unsigned char u8Function, unsigned u32Start, unsigned u32Count)
+{
+    static const unsigned char au8Type[5] = {0, MODBUS_COIL, MODBUS_DISCRETE, MODBUS_HOLDING_REG, MODBUS_INPUT_REG};
+    unsigned char au8Pdu[5], au8Expect[MODBUS_FRAME_MAX];
+    unsigned u32Len, u32Max, i;
+    unsigned short *pu16Reg;
+    MODBUS_MAP *pEntry;
+
+    au8Pdu[0] = u8Function;
+    au8Pdu[1] = (unsigned char)(u32Start >> 8);
+    au8Pdu[2] = (unsigned char)u32Start;
+    au8Pdu[3] = (unsigned char)(u32Count >> 8);
+    au8Pdu[4] = (unsigned char)u32Count;
+
+    u32Max = (u8Function <= 0x02) ? 2000 : 125;
+    pEntry = Shadow_Find(au8Type[u8Function], u32Start, u32Count);
+
+    if ((u32Count == 0) || (u32Count > u32Max))
+    {
+        u32Len = Expect_Exception(au8Expect, u8Function, MODBUS_EX_VALUE);
+    }
+    else if (pEntry == NULL)
+    {
+        u32Len = Expect_Exception(au8Expect, u8Function, MODBUS_EX_ADDRESS);
+    }
+    else if (u8Function <= 0x02)
+    {
+        au8Expect[0] = u8Function;
+        au8Expect[1] = (unsigned char)((u32Count + 7) / 8);
+        memset(&au8Expect[2], 0, au8Expect[1]);
+        for (i = 0; i < u32Count; i++)
+            au8Expect[2 + i / 8] |= (unsigned char)(Shadow_Bit(pEntry, u32Start + i) << (i & 7));
+        u32Len = 2 + au8Expect[1];
+    }
+    else
+    {
+        au8Expect[0] = u8Function;
+        au8Expect[1] = (unsigned char)(u32Count * 2);
+        pu16Reg = Shadow_Reg(pEntry, u32Start);
+        for (i = 0; i < u32Count; i++)
+        {
+            au8Expect[2 + i * 2] = (unsigned char)(pu16Reg[i] >> 8);
+            au8Expect[3 + i * 2] = (unsigned char)pu16Reg[i];
+        }
+        u32Len = 2 + au8Expect[1];
+    }
+
+    g_sim.frames++;
+    Transfer(pcName, SLAVE_ADDRESS, au8Pdu, 5, au8Expect, u32Len, 0, 0, 0);
+}
+
+/* Function 05 06, u8Address 0 is broadcast */
+static void Test_Write_Single(const char *pcName, unsigned char u8Address, unsigned char u8Function, unsigned u32Start,
+                              unsigned u32Value)
+{
+    unsigned char au8Pdu[5], au8Expect[8];
+    unsigned u32Len;
+    MODBUS_MAP *pEntry;
+
+    au8Pdu[0] = u8Function;
+    au8Pdu[1] = (unsigned char)(u32Start >> 8);
+    au8Pdu[2] = (unsigned char)u32Start;
+    au8Pdu[3] = (unsigned char)(u32Value >> 8);
+    au8Pdu[4] = (unsigned char)u32Value;
+
+    pEntry = Shadow_Find((u8Function == 0x05) ? MODBUS_COIL : MODBUS_HOLDING_REG, u32Start, 1);
+
+    if ((u8Function == 0x05) && (u32Value != 0xFF00) && (u32Value != 0x0000))
+    {
+        u32Len = Expect_Exception(au8Expect, u8Function, MODBUS_EX_VALUE);
+    }
+    else if (pEntry == NULL)
+    {
+        u32Len = Expect_Exception(au8Expect, u8Function, MODBUS_EX_ADDRESS);
+    }
+    else
+    {
+        if (u8Function == 0x05)
+            Shadow_Set_Bit(pEntry, u32Start, u32Value);
+        else
+            *Shadow_Reg(pEntry, u32Start) = (unsigned short)u32Value;
+        memcpy(au8Expect, au8Pdu, 5);
+        u32Len = 5;
+        g_sim.expect_written = u8Function;
+    }
+
+    g_sim.frames++;
+    Transfer(pcName, u8Address, au8Pdu, 5, au8Expect, u8Address ? u32Len : 0, 0, 0, 0);
+}
+
+/* Function 0F 10, u32Bytes is the byte count field, data of pu8Data */
+static void Test_Write_Multiple(const char *pcName, unsigned char u8Function, unsigned u32Start, unsigned u32Count,
+                                const unsigned char *pu8Data, unsigned u32Bytes)
+{
+    unsigned char au8Pdu[MODBUS_FRAME_MAX], au8Expect[8];
+    unsigned u32Len, u32Need, u32Max, i;
+    MODBUS_MAP *pEntry;
+
+    au8Pdu[0] = u8Function;
+    au8Pdu[1] = (unsigned char)(u32Start >> 8);
+    au8Pdu[2] = (unsigned char)u32Start;
+    au8Pdu[3] = (unsigned char)(u32Count >> 8);
+    au8Pdu[4] = (unsigned char)u32Count;
+    au8Pdu[5] = (unsigned char)u32Bytes;
+    memcpy(&au8Pdu[6], pu8Data, u32Bytes);
+
+    if (u8Function == 0x0F)
+    {
+        u32Need = (u32Count + 7) / 8;
+        u32Max = 1968;
+        pEntry = Shadow_Find(MODBUS_COIL, u32Start, u32Count);
+    }
+    else
+    {
+        u32Need = u32Count * 2;
+        u32Max = 123;
+        pEntry = Shadow_Find(MODBUS_HOLDING_REG, u32Start, u32Count);
+    }
+
+    if ((u32Count == 0) || (u32Count > u32Max) || (u32Bytes != u32Need))
+    {
+        u32Len = Expect_Exception(au8Expect, u8Function, MODBUS_EX_VALUE);
+    }
+    else if (pEntry == NULL)
+    {
+        u32Len = Expect_Exception(au8Expect, u8Function, MODBUS_EX_ADDRESS);
+    }
+    else
+    {
+        for (i = 0; i < u32Count; i++)
+        {
+            if (u8Function == 0x0F)
+                Shadow_Set_Bit(pEntry, u32Start + i, (pu8Data[i / 8] >> (i & 7)) & 1);
+            else
+                *Shadow_Reg(pEntry, u32Start + i) = (unsigned short)(((unsigned)pu8Data[i * 2] << 8) | pu8Data[i * 2 + 1]);
+        }
+        memcpy(au8Expect, au8Pdu, 5);
+        u32Len = 5;
+        g_sim.expect_written = u8Function;
+    }
+
+    g_sim.frames++;
+    Transfer(pcName, SLAVE_ADDRESS, au8Pdu, 6 + u32Bytes, au8Expect, u32Len, 0, 0, 0);
+}
+
+static void Test_Counters(const char *pcName)
+{
+    unsigned char au8Pdu[5] = {0x04, 0x00, DIAG_ADDRESS, 0x00, 0x04};
+    unsigned char au8Expect[10];
+    unsigned au32Value[4], i;
+
+    au32Value[0] = g_sim.frames;
+    au32Value[1] = g_sim.crc_errors;
+    au32Value[2] = g_sim.overruns;
+    au32Value[3] = g_sim.exceptions;
+
+    au8Expect[0] = 0x04;
+    au8Expect[1] = 8;
+    for (i = 0; i < 4; i++)
+    {
+        au8Expect[2 + i * 2] = (unsigned char)(au32Value[i] >> 8);
+        au8Expect[3 + i * 2] = (unsigned char)au32Value[i];
+    }
+
+    Transfer(pcName, SLAVE_ADDRESS, au8Pdu, 5, au8Expect, 10, 0, 0, 0);
+    g_sim.frames++;
+}
+
+static void Test_Fixed(void)
+{
+    static const unsigned char au8Unknown[5] = {0x2B, 0x0E, 0x01, 0x00, 0x00};
+    static const unsigned char au8UnknownEx[2] = {0xAB, MODBUS_EX_FUNCTION};
+    static const unsigned char au8Read[5] = {0x03, 0x00, 0x00, 0x00, 0x02};
+    unsigned char au8Data[MODBUS_FRAME_MAX], au8Expect[8];
+    unsigned i;
+
+    for (i = 0; i < sizeof(au8Data); i++)
+        au8Data[i] = (unsigned char)(i * 37 + 11);
+
+    printf("function codes\n");
+    Test_Read("read holding 0..9", 0x03, 0, 10);
+    Test_Read("read holding 125 registers", 0x03, 0, 125);
+    Test_Read("read holding 126 registers, exception 03", 0x03, 0, 126);
+    Test_Read("read holding 125..134 over entry end, exception 02", 0x03, 125, 10);
+    Test_Read("read holding 500, exception 02", 0x03, 500, 1);
+    Test_Read("read input 0..15", 0x04, 0, 16);
+    Test_Read("read input quantity 0, exception 03", 0x04, 0, 0);
+    Test_Read("read coils 3..37", 0x01, 3, 35);
+    Test_Read("read coils 100..115", 0x01, 100, 16);
+    Test_Read("read coils 38..101 across entries, exception 02", 0x01, 38, 64);
+    Test_Read("read discrete 1..22", 0x02, 1, 22);
+    Test_Write_Single("write coil 7 on", SLAVE_ADDRESS, 0x05, 7, 0xFF00);
+    Test_Write_Single("write coil 8 value 1234, exception 03", SLAVE_ADDRESS, 0x05, 8, 0x1234);
+    Test_Write_Single("write coil 40, exception 02", SLAVE_ADDRESS, 0x05, 40, 0x0000);
+    Test_Read("read coils 0..39", 0x01, 0, 40);
+    Test_Write_Single("write register 1005", SLAVE_ADDRESS, 0x06, 1005, 0xBEEF);
+    Test_Write_Single("write register 1010, exception 02", SLAVE_ADDRESS, 0x06, 1010, 0x0001);
+    Test_Read("read holding 1000..1009", 0x03, 1000, 10);
+    Test_Write_Multiple("write coils 5..29", 0x0F, 5, 25, au8Data, 4);
+    Test_Write_Multiple("write coils byte count wrong, exception 03", 0x0F, 5, 25, au8Data, 3);
+    Test_Write_Multiple("write coils 96..103, exception 02", 0x0F, 96, 8, au8Data, 1);
+    Test_Read("read coils 0..39", 0x01, 0, 40);
+    Test_Write_Multiple("write 123 registers", 0x10, 2, 123, au8Data, 246);
+    Test_Write_Multiple("write 124 registers, exception 03", 0x10, 0, 124, au8Data, 246);
+    Test_Read("read holding 0..124", 0x03, 0, 125);
+    Test_Read("read holding 125..129", 0x03, 125, 5);
+
+    g_sim.frames++;
+    g_sim.exceptions++;
+    Transfer("unknown function 2B, exception 01", SLAVE_ADDRESS, au8Unknown, 5, au8UnknownEx, 2, 0, 0, 0);
+    Test_Counters("counters");
+
+    printf("frames\n");
+    Transfer("other slave address, no reply", SLAVE_ADDRESS + 1, au8Read, 5, NULL, 0, 0, 0, 0);
+    g_sim.crc_errors++;
+    Transfer("bad CRC, no reply", SLAVE_ADDRESS, au8Read, 5, NULL, 0, 1, 0, 0);
+    Test_Write_Single("broadcast write register 1001, no reply", 0, 0x06, 1001, 0x5A5A);
+    Test_Write_Single("broadcast write coil 101, no reply", 0, 0x05, 101, 0xFF00);
+    Test_Read("read holding 1000..1009", 0x03, 1000, 10);
+    Test_Read("read coils 100..115", 0x01, 100, 16);
+
+    g_sim.frames++;
+    au8Expect[0] = 0x03;
+    au8Expect[1] = 4;
+    au8Expect[2] = (unsigned char)(s_Master.au16Holding[0] >> 8);
+    au8Expect[3] = (unsigned char)s_Master.au16Holding[0];
+    au8Expect[4] = (unsigned char)(s_Master.au16Holding[1] >> 8);
+    au8Expect[5] = (unsigned char)s_Master.au16Holding[1];
+    Transfer("1.5 character silence inside frame", SLAVE_ADDRESS, au8Read, 5, au8Expect, 6, 0, 3, g_sim.char_ns * 3 / 2);
+    g_sim.crc_errors += 2;
+    Transfer("frame split by T3.5 gap, no reply", SLAVE_ADDRESS, au8Read, 5, NULL, 0, 0, 3,
+             g_sim.t35_ns + 2 * g_sim.char_ns);
+
+    g_sim.overruns++;
+    memset(au8Data, 0, sizeof(au8Data));
+    au8Data[0] = 0x10;
+    Transfer("frame over MODBUS_FRAME_MAX, no reply", SLAVE_ADDRESS, au8Data, MODBUS_FRAME_MAX, NULL, 0, 0, 0, 0);
+    Test_Counters("counters");
+}
+
+static void Test_Random(unsigned u32Count)
+{
+    static const unsigned char au8Function[6] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    unsigned char au8Data[256];
+    unsigned i, j, u32Start, u32Quantity;
+    unsigned char u8Function;
+
+    printf("random requests\n");
+
+    for (i = 0; i < u32Count; i++)
+    {
+        u32Start = (rand() % 8 == 0) ? (unsigned)(rand() % 1100) : (unsigned)(rand() % 130);
+        u32Quantity = 1 + (unsigned)(rand() % ((rand() % 4 == 0) ? 130 : 20));
+        for (j = 0; j < sizeof(au8Data); j++)
+            au8Data[j] = (unsigned char)rand();
+
+        switch (rand() % 8)
+        {
+            case 6:
+                u8Function = 0x0F;
+                Test_Write_Multiple("random write coils", u8Function, u32Start, u32Quantity, au8Data,
+                                    (u32Quantity + 7) / 8);
+                break;
+            case 7:
+                u8Function = 0x10;
+                if (u32Quantity > 123)
+                    u32Quantity = 123;
+                Test_Write_Multiple("random write registers", u8Function, u32Start, u32Quantity, au8Data,
+                                    u32Quantity * 2);
+                break;
+            default:
+                u8Function = au8Function[rand() % 6];
+                if (u8Function == 0x05)
+                    Test_Write_Single("random write coil", SLAVE_ADDRESS, u8Function, u32Start,
+                                      (rand() & 1) ? 0xFF00 : 0x0000);
+                else if (u8Function == 0x06)
+                    Test_Write_Single("random write register", SLAVE_ADDRESS, u8Function, u32Start,
+                                      (unsigned)rand() & 0xFFFF);
+                else
+                {
+                    /* counters change, read them only in Test_Counters */
+                    if ((u8Function == 0x04) && (u32Start < DIAG_ADDRESS + 4) && (u32Start + u32Quantity > DIAG_ADDRESS))
+                        u32Start = DIAG_ADDRESS + 4;
+                    Test_Read("random read", u8Function, u32Start, u32Quantity);
+                }
+                break;
+        }
+    }
+
+    Test_Counters("counters");
+}
+
+static void Usage(void)
+{
+    fprintf(stderr, "usage: modbus_master_sim [-b baud] [-n count] [-s seed] [-v]\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned u32Count = 300, u32Seed = 1, i;
+    int opt;
+
+    g_sim.baud = 9600;
+
+    while ((opt = getopt(argc, argv, "b:n:s:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': g_sim.baud = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'n': u32Count = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': u32Seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'v': g_sim.verbose = 1; break;
+            default: Usage();
+        }
+    }
+    if ((optind != argc) || (g_sim.baud < 1200) || (g_sim.baud > 1000000))
+        Usage();
+
+    g_sim.bit_ns = 1e9 / g_sim.baud;
+    g_sim.char_ns = 11 * g_sim.bit_ns;
+    g_sim.t35_ns = (g_sim.baud > 19200) ? 1750e3 : 38.5 * g_sim.bit_ns;
+    g_sim.start_min = NEVER;
+
+    for (i = 0; i < sizeof(s_Master.au8Coil); i++)
+        s_Master.au8Coil[i] = (unsigned char)(0x5A ^ (i * 29));
+    for (i = 0; i < sizeof(s_Master.au8Discrete); i++)
+        s_Master.au8Discrete[i] = (unsigned char)(0xC3 + i * 17);
+    for (i = 0; i < 16; i++)
+        s_Master.au16Input[i] = (unsigned short)(0x3000 + i * 0x0101);
+    for (i = 0; i < 130; i++)
+        s_Master.au16Holding[i] = (unsigned short)(0x4000 + i);
+    s_Slave = s_Master;
+
+    srand(u32Seed);
+
+    printf("%u bps, character %.0f us, T3.5 %.0f us\n", g_sim.baud, g_sim.char_ns / 1e3, g_sim.t35_ns / 1e3);
+    Result("Modbus_Open", Slave_Start());
+    Test_Fixed();
+    Test_Random(u32Count);
+
+    Result("no request byte lost, no SBUF overwrite, DE high while sending",
+           !g_sim.rx_lost && !g_sim.tx_overwrite && !g_sim.de_error);
+
+    printf("result: %u tests, %u failed, %u replies\n", g_sim.tests, g_sim.failed, g_sim.replies);
+    printf("        reply start after request: %.1f to %.1f us, T3.5 %.1f us + character %.1f us at most\n",
+           g_sim.start_min / 1e3, g_sim.start_max / 1e3, g_sim.t35_ns / 1e3, g_sim.char_ns / 1e3);
+    printf("        longest gap inside reply %.1f us, %lu request bytes lost, %lu SBUF overwrites, %lu DE errors\n",
+           g_sim.gap_max / 1e3, g_sim.rx_lost, g_sim.tx_overwrite, g_sim.de_error);
+
+    return g_sim.failed ? 1 : 0;
+}
@@ -0,0 +1,430 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: printf of MS51 16K through the library putchar and the uart_putchar.c ring putchar, on an
+//                 SFR model in simulated time
+//
+//  Build : make            (GCC, see Makefile and host_inc/MS51_16K.h)
+//  Usage : printf_ring_sim
+//
+//  uart_ring.c and uart_putchar.c of the 16K library are compiled as C++ against host_inc/MS51_16K.h with
+//  UART0_TX_RING_SIZE=64, uart_putchar.c once for PUTCHAR_DROP and once for PUTCHAR_BLOCK. Each SFR access
+//  is a call of Host_SFR_Read or Host_SFR_Modify.
+//
+//  Two programs run for each of library putchar, ring DROP and ring BLOCK:
+//    one printf        "\nADC %u, state 0x%bX" of UART0_Printf_Ring with the UART idle, CPU time to return
+//    I2C_M             write phase of SampleCode/RegBased/I2C_Master_Interrupt: main prints, starts the I2C
+//                      and waits, each of the 34 I2C interrupts (I2STAT 0x08, 0x18, 0x28 x 32) prints two
+//                      lines, the next interrupt is I2C_BYTE_NS after the return of one. printf is called from
+//                      main and from the I2C interrupt, never at the same time, one context per port
+//
+//  Model
+//    CPU               ACCESS_NS per SFR access, other code and the printf formatting take no time. The CPU
+//                      times below are of this model, not cycles of the MS51
+//    interrupt         UART0_Ring_ISR (RI / TI and ES) before the I2C interrupt, the vector order, when EA
+//                      is 1. Taken after an SFR access or while main waits, an ISR is not interrupted
+//    UART0 transmit    TI is set 10 bit times of 115200 baud after a write of SBUF, a write of SBUF while a
+//                      byte is sent is counted as an overwrite. The bytes are the output on the wire
+//    library putchar   Keil C51 putchar.c: '\n' is sent as CR LF, while(!TI); TI = 0; SBUF = c
+//
+//  Checks, exit status 1 when one fails
+//    library, BLOCK    the wire output is the text of all printf
+//    DROP              the wire output is the text with u16PutcharDrop characters missing, and no I2C
+//                      interrupt is longer than one character time, the I2C runs at bus speed
+//    all               no SBUF overwrite
+//***********************************************************************************************************
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MS51_16K.h"
+#undef int
+#undef data
+#undef bit
+
+/* uart_putchar.c is built twice, see Makefile */
+char fw_putchar_drop(char c);
+char fw_putchar_block(char c);
+extern unsigned short u16PutcharDropDrop, u16PutcharDropBlock;
+extern unsigned char bUART0TxBusy;                  /* bit of uart_ring.c */
+
+#define ACCESS_NS               250.0       /* one SFR access with the code around it, 6 clocks of 24 MHz */
+#define BAUD                    115200.0
+#define CHAR_NS                 (10 * 1e9 / BAUD)
+#define I2C_BYTE_NS             90000.0     /* 9 SCL clocks of 100 kHz */
+#define I2C_START_NS            10000.0
+#define I2C_INTERRUPTS          34
+#define NEVER                   1e30
+#define TEXT_SIZE               4096
+
+#define SFR_SFRS                0x91
+#define SFR_SCON                0x98
+#define SFR_SBUF                0x99
+#define SFR_IE                  0xA8
+
+#define SCON_RI                 0x01
+#define SCON_TI                 0x02
+#define IE_ES                   0x10
+#define IE_EA                   0x80
+
+enum { PUTCHAR_LIBRARY, PUTCHAR_RING_DROP, PUTCHAR_RING_BLOCK };
+
+static const char *s_apcName[] = { "library putchar", "ring DROP", "ring BLOCK" };
+
+static struct
+{
+    unsigned char sfr[256];
+    double        now;
+    int           tx_busy;
+    double        tx_done;
+    unsigned long tx_overwrite;
+    char          wire[TEXT_SIZE];          /* bytes sent */
+    unsigned      wire_len;
+    char          text[TEXT_SIZE];          /* text of all printf, '\n' as CR LF */
+    unsigned      text_len;
+
+    int           mode;
+    int           in_isr;
+    double        i2c_at;                   /* time of the next I2C interrupt */
+    int           i2c_count;
+    int           write_end;
+    double        i2c_isr_max;              /* longest I2C interrupt */
+    double        ring_isr_max;             /* longest UART0_Ring_ISR */
+} g_sim;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SFR model                                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Uart_Update(void)
+{
+    if (g_sim.tx_busy && g_sim.now >= g_sim.tx_done)
+    {
+        g_sim.tx_busy = 0;
+        g_sim.sfr[SFR_SCON] |= SCON_TI;
+    }
+}
+
+static void I2C_Isr(void);
+
+static void Irq_Dispatch(void)
+{
+    double start;
+
+    if (g_sim.in_isr)
+        return;
+
+    g_sim.in_isr = 1;
+
+    for (;;)
+    {
+        Uart_Update();
+
+        if (!(g_sim.sfr[SFR_IE] & IE_EA))
+            break;
+
+        if ((g_sim.sfr[SFR_IE] & IE_ES) && (g_sim.sfr[SFR_SCON] & (SCON_RI | SCON_TI)))
+        {
+            unsigned char u8SFRS = g_sim.sfr[SFR_SFRS];     /* uart.c vector 4 saves SFRS */
+
+            start = g_sim.now;
+            UART0_Ring_ISR();
+            g_sim.sfr[SFR_SFRS] = u8SFRS;
+
+            if (g_sim.now - start > g_sim.ring_isr_max)
+                g_sim.ring_isr_max = g_sim.now - start;
+            continue;
+        }
+
+        if (g_sim.now >= g_sim.i2c_at)
+        {
+            start = g_sim.now;
+            g_sim.i2c_at = NEVER;
+            I2C_Isr();
+
+            if (g_sim.now - start > g_sim.i2c_isr_max)
+                g_sim.i2c_isr_max = g_sim.now - start;
+
+            if (!g_sim.write_end)
+                g_sim.i2c_at = g_sim.now + I2C_BYTE_NS;
+            continue;
+        }
+
+        break;
+    }
+
+    g_sim.in_isr = 0;
+}
+
+unsigned char Host_SFR_Read(unsigned short u16Index)
+{
+    unsigned char u8Value;
+
+    g_sim.now += ACCESS_NS;
+    Uart_Update();
+
+    if (u16Index & 0x100)
+        u8Value = (g_sim.sfr[u16Index & 0xF8] >> (u16Index & 0x07)) & 1;
+    else
+        u8Value = g_sim.sfr[u16Index & 0xFF];
+
+    Irq_Dispatch();
+    return u8Value;
+}
+
+/* Write (u8And 0) or read-modify-write of one SFR or sbit, one instruction of the CPU */
+void Host_SFR_Modify(unsigned short u16Index, unsigned char u8And, unsigned char u8Or)
+{
+    unsigned char u8Addr, u8Mask;
+
+    g_sim.now += ACCESS_NS;
+    Uart_Update();
+
+    if (u16Index & 0x100)
+    {
+        u8Addr = u16Index & 0xF8;
+        u8Mask = 1 << (u16Index & 0x07);
+
+        if ((((g_sim.sfr[u8Addr] & u8Mask) ? 1 : 0) & u8And) | u8Or)
+            g_sim.sfr[u8Addr] |= u8Mask;
+        else
+            g_sim.sfr[u8Addr] &= ~u8Mask;
+    }
+    else
+    {
+        u8Addr = u16Index & 0xFF;
+        g_sim.sfr[u8Addr] = (g_sim.sfr[u8Addr] & u8And) | u8Or;
+
+        if (u8Addr == SFR_SBUF)
+        {
+            if (g_sim.tx_busy)
+                g_sim.tx_overwrite++;
+
+            if (g_sim.wire_len < TEXT_SIZE)
+                g_sim.wire[g_sim.wire_len++] = (char)u8Or;
+
+            g_sim.tx_busy = 1;
+            g_sim.tx_done = g_sim.now + CHAR_NS;
+        }
+    }
+
+    Irq_Dispatch();
+}
+
+/* Main waits without SFR access until the next UART or I2C event */
+static void Idle_Step(void)
+{
+    double next = g_sim.tx_busy ? g_sim.tx_done : NEVER;
+
+    if (g_sim.i2c_at < next)
+        next = g_sim.i2c_at;
+
+    if (next == NEVER)
+    {
+        fprintf(stderr, "%s: main waits for ever\n", s_apcName[g_sim.mode]);
+        exit(1);
+    }
+
+    if (next > g_sim.now)
+        g_sim.now = next;
+
+    Irq_Dispatch();
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  printf                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Keil C51 putchar.c without XON / XOFF */
+static void Library_Putchar(char c)
+{
+    if (c == '\n')
+    {
+        while (!TI);
+        TI = 0;
+        SBUF = 0x0D;
+    }
+
+    while (!TI);
+    TI = 0;
+    SBUF = c;
+}
+
+static void Sim_Printf(const char *pcFormat, ...)
+{
+    char acLine[128];
+    va_list ap;
+    int i;
+
+    va_start(ap, pcFormat);
+    vsnprintf(acLine, sizeof(acLine), pcFormat, ap);
+    va_end(ap);
+
+    for (i = 0; acLine[i]; i++)
+    {
+        if (acLine[i] == '\n' && g_sim.text_len < TEXT_SIZE)
+            g_sim.text[g_sim.text_len++] = 0x0D;
+
+        if (g_sim.text_len < TEXT_SIZE)
+            g_sim.text[g_sim.text_len++] = acLine[i];
+
+        switch (g_sim.mode)
+        {
+            case PUTCHAR_LIBRARY:       Library_Putchar(acLine[i]); break;
+            case PUTCHAR_RING_DROP:     fw_putchar_drop(acLine[i]); break;
+            case PUTCHAR_RING_BLOCK:    fw_putchar_block(acLine[i]); break;
+        }
+    }
+}
+
+/* I2C0_Master_Tx_Isr of I2C_M.c, printf and the I2STAT sequence of the write phase only */
+static void I2C_Isr(void)
+{
+    static const unsigned char au8I2STAT[3] = { 0x08, 0x18, 0x28 };
+    unsigned char u8I2STAT = au8I2STAT[(g_sim.i2c_count < 2) ? g_sim.i2c_count : 2];
+
+    SFRS = 0;
+    Sim_Printf("\n I2C Transmit Interrupt");
+    Sim_Printf("\n I2STAT = 0x%d", u8I2STAT);
+
+    if (++g_sim.i2c_count == I2C_INTERRUPTS)
+        g_sim.write_end = 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Programs                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Sim_Open(int i32Mode)
+{
+    memset(&g_sim, 0, sizeof(g_sim));
+    g_sim.mode = i32Mode;
+    g_sim.i2c_at = NEVER;
+    u16PutcharDropDrop = u16PutcharDropBlock = 0;
+
+    if (i32Mode == PUTCHAR_LIBRARY)
+    {
+        SFRS = 0;
+        TI = 1;                                     /* Enable_UART0_VCOM_printf_24M_115200 */
+    }
+    else
+    {
+        UART_Ring_Open(UART0);
+    }
+
+    EA = 1;
+    g_sim.ring_isr_max = g_sim.i2c_isr_max = 0;
+}
+
+/* Main waits until the last byte is on the wire */
+static void Sim_Drain(void)
+{
+    while (g_sim.tx_busy || ((g_sim.mode != PUTCHAR_LIBRARY) && bUART0TxBusy))
+        Idle_Step();
+}
+
+static unsigned short Sim_Dropped(void)
+{
+    return (g_sim.mode == PUTCHAR_RING_DROP) ? u16PutcharDropDrop :
+           (g_sim.mode == PUTCHAR_RING_BLOCK) ? u16PutcharDropBlock : 0;
+}
+
+/* Wire output is text with Sim_Dropped characters missing, all of it for library and BLOCK */
+static int Sim_Check(void)
+{
+    unsigned i, j;
+
+    if (g_sim.tx_overwrite)
+    {
+        printf("  FAIL %lu SBUF written while sending\n", g_sim.tx_overwrite);
+        return 1;
+    }
+
+    for (i = j = 0; i < g_sim.text_len && j < g_sim.wire_len; i++)
+    {
+        if (g_sim.text[i] == g_sim.wire[j])
+            j++;
+    }
+
+    if (j != g_sim.wire_len || g_sim.text_len - g_sim.wire_len != Sim_Dropped())
+    {
+        printf("  FAIL wire %u of %u characters, %u dropped counted\n", g_sim.wire_len, g_sim.text_len,
+               Sim_Dropped());
+        return 1;
+    }
+
+    if (g_sim.mode != PUTCHAR_RING_DROP && g_sim.wire_len != g_sim.text_len)
+    {
+        printf("  FAIL %u characters lost\n", g_sim.text_len - g_sim.wire_len);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int Run_One_Printf(int i32Mode)
+{
+    double start;
+
+    Sim_Open(i32Mode);
+    start = g_sim.now;
+    Sim_Printf("\nADC %u, state 0x%X", 1234, 0x5A);
+    printf("  one printf of %u characters      CPU %8.1f us\n", g_sim.text_len, (g_sim.now - start) / 1000);
+    Sim_Drain();
+
+    return Sim_Check();
+}
+
+static int Run_I2C_M(int i32Mode)
+{
+    double start;
+    int i32Fail;
+
+    Sim_Open(i32Mode);
+    Sim_Printf("\n I2C Master intial...");
+    Sim_Printf("\n Write n24LC64 data 0x%d", 0);
+
+    start = g_sim.now;
+    g_sim.i2c_at = g_sim.now + I2C_START_NS;        /* set_I2CON_STA */
+
+    while (!g_sim.write_end)
+        Idle_Step();
+
+    printf("  I2C_M write phase                %8.1f us, I2C interrupt max %8.1f us\n",
+           (g_sim.now - start) / 1000, g_sim.i2c_isr_max / 1000);
+    Sim_Drain();
+    printf("  I2C_M wire %u of %u characters, dropped %u, TX ring max %u, UART0_Ring_ISR max %.1f us\n",
+           g_sim.wire_len, g_sim.text_len, Sim_Dropped(),
+           (i32Mode == PUTCHAR_LIBRARY) ? 0 : u8UART0TxHighWater, g_sim.ring_isr_max / 1000);
+
+    i32Fail = Sim_Check();
+
+    if (i32Mode == PUTCHAR_RING_DROP && g_sim.i2c_isr_max > CHAR_NS)
+    {
+        printf("  FAIL I2C interrupt longer than one character time %.1f us\n", CHAR_NS / 1000);
+        i32Fail = 1;
+    }
+
+    return i32Fail;
+}
+
+int main(void)
+{
+    int i, i32Fail = 0;
+
+    printf("115200 baud, %.1f us per character, TX ring %d bytes, %.0f ns per SFR access\n",
+           CHAR_NS / 1000, UART0_TX_RING_SIZE, ACCESS_NS);
+
+    for (i = PUTCHAR_LIBRARY; i <= PUTCHAR_RING_BLOCK; i++)
+    {
+        printf("%s\n", s_apcName[i]);
+        i32Fail |= Run_One_Printf(i);
+        i32Fail |= Run_I2C_M(i);
+    }
+
+    printf("%s\n", i32Fail ? "FAIL" : "PASS");
+    return i32Fail;
+}
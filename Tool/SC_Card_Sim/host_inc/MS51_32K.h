@@ -0,0 +1,16 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Host build of sc_iso7816.c for sc_card_sim, Keil memory type keywords removed, no SFR */
+#include <string.h>
+
+#define xdata
+#define code
+#define LOBYTE(v1)              ((unsigned char)(v1))
+#define HIBYTE(v1)              ((unsigned char)((v1) >> 8))
+
+#include "../../../MS51FC0AE_MS51XC0BE_MS51EB0AE_MS51EC0AE_MS51TC0AE_MS51PC0AE/Library/StdDriver/inc/sc_iso7816.h"
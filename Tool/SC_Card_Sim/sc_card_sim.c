@@ -0,0 +1,936 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Host test of sc_iso7816.c with a simulated card replaying recorded APDU exchanges
+//
+//  Build : SRC=../../MS51FC0AE_MS51XC0BE_MS51EB0AE_MS51EC0AE_MS51TC0AE_MS51PC0AE/Library/StdDriver/src
+//          cc -O2 -I host_inc -o sc_card_sim sc_card_sim.c $SRC/sc_iso7816.c
+//
+//  Usage : sc_card_sim [options] <script>
+//
+//  Script, one item per line, hex bytes, # is comment
+//    atr  <bytes>                  ATR sent after RST high
+//    apdu <command> : <response>   command APDU of reader and response data with SW1 SW2 of card
+//
+//  The reader runs SC_Card_Activate, SC_Card_PPS, SC_Card_APDU of each apdu line and SC_Card_Deactivate.
+//  SC_HW_xxx of sc_iso7816_hw.c are replaced by the card model at byte level: T=0 procedure bytes, 61xx
+//  GET RESPONSE, 6Cxx, T=1 blocks with chaining, R-block and S-block. Bytes sent with an ETU different
+//  from the ETU of the card are lost, so a PPS not applied on both sides fails the next exchange.
+//
+//  Options
+//    -n <n>            T=0 NULL bytes (0x60) before each procedure byte
+//    -1                T=0 card asks command data one byte at a time by ~INS
+//    -l                T=0 case 2 answers 6Cxx first, reader resends with right P3
+//    -c <n>            T=1 card sends response in I-blocks of n bytes at most
+//    -w                T=1 card asks S(WTX) before each response
+//    -e                T=1 card corrupts EDC of the first block of each response once
+//    -p                card answers PPS without PPS1, reader keeps Fd / Dd
+//    -v                print bytes of the card line
+//***********************************************************************************************************
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MS51_32K.h"
+
+#define SCRIPT_APDU_MAX         64
+#define LINE_MAX_LEN            2048
+
+static const unsigned au32Fi[16] = {372, 372, 558, 744, 1116, 1488, 1860, 0, 0, 512, 768, 1024, 1536, 2048, 0, 0};
+static const unsigned au32Di[16] = {0, 1, 2, 4, 8, 16, 32, 64, 12, 20, 0, 0, 0, 0, 0, 0};
+
+typedef struct
+{
+    uint8_t  cmd[ISO7816_APDU_MAX];
+    unsigned cmd_len;
+    uint8_t  resp[ISO7816_RESP_MAX];
+    unsigned resp_len;
+} SCRIPT_APDU;
+
+typedef enum
+{
+    CARD_OFF,
+    CARD_RESET,             /* RST low */
+    CARD_READY,             /* ATR sent, PPS allowed */
+    CARD_PPS,
+    CARD_T0_HEAD,
+    CARD_T0_DATA,
+    CARD_T1
+} CARD_STATE;
+
+typedef struct
+{
+    /* script */
+    uint8_t     atr[ISO7816_ATR_MAX];
+    unsigned    atr_len;
+    SCRIPT_APDU apdu[SCRIPT_APDU_MAX];
+    unsigned    apdu_count;
+    unsigned    apdu_index;         /* next expected command */
+
+    /* options */
+    unsigned    nulls;
+    int         one_byte;
+    int         wrong_le;
+    unsigned    chunk;
+    int         wtx;
+    int         bad_edc;
+    int         pps_reject;
+    int         verbose;
+
+    /* ATR values of the card */
+    unsigned    protocol;
+    int         crc;
+    unsigned    card_etu;
+    unsigned    pps_etu;            /* PPS response is sent at old ETU, new ETU from next byte */
+
+    /* line */
+    CARD_STATE  state;
+    unsigned    reader_etu;
+    int         clock_on;
+    uint8_t     out[4096];          /* card to reader */
+    unsigned    out_head, out_tail;
+    uint8_t     in[ISO7816_APDU_MAX + 8];
+    unsigned    in_len;
+
+    /* T=0 */
+    uint8_t     head[5];
+    unsigned    data_need;
+    uint8_t     pending[256];       /* data for GET RESPONSE */
+    unsigned    pending_len;
+    uint8_t     pending_sw[2];
+    int         le_wrong_sent;
+
+    /* T=1 */
+    unsigned    card_ns, card_nr;
+    uint8_t     apdu_buf[ISO7816_APDU_MAX];
+    unsigned    apdu_len;
+    uint8_t     resp_buf[ISO7816_RESP_MAX];
+    unsigned    resp_len, resp_off, resp_chunk;
+    int         resp_final;         /* last I-block of response sent */
+    uint8_t     last[3 + 254 + 2];  /* last block sent, for retransmission */
+    unsigned    last_len;
+    int         edc_done;
+    int         wtx_wait;
+
+    /* result */
+    unsigned    errors;
+    unsigned    lost;
+    unsigned    wtx_count, r_count, chain_count, get_response, null_count, pps_done;
+} SIM_CARD;
+
+static SIM_CARD g_card;
+
+static void Fail(const char *pcFormat, ...)
+{
+    va_list ap;
+
+    va_start(ap, pcFormat);
+    printf("  card: ");
+    vprintf(pcFormat, ap);
+    printf("\n");
+    va_end(ap);
+    g_card.errors++;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Card line                                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Card_Put(uint8_t u8Byte)
+{
+    g_card.out[g_card.out_head++ % sizeof(g_card.out)] = u8Byte;
+}
+
+static void Card_Put_Buf(const uint8_t *pu8Buf, unsigned u32Len)
+{
+    while (u32Len--)
+        Card_Put(*pu8Buf++);
+}
+
+static uint16_t T1_Edc(const uint8_t *pu8Buf, unsigned u32Len)
+{
+    uint16_t u16EDC = g_card.crc ? 0xFFFF : 0;
+    int i;
+
+    while (u32Len--)
+    {
+        u16EDC ^= *pu8Buf++;
+        if (g_card.crc)
+        {
+            for (i = 0; i < 8; i++)
+                u16EDC = (u16EDC & 1) ? ((u16EDC >> 1) ^ 0x8408) : (u16EDC >> 1);
+        }
+    }
+
+    return g_card.crc ? u16EDC : (u16EDC & 0xFF);
+}
+
+/* Parse ATR of script for the card protocol and EDC, same rule as the reader must apply */
+static void Card_ATR_Values(void)
+{
+    unsigned i = 2, y, group = 1, t = 0, first_t = 0xFF, specific_t = 0xFF;
+
+    g_card.crc = 0;
+    y = g_card.atr[1] & 0xF0;
+    while (y && (i < g_card.atr_len))
+    {
+        if (y & 0x10)
+        {
+            if (group == 2)
+                specific_t = g_card.atr[i] & 0x0F;
+            i++;
+        }
+        if (y & 0x20)
+            i++;
+        if (y & 0x40)
+        {
+            if ((group >= 3) && (t == 1))
+                g_card.crc = g_card.atr[i] & 1;
+            i++;
+        }
+        if (y & 0x80)
+        {
+            t = g_card.atr[i] & 0x0F;
+            if (first_t == 0xFF)
+                first_t = t;
+            y = g_card.atr[i++] & 0xF0;
+        }
+        else
+        {
+            y = 0;
+        }
+        group++;
+    }
+    if (specific_t != 0xFF)
+        first_t = specific_t;
+    g_card.protocol = (first_t == 0xFF) ? 0 : first_t;
+}
+
+static void Card_Reset(void)
+{
+    g_card.out_head = g_card.out_tail = 0;
+    g_card.in_len = 0;
+    g_card.card_etu = 372;
+    g_card.card_ns = g_card.card_nr = 0;
+    g_card.pending_len = 0;
+    g_card.resp_len = g_card.resp_off = 0;
+    g_card.resp_final = 0;
+    g_card.pps_etu = 0;
+    g_card.apdu_len = 0;
+    g_card.wtx_wait = 0;
+    g_card.resp_chunk = g_card.chunk ? g_card.chunk : 254;
+    Card_Put_Buf(g_card.atr, g_card.atr_len);
+    g_card.state = CARD_READY;
+}
+
+static const SCRIPT_APDU *Card_Match(const uint8_t *pu8Cmd, unsigned u32Len, unsigned u32Compare)
+{
+    const SCRIPT_APDU *pApdu;
+
+    if (g_card.apdu_index >= g_card.apdu_count)
+    {
+        Fail("command after end of script");
+        return NULL;
+    }
+
+    pApdu = &g_card.apdu[g_card.apdu_index];
+    if ((u32Len < u32Compare) || (pApdu->cmd_len < u32Compare) || memcmp(pu8Cmd, pApdu->cmd, u32Compare))
+    {
+        Fail("command %u not as recorded", g_card.apdu_index);
+        return NULL;
+    }
+
+    return pApdu;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  T=0 card                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static void T0_Procedure(uint8_t u8Byte)
+{
+    unsigned i;
+
+    for (i = 0; i < g_card.nulls; i++)
+        Card_Put(0x60);
+    g_card.null_count += g_card.nulls;
+    Card_Put(u8Byte);
+}
+
+static void T0_Reply(const uint8_t *pu8Data, unsigned u32Len, const uint8_t *pu8SW)
+{
+    if (u32Len)
+    {
+        T0_Procedure(g_card.head[1]);
+        Card_Put_Buf(pu8Data, u32Len);
+        Card_Put(pu8SW[0]);
+        Card_Put(pu8SW[1]);
+    }
+    else
+    {
+        T0_Procedure(pu8SW[0]);
+        Card_Put(pu8SW[1]);
+    }
+}
+
+/* Header and data of command are in, answer of the recorded response */
+static void T0_Command_Done(void)
+{
+    const SCRIPT_APDU *pApdu;
+    unsigned u32Lc = g_card.in_len - 5, u32Data;
+    uint8_t au8SW[2];
+
+    pApdu = Card_Match(g_card.in, g_card.in_len, u32Lc ? g_card.in_len : 4);
+    g_card.state = CARD_T0_HEAD;
+    g_card.in_len = 0;
+    if (pApdu == NULL)
+    {
+        au8SW[0] = 0x6F;
+        au8SW[1] = 0x00;
+        T0_Reply(NULL, 0, au8SW);
+        return;
+    }
+
+    u32Data = pApdu->resp_len - 2;
+    if (u32Lc == 0)
+    {
+        /* case 1 or case 2, P3 is Le */
+        unsigned u32Le = (pApdu->cmd_len == 5) ? (g_card.head[4] ? g_card.head[4] : 256) : 0;
+
+        if (u32Data && (u32Le != u32Data))
+        {
+            au8SW[0] = 0x6C;
+            au8SW[1] = (uint8_t)u32Data;
+            T0_Reply(NULL, 0, au8SW);
+            return;
+        }
+        g_card.apdu_index++;
+        g_card.le_wrong_sent = 0;
+        T0_Reply(pApdu->resp, u32Data, &pApdu->resp[u32Data]);
+        return;
+    }
+
+    /* case 3 or case 4 */
+    g_card.apdu_index++;
+    if (u32Data)
+    {
+        memcpy(g_card.pending, pApdu->resp, u32Data);
+        g_card.pending_len = u32Data;
+        memcpy(g_card.pending_sw, &pApdu->resp[u32Data], 2);
+        au8SW[0] = 0x61;
+        au8SW[1] = (uint8_t)u32Data;
+        T0_Reply(NULL, 0, au8SW);
+    }
+    else
+    {
+        T0_Reply(NULL, 0, &pApdu->resp[0]);
+    }
+}
+
+static void T0_Head(void)
+{
+    unsigned u32P3 = g_card.head[4];
+    const SCRIPT_APDU *pApdu;
+    uint8_t au8SW[2];
+
+    if (g_card.head[1] == 0xC0)
+    {
+        /* GET RESPONSE */
+        if (g_card.pending_len == 0)
+        {
+            au8SW[0] = 0x69;
+            au8SW[1] = 0x85;
+            T0_Reply(NULL, 0, au8SW);
+            return;
+        }
+        if ((u32P3 ? u32P3 : 256) != g_card.pending_len)
+        {
+            au8SW[0] = 0x6C;
+            au8SW[1] = (uint8_t)g_card.pending_len;
+            T0_Reply(NULL, 0, au8SW);
+            return;
+        }
+        g_card.get_response++;
+        T0_Reply(g_card.pending, g_card.pending_len, g_card.pending_sw);
+        g_card.pending_len = 0;
+        return;
+    }
+
+    g_card.pending_len = 0;
+    if (g_card.apdu_index < g_card.apdu_count)
+    {
+        pApdu = &g_card.apdu[g_card.apdu_index];
+        if ((pApdu->cmd_len > 5) && u32P3)
+        {
+            /* case 3 / 4, P3 is Lc */
+            g_card.data_need = u32P3;
+            g_card.state = CARD_T0_DATA;
+            T0_Procedure(g_card.one_byte ? (uint8_t)~g_card.head[1] : g_card.head[1]);
+            return;
+        }
+        if ((pApdu->cmd_len == 5) && g_card.wrong_le && !g_card.le_wrong_sent)
+        {
+            g_card.le_wrong_sent = 1;
+            g_card.in_len = 0;
+            au8SW[0] = 0x6C;
+            au8SW[1] = (uint8_t)(pApdu->resp_len - 2);
+            T0_Reply(NULL, 0, au8SW);
+            return;
+        }
+    }
+
+    T0_Command_Done();
+}
+
+static void T0_Byte(uint8_t u8Byte)
+{
+    g_card.in[g_card.in_len++] = u8Byte;
+
+    if (g_card.state == CARD_T0_HEAD)
+    {
+        if (g_card.in_len == 5)
+        {
+            memcpy(g_card.head, g_card.in, 5);
+            if (g_card.head[1] == 0xC0)
+                g_card.in_len = 0;
+            T0_Head();
+        }
+        return;
+    }
+
+    /* CARD_T0_DATA */
+    if (g_card.in_len == 5 + g_card.data_need)
+        T0_Command_Done();
+    else if (g_card.one_byte)
+        T0_Procedure((uint8_t)~g_card.head[1]);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  T=1 card                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static void T1_Send(uint8_t u8PCB, const uint8_t *pu8Inf, unsigned u32Len, int i32Corrupt)
+{
+    uint16_t u16EDC;
+
+    g_card.last[0] = 0;
+    g_card.last[1] = u8PCB;
+    g_card.last[2] = (uint8_t)u32Len;
+    memcpy(&g_card.last[3], pu8Inf, u32Len);
+    u16EDC = T1_Edc(g_card.last, 3 + u32Len);
+    if (g_card.crc)
+    {
+        g_card.last[3 + u32Len] = (uint8_t)(u16EDC >> 8);
+        g_card.last[4 + u32Len] = (uint8_t)u16EDC;
+        g_card.last_len = 5 + u32Len;
+    }
+    else
+    {
+        g_card.last[3 + u32Len] = (uint8_t)u16EDC;
+        g_card.last_len = 4 + u32Len;
+    }
+
+    Card_Put_Buf(g_card.last, g_card.last_len - 1);
+    Card_Put(g_card.last[g_card.last_len - 1] ^ (i32Corrupt ? 0x5A : 0));
+}
+
+/* Next I-block of response from resp_off */
+static void T1_Send_Response(void)
+{
+    unsigned u32Len = g_card.resp_len - g_card.resp_off;
+    int i32More = 0, i32Corrupt = 0;
+
+    if (u32Len > g_card.resp_chunk)
+    {
+        u32Len = g_card.resp_chunk;
+        i32More = 1;
+        g_card.chain_count++;
+    }
+    g_card.resp_final = !i32More;
+    if (g_card.bad_edc && !g_card.edc_done)
+    {
+        g_card.edc_done = 1;
+        i32Corrupt = 1;
+    }
+
+    T1_Send((uint8_t)((g_card.card_ns << 6) | (i32More ? 0x20 : 0)), &g_card.resp_buf[g_card.resp_off], u32Len, i32Corrupt);
+}
+
+static void T1_Apdu_Done(void)
+{
+    const SCRIPT_APDU *pApdu = Card_Match(g_card.apdu_buf, g_card.apdu_len, g_card.apdu_len);
+
+    g_card.edc_done = 0;
+    if (pApdu && (pApdu->cmd_len == g_card.apdu_len))
+    {
+        g_card.apdu_index++;
+        memcpy(g_card.resp_buf, pApdu->resp, pApdu->resp_len);
+        g_card.resp_len = pApdu->resp_len;
+    }
+    else
+    {
+        if (pApdu)
+            Fail("command %u length %u, recorded %u", g_card.apdu_index, g_card.apdu_len, pApdu->cmd_len);
+        g_card.resp_buf[0] = 0x6F;
+        g_card.resp_buf[1] = 0x00;
+        g_card.resp_len = 2;
+    }
+    g_card.resp_off = 0;
+    g_card.apdu_len = 0;
+
+    if (g_card.wtx)
+    {
+        uint8_t u8Mult = 2;
+
+        g_card.wtx_wait = 1;
+        g_card.wtx_count++;
+        T1_Send(0xC3, &u8Mult, 1, 0);
+        return;
+    }
+    T1_Send_Response();
+}
+
+static void T1_Block(void)
+{
+    uint8_t *pu8Blk = g_card.in;
+    uint8_t u8PCB = pu8Blk[1];
+    unsigned u32Len = pu8Blk[2];
+    uint16_t u16EDC = T1_Edc(pu8Blk, 3 + u32Len);
+    int i32Bad;
+
+    if (g_card.crc)
+        i32Bad = (pu8Blk[3 + u32Len] != (uint8_t)(u16EDC >> 8)) || (pu8Blk[4 + u32Len] != (uint8_t)u16EDC);
+    else
+        i32Bad = pu8Blk[3 + u32Len] != (uint8_t)u16EDC;
+    if (i32Bad || pu8Blk[0])
+    {
+        Fail("reader block EDC / NAD error");
+        return;
+    }
+
+    if ((u8PCB & 0x80) == 0)
+    {
+        /* I-block of reader */
+        if (((u8PCB >> 6) & 1) != g_card.card_nr)
+        {
+            Fail("reader N(S) %u, expected %u", (u8PCB >> 6) & 1, g_card.card_nr);
+            return;
+        }
+        if (g_card.resp_len && !g_card.resp_final)
+            Fail("reader I-block while card chain not finished");
+        g_card.card_nr ^= 1;
+        if (g_card.resp_len)
+        {
+            g_card.card_ns ^= 1;        /* I-block of reader acknowledges our last I-block */
+            g_card.resp_len = 0;
+        }
+        memcpy(&g_card.apdu_buf[g_card.apdu_len], &pu8Blk[3], u32Len);
+        g_card.apdu_len += u32Len;
+        if (u8PCB & 0x20)
+        {
+            g_card.chain_count++;
+            T1_Send((uint8_t)(0x80 | (g_card.card_nr << 4)), NULL, 0, 0);
+            return;
+        }
+        T1_Apdu_Done();
+        return;
+    }
+
+    if ((u8PCB & 0xC0) == 0x80)
+    {
+        /* R-block of reader */
+        g_card.r_count++;
+        if (((u8PCB >> 4) & 1) == g_card.card_ns)
+        {
+            /* error or not received, send last block again */
+            Card_Put_Buf(g_card.last, g_card.last_len);
+            return;
+        }
+        /* chained block acknowledged */
+        g_card.card_ns ^= 1;
+        g_card.resp_off += g_card.resp_chunk;
+        if (g_card.resp_off >= g_card.resp_len)
+        {
+            Fail("R-block after last response block");
+            return;
+        }
+        T1_Send_Response();
+        return;
+    }
+
+    /* S-block */
+    if (u8PCB == 0xC1)
+    {
+        T1_Send(0xE1, &pu8Blk[3], 1, 0);
+    }
+    else if ((u8PCB == 0xE3) && g_card.wtx_wait)
+    {
+        g_card.wtx_wait = 0;
+        T1_Send_Response();
+    }
+    else
+    {
+        Fail("S-block %02X not expected", u8PCB);
+    }
+}
+
+static void T1_Byte(uint8_t u8Byte)
+{
+    unsigned u32Need;
+
+    g_card.in[g_card.in_len++] = u8Byte;
+    if (g_card.in_len < 3)
+        return;
+    u32Need = 3 + g_card.in[2] + (g_card.crc ? 2 : 1);
+    if (g_card.in_len < u32Need)
+        return;
+
+    T1_Block();
+    g_card.in_len = 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Byte of reader                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Card_PPS_Done(void)
+{
+    uint8_t *pu8PPS = g_card.in;
+    uint8_t u8Check = 0;
+    unsigned i, u32Fi, u32Di;
+
+    for (i = 0; i < g_card.in_len; i++)
+        u8Check ^= pu8PPS[i];
+    g_card.in_len = 0;
+    g_card.state = (g_card.protocol == 1) ? CARD_T1 : CARD_T0_HEAD;
+    if (u8Check || ((pu8PPS[1] & 0x0F) != g_card.protocol) || !(pu8PPS[1] & 0x10))
+    {
+        Fail("PPS request not valid");
+        return;
+    }
+
+    if (g_card.pps_reject)
+    {
+        Card_Put(0xFF);
+        Card_Put(g_card.protocol);
+        Card_Put(0xFF ^ g_card.protocol);
+        return;
+    }
+
+    Card_Put_Buf(pu8PPS, 4);
+    u32Fi = au32Fi[pu8PPS[2] >> 4];
+    u32Di = au32Di[pu8PPS[2] & 0x0F];
+    g_card.pps_etu = u32Fi / u32Di;
+    g_card.pps_done = 1;
+}
+
+static void Card_Byte(uint8_t u8Byte)
+{
+    if (g_card.verbose)
+        printf("    R> %02X\n", u8Byte);
+
+    if (g_card.pps_etu)
+    {
+        g_card.card_etu = g_card.pps_etu;
+        g_card.pps_etu = 0;
+    }
+    if (g_card.reader_etu != g_card.card_etu)
+    {
+        g_card.lost++;
+        return;
+    }
+
+    switch (g_card.state)
+    {
+        case CARD_READY:
+            g_card.state = (g_card.protocol == 1) ? CARD_T1 : CARD_T0_HEAD;
+            if (u8Byte == 0xFF)
+            {
+                g_card.state = CARD_PPS;
+                g_card.in[0] = u8Byte;
+                g_card.in_len = 1;
+                return;
+            }
+            break;
+
+        case CARD_PPS:
+            g_card.in[g_card.in_len++] = u8Byte;
+            if ((g_card.in_len >= 2) &&
+                (g_card.in_len == 3u + ((g_card.in[1] >> 4) & 1) + ((g_card.in[1] >> 5) & 1) + ((g_card.in[1] >> 6) & 1)))
+                Card_PPS_Done();
+            return;
+
+        case CARD_OFF:
+        case CARD_RESET:
+            Fail("byte sent while card not active");
+            return;
+
+        default:
+            break;
+    }
+
+    if (g_card.state == CARD_T1)
+        T1_Byte(u8Byte);
+    else
+        T0_Byte(u8Byte);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SC_HW_xxx of sc_iso7816_hw.c                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+void SC_HW_Open(unsigned char u8Port)
+{
+    (void)u8Port;
+    g_card.state = CARD_OFF;
+    g_card.reader_etu = 372;
+}
+
+void SC_HW_Close(unsigned char u8Port)
+{
+    (void)u8Port;
+    g_card.state = CARD_OFF;
+}
+
+void SC_HW_Set_RST(unsigned char u8Port, unsigned char u8Level)
+{
+    (void)u8Port;
+    if (!u8Level)
+    {
+        g_card.state = CARD_RESET;
+        return;
+    }
+
+    if (!g_card.clock_on)
+    {
+        Fail("RST high without clock");
+        return;
+    }
+    Card_Reset();
+}
+
+void SC_HW_Set_Clock(unsigned char u8Port, unsigned char u8On)
+{
+    (void)u8Port;
+    g_card.clock_on = u8On;
+}
+
+void SC_HW_Set_ETU(unsigned char u8Port, unsigned int u16EtuClock)
+{
+    (void)u8Port;
+    printf("  reader ETU %u clocks\n", u16EtuClock);
+    g_card.reader_etu = u16EtuClock;
+}
+
+void SC_HW_Set_Guard(unsigned char u8Port, unsigned char u8Protocol, unsigned char u8N)
+{
+    (void)u8Port;
+    printf("  reader T=%u, extra guard time N=%u\n", u8Protocol, u8N);
+}
+
+void SC_HW_Wait_Clock(unsigned long u32Clock)
+{
+    (void)u32Clock;
+}
+
+unsigned char SC_HW_Send(unsigned char u8Port, unsigned char *pu8Data, unsigned int u16Len)
+{
+    (void)u8Port;
+    while (u16Len--)
+        Card_Byte(*pu8Data++);
+
+    return SC_OK;
+}
+
+unsigned char SC_HW_Receive(unsigned char u8Port, unsigned char *pu8Data, unsigned long u32TimeoutClock)
+{
+    (void)u8Port;
+    (void)u32TimeoutClock;
+    if ((g_card.out_tail == g_card.out_head) || (g_card.reader_etu != g_card.card_etu))
+        return SC_ERR_TIMEOUT;
+
+    *pu8Data = g_card.out[g_card.out_tail++ % sizeof(g_card.out)];
+    if (g_card.verbose)
+        printf("    C> %02X\n", *pu8Data);
+
+    return SC_OK;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Script                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static int Parse_Hex(char *pcText, uint8_t *pu8Out, unsigned u32Max, unsigned *pu32Len)
+{
+    char *pcToken, *pcEnd;
+    unsigned long u32Value;
+
+    *pu32Len = 0;
+    for (pcToken = strtok(pcText, " \t\r\n"); pcToken; pcToken = strtok(NULL, " \t\r\n"))
+    {
+        u32Value = strtoul(pcToken, &pcEnd, 16);
+        if (*pcEnd || (u32Value > 0xFF) || (*pu32Len >= u32Max))
+            return -1;
+        pu8Out[(*pu32Len)++] = (uint8_t)u32Value;
+    }
+
+    return 0;
+}
+
+static int Load_Script(const char *pcName)
+{
+    char acLine[LINE_MAX_LEN], *pc, *pcResp;
+    unsigned u32Line = 0;
+    SCRIPT_APDU *pApdu;
+    FILE *fp = fopen(pcName, "r");
+
+    if (fp == NULL)
+    {
+        perror(pcName);
+        return -1;
+    }
+
+    while (fgets(acLine, sizeof(acLine), fp))
+    {
+        u32Line++;
+        pc = strchr(acLine, '#');
+        if (pc)
+            *pc = 0;
+        for (pc = acLine; (*pc == ' ') || (*pc == '\t'); pc++);
+        if ((*pc == 0) || (*pc == '\r') || (*pc == '\n'))
+            continue;
+
+        if (!strncmp(pc, "atr", 3))
+        {
+            if (Parse_Hex(pc + 3, g_card.atr, ISO7816_ATR_MAX, &g_card.atr_len) || (g_card.atr_len < 2))
+                goto error;
+        }
+        else if (!strncmp(pc, "apdu", 4) && (g_card.apdu_count < SCRIPT_APDU_MAX))
+        {
+            pApdu = &g_card.apdu[g_card.apdu_count];
+            pcResp = strchr(pc, ':');
+            if (pcResp == NULL)
+                goto error;
+            *pcResp++ = 0;
+            if (Parse_Hex(pc + 4, pApdu->cmd, ISO7816_APDU_MAX, &pApdu->cmd_len) || (pApdu->cmd_len < 4) ||
+                Parse_Hex(pcResp, pApdu->resp, ISO7816_RESP_MAX, &pApdu->resp_len) || (pApdu->resp_len < 2))
+                goto error;
+            g_card.apdu_count++;
+        }
+        else
+        {
+            goto error;
+        }
+    }
+
+    fclose(fp);
+    if (g_card.atr_len == 0)
+    {
+        fprintf(stderr, "%s: no atr line\n", pcName);
+        return -1;
+    }
+    return 0;
+
+error:
+    fprintf(stderr, "%s:%u: bad line\n", pcName, u32Line);
+    fclose(fp);
+    return -1;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Reader                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Print_Hex(const char *pcTitle, const uint8_t *pu8Buf, unsigned u32Len)
+{
+    unsigned i;
+
+    printf("  %s", pcTitle);
+    for (i = 0; i < u32Len; i++)
+        printf(" %02X", pu8Buf[i]);
+    printf("\n");
+}
+
+static void Usage(void)
+{
+    fprintf(stderr, "usage: sc_card_sim [-n nulls] [-1] [-l] [-c chunk] [-w] [-e] [-p] [-v] <script>\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    static SC_CARD Card;
+    static uint8_t au8Cmd[ISO7816_APDU_MAX], au8Resp[ISO7816_RESP_MAX];
+    unsigned int u16RespLen;
+    unsigned i, u32Fail = 0;
+    unsigned char u8Ret;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:1lc:wepv")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': g_card.nulls = (unsigned)strtoul(optarg, NULL, 0); break;
+            case '1': g_card.one_byte = 1; break;
+            case 'l': g_card.wrong_le = 1; break;
+            case 'c': g_card.chunk = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'w': g_card.wtx = 1; break;
+            case 'e': g_card.bad_edc = 1; break;
+            case 'p': g_card.pps_reject = 1; break;
+            case 'v': g_card.verbose = 1; break;
+            default: Usage();
+        }
+    }
+    if ((optind + 1 != argc) || (g_card.chunk > 254))
+        Usage();
+    if (Load_Script(argv[optind]))
+        return 2;
+    Card_ATR_Values();
+
+    printf("activate\n");
+    u8Ret = SC_Card_Activate(&Card, SC0);
+    if (u8Ret != SC_OK)
+    {
+        printf("  SC_Card_Activate error %u\n", u8Ret);
+        return 1;
+    }
+    Print_Hex("ATR", Card.au8ATR, Card.u8ATRLen);
+    printf("  T=%u TA1 %02X%s N=%u WI=%u IFSC=%u BWI=%u CWI=%u EDC %s, %u historical bytes\n",
+           Card.u8Protocol, Card.u8TA1, Card.u8HasTA1 ? "" : " (absent)", Card.u8N, Card.u8WI, Card.u8IFSC,
+           Card.u8BWI, Card.u8CWI, Card.u8CRC ? "CRC" : "LRC", Card.u8HistLen);
+
+    printf("PPS\n");
+    u8Ret = SC_Card_PPS(&Card);
+    printf("  SC_Card_PPS %u, ETU %u clocks\n", u8Ret, Card.u16EtuClock);
+    if (u8Ret != SC_OK)
+        u32Fail++;
+
+    for (i = 0; (i < g_card.apdu_count) && (u8Ret == SC_OK); i++)
+    {
+        memcpy(au8Cmd, g_card.apdu[i].cmd, g_card.apdu[i].cmd_len);
+        printf("APDU %u\n", i);
+        Print_Hex("C-APDU", au8Cmd, g_card.apdu[i].cmd_len);
+        u8Ret = SC_Card_APDU(&Card, au8Cmd, g_card.apdu[i].cmd_len, au8Resp, &u16RespLen);
+        if (u8Ret != SC_OK)
+        {
+            printf("  SC_Card_APDU error %u\n", u8Ret);
+            u32Fail++;
+            break;
+        }
+        Print_Hex("R-APDU", au8Resp, u16RespLen);
+        if ((u16RespLen != g_card.apdu[i].resp_len) || memcmp(au8Resp, g_card.apdu[i].resp, u16RespLen))
+        {
+            printf("  response not as recorded\n");
+            u32Fail++;
+        }
+    }
+
+    SC_Card_Deactivate(&Card);
+
+    printf("result: %u APDU, %u failed, card errors %u, lost bytes %u\n", g_card.apdu_count, u32Fail, g_card.errors, g_card.lost);
+    printf("        PPS %u, NULL %u, GET RESPONSE %u, chained blocks %u, R-blocks %u, WTX %u\n",
+           g_card.pps_done, g_card.null_count, g_card.get_response, g_card.chain_count, g_card.r_count, g_card.wtx_count);
+
+    return (u32Fail || g_card.errors || g_card.lost) ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Host build of tlog.c for tlog_test, Keil memory type keywords removed, EA is a variable of tlog_test.c */
+#define xdata
+#define data
+#define bit                     unsigned char
+#define HIBYTE(v1)              ((unsigned char)((v1) >> 8))
+#define LOBYTE(v1)              ((unsigned char)((v1) & 0xFF))
+
+extern unsigned char EA;
+
+#include "../../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/StdDriver/inc/tlog.h"
@@ -0,0 +1,580 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Linux host table builder and decoder of MS51 tokenized log (tlog.c)
+//
+//  Build : cc -O2 -o tlog_host tlog_host.c
+//
+//  Usage : tlog_host table <table> <source.c>...
+//          tlog_host [-b baud] decode <table> <port|file|->
+//
+//  Command
+//    table             scan the sources for TLOG0..TLOG3 and write the message ID table, run it in the same
+//                      build step as the firmware, the table must match the image on the device
+//    decode            read the log stream from a UART port, a capture file or stdin and print each record
+//                      with its format string
+//
+//  Options
+//    -b <baud>         baud rate of <port>, default 115200
+//
+//  Message ID = TLOG_FILE_ID << 11 | line, TLOG_FILE_ID is read from "#define TLOG_FILE_ID n" of each source,
+//  default 0. One TLOGn per source line, format string and the macro name on the same line.
+//
+//  Record = ID high, ID low, argument high, low... ID 0 is the marker record, argument 0 is device start,
+//  else total lost records. The format is Keil printf with 16 bit arguments: %d %i %u %x %X %o %c, b or B
+//  modifier for 8 bit, flags, width and precision.
+//
+//  Table line : <ID hex> <argument count> <format string as in source> <file>:<line>
+//***********************************************************************************************************
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define ID_MAX                  0x10000
+#define FILE_ID_MAX             31
+#define LINE_MAX_ID             2047
+#define ARG_MAX                 3
+#define FORMAT_MAX              256
+#define LINE_BUF                1024
+
+typedef struct
+{
+    int      valid;
+    int      args;
+    char     format[FORMAT_MAX];            /* unescaped */
+} TLOG_MESSAGE;
+
+static TLOG_MESSAGE g_message[ID_MAX];
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Format string                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Read C string literal at *ppc, adjacent literals joined, escapes kept. Return length or -1. */
+static int Parse_Literal(const char **ppc, char *pcOut, int i32Max)
+{
+    const char *pc = *ppc;
+    int n = 0;
+
+    while (*pc == '"')
+    {
+        pc++;
+
+        while (*pc && *pc != '"')
+        {
+            if (*pc == '\\' && pc[1])
+            {
+                if (n + 2 >= i32Max)
+                    return -1;
+
+                pcOut[n++] = *pc++;
+            }
+
+            if (n + 1 >= i32Max)
+                return -1;
+
+            pcOut[n++] = *pc++;
+        }
+
+        if (*pc != '"')
+            return -1;
+
+        pc++;
+
+        while (*pc == ' ' || *pc == '\t')
+            pc++;
+    }
+
+    pcOut[n] = 0;
+    *ppc = pc;
+    return n;
+}
+
+static void Unescape(const char *pcIn, char *pcOut)
+{
+    while (*pcIn)
+    {
+        if (*pcIn != '\\')
+        {
+            *pcOut++ = *pcIn++;
+            continue;
+        }
+
+        pcIn++;
+
+        switch (*pcIn)
+        {
+            case 'n':  *pcOut++ = '\n'; pcIn++; break;
+            case 'r':  *pcOut++ = '\r'; pcIn++; break;
+            case 't':  *pcOut++ = '\t'; pcIn++; break;
+            case 'x':
+                pcIn++;
+                *pcOut++ = (char)strtoul(pcIn, (char **)&pcIn, 16);
+                break;
+            default:   *pcOut++ = *pcIn++; break;
+        }
+    }
+
+    *pcOut = 0;
+}
+
+/* Walk one conversion after '%'. Return conversion char, 0 if not supported. */
+static char Parse_Spec(const char **ppc, char *pcSpec, int *pi32Byte)
+{
+    const char *pc = *ppc;
+    int n = 0;
+    char c;
+
+    pcSpec[n++] = '%';
+
+    while (*pc && strchr("-+ #0", *pc))
+        pcSpec[n++] = *pc++;
+
+    while (isdigit((unsigned char)*pc) || *pc == '.')
+        pcSpec[n++] = *pc++;
+
+    *pi32Byte = 0;
+
+    if (*pc == 'b' || *pc == 'B')
+    {
+        *pi32Byte = 1;
+        pc++;
+    }
+
+    c = *pc;
+
+    if (c == 'D' || c == 'U')
+        c = (char)tolower((unsigned char)c);
+
+    if (!c || !strchr("diuxXoc", c) || n > 16)
+        return 0;
+
+    pc++;
+    pcSpec[n++] = c;
+    pcSpec[n] = 0;
+    *ppc = pc;
+    return c;
+}
+
+/* Return argument count of format, -1 if a conversion is not supported */
+static int Count_Args(const char *pcFormat)
+{
+    char acSpec[24];
+    int i32Byte, n = 0;
+
+    while (*pcFormat)
+    {
+        if (*pcFormat++ != '%')
+            continue;
+
+        if (*pcFormat == '%')
+        {
+            pcFormat++;
+            continue;
+        }
+
+        if (!Parse_Spec(&pcFormat, acSpec, &i32Byte))
+            return -1;
+
+        n++;
+    }
+
+    return n;
+}
+
+static void Print_Record(const char *pcFormat, const uint16_t *pu16Arg)
+{
+    char acSpec[24];
+    int i32Byte, i = 0;
+    char c;
+
+    while (*pcFormat)
+    {
+        if (*pcFormat != '%')
+        {
+            putchar(*pcFormat++);
+            continue;
+        }
+
+        pcFormat++;
+
+        if (*pcFormat == '%')
+        {
+            putchar(*pcFormat++);
+            continue;
+        }
+
+        c = Parse_Spec(&pcFormat, acSpec, &i32Byte);
+
+        if (c == 'd' || c == 'i')
+            printf(acSpec, i32Byte ? (int)(int8_t)pu16Arg[i] : (int)(int16_t)pu16Arg[i]);
+        else
+            printf(acSpec, i32Byte ? (unsigned)(pu16Arg[i] & 0xFF) : (unsigned)pu16Arg[i]);
+
+        i++;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Table                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+static int Scan_Source(const char *pcName, FILE *fpTable, char *pcOwner[])
+{
+    char acLine[LINE_BUF], acFormat[FORMAT_MAX], acPlain[FORMAT_MAX];
+    const char *pc;
+    FILE *fp;
+    unsigned u32FileId = 0, u32Id;
+    int i32Line = 0, i32Args, i32Errors = 0, i32Found, n;
+
+    fp = fopen(pcName, "r");
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", pcName, strerror(errno));
+        return 1;
+    }
+
+/* TLOG_FILE_ID is defined before the first TLOG of the file */
+    while (fgets(acLine, sizeof(acLine), fp))
+    {
+        i32Line++;
+        pc = acLine;
+
+        while (*pc == ' ' || *pc == '\t')
+            pc++;
+
+        if (sscanf(pc, "#define TLOG_FILE_ID %u", &u32FileId) == 1)
+        {
+            if (u32FileId > FILE_ID_MAX)
+            {
+                fprintf(stderr, "%s:%d: TLOG_FILE_ID over %d\n", pcName, i32Line, FILE_ID_MAX);
+                i32Errors++;
+                u32FileId = 0;
+            }
+
+            continue;
+        }
+
+        if (*pc == '#')
+            continue;
+
+        i32Found = 0;
+
+        for (pc = strstr(acLine, "TLOG"); pc; pc = strstr(pc + 1, "TLOG"))
+        {
+            if (pc > acLine && (isalnum((unsigned char)pc[-1]) || pc[-1] == '_'))
+                continue;
+
+            if (pc[4] < '0' || pc[4] > '0' + ARG_MAX || pc[5] != '(')
+                continue;
+
+            i32Args = pc[4] - '0';
+            u32Id = u32FileId << 11 | (unsigned)i32Line;
+
+            if (i32Found++)
+            {
+                fprintf(stderr, "%s:%d: more than one TLOG on the line\n", pcName, i32Line);
+                i32Errors++;
+                break;
+            }
+
+            if (i32Line > LINE_MAX_ID)
+            {
+                fprintf(stderr, "%s:%d: TLOG over line %d\n", pcName, i32Line, LINE_MAX_ID);
+                i32Errors++;
+                break;
+            }
+
+            pc += 6;
+
+            while (*pc == ' ' || *pc == '\t')
+                pc++;
+
+            if (Parse_Literal(&pc, acFormat, sizeof(acFormat)) < 0)
+            {
+                fprintf(stderr, "%s:%d: format string not on the TLOG line\n", pcName, i32Line);
+                i32Errors++;
+                break;
+            }
+
+            Unescape(acFormat, acPlain);
+
+            n = Count_Args(acPlain);
+
+            if (n < 0)
+            {
+                fprintf(stderr, "%s:%d: only %%d %%i %%u %%x %%X %%o %%c with b modifier are supported\n", pcName, i32Line);
+                i32Errors++;
+                break;
+            }
+
+            if (n != i32Args)
+            {
+                fprintf(stderr, "%s:%d: TLOG%d format needs %d 16 bit argument(s)\n", pcName, i32Line, i32Args, i32Args);
+                i32Errors++;
+                break;
+            }
+
+            if (pcOwner[u32Id])
+            {
+                fprintf(stderr, "%s:%d: ID 0x%04X also used by %s, set another TLOG_FILE_ID\n", pcName, i32Line, u32Id, pcOwner[u32Id]);
+                i32Errors++;
+                break;
+            }
+
+            pcOwner[u32Id] = strdup(pcName);
+            fprintf(fpTable, "0x%04X %d \"%s\" %s:%d\n", u32Id, i32Args, acFormat, pcName, i32Line);
+        }
+    }
+
+    fclose(fp);
+    return i32Errors;
+}
+
+static int Build_Table(const char *pcTable, int argc, char *argv[])
+{
+    static char *pcOwner[ID_MAX];
+    FILE *fp;
+    int i, i32Errors = 0;
+
+    fp = fopen(pcTable, "w");
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", pcTable, strerror(errno));
+        return 1;
+    }
+
+    fprintf(fp, "# tlog message table, generated by tlog_host table\n");
+
+    for (i = 0; i < argc; i++)
+        i32Errors += Scan_Source(argv[i], fp, pcOwner);
+
+    fclose(fp);
+
+    if (i32Errors)
+    {
+        remove(pcTable);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int Load_Table(const char *pcTable)
+{
+    char acLine[LINE_BUF], acFormat[FORMAT_MAX];
+    const char *pc;
+    FILE *fp;
+    unsigned u32Id;
+    int i32Args, i32Count = 0;
+
+    fp = fopen(pcTable, "r");
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", pcTable, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(acLine, sizeof(acLine), fp))
+    {
+        if (acLine[0] == '#' || sscanf(acLine, "%x %d", &u32Id, &i32Args) != 2)
+            continue;
+
+        pc = strchr(acLine, '"');
+
+        if (u32Id == 0 || u32Id >= ID_MAX || i32Args > ARG_MAX || pc == NULL || Parse_Literal(&pc, acFormat, sizeof(acFormat)) < 0)
+        {
+            fprintf(stderr, "%s: bad line %s", pcTable, acLine);
+            continue;
+        }
+
+        Unescape(acFormat, g_message[u32Id].format);
+        g_message[u32Id].args = i32Args;
+        g_message[u32Id].valid = 1;
+        i32Count++;
+    }
+
+    fclose(fp);
+    return i32Count;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Decode                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static speed_t Baud_To_Speed(unsigned u32Baud)
+{
+    switch (u32Baud)
+    {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        default:      return 0;
+    }
+}
+
+static int Set_Raw(int fd, unsigned u32Baud)
+{
+    struct termios tio;
+    speed_t speed;
+
+    speed = Baud_To_Speed(u32Baud);
+
+    if (speed == 0 || tcgetattr(fd, &tio) < 0)
+        return -1;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+/* Unknown ID skips one byte, so the decoder finds record start again after a lost byte */
+static int Decode(int fd)
+{
+    uint8_t au8Buf[4096];
+    uint16_t au16Arg[ARG_MAX], u16Id, u16LostLast = 0;
+    int i32Len = 0, i32Pos, i32Need, i, n;
+
+    while ((n = (int)read(fd, au8Buf + i32Len, sizeof(au8Buf) - i32Len)) > 0 || (n < 0 && errno == EINTR))
+    {
+        if (n < 0)
+            continue;
+
+        i32Len += n;
+        i32Pos = 0;
+
+        while (i32Len - i32Pos >= 2)
+        {
+            u16Id = (uint16_t)(au8Buf[i32Pos] << 8 | au8Buf[i32Pos + 1]);
+
+            if (u16Id != 0 && !g_message[u16Id].valid)
+            {
+                printf("<%02X>", au8Buf[i32Pos]);
+                i32Pos++;
+                continue;
+            }
+
+            i32Need = 2 + 2 * (u16Id ? g_message[u16Id].args : 1);
+
+            if (i32Len - i32Pos < i32Need)
+                break;
+
+            for (i = 0; i < (i32Need - 2) / 2; i++)
+                au16Arg[i] = (uint16_t)(au8Buf[i32Pos + 2 + 2 * i] << 8 | au8Buf[i32Pos + 3 + 2 * i]);
+
+            if (u16Id)
+            {
+                Print_Record(g_message[u16Id].format, au16Arg);
+            }
+            else if (au16Arg[0] == 0)
+            {
+                printf("\n[device start]\n");
+                u16LostLast = 0;
+            }
+            else
+            {
+                printf("\n[%u records lost]\n", (unsigned)(uint16_t)(au16Arg[0] - u16LostLast));
+                u16LostLast = au16Arg[0];
+            }
+
+            i32Pos += i32Need;
+        }
+
+        memmove(au8Buf, au8Buf + i32Pos, i32Len - i32Pos);
+        i32Len -= i32Pos;
+        fflush(stdout);
+    }
+
+    if (i32Len)
+        printf("<%d bytes of incomplete record>\n", i32Len);
+
+    return n < 0 ? 1 : 0;
+}
+
+static void Usage(void)
+{
+    fprintf(stderr,
+            "usage: tlog_host table <table> <source.c>...\n"
+            "       tlog_host [-b baud] decode <table> <port|file|->\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned u32Baud = 115200;
+    int opt, fd, i32Ret;
+
+    while ((opt = getopt(argc, argv, "b:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': u32Baud = strtoul(optarg, NULL, 0); break;
+            default:  Usage();
+        }
+    }
+
+    if (argc - optind < 3)
+        Usage();
+
+    if (strcmp(argv[optind], "table") == 0)
+        return Build_Table(argv[optind + 1], argc - optind - 2, argv + optind + 2);
+
+    if (strcmp(argv[optind], "decode") != 0)
+        Usage();
+
+    if (Load_Table(argv[optind + 1]) < 0)
+        return 1;
+
+    if (strcmp(argv[optind + 2], "-") == 0)
+    {
+        fd = STDIN_FILENO;
+    }
+    else
+    {
+        fd = open(argv[optind + 2], O_RDONLY | O_NOCTTY);
+
+        if (fd < 0)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind + 2], strerror(errno));
+            return 1;
+        }
+
+        if (isatty(fd) && Set_Raw(fd, u32Baud) < 0)
+        {
+            fprintf(stderr, "%s: cannot set %u baud\n", argv[optind + 2], u32Baud);
+            return 1;
+        }
+    }
+
+    i32Ret = Decode(fd);
+
+    if (fd != STDIN_FILENO)
+        close(fd);
+
+    return i32Ret;
+}
@@ -0,0 +1,235 @@
+/*---------------------------------------------------------------------------------------------------------*/
+/*                                                                                                         */
+/* SPDX-License-Identifier: Apache-2.0                                                                     */
+/* Copyright(c) 2020 Nuvoton Technology Corp. All rights reserved.                                         */
+/*                                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+//***********************************************************************************************************
+//  File Function: Round trip test of the library tlog.c and tlog_host table / decode
+//
+//  Build : SRC=../../MS51FB9AE_MS51XB9AE_MS51XB9BE/Library/StdDriver/src
+//          cc -O2 -DTLOG_ENABLE=1 -DTLOG_RING_SIZE=16 -I host_inc -o tlog_test tlog_test.c $SRC/tlog.c
+//
+//  Usage : tlog_host table tlog_test.tbl tlog_test.c
+//          tlog_test tlog_test.bin tlog_test.txt
+//          tlog_host decode tlog_test.tbl tlog_test.bin | cmp - tlog_test.txt
+//
+//  tlog.c runs with a 16 bytes ring, the log bytes read by TLog_Read are written to <bin>. For each TLOGn
+//  the test sees from u8TLogHead and u16TLogDrop whether the record is stored or dropped and whether tlog.c
+//  put a lost record marker before it, and writes what tlog_host decode must print for it to <txt>.
+//
+//  Phases
+//    wrap              200 records of TLOG0 ~ TLOG3 with the ring read by 0 ~ 6 bytes between them, so records
+//                      start at every even ring index and are written both at once and word by word. No drop
+//    drop              records without read until the ring is full, a read of 5 bytes so a marker fits but
+//                      the next TLOG3 does not, more drops, then a drained ring, the marker with the total
+//    restart           TLog_Open again, the decoder prints device start and counts lost records from 0
+//***********************************************************************************************************
+#define TLOG_FILE_ID    3
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MS51_16K.h"
+
+#define LOG_MAX                 65536
+
+unsigned char EA = 1;
+
+extern unsigned char u8TLogHead, u8TLogTail;
+
+static unsigned char au8Log[LOG_MAX];
+static unsigned u32LogLen;
+static FILE *fpExpect;
+static unsigned char u8HeadBefore;
+static unsigned u32DropBefore, u32MarkerLast, u32Markers, u32MarkerDrop, u32Stored, u32Dropped;
+static int i32Fail;
+
+/* Move n log bytes to au8Log, return bytes moved */
+static unsigned Log_Read(unsigned n)
+{
+    unsigned i;
+
+    for (i = 0; i < n && u32LogLen < LOG_MAX; i++)
+    {
+        if (!TLog_Read(&au8Log[u32LogLen]))
+            break;
+
+        u32LogLen++;
+    }
+
+    return i;
+}
+
+static void Before(void)
+{
+    u8HeadBefore = u8TLogHead;
+    u32DropBefore = u16TLogDrop;
+}
+
+/* Expected decode of the marker (value before this TLOGn) and of the record when it is stored */
+static void After(unsigned u32Size, const char *pcFormat, ...)
+{
+    unsigned u32Put = (unsigned char)(u8TLogHead - u8HeadBefore);
+    int i32Stored = (u16TLogDrop == u32DropBefore);
+    va_list ap;
+
+    if (EA != 1)
+    {
+        printf("FAIL EA %u after TLOG\n", EA);
+        i32Fail = 1;
+    }
+
+    if (u32Put - (i32Stored ? u32Size : 0) == 4)
+    {
+        fprintf(fpExpect, "\n[%u records lost]\n", (unsigned)(uint16_t)(u32DropBefore - u32MarkerLast));
+        u32MarkerLast = u32DropBefore;
+        u32Markers++;
+        u32MarkerDrop += !i32Stored;
+    }
+    else if (u32Put != (i32Stored ? u32Size : 0))
+    {
+        printf("FAIL record of %u bytes put %u bytes\n", u32Size, u32Put);
+        i32Fail = 1;
+    }
+
+    if (i32Stored)
+    {
+        va_start(ap, pcFormat);
+        vfprintf(fpExpect, pcFormat, ap);
+        va_end(ap);
+        u32Stored++;
+    }
+    else
+    {
+        u32Dropped++;
+    }
+}
+
+static void Open(void)
+{
+    TLog_Open();
+    fprintf(fpExpect, "\n[device start]\n");
+    u32MarkerLast = 0;
+}
+
+static void Log_One(unsigned i)
+{
+    unsigned u16A = (unsigned)(i * 40503u) & 0xFFFF, u16B = (unsigned)(i * 7919u + 1) & 0xFFFF;
+
+    Before();
+
+    switch (i % 4)
+    {
+        case 0:
+            TLOG0("\nidle");
+            After(2, "\nidle");
+            break;
+
+        case 1:
+            TLOG1("\nADC %u", u16A);
+            After(4, "\nADC %u", u16A);
+            break;
+
+        case 2:
+            TLOG2("\nstate 0x%bX, delta %d", u16A, u16B);
+            After(6, "\nstate 0x%X, delta %d", u16A & 0xFF, (int)(int16_t)u16B);
+            break;
+
+        default:
+            TLOG3("\nRX '%c' 0x%04x at %5u", 'A' + i % 26, u16B, i);
+            After(8, "\nRX '%c' 0x%04x at %5u", 'A' + i % 26, u16B, i);
+            break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    unsigned i;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: tlog_test <bin> <txt>\n");
+        return 2;
+    }
+
+    fpExpect = fopen(argv[2], "w");
+
+    if (!fpExpect)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+/* Wrap */
+    Open();
+
+    for (i = 0; i < 200; i++)
+    {
+        while ((unsigned char)(u8TLogHead - u8TLogTail) > TLOG_RING_SIZE - 8)
+            Log_Read(1);
+
+        Log_One(i);
+        Log_Read(i % 7);
+    }
+
+    if (u32Dropped)
+    {
+        printf("FAIL %u records dropped in wrap phase\n", u32Dropped);
+        i32Fail = 1;
+    }
+
+/* Drop */
+    for (i = 200; i < 212; i++)
+        Log_One(i);
+
+    Log_Read(5);
+    Before();
+    TLOG3("\nafter read %u %u %u", 1, 2, 3);
+    After(8, "\nafter read %u %u %u", 1, 2, 3);
+
+    for (i = 212; i < 220; i++)
+        Log_One(i);
+
+    Log_Read(LOG_MAX);
+
+    for (i = 220; i < 230; i++)
+    {
+        Log_One(i);
+        Log_Read(LOG_MAX);
+    }
+
+/* Restart */
+    Log_Read(LOG_MAX);
+    Open();
+
+    for (i = 230; i < 240; i++)
+    {
+        Log_One(i);
+        Log_Read(LOG_MAX);
+    }
+
+    if (u16TLogDrop != 0 || u32Dropped == 0 || u32Markers < 2 || u32MarkerDrop == 0)
+    {
+        printf("FAIL drop phase: %u dropped, %u lost record markers, %u before a dropped record\n", u32Dropped,
+               u32Markers, u32MarkerDrop);
+        i32Fail = 1;
+    }
+
+    fclose(fpExpect);
+    fp = fopen(argv[1], "wb");
+
+    if (!fp || fwrite(au8Log, 1, u32LogLen, fp) != u32LogLen)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fclose(fp);
+    printf("%s: %u records stored, %u dropped, %u log bytes\n", i32Fail ? "FAIL" : "PASS", u32Stored, u32Dropped,
+           u32LogLen);
+    return i32Fail;
+}